@@ -8,54 +8,92 @@
  * Key C Programming Concepts:
  * - scanf return value checking
  * - Input buffer clearing
+ * - Reading a whole line, then checking that all of it is a number
  * - Error handling and recovery
  * - Safe input practices
  */
 
+#include <ctype.h>
+#include <errno.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include "num_parse.h"
+
 // Function to clear input buffer
 void clear_input_buffer() {
     int c;
     while ((c = getchar()) != '\n' && c != EOF);
 }
 
-// Function to get a valid integer
+// Read one line for a number and strip surrounding whitespace. Returns
+// the start of the text (length in *length), or NULL if the line was too
+// long to be a number. Ends the program at end of input, where asking
+// again would loop forever.
+static const char* read_number_line(char* buffer, int size, size_t* length) {
+    if (fgets(buffer, size, stdin) == NULL) {
+        printf("\nEnd of input.\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    size_t n = strlen(buffer);
+    if (n > 0 && buffer[n - 1] != '\n' && !feof(stdin)) {
+        clear_input_buffer();
+        return NULL;
+    }
+    
+    const char* start = buffer;
+    const char* end = buffer + n;
+    while (isspace((unsigned char)*start)) start++;
+    while (end > start && isspace((unsigned char)end[-1])) end--;
+    *length = (size_t)(end - start);
+    return start;
+}
+
+// Function to get a valid integer. scanf("%d") would take "12abc" as 12
+// and overflow silently on "99999999999"; parse_int32() accepts only a
+// line that is entirely one number that fits.
 int get_valid_integer(const char* prompt) {
-    int value;
-    int result;
+    char line[64];
     
     do {
         printf("%s", prompt);
-        result = scanf("%d", &value);
+        size_t length;
+        const char* text = read_number_line(line, sizeof(line), &length);
+        int32_t value;
         
-        if (result != 1) {
-            printf("Error: Please enter a valid integer.\n");
-            clear_input_buffer();
-        } else {
-            clear_input_buffer();  // Clear any remaining input
+        if (text != NULL && parse_int32(text, length, &value) == 0) {
             return value;
         }
+        if (text != NULL && errno == ERANGE) {
+            printf("Error: %.*s is out of range (%d to %d).\n", (int)length, text,
+                   INT32_MIN, INT32_MAX);
+        } else {
+            printf("Error: Please enter a valid integer.\n");
+        }
     } while (1);
 }
 
 // Function to get a valid float
 float get_valid_float(const char* prompt) {
-    float value;
-    int result;
+    char line[128];
     
     do {
         printf("%s", prompt);
-        result = scanf("%f", &value);
+        size_t length;
+        const char* text = read_number_line(line, sizeof(line), &length);
+        float value;
         
-        if (result != 1) {
-            printf("Error: Please enter a valid number.\n");
-            clear_input_buffer();
-        } else {
-            clear_input_buffer();
+        if (text != NULL && parse_float(text, length, &value) == 0) {
             return value;
         }
+        if (text != NULL && errno == ERANGE) {
+            printf("Error: %.*s is too large or too small for a float.\n", (int)length, text);
+        } else {
+            printf("Error: Please enter a valid number.\n");
+        }
     } while (1);
 }
 
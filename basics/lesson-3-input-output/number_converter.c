@@ -10,28 +10,27 @@
  * - Number base conversions
  * - Input validation
  * - Formatted output control
+ * 
+ * The conversions use ../../common/num_format.h, which writes digits into
+ * a buffer from lookup tables instead of going through printf's format
+ * parser for every number (and can do binary and digit grouping, which
+ * printf can't). The "Formatted Output Examples" section keeps printf so
+ * the two can be compared.
  */
 
+#include <stdint.h>
 #include <stdio.h>
 
+#include "num_format.h"
+
 // Function to print binary representation (C doesn't have %b)
 void print_binary(int num) {
-    if (num == 0) {
-        printf("0");
-        return;
-    }
-    
-    // Find the highest bit position
-    int bit_position = 31;
-    while (bit_position >= 0 && !(num & (1 << bit_position))) {
-        bit_position--;
-    }
-    
-    // Print bits from highest to lowest
-    for (int i = bit_position; i >= 0; i--) {
-        printf("%d", (num >> i) & 1);
-        if (i % 4 == 0 && i > 0) printf(" ");  // Space every 4 bits
-    }
+    // The int's bits, as the unsigned value they form: negative numbers
+    // show their two's complement form instead of shifting into the sign bit
+    static const NumberFormat nibbles = {2, 0, 0, ' ', 4, 0};  // Space every 4 bits
+    char text[FORMAT_MAX_SIZE];
+    format_unsigned(text, (uint32_t)num, &nibbles);
+    fputs(text, stdout);
 }
 
 int main() {
@@ -49,11 +48,21 @@ int main() {
     printf("Conversions:\n");
     printf("─────────────────────────────\n");
     
-    // Different number base representations
-    printf("Decimal:     %d\n", number);
-    printf("Hexadecimal: %x (lowercase)\n", number);
-    printf("Hexadecimal: %X (uppercase)\n", number);
-    printf("Octal:       %o\n", number);
+    // Different number base representations. Hex and octal show the
+    // int's bits like %x and %o do, so they format (uint32_t)number
+    static const NumberFormat thousands = {10, 0, 0, ',', 3, 0};
+    char text[FORMAT_MAX_SIZE];
+    
+    format_int64(text, number);
+    printf("Decimal:     %s\n", text);
+    format_signed(text, number, &thousands);
+    printf("Grouped:     %s\n", text);
+    format_hex64(text, (uint32_t)number, 0);
+    printf("Hexadecimal: %s (lowercase)\n", text);
+    format_hex64(text, (uint32_t)number, 1);
+    printf("Hexadecimal: %s (uppercase)\n", text);
+    format_octal64(text, (uint32_t)number);
+    printf("Octal:       %s\n", text);
     printf("Binary:      ");
     print_binary(number);
     printf("\n\n");
@@ -0,0 +1,512 @@
+/*
+ * bench_harness.c - Repeatable micro-benchmarks with statistics
+ *
+ * Implementation notes:
+ * - Calibration (only without a setup function) times batches of calls,
+ *   starting with one, and scales the batch by the shortfall (at most
+ *   100x per step, with 10% to spare) until a batch lasts sample_seconds.
+ *   The calibration batches double as extra warmup.
+ * - One sample is one batch: a clock read before and after, divided by
+ *   the batch size, so the ~20 ns of clock_gettime() vanish into the
+ *   batch. With a setup function every call is its own sample and the
+ *   clock overhead stays in; that is meant for calls of a millisecond or
+ *   more (sorting a fresh copy of an array), where it doesn't matter.
+ * - Statistics sort a copy of the samples: median of the middle one or
+ *   two, MAD as the median of the absolute deviations, p99 by nearest
+ *   rank (the maximum below 100 samples).
+ * - Hardware counters are read around every timed sample, inside the
+ *   clock reads, and added up; dividing by all calls gives the counts
+ *   per call. A counter that missed any sample (multiplexed off the PMU
+ *   the whole time) is left out of the result rather than undercounted.
+ * - Inputs use splitmix64 from the seed: every output of it is a full
+ *   64-bit mix of the state, so consecutive seeds give unrelated data.
+ *   Random values are reduced to [0, count) with a multiply-shift
+ *   instead of %, which needs no division.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench_harness.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BENCH_HAVE_TSC 1
+#include <x86intrin.h>
+#else
+#define BENCH_HAVE_TSC 0
+#endif
+
+// Calibration stops growing the batch here, whatever sample_seconds says
+#define BENCH_MAX_ITERATIONS (1ull << 32)
+
+static const char* const input_names[BENCH_INPUT_COUNT] = {
+    "random", "sorted", "reversed", "few-unique", "organ-pipe"
+};
+
+void bench_init(Bench* bench) {
+    bench->format = BENCH_FORMAT_TEXT;
+    bench->out = stdout;
+    bench->seed = 42;
+    bench->warmup = 1;
+    bench->min_samples = 5;
+    bench->max_samples = 100;
+    bench->sample_seconds = 0.005;
+    bench->max_seconds = 0.5;
+    bench->result_count = 0;
+    bench->use_counters = 1;
+    bench->counters = NULL;
+}
+
+// The value after option argv[*i], or NULL (and errno = EINVAL) if none
+static const char* option_value(int argc, char* argv[], int* i) {
+    if (*i + 1 >= argc) {
+        errno = EINVAL;
+        return NULL;
+    }
+    return argv[++*i];
+}
+
+static int parse_count(const char* text, int min, int max, int* out) {
+    char* end;
+    long value = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || value < min || value > max) {
+        errno = EINVAL;
+        return -1;
+    }
+    *out = (int)value;
+    return 0;
+}
+
+int bench_parse_args(Bench* bench, int* argc, char* argv[]) {
+    int kept = 1;
+    for (int i = 1; i < *argc; i++) {
+        const char* option = argv[i];
+        const char* value;
+        if (strcmp(option, "--format") == 0) {
+            if ((value = option_value(*argc, argv, &i)) == NULL) return -1;
+            if (strcmp(value, "text") == 0) {
+                bench->format = BENCH_FORMAT_TEXT;
+            } else if (strcmp(value, "csv") == 0) {
+                bench->format = BENCH_FORMAT_CSV;
+            } else if (strcmp(value, "json") == 0) {
+                bench->format = BENCH_FORMAT_JSON;
+            } else {
+                errno = EINVAL;
+                return -1;
+            }
+        } else if (strcmp(option, "--seed") == 0) {
+            if ((value = option_value(*argc, argv, &i)) == NULL) return -1;
+            char* end;
+            errno = 0;
+            unsigned long long seed = strtoull(value, &end, 0);
+            if (end == value || *end != '\0' || errno != 0) {
+                errno = EINVAL;
+                return -1;
+            }
+            bench->seed = seed;
+        } else if (strcmp(option, "--samples") == 0) {
+            if ((value = option_value(*argc, argv, &i)) == NULL) return -1;
+            if (parse_count(value, 1, BENCH_MAX_SAMPLES, &bench->max_samples) != 0) return -1;
+            if (bench->min_samples > bench->max_samples) bench->min_samples = bench->max_samples;
+        } else if (strcmp(option, "--warmup") == 0) {
+            if ((value = option_value(*argc, argv, &i)) == NULL) return -1;
+            if (parse_count(value, 0, 1000, &bench->warmup) != 0) return -1;
+        } else if (strcmp(option, "--max-seconds") == 0) {
+            if ((value = option_value(*argc, argv, &i)) == NULL) return -1;
+            char* end;
+            double seconds = strtod(value, &end);
+            if (end == value || *end != '\0' || !(seconds >= 0)) {
+                errno = EINVAL;
+                return -1;
+            }
+            bench->max_seconds = seconds;
+        } else if (strcmp(option, "--no-counters") == 0) {
+            bench->use_counters = 0;
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    *argc = kept;
+    argv[kept] = NULL;
+    return 0;
+}
+
+double bench_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+uint64_t bench_cycles(void) {
+#if BENCH_HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+uint64_t bench_random(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+const char* bench_input_name(BenchInput input) {
+    return (unsigned)input < BENCH_INPUT_COUNT ? input_names[input] : "unknown";
+}
+
+void bench_fill_int32(int32_t* values, size_t count, BenchInput input, uint64_t seed) {
+    uint64_t state = seed;
+    // Values stay in [0, range), which an int32_t can hold
+    uint64_t range = count < INT32_MAX ? count : INT32_MAX;
+    switch (input) {
+    case BENCH_INPUT_RANDOM:
+        for (size_t i = 0; i < count; i++) {
+            values[i] = (int32_t)(((bench_random(&state) >> 32) * range) >> 32);
+        }
+        break;
+    case BENCH_INPUT_SORTED:
+        for (size_t i = 0; i < count; i++) values[i] = (int32_t)(i % range);
+        break;
+    case BENCH_INPUT_REVERSED:
+        for (size_t i = 0; i < count; i++) values[i] = (int32_t)((count - 1 - i) % range);
+        break;
+    case BENCH_INPUT_FEW_UNIQUE: {
+        int32_t step = (int32_t)(range / 16 > 0 ? range / 16 : 1);
+        for (size_t i = 0; i < count; i++) {
+            values[i] = (int32_t)(bench_random(&state) >> 60) * step;
+        }
+        break;
+    }
+    case BENCH_INPUT_ORGAN_PIPE:
+        for (size_t i = 0; i < count; i++) {
+            size_t rank = i < count / 2 ? i : count - 1 - i;
+            values[i] = (int32_t)(rank % range);
+        }
+        break;
+    }
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Median of `count` sorted values
+static double sorted_median(const double* sorted, int count) {
+    return count % 2 ? sorted[count / 2] : (sorted[count / 2 - 1] + sorted[count / 2]) / 2;
+}
+
+// Seconds for one batch of `iterations` calls
+static double time_batch(BenchFunction run, void* context, uint64_t iterations) {
+    double start = bench_seconds();
+    for (uint64_t i = 0; i < iterations; i++) run(context);
+    return bench_seconds() - start;
+}
+
+void bench_run(Bench* bench, BenchResult* result, const char* name, const char* input,
+               size_t items, BenchFunction run, BenchFunction setup, void* context) {
+    for (int i = 0; i < bench->warmup; i++) {
+        if (setup != NULL) setup(context);
+        run(context);
+    }
+
+    uint64_t iterations = 1;
+    if (setup == NULL) {
+        for (;;) {
+            double elapsed = time_batch(run, context, iterations);
+            if (elapsed >= bench->sample_seconds || iterations >= BENCH_MAX_ITERATIONS) break;
+            double scale = elapsed > 0 ? 1.1 * bench->sample_seconds / elapsed : 100;
+            if (scale > 100) scale = 100;
+            if (scale < 2) scale = 2;
+            iterations = (uint64_t)(iterations * scale);
+        }
+    }
+
+    int max_samples = bench->max_samples;
+    if (max_samples > BENCH_MAX_SAMPLES) max_samples = BENCH_MAX_SAMPLES;
+    if (max_samples < 1) max_samples = 1;
+    double samples[BENCH_MAX_SAMPLES];
+    double cycles[BENCH_MAX_SAMPLES];
+    PerfCounters* counters = bench->counters;
+    PerfSample totals;
+    memset(&totals, 0, sizeof(totals));
+    totals.available = counters != NULL ? counters->available : 0;
+    int count = 0;
+    double deadline = bench_seconds() + bench->max_seconds;
+    while (count < max_samples) {
+        if (setup != NULL) setup(context);
+        if (counters != NULL) perf_counters_start(counters);
+        uint64_t start_cycles = bench_cycles();
+        double start = bench_seconds();
+        for (uint64_t i = 0; i < iterations; i++) run(context);
+        double elapsed = bench_seconds() - start;
+        uint64_t end_cycles = bench_cycles();
+        if (counters != NULL) {
+            PerfSample sample;
+            perf_counters_stop(counters, &sample);
+            perf_sample_add(&totals, &sample);
+        }
+
+        samples[count] = elapsed * 1e9 / (double)iterations;
+        cycles[count] = (double)(end_cycles - start_cycles) / (double)iterations;
+        count++;
+        if (count >= bench->min_samples && bench_seconds() >= deadline) break;
+    }
+
+    qsort(samples, (size_t)count, sizeof(double), compare_doubles);
+    qsort(cycles, (size_t)count, sizeof(double), compare_doubles);
+    double median = sorted_median(samples, count);
+    double deviations[BENCH_MAX_SAMPLES];
+    for (int i = 0; i < count; i++) {
+        deviations[i] = samples[i] > median ? samples[i] - median : median - samples[i];
+    }
+    qsort(deviations, (size_t)count, sizeof(double), compare_doubles);
+    int p99_rank = (99 * count + 99) / 100;     // ceil(0.99 * count)
+
+    result->name = name;
+    result->input = input;
+    result->items = items;
+    result->iterations = iterations;
+    result->samples = count;
+    result->median_ns = median;
+    result->mad_ns = sorted_median(deviations, count);
+    result->p99_ns = samples[p99_rank - 1];
+    result->min_ns = samples[0];
+    result->median_cycles = BENCH_HAVE_TSC ? sorted_median(cycles, count) : 0;
+    result->counters.available = totals.available;
+    for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+        result->counters.values[c] =
+            (totals.available >> c) & 1u ? totals.values[c] / ((double)iterations * count) : 0;
+    }
+}
+
+// "12.3 ns", "4.56 us", "7.89 ms", "1.234 s"
+static void format_time(double ns, char* out, size_t size) {
+    if (ns < 1e3) {
+        snprintf(out, size, "%.1f ns", ns);
+    } else if (ns < 1e6) {
+        snprintf(out, size, "%.2f us", ns / 1e3);
+    } else if (ns < 1e9) {
+        snprintf(out, size, "%.2f ms", ns / 1e6);
+    } else {
+        snprintf(out, size, "%.3f s", ns / 1e9);
+    }
+}
+
+// The misses shown per result, in table, CSV and JSON order
+static const PerfCounter reported_misses[] = {
+    PERF_L1D_MISSES, PERF_LLC_MISSES, PERF_BRANCH_MISSES, PERF_DTLB_MISSES
+};
+static const char* const reported_names[] = {"l1d_mpki", "llc_mpki", "branch_mpki", "dtlb_mpki"};
+#define REPORTED_MISSES 4
+
+static int have_counters(const Bench* bench) {
+    return bench->counters != NULL && bench->counters->available != 0;
+}
+
+// `value` with `format`, or `missing` when it is negative (not available)
+static void print_metric(FILE* out, const char* format, double value, const char* missing) {
+    if (value >= 0) {
+        fprintf(out, format, value);
+    } else {
+        fputs(missing, out);
+    }
+}
+
+static void print_json_string(FILE* out, const char* text) {
+    fputc('"', out);
+    for (const char* p = text; *p != '\0'; p++) {
+        unsigned char c = (unsigned char)*p;
+        if (c == '"' || c == '\\') {
+            fprintf(out, "\\%c", c);
+        } else if (c < 0x20) {
+            fprintf(out, "\\u%04x", c);
+        } else {
+            fputc(c, out);
+        }
+    }
+    fputc('"', out);
+}
+
+// Quoted only when it has to be, with quotes doubled
+static void print_csv_field(FILE* out, const char* text) {
+    if (strpbrk(text, ",\"\n") == NULL) {
+        fputs(text, out);
+        return;
+    }
+    fputc('"', out);
+    for (const char* p = text; *p != '\0'; p++) {
+        if (*p == '"') fputc('"', out);
+        fputc(*p, out);
+    }
+    fputc('"', out);
+}
+
+void bench_begin(Bench* bench) {
+    bench->result_count = 0;
+    if (bench->use_counters && bench->counters == NULL) {
+        bench->counters = malloc(sizeof(PerfCounters));
+        if (bench->counters != NULL) perf_counters_open(bench->counters);
+    }
+    char status[160] = "Hardware counters off (--no-counters)";
+    if (bench->counters != NULL) perf_counters_status(bench->counters, status, sizeof(status));
+
+    switch (bench->format) {
+    case BENCH_FORMAT_CSV:
+        fprintf(bench->out, "name,input,items,iterations,samples,median_ns,mad_ns,p99_ns,"
+                            "min_ns,median_cycles,ns_per_item");
+        bench_print_counts_header(bench->out, bench->format);
+        fputc('\n', bench->out);
+        break;
+    case BENCH_FORMAT_JSON:
+        fprintf(bench->out, "{\n  \"seed\": %llu,\n  \"warmup\": %d,\n  \"counters\": ",
+                (unsigned long long)bench->seed, bench->warmup);
+        print_json_string(bench->out, status);
+        fprintf(bench->out, ",\n  \"results\": [");
+        break;
+    case BENCH_FORMAT_TEXT:
+        if (!have_counters(bench)) fprintf(bench->out, "%s\n", status);
+        fprintf(bench->out, "%-24s %-12s %11s %11s %9s %11s %13s %10s %7s", "name", "input",
+                "items", "median", "MAD", "p99", "cycles", "ns/item", "samples");
+        if (have_counters(bench)) bench_print_counts_header(bench->out, bench->format);
+        fputc('\n', bench->out);
+        break;
+    }
+}
+
+void bench_report(Bench* bench, const BenchResult* result) {
+    FILE* out = bench->out;
+    double per_item = result->items > 0 ? result->median_ns / (double)result->items : 0;
+
+    switch (bench->format) {
+    case BENCH_FORMAT_CSV:
+        print_csv_field(out, result->name);
+        fputc(',', out);
+        print_csv_field(out, result->input);
+        fprintf(out, ",%zu,%llu,%d,%.3f,%.3f,%.3f,%.3f,%.1f,%.4f", result->items,
+                (unsigned long long)result->iterations, result->samples, result->median_ns,
+                result->mad_ns, result->p99_ns, result->min_ns, result->median_cycles,
+                per_item);
+        bench_print_counts(out, bench->format, &result->counters);
+        fputc('\n', out);
+        break;
+    case BENCH_FORMAT_JSON:
+        fprintf(out, "%s\n    {\"name\": ", bench->result_count > 0 ? "," : "");
+        print_json_string(out, result->name);
+        fprintf(out, ", \"input\": ");
+        print_json_string(out, result->input);
+        fprintf(out, ", \"items\": %zu, \"iterations\": %llu, \"samples\": %d, "
+                     "\"median_ns\": %.3f, \"mad_ns\": %.3f, \"p99_ns\": %.3f, "
+                     "\"min_ns\": %.3f, \"median_cycles\": %.1f, \"ns_per_item\": %.4f",
+                result->items, (unsigned long long)result->iterations, result->samples,
+                result->median_ns, result->mad_ns, result->p99_ns, result->min_ns,
+                result->median_cycles, per_item);
+        bench_print_counts(out, bench->format, &result->counters);
+        fputc('}', out);
+        break;
+    case BENCH_FORMAT_TEXT: {
+        char median[24], mad[24], p99[24];
+        format_time(result->median_ns, median, sizeof(median));
+        format_time(result->mad_ns, mad, sizeof(mad));
+        format_time(result->p99_ns, p99, sizeof(p99));
+        fprintf(out, "%-24s %-12s %11zu %11s %9s %11s %13.0f %10.2f %7d", result->name,
+                result->input, result->items, median, mad, p99, result->median_cycles,
+                per_item, result->samples);
+        if (have_counters(bench)) bench_print_counts(out, bench->format, &result->counters);
+        fputc('\n', out);
+        break;
+    }
+    }
+    bench->result_count++;
+}
+
+void bench_print_counts_header(FILE* out, BenchFormat format) {
+    switch (format) {
+    case BENCH_FORMAT_CSV:
+        fprintf(out, ",ipc");
+        for (int i = 0; i < REPORTED_MISSES; i++) fprintf(out, ",%s", reported_names[i]);
+        break;
+    case BENCH_FORMAT_JSON:
+        break;
+    case BENCH_FORMAT_TEXT:
+        fprintf(out, " %6s %8s %8s %8s %8s", "IPC", "L1D/ki", "LLC/ki", "br/ki", "dTLB/ki");
+        break;
+    }
+}
+
+void bench_print_counts(FILE* out, BenchFormat format, const PerfSample* counts) {
+    switch (format) {
+    case BENCH_FORMAT_CSV:
+        fputc(',', out);
+        print_metric(out, "%.3f", perf_ipc(counts), "");
+        for (int i = 0; i < REPORTED_MISSES; i++) {
+            fputc(',', out);
+            print_metric(out, "%.3f", perf_mpki(counts, reported_misses[i]), "");
+        }
+        break;
+    case BENCH_FORMAT_JSON:
+        fprintf(out, ", \"ipc\": ");
+        print_metric(out, "%.3f", perf_ipc(counts), "null");
+        for (int i = 0; i < REPORTED_MISSES; i++) {
+            fprintf(out, ", \"%s\": ", reported_names[i]);
+            print_metric(out, "%.3f", perf_mpki(counts, reported_misses[i]), "null");
+        }
+        break;
+    case BENCH_FORMAT_TEXT:
+        print_metric(out, " %6.2f", perf_ipc(counts), "      -");
+        for (int i = 0; i < REPORTED_MISSES; i++) {
+            print_metric(out, " %8.2f", perf_mpki(counts, reported_misses[i]), "        -");
+        }
+        break;
+    }
+}
+
+void bench_timer_open(BenchTimer* timer) {
+    perf_counters_open(&timer->counters);
+    timer->start = 0;
+    memset(&timer->counts, 0, sizeof(timer->counts));
+}
+
+void bench_timer_close(BenchTimer* timer) {
+    perf_counters_close(&timer->counters);
+}
+
+void bench_timer_start(BenchTimer* timer) {
+    perf_counters_start(&timer->counters);
+    timer->start = bench_seconds();
+}
+
+double bench_timer_stop(BenchTimer* timer) {
+    double elapsed = bench_seconds() - timer->start;
+    perf_counters_stop(&timer->counters, &timer->counts);
+    return elapsed;
+}
+
+void bench_timer_print_status(const BenchTimer* timer, FILE* out) {
+    char status[160];
+    perf_counters_status(&timer->counters, status, sizeof(status));
+    fprintf(out, "%s\n", status);
+}
+
+const char* bench_counts_text(const PerfSample* counts, char* out, size_t size) {
+    char summary[128];
+    perf_format_summary(counts, summary, sizeof(summary));
+    snprintf(out, size, "%s%s", summary[0] != '\0' ? "  " : "", summary);
+    return out;
+}
+
+void bench_end(Bench* bench) {
+    if (bench->format == BENCH_FORMAT_JSON) fprintf(bench->out, "\n  ]\n}\n");
+    fflush(bench->out);
+    if (bench->counters != NULL) {
+        perf_counters_close(bench->counters);
+        free(bench->counters);
+        bench->counters = NULL;
+    }
+}
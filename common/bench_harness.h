@@ -0,0 +1,177 @@
+/*
+ * bench_harness.h - Repeatable micro-benchmarks with statistics
+ *
+ * Timing one run with clock() answers "how long did that take once?",
+ * not "how fast is it?": the first run pays for page faults and cold
+ * caches, a short run is below the timer's resolution, one run can't
+ * tell a 5% improvement from noise, clock() counts CPU time instead of
+ * elapsed time, and input generated with srand(time(NULL)) differs on
+ * every run. This harness:
+ * - runs the code untimed `warmup` times first
+ * - calibrates how many calls make up one timed sample, so every sample
+ *   lasts at least `sample_seconds` (a setup function, run untimed
+ *   before each call - copying the unsorted input back - forces one
+ *   call per sample)
+ * - collects samples until `max_seconds` have passed, but at least
+ *   `min_samples` and at most `max_samples`
+ * - reports per call: the median (robust against a few slow samples),
+ *   the median absolute deviation (MAD, the spread), p99 (nearest rank)
+ *   and minimum, measured with CLOCK_MONOTONIC, plus the median in TSC
+ *   cycles on x86 (reference cycles, which tick at a fixed rate)
+ * - counts hardware events around the same samples (perf_counters.h):
+ *   IPC and cache, branch and TLB misses per 1000 instructions, where
+ *   the machine allows it (--no-counters turns them off)
+ * - generates inputs (random, sorted, reversed, few unique values, organ
+ *   pipe) from a seed, so every run and every machine sorts the same data
+ * - prints results as an aligned table, CSV or JSON (--format)
+ *
+ * Benchmarks that time their own code and print their own lines (one
+ * pass over a file, a best-of-3 loop) use a BenchTimer instead: the wall
+ * time of one start/stop plus its counts, and bench_counts_text() to put
+ * "IPC ... /1k instr" at the end of the line (bench_print_counts() when
+ * the line is a table, CSV or JSON row).
+ *
+ * Typical use:
+ *   Bench bench;
+ *   bench_init(&bench);
+ *   if (bench_parse_args(&bench, &argc, argv) != 0) return usage();
+ *   bench_begin(&bench);
+ *   BenchResult result;
+ *   bench_run(&bench, &result, "pdqsort", "random", count, run, setup, &context);
+ *   bench_report(&bench, &result);
+ *   bench_end(&bench);
+ *
+ *   static BenchTimer timer;
+ *   bench_timer_open(&timer);
+ *   bench_timer_print_status(&timer, stdout);
+ *   bench_timer_start(&timer);
+ *   ...
+ *   double seconds = bench_timer_stop(&timer);
+ *   char counts[BENCH_COUNTS_TEXT_SIZE];
+ *   printf("%.3f s%s\n", seconds, bench_counts_text(&timer.counts, counts, sizeof(counts)));
+ *
+ * For frontend developers: What benchmark.js or Vitest's bench() do for
+ * JavaScript: warm up, repeat, and report statistics instead of one
+ * performance.now() difference.
+ */
+
+#ifndef BENCH_HARNESS_H
+#define BENCH_HARNESS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "perf_counters.h"
+
+#define BENCH_MAX_SAMPLES 1000
+#define BENCH_COUNTS_TEXT_SIZE 144
+
+// Options bench_parse_args() understands, for usage messages
+#define BENCH_OPTIONS_USAGE \
+    "[--format text|csv|json] [--seed N] [--samples N] [--warmup N] [--max-seconds S] " \
+    "[--no-counters]"
+
+typedef enum { BENCH_FORMAT_TEXT, BENCH_FORMAT_CSV, BENCH_FORMAT_JSON } BenchFormat;
+
+typedef enum {
+    BENCH_INPUT_RANDOM,         // Uniform in [0, count)
+    BENCH_INPUT_SORTED,         // 0, 1, 2, ...
+    BENCH_INPUT_REVERSED,       // count - 1, count - 2, ...
+    BENCH_INPUT_FEW_UNIQUE,     // 16 distinct values, random order
+    BENCH_INPUT_ORGAN_PIPE      // Ascending to the middle, then descending
+} BenchInput;
+#define BENCH_INPUT_COUNT 5
+
+typedef struct {
+    BenchFormat format;
+    FILE* out;
+    uint64_t seed;              // For bench_fill_int32() and the caller's own inputs
+    int warmup;                 // Untimed runs before calibrating
+    int min_samples;
+    int max_samples;            // At most BENCH_MAX_SAMPLES
+    double sample_seconds;      // Minimum length of one sample
+    double max_seconds;         // Stop sampling after this, once min_samples are in
+    int result_count;           // Results reported so far
+    int use_counters;           // Open hardware counters in bench_begin()
+    PerfCounters* counters;     // NULL outside bench_begin() / bench_end()
+} Bench;
+
+// Every time is per call of the benchmarked function
+typedef struct {
+    const char* name;
+    const char* input;          // Label of the input ("random", "1000 x 1000", ...)
+    size_t items;               // Elements per call, for ns per item; 0 = none
+    uint64_t iterations;        // Calls per sample
+    int samples;
+    double median_ns;
+    double mad_ns;              // Median absolute deviation from the median
+    double p99_ns;
+    double min_ns;
+    double median_cycles;       // TSC cycles; 0 where there is no TSC
+    PerfSample counters;        // Per call, over all samples; nothing available without counters
+} BenchResult;
+
+typedef void (*BenchFunction)(void* context);
+
+// One hand-timed region at a time; counts cover every thread started
+// after bench_timer_open()
+typedef struct {
+    PerfCounters counters;
+    double start;               // bench_seconds() at bench_timer_start()
+    PerfSample counts;          // Of the last bench_timer_stop()
+} BenchTimer;
+
+// Defaults: text on stdout, seed 42, 1 warmup run, 5-100 samples of at
+// least 5 ms, 0.5 s per benchmark
+void bench_init(Bench* bench);
+
+// Take the harness options (BENCH_OPTIONS_USAGE) out of argv, leaving
+// the program's own arguments. Returns 0, or -1 with errno = EINVAL for
+// a missing or bad value.
+int bench_parse_args(Bench* bench, int* argc, char* argv[]);
+
+// Time run(context). setup(context), if not NULL, runs untimed before
+// every call. Fills `result`; prints nothing.
+void bench_run(Bench* bench, BenchResult* result, const char* name, const char* input,
+               size_t items, BenchFunction run, BenchFunction setup, void* context);
+
+// Table header / opening bracket, one result line, closing bracket.
+// bench_begin() opens the hardware counters and bench_end() closes them.
+void bench_begin(Bench* bench);
+void bench_report(Bench* bench, const BenchResult* result);
+void bench_end(Bench* bench);
+
+// The IPC and misses-per-1k-instruction columns of a result line, each after
+// its separator (",1.234" in CSV, ", \"ipc\": 1.234" in JSON, " 1.23" in a
+// table), for tools that print their own rows; the JSON header is empty
+void bench_print_counts_header(FILE* out, BenchFormat format);
+void bench_print_counts(FILE* out, BenchFormat format, const PerfSample* counts);
+
+// Open the hardware counters (whatever can be opened) / close them
+void bench_timer_open(BenchTimer* timer);
+void bench_timer_close(BenchTimer* timer);
+
+// Seconds since bench_timer_start(); the counts go to timer->counts
+void bench_timer_start(BenchTimer* timer);
+double bench_timer_stop(BenchTimer* timer);
+
+// "6 of 6 hardware counters", or fewer and why, on a line of its own
+void bench_timer_print_status(const BenchTimer* timer, FILE* out);
+
+// "  IPC 2.31  L1D 12.3 ... /1k instr" to end a result line, or "" when
+// nothing was counted. Returns `out`.
+const char* bench_counts_text(const PerfSample* counts, char* out, size_t size);
+
+// Seeded input of `count` values; the same seed always gives the same values
+void bench_fill_int32(int32_t* values, size_t count, BenchInput input, uint64_t seed);
+const char* bench_input_name(BenchInput input);
+
+// splitmix64: the next value of the sequence started at *state
+uint64_t bench_random(uint64_t* state);
+
+// CLOCK_MONOTONIC seconds, and the TSC (0 where there is none)
+double bench_seconds(void);
+uint64_t bench_cycles(void);
+
+#endif // BENCH_HARNESS_H
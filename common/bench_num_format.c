@@ -0,0 +1,161 @@
+/*
+ * bench_num_format.c - snprintf() vs. num_format
+ *
+ * Formats a column of numbers per kind - ages (1-2 digits), IDs (7
+ * digits), full-range 64-bit values, and the same values in hex, binary
+ * and grouped decimal - once with snprintf() (or, for binary, the
+ * bit-by-bit loop print_binary() used to run) and once with num_format,
+ * and reports nanoseconds per number.
+ *
+ * Every num_format result is compared with the reference output and
+ * mismatches are counted. The output lengths are summed so the compiler
+ * can't drop either loop.
+ *
+ * Usage: ./bench_num_format [numbers per kind]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_harness.h"
+#include "num_format.h"
+
+typedef enum { KIND_AGE, KIND_ID, KIND_U64, KIND_HEX, KIND_BINARY, KIND_GROUPED } FormatKind;
+
+static uint64_t rng_state = 88172645463325252ull;
+
+static uint64_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static BenchTimer timer;
+
+// Bit at a time, most significant first: what the lesson's print_binary()
+// did, writing into a buffer instead of calling printf per bit
+static size_t binary_bit_loop(char* out, uint64_t value) {
+    int top = 63;
+    while (top > 0 && !((value >> top) & 1)) top--;
+    size_t n = 0;
+    for (int bit = top; bit >= 0; bit--) out[n++] = (char)('0' + ((value >> bit) & 1));
+    out[n] = '\0';
+    return n;
+}
+
+// snprintf() has no grouping flag (the ' flag is POSIX and locale-dependent),
+// so the reference inserts the commas afterwards
+static size_t grouped_snprintf(char* out, uint64_t value) {
+    char digits[FORMAT_DECIMAL_SIZE];
+    int count = snprintf(digits, sizeof(digits), "%" PRIu64, value);
+    size_t n = 0;
+    for (int i = 0; i < count; i++) {
+        if (i > 0 && (count - i) % 3 == 0) out[n++] = ',';
+        out[n++] = digits[i];
+    }
+    out[n] = '\0';
+    return n;
+}
+
+static size_t reference(char* out, FormatKind kind, uint64_t value) {
+    switch (kind) {
+    case KIND_HEX:
+        return (size_t)snprintf(out, FORMAT_MAX_SIZE, "%" PRIx64, value);
+    case KIND_BINARY:
+        return binary_bit_loop(out, value);
+    case KIND_GROUPED:
+        return grouped_snprintf(out, value);
+    default:
+        return (size_t)snprintf(out, FORMAT_MAX_SIZE, "%" PRIu64, value);
+    }
+}
+
+static size_t fast(char* out, FormatKind kind, uint64_t value) {
+    static const NumberFormat grouped = {10, 0, 0, ',', 3, 0};
+    switch (kind) {
+    case KIND_HEX:
+        return format_hex64(out, value, 0);
+    case KIND_BINARY:
+        return format_binary64(out, value);
+    case KIND_GROUPED:
+        return format_unsigned(out, value, &grouped);
+    default:
+        return format_uint64(out, value);
+    }
+}
+
+static uint64_t make_value(FormatKind kind) {
+    if (kind == KIND_AGE) return 18 + next_random() % 50;
+    if (kind == KIND_ID) return 1000000 + next_random() % 9000000;
+    // Spread over all magnitudes, not just 19-20 digit numbers
+    return next_random() >> (next_random() % 64);
+}
+
+// One result line, with the counts of the last bench_timer_stop()
+static void report(const char* label, size_t count, double seconds, size_t bytes) {
+    char counts[BENCH_COUNTS_TEXT_SIZE];
+    printf("    %-22s %7.2f ns/number  %8.1f MB/s%s\n", label, seconds * 1e9 / count,
+           bytes / seconds / (1024.0 * 1024.0),
+           bench_counts_text(&timer.counts, counts, sizeof(counts)));
+}
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? (size_t)atol(argv[1]) : 5000000;
+    if (count == 0) {
+        fprintf(stderr, "Usage: %s [numbers per kind]\n", argv[0]);
+        return 1;
+    }
+    uint64_t* values = malloc(count * sizeof(uint64_t));
+    if (values == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    static const char* const names[] = {
+        "Ages (1-2 digits)", "IDs (7 digits)", "64-bit values, decimal",
+        "64-bit values, hex", "64-bit values, binary", "64-bit values, \"1,234,567\""
+    };
+    static const char* const reference_names[] = {
+        "snprintf %d", "snprintf %d", "snprintf %llu", "snprintf %llx", "bit-by-bit loop",
+        "snprintf + commas"
+    };
+    static const char* const fast_names[] = {
+        "format_uint64", "format_uint64", "format_uint64", "format_hex64", "format_binary64",
+        "format_unsigned"
+    };
+    bench_timer_open(&timer);
+    printf("Integer formatting benchmark: %zu numbers per kind\n", count);
+    bench_timer_print_status(&timer, stdout);
+
+    char buffer[FORMAT_MAX_SIZE], expected[FORMAT_MAX_SIZE];
+    for (int kind = KIND_AGE; kind <= KIND_GROUPED; kind++) {
+        for (size_t i = 0; i < count; i++) values[i] = make_value((FormatKind)kind);
+        printf("  %s:\n", names[kind]);
+
+        size_t bytes = 0;
+        bench_timer_start(&timer);
+        for (size_t i = 0; i < count; i++) bytes += reference(buffer, (FormatKind)kind, values[i]);
+        report(reference_names[kind], count, bench_timer_stop(&timer), bytes);
+
+        bytes = 0;
+        bench_timer_start(&timer);
+        for (size_t i = 0; i < count; i++) bytes += fast(buffer, (FormatKind)kind, values[i]);
+        report(fast_names[kind], count, bench_timer_stop(&timer), bytes);
+
+        size_t mismatches = 0;
+        for (size_t i = 0; i < count; i++) {
+            reference(expected, (FormatKind)kind, values[i]);
+            fast(buffer, (FormatKind)kind, values[i]);
+            if (strcmp(buffer, expected) != 0) mismatches++;
+        }
+        printf("    mismatches: %zu\n", mismatches);
+    }
+    free(values);
+    bench_timer_close(&timer);
+    return 0;
+}
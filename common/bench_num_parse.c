@@ -0,0 +1,187 @@
+/*
+ * bench_num_parse.c - atoi()/strtol()/atof()/strtod() vs. num_parse
+ *
+ * Generates a column of numbers per kind - ages (1-2 digits), IDs (7
+ * digits), salaries ("54321.37"), and arbitrary doubles printed with
+ * 17 significant digits - and converts each column with the C library
+ * and with num_parse, in nanoseconds per number and MB/s of text.
+ *
+ * The strings are NUL-terminated, which is the best case for the C
+ * library: parsing a CSV field with it would also need a copy first.
+ * Every num_parse result is compared with strtod()/strtoll() and
+ * mismatches are counted.
+ *
+ * Usage: ./bench_num_parse [numbers per kind]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_harness.h"
+#include "num_parse.h"
+
+typedef struct {
+    char* text;             // All numbers, each followed by '\0'
+    size_t* offsets;
+    size_t* lengths;
+    size_t count;
+    size_t bytes;           // Text bytes, terminators not counted
+} NumberColumn;
+
+typedef enum { KIND_AGE, KIND_ID, KIND_SALARY, KIND_DOUBLE } NumberKind;
+
+static uint64_t rng_state = 88172645463325252ull;
+
+static uint64_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static BenchTimer timer;
+
+static int make_column(NumberColumn* column, NumberKind kind, size_t count) {
+    column->text = malloc(count * 26);
+    column->offsets = malloc(count * sizeof(size_t));
+    column->lengths = malloc(count * sizeof(size_t));
+    if (column->text == NULL || column->offsets == NULL || column->lengths == NULL) return -1;
+
+    size_t used = 0;
+    for (size_t i = 0; i < count; i++) {
+        char* out = column->text + used;
+        int n;
+        if (kind == KIND_AGE) {
+            n = sprintf(out, "%d", (int)(18 + next_random() % 50));
+        } else if (kind == KIND_ID) {
+            n = sprintf(out, "%d", (int)(1000000 + next_random() % 9000000));
+        } else if (kind == KIND_SALARY) {
+            n = sprintf(out, "%d.%02d", (int)(30000 + next_random() % 150000),
+                        (int)(next_random() % 100));
+        } else {
+            double value = (double)(next_random() >> 11) / (double)(1ull << 53);
+            value *= 1e-5 * (double)(next_random() % 20000000);
+            n = sprintf(out, "%.17g", value);
+        }
+        column->offsets[i] = used;
+        column->lengths[i] = (size_t)n;
+        used += (size_t)n + 1;
+    }
+    column->count = count;
+    column->bytes = used - count;
+    return 0;
+}
+
+static void free_column(NumberColumn* column) {
+    free(column->text);
+    free(column->offsets);
+    free(column->lengths);
+}
+
+// One result line, with the counts of the last bench_timer_stop()
+static void report(const char* label, const NumberColumn* column, double seconds, double sum) {
+    char counts[BENCH_COUNTS_TEXT_SIZE];
+    printf("    %-22s %7.2f ns/number  %8.1f MB/s  (sum %.6g)%s\n", label,
+           seconds * 1e9 / column->count, column->bytes / seconds / (1024.0 * 1024.0), sum,
+           bench_counts_text(&timer.counts, counts, sizeof(counts)));
+}
+
+static void bench_integers(const NumberColumn* c) {
+    double sum = 0;
+    bench_timer_start(&timer);
+    for (size_t i = 0; i < c->count; i++) sum += atoi(c->text + c->offsets[i]);
+    report("atoi", c, bench_timer_stop(&timer), sum);
+
+    sum = 0;
+    bench_timer_start(&timer);
+    for (size_t i = 0; i < c->count; i++) sum += (double)strtoll(c->text + c->offsets[i], NULL, 10);
+    report("strtoll", c, bench_timer_stop(&timer), sum);
+
+    sum = 0;
+    bench_timer_start(&timer);
+    for (size_t i = 0; i < c->count; i++) {
+        int64_t value;
+        if (parse_int64(c->text + c->offsets[i], c->lengths[i], &value) == 0) sum += (double)value;
+    }
+    report("parse_int64", c, bench_timer_stop(&timer), sum);
+}
+
+static void bench_floats(const NumberColumn* c) {
+    double sum = 0;
+    bench_timer_start(&timer);
+    for (size_t i = 0; i < c->count; i++) sum += atof(c->text + c->offsets[i]);
+    report("atof", c, bench_timer_stop(&timer), sum);
+
+    sum = 0;
+    bench_timer_start(&timer);
+    for (size_t i = 0; i < c->count; i++) sum += strtod(c->text + c->offsets[i], NULL);
+    report("strtod", c, bench_timer_stop(&timer), sum);
+
+    sum = 0;
+    bench_timer_start(&timer);
+    for (size_t i = 0; i < c->count; i++) {
+        double value;
+        if (parse_double(c->text + c->offsets[i], c->lengths[i], &value) == 0) sum += value;
+    }
+    report("parse_double", c, bench_timer_stop(&timer), sum);
+}
+
+// Bit-for-bit comparison with the C library
+static size_t count_mismatches(const NumberColumn* c, int integers) {
+    size_t mismatches = 0;
+    for (size_t i = 0; i < c->count; i++) {
+        const char* text = c->text + c->offsets[i];
+        if (integers) {
+            int64_t value;
+            if (parse_int64(text, c->lengths[i], &value) != 0 || value != strtoll(text, NULL, 10)) {
+                mismatches++;
+            }
+        } else {
+            double value, expected = strtod(text, NULL);
+            if (parse_double(text, c->lengths[i], &value) != 0 ||
+                memcmp(&value, &expected, sizeof(double)) != 0) {
+                mismatches++;
+            }
+        }
+    }
+    return mismatches;
+}
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? (size_t)atol(argv[1]) : 5000000;
+    if (count == 0) {
+        fprintf(stderr, "Usage: %s [numbers per kind]\n", argv[0]);
+        return 1;
+    }
+
+    static const char* const names[] = {
+        "Ages (1-2 digits)", "IDs (7 digits)", "Salaries (\"54321.37\")", "Doubles (%.17g)"
+    };
+    bench_timer_open(&timer);
+    printf("Numeric parsing benchmark: %zu numbers per kind\n", count);
+    bench_timer_print_status(&timer, stdout);
+
+    for (int kind = KIND_AGE; kind <= KIND_DOUBLE; kind++) {
+        NumberColumn column;
+        if (make_column(&column, (NumberKind)kind, count) != 0) {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+        int integers = kind == KIND_AGE || kind == KIND_ID;
+        printf("  %s, %.1f bytes each:\n", names[kind], (double)column.bytes / count);
+        if (integers) {
+            bench_integers(&column);
+        } else {
+            bench_floats(&column);
+        }
+        printf("    mismatches vs. %s: %zu\n", integers ? "strtoll" : "strtod",
+               count_mismatches(&column, integers));
+        free_column(&column);
+    }
+    bench_timer_close(&timer);
+    return 0;
+}
@@ -0,0 +1,291 @@
+/*
+ * bench_out_sink.c - printf() per line vs. an OutSink
+ *
+ * Writes the same employee listing file_processing prints -
+ *   "  Employee 17: ID=1017, Name="Alice Johnson", Email=..., Age=28, Salary=$75000.50"
+ * - to /dev/null (or the file given) in several ways and reports lines
+ * per second:
+ * - write(2) per line: snprintf() into a line buffer, one system call each
+ * - fprintf() with stdio's default buffer, and with a 64 KB setvbuf()
+ * - OutSink in OUT_SINK_LOCKED and OUT_SINK_UNLOCKED mode
+ *
+ * /dev/null makes every write(2) free of I/O, so what's left is exactly
+ * the formatting, locking and system-call overhead per line. With a real
+ * file, the page cache copy is added to every method alike. The hardware
+ * counts are user space only: the write(2) calls themselves aren't in them.
+ *
+ * Before timing, 100000 lines from fprintf() and from an OutSink are
+ * written to two temporary files and compared byte for byte. Then four
+ * threads write 25000 lines each to one OUT_SINK_LOCKED sink, holding
+ * out_sink_lock() for a whole line, and every line must come out intact.
+ *
+ * Usage: ./bench_out_sink [lines] [output file]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench_harness.h"
+#include "out_sink.h"
+
+typedef struct {
+    int id;
+    const char* name;
+    const char* email;
+    int age;
+    double salary;
+} Employee;
+
+static const char* const NAMES[] = {
+    "Alice Johnson", "Bob Smith", "Carol Davis", "David Wilson", "Eve Brown", "Garcia, Frank",
+    "Hannah \"Hank\" Lee", "Ivan Petrov"
+};
+static const char* const EMAILS[] = {
+    "alice@company.com", "bob@company.com", "carol@company.com", "david@company.com",
+    "eve@company.com", "frank@company.com", "hannah@company.com", "ivan@company.com"
+};
+
+#define EMPLOYEE_COUNT 4096
+
+static Employee employees[EMPLOYEE_COUNT];
+
+static uint64_t rng_state = 88172645463325252ull;
+
+static uint64_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static BenchTimer timer;
+
+static void make_employees(void) {
+    for (int i = 0; i < EMPLOYEE_COUNT; i++) {
+        employees[i].id = 1001 + i;
+        employees[i].name = NAMES[next_random() % 8];
+        employees[i].email = EMAILS[next_random() % 8];
+        employees[i].age = 22 + (int)(next_random() % 43);
+        employees[i].salary = (double)(3000000 + next_random() % 12000000) / 100.0;
+    }
+}
+
+#define EMPLOYEE_FORMAT "  Employee %zu: ID=%d, Name=\"%s\", Email=%s, Age=%d, Salary=$%.2f\n"
+
+static int print_employee(FILE* file, size_t n, const Employee* e) {
+    return fprintf(file, EMPLOYEE_FORMAT, n, e->id, e->name, e->email, e->age, e->salary);
+}
+
+static void sink_employee(OutSink* sink, size_t n, const Employee* e) {
+    out_str(sink, "  Employee ");
+    out_uint(sink, n);
+    out_str(sink, ": ID=");
+    out_int(sink, e->id);
+    out_str(sink, ", Name=\"");
+    out_str(sink, e->name);
+    out_str(sink, "\", Email=");
+    out_str(sink, e->email);
+    out_str(sink, ", Age=");
+    out_int(sink, e->age);
+    out_str(sink, ", Salary=$");
+    out_double(sink, e->salary, 2);
+    out_char(sink, '\n');
+}
+
+// calls = 0: not counted (stdio makes its write(2) calls out of sight).
+// The counts are those of the last bench_timer_stop().
+static void report(const char* label, size_t lines, double seconds, double bytes, size_t calls) {
+    char counts[BENCH_COUNTS_TEXT_SIZE];
+    printf("  %-26s %12.0f lines/s  %7.1f ns/line  %8.1f MB/s", label, lines / seconds,
+           seconds * 1e9 / lines, bytes / seconds / (1024.0 * 1024.0));
+    if (calls > 0) printf("  %10zu write calls", calls);
+    printf("%s\n", bench_counts_text(&timer.counts, counts, sizeof(counts)));
+}
+
+static double bench_write_per_line(int fd, size_t lines, size_t* bytes) {
+    char line[256];
+    *bytes = 0;
+    bench_timer_start(&timer);
+    for (size_t i = 0; i < lines; i++) {
+        const Employee* e = &employees[i % EMPLOYEE_COUNT];
+        int length = snprintf(line, sizeof(line), EMPLOYEE_FORMAT, i + 1, e->id, e->name,
+                              e->email, e->age, e->salary);
+        if (write(fd, line, (size_t)length) != length) return -1;
+        *bytes += (size_t)length;
+    }
+    return bench_timer_stop(&timer);
+}
+
+// buffer_size 0 keeps stdio's default buffer
+static double bench_fprintf(const char* path, size_t lines, size_t buffer_size, size_t* bytes) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) return -1;
+    if (buffer_size > 0) setvbuf(file, NULL, _IOFBF, buffer_size);
+    // ftell() is 0 on /dev/null: count what fprintf() reports instead
+    *bytes = 0;
+    bench_timer_start(&timer);
+    for (size_t i = 0; i < lines; i++) {
+        *bytes += (size_t)print_employee(file, i + 1, &employees[i % EMPLOYEE_COUNT]);
+    }
+    fflush(file);
+    double seconds = bench_timer_stop(&timer);
+    fclose(file);
+    return seconds;
+}
+
+static double bench_sink(int fd, size_t lines, OutSinkMode mode, size_t* bytes, size_t* calls) {
+    OutSink sink;
+    if (out_sink_init(&sink, fd, 0, mode) != 0) return -1;
+    bench_timer_start(&timer);
+    for (size_t i = 0; i < lines; i++) sink_employee(&sink, i + 1, &employees[i % EMPLOYEE_COUNT]);
+    out_sink_flush(&sink);
+    double seconds = bench_timer_stop(&timer);
+    *bytes = (size_t)sink.bytes_written;
+    *calls = (size_t)sink.flushes;
+    return out_sink_close(&sink) == 0 ? seconds : -1;
+}
+
+// Same bytes from fprintf() and from the sink?
+static int check_output(size_t lines) {
+    FILE* expected = tmpfile();
+    FILE* actual = tmpfile();
+    if (expected == NULL || actual == NULL) return -1;
+
+    for (size_t i = 0; i < lines; i++) print_employee(expected, i + 1, &employees[i % EMPLOYEE_COUNT]);
+    fflush(expected);
+    OutSink sink;
+    if (out_sink_init(&sink, fileno(actual), 0, OUT_SINK_UNLOCKED) != 0) return -1;
+    for (size_t i = 0; i < lines; i++) sink_employee(&sink, i + 1, &employees[i % EMPLOYEE_COUNT]);
+    if (out_sink_close(&sink) != 0) return -1;
+
+    int same = 1;
+    char a[65536], b[65536];
+    rewind(expected);
+    lseek(fileno(actual), 0, SEEK_SET);
+    for (;;) {
+        size_t na = fread(a, 1, sizeof(a), expected);
+        ssize_t nb = read(fileno(actual), b, na > 0 ? na : 1);
+        if (nb < 0 || (size_t)nb != na || memcmp(a, b, na) != 0) {
+            same = 0;
+            break;
+        }
+        if (na == 0) break;
+    }
+    fclose(expected);
+    fclose(actual);
+    return same;
+}
+
+#define CHECK_THREADS 4
+
+typedef struct {
+    OutSink* sink;
+    size_t first;       // Line numbers first + 1 .. first + lines
+    size_t lines;
+} SinkWriter;
+
+static void* write_locked_lines(void* argument) {
+    SinkWriter* writer = argument;
+    for (size_t i = 0; i < writer->lines; i++) {
+        size_t n = writer->first + i + 1;
+        out_sink_lock(writer->sink);
+        sink_employee(writer->sink, n, &employees[n % EMPLOYEE_COUNT]);
+        out_sink_unlock(writer->sink);
+    }
+    return NULL;
+}
+
+// Threads writing whole lines under out_sink_lock(): is every line there
+// once, and none torn apart by another thread's?
+static int check_locked_threads(size_t lines_per_thread) {
+    FILE* file = tmpfile();
+    size_t total = CHECK_THREADS * lines_per_thread;
+    unsigned char* seen = calloc(total + 1, 1);
+    if (file == NULL || seen == NULL) return -1;
+
+    // A small buffer, so flushes happen in the middle of lines
+    OutSink sink;
+    if (out_sink_init(&sink, fileno(file), 4096, OUT_SINK_LOCKED) != 0) return -1;
+    pthread_t threads[CHECK_THREADS];
+    SinkWriter writers[CHECK_THREADS];
+    for (int t = 0; t < CHECK_THREADS; t++) {
+        writers[t] = (SinkWriter){&sink, t * lines_per_thread, lines_per_thread};
+        if (pthread_create(&threads[t], NULL, write_locked_lines, &writers[t]) != 0) return -1;
+    }
+    for (int t = 0; t < CHECK_THREADS; t++) pthread_join(threads[t], NULL);
+    if (out_sink_close(&sink) != 0) return -1;
+
+    int same = 1;
+    size_t count = 0;
+    char line[256], expected[256];
+    rewind(file);
+    while (same && fgets(line, sizeof(line), file) != NULL) {
+        size_t n;
+        if (sscanf(line, "  Employee %zu:", &n) != 1 || n == 0 || n > total || seen[n]) {
+            same = 0;
+            break;
+        }
+        const Employee* e = &employees[n % EMPLOYEE_COUNT];
+        snprintf(expected, sizeof(expected), EMPLOYEE_FORMAT, n, e->id, e->name, e->email,
+                 e->age, e->salary);
+        same = strcmp(line, expected) == 0;
+        seen[n] = 1;
+        count++;
+    }
+    if (count != total) same = 0;
+    fclose(file);
+    free(seen);
+    return same;
+}
+
+int main(int argc, char* argv[]) {
+    size_t lines = argc > 1 ? (size_t)atol(argv[1]) : 2000000;
+    const char* path = argc > 2 ? argv[2] : "/dev/null";
+    if (lines == 0) {
+        fprintf(stderr, "Usage: %s [lines] [output file]\n", argv[0]);
+        return 1;
+    }
+
+    make_employees();
+    bench_timer_open(&timer);
+    bench_timer_print_status(&timer, stdout);
+    int same = check_output(100000);
+    printf("Output check (100000 lines, fprintf vs. OutSink): %s\n",
+           same == 1 ? "identical" : same == 0 ? "DIFFERENT" : "failed");
+    int intact = check_locked_threads(25000);
+    printf("Locked check (%d threads x 25000 lines, out_sink_lock() per line): %s\n",
+           CHECK_THREADS, intact == 1 ? "intact" : intact == 0 ? "TORN OR MISSING" : "failed");
+    printf("Writing %zu employee lines to %s:\n", lines, path);
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror(path);
+        return 1;
+    }
+
+    size_t bytes, calls;
+    double seconds = bench_write_per_line(fd, lines, &bytes);
+    if (seconds > 0) report("write(2) per line", lines, seconds, (double)bytes, lines);
+
+    seconds = bench_fprintf(path, lines, 0, &bytes);
+    if (seconds > 0) report("fprintf, default buffer", lines, seconds, (double)bytes, 0);
+    seconds = bench_fprintf(path, lines, 65536, &bytes);
+    if (seconds > 0) report("fprintf, 64 KB buffer", lines, seconds, (double)bytes, 0);
+
+    lseek(fd, 0, SEEK_SET);
+    seconds = bench_sink(fd, lines, OUT_SINK_LOCKED, &bytes, &calls);
+    if (seconds > 0) report("OutSink, locked", lines, seconds, (double)bytes, calls);
+    lseek(fd, 0, SEEK_SET);
+    seconds = bench_sink(fd, lines, OUT_SINK_UNLOCKED, &bytes, &calls);
+    if (seconds > 0) report("OutSink, unlocked", lines, seconds, (double)bytes, calls);
+
+    close(fd);
+    bench_timer_close(&timer);
+    return same == 1 && intact == 1 ? 0 : 1;
+}
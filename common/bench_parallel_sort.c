@@ -0,0 +1,184 @@
+/*
+ * bench_parallel_sort.c - Speedup curve of parallel_sort_int32()
+ *
+ * Sorts the same random int32 array with sort_int32() (pdqsort, one
+ * thread) and with parallel_sort_int32() on pools of 1, 2, 4, 8, ...
+ * threads up to the given maximum (default: one per CPU), and reports
+ * milliseconds (best of 3), the speedup over sort_int32(), the parallel
+ * efficiency (speedup / threads) and how many tasks were stolen.
+ * Then the same for int64 values.
+ *
+ * A sort moves every element about log2(pieces) + 1 times through
+ * memory, so on a many-core machine the curve flattens when memory
+ * bandwidth runs out, usually well before the core count. With more
+ * threads than CPUs there is nothing to gain; expect the curve to stay
+ * near 1x (the threads take turns).
+ *
+ * Every result is compared with sort_int32()'s; mismatches are reported.
+ *
+ * Usage: ./bench_parallel_sort [values] [max threads]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench_harness.h"
+#include "parallel_sort.h"
+#include "sort.h"
+
+#define REPEATS 3
+
+static uint64_t rng_state = 88172645463325252ull;
+
+static uint64_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static BenchTimer timer;
+static PerfSample best_counts;      // Of the fastest run in the last TIME_SORT()
+
+// Thread counts to measure: powers of two below max, then max
+static int thread_steps(int max_threads, int* steps) {
+    int count = 0;
+    for (int threads = 1; threads < max_threads; threads *= 2) steps[count++] = threads;
+    steps[count++] = max_threads;
+    return count;
+}
+
+// Best of REPEATS runs; *matches is cleared if any result differs
+#define TIME_SORT(seconds, matches, values, input, expected, count, call)           \
+    do {                                                                            \
+        (seconds) = 1e30;                                                           \
+        for (int repeat = 0; repeat < REPEATS; repeat++) {                          \
+            memcpy((values), (input), (count) * sizeof(*(values)));                 \
+            bench_timer_start(&timer);                                              \
+            int status = (call);                                                    \
+            double elapsed = bench_timer_stop(&timer);                              \
+            if (elapsed < (seconds)) {                                              \
+                (seconds) = elapsed;                                                \
+                best_counts = timer.counts;                                         \
+            }                                                                       \
+            if (status != 0 ||                                                      \
+                memcmp((values), (expected), (count) * sizeof(*(values))) != 0) {   \
+                (matches) = 0;                                                      \
+            }                                                                       \
+        }                                                                           \
+    } while (0)
+
+static void report_header(void) {
+    printf("    %-8s %10s  %8s  %10s  %8s\n", "threads", "ms", "speedup", "efficiency",
+           "steals");
+}
+
+static void report(int threads, double seconds, double baseline, uint64_t steals,
+                   int matches) {
+    double speedup = baseline / seconds;
+    char counts[BENCH_COUNTS_TEXT_SIZE];
+    printf("    %-8d %10.1f  %7.2fx  %9.0f%%  %8llu%s%s\n", threads, seconds * 1e3, speedup,
+           100.0 * speedup / threads, (unsigned long long)steals,
+           bench_counts_text(&best_counts, counts, sizeof(counts)), matches ? "" : "  MISMATCH");
+}
+
+static int sort_int32_status(int32_t* values, size_t count) {
+    sort_int32(values, count);
+    return 0;
+}
+
+static int sort_int64_status(int64_t* values, size_t count) {
+    sort_int64(values, count);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? (size_t)atol(argv[1]) : 10000000;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int max_threads = argc > 2 ? atoi(argv[2]) : (cpus < 1 ? 1 : (int)cpus);
+    if (count == 0 || max_threads < 1 || max_threads > TASK_POOL_MAX_THREADS) {
+        fprintf(stderr, "Usage: %s [values] [max threads, 1-%d]\n", argv[0],
+                TASK_POOL_MAX_THREADS);
+        return 1;
+    }
+    int steps[32];
+    int step_count = thread_steps(max_threads, steps);
+
+    int64_t* input = malloc(count * sizeof(int64_t));
+    int64_t* expected = malloc(count * sizeof(int64_t));
+    int64_t* values = malloc(count * sizeof(int64_t));
+    if (input == NULL || expected == NULL || values == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    for (size_t i = 0; i < count; i++) input[i] = (int64_t)next_random();
+
+    bench_timer_open(&timer);
+    printf("Parallel sort benchmark: %zu values, %ld CPUs online\n", count, cpus);
+    bench_timer_print_status(&timer, stdout);
+
+    // int32: the same buffers, viewed as the first half of each
+    int32_t* input32 = (int32_t*)input;
+    int32_t* expected32 = (int32_t*)expected;
+    int32_t* values32 = (int32_t*)values;
+    memcpy(expected32, input32, count * sizeof(int32_t));
+    sort_int32(expected32, count);
+
+    int matches = 1;
+    double baseline;
+    char counts[BENCH_COUNTS_TEXT_SIZE];
+    printf("  int32, random:\n");
+    TIME_SORT(baseline, matches, values32, input32, expected32, count,
+              sort_int32_status(values32, count));
+    report_header();
+    printf("    %-8s %10.1f  (sort_int32, no pool)%s\n", "-", baseline * 1e3,
+           bench_counts_text(&best_counts, counts, sizeof(counts)));
+    for (int s = 0; s < step_count; s++) {
+        TaskPool pool;
+        if (task_pool_init(&pool, steps[s]) != 0) {
+            perror("task_pool_init");
+            return 1;
+        }
+        double seconds;
+        matches = 1;
+        TIME_SORT(seconds, matches, values32, input32, expected32, count,
+                  parallel_sort_int32(&pool, values32, count));
+        report(pool.thread_count, seconds, baseline, pool.steals / REPEATS, matches);
+        task_pool_destroy(&pool);
+    }
+
+    for (size_t i = 0; i < count; i++) input[i] = (int64_t)next_random();
+    memcpy(expected, input, count * sizeof(int64_t));
+    sort_int64(expected, count);
+
+    printf("  int64, random:\n");
+    matches = 1;
+    TIME_SORT(baseline, matches, values, input, expected, count,
+              sort_int64_status(values, count));
+    report_header();
+    printf("    %-8s %10.1f  (sort_int64, no pool)%s\n", "-", baseline * 1e3,
+           bench_counts_text(&best_counts, counts, sizeof(counts)));
+    for (int s = 0; s < step_count; s++) {
+        TaskPool pool;
+        if (task_pool_init(&pool, steps[s]) != 0) {
+            perror("task_pool_init");
+            return 1;
+        }
+        double seconds;
+        matches = 1;
+        TIME_SORT(seconds, matches, values, input, expected, count,
+                  parallel_sort_int64(&pool, values, count));
+        report(pool.thread_count, seconds, baseline, pool.steals / REPEATS, matches);
+        task_pool_destroy(&pool);
+    }
+
+    free(input);
+    free(expected);
+    free(values);
+    bench_timer_close(&timer);
+    return 0;
+}
@@ -0,0 +1,138 @@
+/*
+ * bench_rng.c - rand() vs. rng.h, and synthetic dataset throughput
+ *
+ * Nanoseconds per value (best of 5) of:
+ * - rand() % 1000, the classic way (biased, one global state)
+ * - rng_next() and rng_below(1000) in a loop
+ * - rng_fill_uint64() / rng_fill_int32(0, 999) on the calling thread
+ *   (four interleaved lanes) and on a pool of all CPUs
+ * Every pool fill is compared with the single-thread fill; they must be
+ * identical.
+ *
+ * Then MB/s and records/s of synth_write_file() writing people, books
+ * and log lines to /dev/null (or a file), on one thread and on the pool.
+ *
+ * Usage: ./bench_rng [values] [records] [output file]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_harness.h"
+#include "rng.h"
+#include "synthetic.h"
+
+#define REPEATS 5
+
+static BenchTimer timer;
+static PerfSample best_counts;      // Of the fastest run in the last BEST_OF()
+
+// Best of REPEATS runs of `statement`, in seconds
+#define BEST_OF(seconds, statement)                         \
+    do {                                                    \
+        (seconds) = 1e30;                                   \
+        for (int repeat = 0; repeat < REPEATS; repeat++) {  \
+            bench_timer_start(&timer);                      \
+            statement;                                      \
+            double elapsed = bench_timer_stop(&timer);      \
+            if (elapsed < (seconds)) {                      \
+                (seconds) = elapsed;                        \
+                best_counts = timer.counts;                 \
+            }                                               \
+        }                                                   \
+    } while (0)
+
+// One result line, with the counts of the fastest run
+static void report(const char* label, double seconds, size_t count, double baseline,
+                   const char* note) {
+    char counts[BENCH_COUNTS_TEXT_SIZE];
+    printf("  %-34s %8.2f ns/value  %7.2fx%s%s\n", label, seconds * 1e9 / count,
+           baseline / seconds, bench_counts_text(&best_counts, counts, sizeof(counts)), note);
+}
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? (size_t)atol(argv[1]) : 50000000;
+    uint64_t records = argc > 2 ? (uint64_t)atoll(argv[2]) : 2000000;
+    const char* output = argc > 3 ? argv[3] : "/dev/null";
+    if (count == 0 || records == 0) {
+        fprintf(stderr, "Usage: %s [values] [records] [output file]\n", argv[0]);
+        return 1;
+    }
+
+    uint64_t* values = malloc(count * sizeof(uint64_t));
+    uint64_t* expected = malloc(count * sizeof(uint64_t));
+    if (values == NULL || expected == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    // Touch the pages once, so no result pays for the page faults
+    memset(values, 0, count * sizeof(uint64_t));
+    memset(expected, 0, count * sizeof(uint64_t));
+    int32_t* values32 = (int32_t*)values;
+    int32_t* expected32 = (int32_t*)expected;
+
+    // Before the pool, so its threads are counted too
+    bench_timer_open(&timer);
+    TaskPool pool;
+    if (task_pool_init(&pool, 0) != 0) {
+        perror("task_pool_init");
+        return 1;
+    }
+    printf("Random numbers: %zu values, pool of %d thread%s\n", count, pool.thread_count,
+           pool.thread_count == 1 ? "" : "s");
+    bench_timer_print_status(&timer, stdout);
+
+    double baseline, seconds;
+    srand(42);
+    BEST_OF(baseline, for (size_t i = 0; i < count; i++) values32[i] = rand() % 1000);
+    report("rand() % 1000", baseline, count, baseline, "");
+
+    Rng rng;
+    rng_seed(&rng, 42);
+    BEST_OF(seconds, for (size_t i = 0; i < count; i++) values[i] = rng_next(&rng));
+    report("rng_next()", seconds, count, baseline, "");
+    BEST_OF(seconds,
+            for (size_t i = 0; i < count; i++) values32[i] = (int32_t)rng_below(&rng, 1000));
+    report("rng_below(1000)", seconds, count, baseline, "");
+
+    BEST_OF(seconds, rng_fill_uint64(NULL, expected, count, 42));
+    report("rng_fill_uint64, 1 thread", seconds, count, baseline, "");
+    BEST_OF(seconds, rng_fill_uint64(&pool, values, count, 42));
+    report("rng_fill_uint64, pool", seconds, count, baseline,
+           memcmp(values, expected, count * sizeof(uint64_t)) == 0 ? "" : "  MISMATCH");
+
+    BEST_OF(seconds, rng_fill_int32(NULL, expected32, count, 0, 999, 42));
+    report("rng_fill_int32(0, 999), 1 thread", seconds, count, baseline, "");
+    BEST_OF(seconds, rng_fill_int32(&pool, values32, count, 0, 999, 42));
+    report("rng_fill_int32(0, 999), pool", seconds, count, baseline,
+           memcmp(values32, expected32, count * sizeof(int32_t)) == 0 ? "" : "  MISMATCH");
+    free(values);
+    free(expected);
+
+    static const char* const kind_names[] = {"people CSV", "books CSV", "log lines"};
+    printf("\nSynthetic datasets: %llu records to %s\n", (unsigned long long)records, output);
+    for (int kind = SYNTH_PEOPLE_CSV; kind <= SYNTH_LOG; kind++) {
+        for (int parallel = 0; parallel <= 1; parallel++) {
+            uint64_t bytes = 0;
+            bench_timer_start(&timer);
+            if (synth_write_file(parallel ? &pool : NULL, output, (SynthKind)kind, 42, records, 0,
+                                 NULL, &bytes) != 0) {
+                perror(output);
+                return 1;
+            }
+            double elapsed = bench_timer_stop(&timer);
+            char counts[BENCH_COUNTS_TEXT_SIZE];
+            printf("  %-10s %-9s %8.1f MB  %8.1f MB/s  %6.2f M records/s%s\n", kind_names[kind],
+                   parallel ? "pool" : "1 thread", bytes / 1e6, bytes / elapsed / 1e6,
+                   records / elapsed / 1e6,
+                   bench_counts_text(&timer.counts, counts, sizeof(counts)));
+        }
+    }
+
+    task_pool_destroy(&pool);
+    bench_timer_close(&timer);
+    return 0;
+}
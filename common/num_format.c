@@ -0,0 +1,269 @@
+/*
+ * num_format.c - Table-driven integer formatting
+ *
+ * Implementation notes:
+ * - Every conversion first computes how many digits it will write, then
+ *   fills the buffer from the last digit backwards. There is no reverse
+ *   pass and no per-digit "are we done" test against the value.
+ * - Decimal: floor(log10(v)) is estimated from the bit length as
+ *   bits * 1233 / 4096 (1233 / 4096 ~ log10(2)) and corrected by one
+ *   comparison with a power of ten. The main loop takes v % 100 and
+ *   copies two characters from the "00".."99" table: half as many
+ *   divisions (which the compiler turns into multiplications) as one
+ *   digit per step.
+ * - Hex: the digit count is (bits + 3) / 4; a byte at a time is looked up
+ *   in a 256-entry table of two-character strings.
+ * - Binary: a byte b is spread into eight bytes holding b & 0x80, b & 0x40,
+ *   ... with one multiply by 0x0101..01 and a mask; adding 0x7F to each
+ *   byte carries into its top bit exactly when it was nonzero, which
+ *   turns the eight bytes into 0/1, and adding '0' makes them ASCII. One
+ *   8-byte store writes eight digits (on little-endian hosts; others use
+ *   a byte loop).
+ * - Octal has no byte alignment (3 bits per digit), so it stays one digit
+ *   per step - it's the least used base.
+ * - Grouping writes the plain digits to a scratch buffer first and copies
+ *   them out with a separator every `group` digits, counted from the
+ *   right.
+ */
+
+#include "num_format.h"
+
+#include <string.h>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define NUM_FORMAT_SWAR 1
+#else
+#define NUM_FORMAT_SWAR 0
+#endif
+
+static const char DIGIT_PAIRS[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const uint64_t POWERS_OF_10[20] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull,
+    100000000ull, 1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull,
+    10000000000000ull, 100000000000000ull, 1000000000000000ull, 10000000000000000ull,
+    100000000000000000ull, 1000000000000000000ull, 10000000000000000000ull
+};
+
+static const char LOWER_DIGITS[] = "0123456789abcdef";
+static const char UPPER_DIGITS[] = "0123456789ABCDEF";
+
+// Two hex characters per byte value
+static const char HEX_PAIRS[2][513] = {
+    "000102030405060708090a0b0c0d0e0f"
+    "101112131415161718191a1b1c1d1e1f"
+    "202122232425262728292a2b2c2d2e2f"
+    "303132333435363738393a3b3c3d3e3f"
+    "404142434445464748494a4b4c4d4e4f"
+    "505152535455565758595a5b5c5d5e5f"
+    "606162636465666768696a6b6c6d6e6f"
+    "707172737475767778797a7b7c7d7e7f"
+    "808182838485868788898a8b8c8d8e8f"
+    "909192939495969798999a9b9c9d9e9f"
+    "a0a1a2a3a4a5a6a7a8a9aaabacadaeaf"
+    "b0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+    "c0c1c2c3c4c5c6c7c8c9cacbcccdcecf"
+    "d0d1d2d3d4d5d6d7d8d9dadbdcdddedf"
+    "e0e1e2e3e4e5e6e7e8e9eaebecedeeef"
+    "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff",
+    "000102030405060708090A0B0C0D0E0F"
+    "101112131415161718191A1B1C1D1E1F"
+    "202122232425262728292A2B2C2D2E2F"
+    "303132333435363738393A3B3C3D3E3F"
+    "404142434445464748494A4B4C4D4E4F"
+    "505152535455565758595A5B5C5D5E5F"
+    "606162636465666768696A6B6C6D6E6F"
+    "707172737475767778797A7B7C7D7E7F"
+    "808182838485868788898A8B8C8D8E8F"
+    "909192939495969798999A9B9C9D9E9F"
+    "A0A1A2A3A4A5A6A7A8A9AAABACADAEAF"
+    "B0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+    "C0C1C2C3C4C5C6C7C8C9CACBCCCDCECF"
+    "D0D1D2D3D4D5D6D7D8D9DADBDCDDDEDF"
+    "E0E1E2E3E4E5E6E7E8E9EAEBECEDEEEF"
+    "F0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF"
+};
+
+static unsigned bit_length(uint64_t value) {
+    return 64u - (unsigned)__builtin_clzll(value | 1);
+}
+
+unsigned decimal_digit_count(uint64_t value) {
+    unsigned estimate = (bit_length(value) * 1233) >> 12;
+    // value | 1 makes 0 count as one digit and changes no other answer
+    return estimate + 1 - ((value | 1) < POWERS_OF_10[estimate]);
+}
+
+// Write exactly `digits` decimal digits of `value` ending at out + digits
+static void write_decimal(char* out, uint64_t value, unsigned digits) {
+    char* p = out + digits;
+    while (value >= 100) {
+        unsigned pair = (unsigned)(value % 100);
+        value /= 100;
+        p -= 2;
+        memcpy(p, &DIGIT_PAIRS[2 * pair], 2);
+    }
+    if (value >= 10) {
+        p -= 2;
+        memcpy(p, &DIGIT_PAIRS[2 * value], 2);
+    } else {
+        *--p = (char)('0' + value);
+    }
+}
+
+size_t format_uint64(char* out, uint64_t value) {
+    unsigned digits = decimal_digit_count(value);
+    write_decimal(out, value, digits);
+    out[digits] = '\0';
+    return digits;
+}
+
+size_t format_int64(char* out, int64_t value) {
+    if (value >= 0) return format_uint64(out, (uint64_t)value);
+    *out = '-';
+    // 0 - (uint64_t)value is the magnitude even for INT64_MIN
+    return 1 + format_uint64(out + 1, 0 - (uint64_t)value);
+}
+
+// Exactly `digits` hex digits of `value`
+static void write_hex(char* out, uint64_t value, unsigned digits, int uppercase) {
+    const char* pairs = HEX_PAIRS[uppercase != 0];
+    char* p = out + digits;
+    unsigned left = digits;
+    while (left >= 2) {
+        p -= 2;
+        memcpy(p, &pairs[2 * (value & 0xFF)], 2);
+        value >>= 8;
+        left -= 2;
+    }
+    if (left) *--p = (uppercase ? UPPER_DIGITS : LOWER_DIGITS)[value & 15];
+}
+
+size_t format_hex64(char* out, uint64_t value, int uppercase) {
+    unsigned digits = (bit_length(value) + 3) / 4;
+    write_hex(out, value, digits, uppercase);
+    out[digits] = '\0';
+    return digits;
+}
+
+static void write_octal(char* out, uint64_t value, unsigned digits) {
+    for (char* p = out + digits; p > out; value >>= 3) {
+        *--p = (char)('0' + (value & 7));
+    }
+}
+
+size_t format_octal64(char* out, uint64_t value) {
+    unsigned digits = (bit_length(value) + 2) / 3;
+    write_octal(out, value, digits);
+    out[digits] = '\0';
+    return digits;
+}
+
+static void write_binary(char* out, uint64_t value, unsigned digits) {
+    char* p = out + digits;
+    unsigned left = digits;
+#if NUM_FORMAT_SWAR
+    while (left >= 8) {
+        uint64_t byte = value & 0xFF;
+        // Byte k of the product & mask is b & (0x80 >> k): memory order
+        // puts the most significant bit first
+        uint64_t spread = (byte * 0x0101010101010101ull) & 0x0102040810204080ull;
+        spread = (((spread + 0x7F7F7F7F7F7F7F7Full) >> 7) & 0x0101010101010101ull) +
+                 0x3030303030303030ull;
+        p -= 8;
+        memcpy(p, &spread, 8);
+        value >>= 8;
+        left -= 8;
+    }
+#endif
+    while (left > 0) {
+        *--p = (char)('0' + (value & 1));
+        value >>= 1;
+        left--;
+    }
+}
+
+size_t format_binary64(char* out, uint64_t value) {
+    unsigned digits = bit_length(value);
+    write_binary(out, value, digits);
+    out[digits] = '\0';
+    return digits;
+}
+
+static size_t format_with(char* out, uint64_t value, int negative, const NumberFormat* format) {
+    static const NumberFormat plain = {10, 0, 0, '\0', 0, 0};
+    if (format == NULL) format = &plain;
+    unsigned base = format->base;
+    if (base != 2 && base != 8 && base != 16) base = 10;
+
+    unsigned digits;
+    if (base == 10) {
+        digits = decimal_digit_count(value);
+    } else {
+        unsigned bits_per_digit = base == 16 ? 4 : base == 8 ? 3 : 1;
+        digits = (bit_length(value) + bits_per_digit - 1) / bits_per_digit;
+    }
+    unsigned min_digits = format->min_digits > 64 ? 64 : format->min_digits;
+    if (digits < min_digits) digits = min_digits;
+
+    // Leading zeros come from the padding: the writers stop at `digits`
+    char scratch[64];
+    memset(scratch, '0', digits);
+    if (base == 10) {
+        unsigned needed = decimal_digit_count(value);
+        write_decimal(scratch + digits - needed, value, needed);
+    } else if (base == 16) {
+        write_hex(scratch, value, digits, format->uppercase);
+    } else if (base == 8) {
+        write_octal(scratch, value, digits);
+    } else {
+        write_binary(scratch, value, digits);
+    }
+
+    char* p = out;
+    if (negative) *p++ = '-';
+    // Like printf("%#o"): octal's 0 prefix is the leading zero itself, so
+    // it is left out when the digits already start with one (0, or padding)
+    if (format->prefix && base != 10 && !(base == 8 && digits > 0 && scratch[0] == '0')) {
+        *p++ = '0';
+        if (base == 16) *p++ = format->uppercase ? 'X' : 'x';
+        if (base == 2) *p++ = 'b';
+    }
+
+    if (format->separator == '\0') {
+        memcpy(p, scratch, digits);
+        p += digits;
+    } else {
+        unsigned group = format->group ? format->group : (base == 10 || base == 8) ? 3 : 4;
+        // The first group is the short one: 1,234,567
+        unsigned first = digits % group ? digits % group : group;
+        memcpy(p, scratch, first);
+        p += first;
+        for (unsigned i = first; i < digits; i += group) {
+            *p++ = format->separator;
+            memcpy(p, scratch + i, group);
+            p += group;
+        }
+    }
+    *p = '\0';
+    return (size_t)(p - out);
+}
+
+size_t format_unsigned(char* out, uint64_t value, const NumberFormat* format) {
+    return format_with(out, value, 0, format);
+}
+
+size_t format_signed(char* out, int64_t value, const NumberFormat* format) {
+    if (value >= 0) return format_with(out, (uint64_t)value, 0, format);
+    return format_with(out, 0 - (uint64_t)value, 1, format);
+}
@@ -0,0 +1,66 @@
+/*
+ * num_format.h - Integer to text in decimal, hex, octal and binary
+ *
+ * printf("%d") parses its format string, looks at the locale and takes
+ * the stream lock for every number. These functions only write digits
+ * into a buffer the caller provides and return the length, so a report
+ * that prints millions of numbers pays for the digits and nothing else:
+ * - decimal two digits per step from a 200-byte "00".."99" table
+ * - hex one byte (two digits) per step from a 512-byte table
+ * - binary eight digits per step with a multiply-and-mask trick
+ * - the digit count comes from the position of the highest set bit
+ *   (one lzcnt instruction), so no loop has to find it first
+ *
+ * format_unsigned()/format_signed() add what printf's flags would: a
+ * 0x/0/0b prefix, zero padding, and digit grouping ("1,234,567",
+ * "1010 1100"), which printf can't do at all.
+ *
+ * Every function NUL-terminates its output.
+ *
+ * For frontend developers: Like value.toString(16) or
+ * Intl.NumberFormat's grouping, but writing into a preallocated buffer
+ * instead of creating a new string for every number.
+ */
+
+#ifndef NUM_FORMAT_H
+#define NUM_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Buffer sizes that always fit, terminating NUL included
+#define FORMAT_DECIMAL_SIZE 21      // "-9223372036854775808"
+#define FORMAT_HEX_SIZE 17
+#define FORMAT_OCTAL_SIZE 23
+#define FORMAT_BINARY_SIZE 65
+#define FORMAT_MAX_SIZE 136         // format_unsigned/signed: 64 binary
+                                    // digits, 63 separators, sign, prefix
+
+typedef struct {
+    unsigned base;          // 2, 8, 10 or 16
+    int uppercase;          // A-F instead of a-f (and 0X)
+    int prefix;             // 0b, 0 or 0x in front of the digits (0 only
+                            // if they don't already start with 0, like %#o)
+    char separator;         // Between digit groups; '\0' = no grouping
+    unsigned group;         // Digits per group (0 = 3 for base 10 and 8, 4 for 2 and 16)
+    unsigned min_digits;    // Pad with zeros up to this many digits (max 64)
+} NumberFormat;
+
+// Plain digits, no prefix or padding. Return the length.
+size_t format_uint64(char* out, uint64_t value);                // FORMAT_DECIMAL_SIZE
+size_t format_int64(char* out, int64_t value);                  // FORMAT_DECIMAL_SIZE
+size_t format_hex64(char* out, uint64_t value, int uppercase);  // FORMAT_HEX_SIZE
+size_t format_octal64(char* out, uint64_t value);               // FORMAT_OCTAL_SIZE
+size_t format_binary64(char* out, uint64_t value);              // FORMAT_BINARY_SIZE
+
+// With the options in `format` (NULL = plain decimal); `out` needs
+// FORMAT_MAX_SIZE bytes. A negative value is written as '-' and its
+// magnitude in every base (-255 in hex is "-0xff"); to see the two's
+// complement bits, pass (uint32_t)value to format_unsigned() instead.
+size_t format_unsigned(char* out, uint64_t value, const NumberFormat* format);
+size_t format_signed(char* out, int64_t value, const NumberFormat* format);
+
+// Number of decimal digits in `value` (1 for 0)
+unsigned decimal_digit_count(uint64_t value);
+
+#endif // NUM_FORMAT_H
@@ -0,0 +1,45 @@
+/*
+ * num_parse.h - Length-delimited integer and floating-point parsing
+ *
+ * atoi() and atof() want a NUL-terminated string, so a CSV field or a
+ * slice of a mapped file has to be copied first; they return 0 for "abc"
+ * and for "0" alike, and they consult the locale for the decimal point.
+ * These parsers take a pointer and a length, accept exactly one number
+ * that fills the whole slice, and report anything else as an error.
+ *
+ * Integers are converted 8 digits at a time with SWAR arithmetic (eight
+ * ASCII digits loaded into one 64-bit register and combined with three
+ * multiplications). Floats follow the Eisel-Lemire algorithm: the decimal
+ * digits become a 64-bit integer w and a power of ten q, and w is
+ * multiplied by a 128-bit approximation of 10^q from a table; that
+ * product decides the correctly rounded double in all but a handful of
+ * near-halfway cases, which fall back to strtod(). The result is always
+ * the same double that strtod() returns.
+ *
+ * Accepted:  [+-]digits                               (integers)
+ *            [+-]digits[.digits][(e|E)[+-]digits]     (floats; ".5" and
+ *            "5." too)
+ * Rejected:  leading/trailing spaces, "0x1p3", "inf", "nan", "1,5"
+ *
+ * For frontend developers: Like Number(text) with a check that the whole
+ * text was the number - except that it reads a slice of a bigger buffer
+ * instead of needing a string of its own.
+ */
+
+#ifndef NUM_PARSE_H
+#define NUM_PARSE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// All parsers return 0 on success, or -1 with errno set: EINVAL if the
+// text is not a number of the expected form, ERANGE if it is one but
+// doesn't fit. On ERANGE `value` is still set: clamped for integers,
+// +-HUGE_VAL or +-0.0 for floats (like strtol() and strtod()).
+int parse_int64(const char* text, size_t length, int64_t* value);
+int parse_int32(const char* text, size_t length, int32_t* value);
+int parse_uint64(const char* text, size_t length, uint64_t* value);
+int parse_double(const char* text, size_t length, double* value);
+int parse_float(const char* text, size_t length, float* value);
+
+#endif // NUM_PARSE_H
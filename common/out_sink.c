@@ -0,0 +1,270 @@
+/*
+ * out_sink.c - Buffered output straight to a file descriptor
+ *
+ * Implementation notes:
+ * - Every public function is a lock/unlock pair around a static helper
+ *   that does the work, and the helpers only call each other, so one call
+ *   takes the lock once. The mutex is recursive, like the lock behind
+ *   flockfile(): a thread holding it through out_sink_lock() takes it
+ *   again (a counter increment) in each call. In OUT_SINK_UNLOCKED mode
+ *   the pair is two predictable branches.
+ * - Numbers are formatted in place: when at least FORMAT_DECIMAL_SIZE
+ *   bytes are free, format_int64() writes straight into the buffer (its
+ *   NUL lands on the next free byte and is overwritten by the next
+ *   append). Otherwise the buffer is flushed first.
+ * - Text longer than the whole buffer isn't copied: what's buffered is
+ *   flushed and the text goes to write(2) as it is.
+ * - out_double() rounds value * 10^decimals to an integer and prints it
+ *   with the decimal point inserted. printf() rounds the exact binary
+ *   value, and the multiplication can be off by half an ulp, so when the
+ *   fraction is that close to .5 the answer could differ - those values
+ *   (about one in a billion for prices) are passed to snprintf().
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "out_sink.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "num_format.h"
+
+static const double POWERS_OF_10[10] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9
+};
+
+static const uint64_t INTEGER_POWERS_OF_10[10] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull,
+    100000000ull, 1000000000ull
+};
+
+int out_sink_init(OutSink* sink, int fd, size_t capacity, OutSinkMode mode) {
+    memset(sink, 0, sizeof(*sink));
+    if (capacity == 0) capacity = OUT_SINK_DEFAULT_CAPACITY;
+    // Room for one formatted number at least, so out_int() always fits
+    // into an empty buffer
+    if (capacity < FORMAT_MAX_SIZE) capacity = FORMAT_MAX_SIZE;
+
+    sink->buffer = malloc(capacity);
+    if (sink->buffer == NULL) return -1;
+    sink->fd = fd;
+    sink->capacity = capacity;
+    sink->mode = mode;
+    if (mode == OUT_SINK_LOCKED) {
+        // Recursive, so out_*() calls work under out_sink_lock()
+        pthread_mutexattr_t attributes;
+        int status = pthread_mutexattr_init(&attributes);
+        if (status == 0) {
+            status = pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE);
+            if (status == 0) status = pthread_mutex_init(&sink->lock, &attributes);
+            pthread_mutexattr_destroy(&attributes);
+        }
+        if (status != 0) {
+            free(sink->buffer);
+            sink->buffer = NULL;
+            errno = status;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void out_sink_lock(OutSink* sink) {
+    if (sink->mode == OUT_SINK_LOCKED) pthread_mutex_lock(&sink->lock);
+}
+
+void out_sink_unlock(OutSink* sink) {
+    if (sink->mode == OUT_SINK_LOCKED) pthread_mutex_unlock(&sink->lock);
+}
+
+// write(2) all of it, retrying short writes and EINTR
+static void write_all(OutSink* sink, const char* data, size_t length) {
+    while (length > 0 && sink->error == 0) {
+        ssize_t written = write(sink->fd, data, length);
+        sink->flushes++;
+        if (written < 0) {
+            if (errno != EINTR) sink->error = errno;
+            continue;
+        }
+        data += written;
+        length -= (size_t)written;
+        sink->bytes_written += (uint64_t)written;
+    }
+}
+
+static void flush_buffer(OutSink* sink) {
+    write_all(sink, sink->buffer, sink->length);
+    sink->length = 0;
+}
+
+// Make `length` bytes free, if the buffer can hold that many at all
+static void reserve(OutSink* sink, size_t length) {
+    if (sink->capacity - sink->length < length) flush_buffer(sink);
+}
+
+static void append(OutSink* sink, const char* data, size_t length) {
+    if (sink->error != 0) return;
+    if (length > sink->capacity) {
+        flush_buffer(sink);
+        write_all(sink, data, length);
+        return;
+    }
+    reserve(sink, length);
+    memcpy(sink->buffer + sink->length, data, length);
+    sink->length += length;
+}
+
+static void fill(OutSink* sink, char c, size_t count) {
+    while (count > 0 && sink->error == 0) {
+        reserve(sink, 1);
+        size_t room = sink->capacity - sink->length;
+        size_t n = count < room ? count : room;
+        memset(sink->buffer + sink->length, c, n);
+        sink->length += n;
+        count -= n;
+    }
+}
+
+static void append_uint(OutSink* sink, uint64_t value) {
+    reserve(sink, FORMAT_DECIMAL_SIZE);
+    sink->length += format_uint64(sink->buffer + sink->length, value);
+}
+
+static void append_double(OutSink* sink, double value, int decimals) {
+    if (decimals < 0) decimals = 0;
+    int negative = signbit(value) != 0;
+    double magnitude = negative ? -value : value;
+
+    // NaN fails every comparison, so it takes the slow path with infinity
+    if (decimals <= 9 && magnitude < 1e15) {
+        double scaled = magnitude * POWERS_OF_10[decimals];
+        // Exact: scaled < 2^53 makes both the conversion and the
+        // subtraction exact
+        if (scaled < 9007199254740992.0) {
+            uint64_t whole = (uint64_t)scaled;
+            double fraction = scaled - (double)whole;
+            double error = scaled * 0x1p-52;
+            if (fraction < 0.5 - error || fraction > 0.5 + error) {
+                uint64_t rounded = whole + (fraction > 0.5);
+                uint64_t unit = INTEGER_POWERS_OF_10[decimals];
+
+                reserve(sink, 2 * FORMAT_DECIMAL_SIZE + 1);
+                char* p = sink->buffer + sink->length;
+                if (negative) *p++ = '-';
+                p += format_uint64(p, rounded / unit);
+                if (decimals > 0) {
+                    static const NumberFormat padded[10] = {
+                        {10, 0, 0, '\0', 0, 0}, {10, 0, 0, '\0', 0, 1}, {10, 0, 0, '\0', 0, 2},
+                        {10, 0, 0, '\0', 0, 3}, {10, 0, 0, '\0', 0, 4}, {10, 0, 0, '\0', 0, 5},
+                        {10, 0, 0, '\0', 0, 6}, {10, 0, 0, '\0', 0, 7}, {10, 0, 0, '\0', 0, 8},
+                        {10, 0, 0, '\0', 0, 9}
+                    };
+                    *p++ = '.';
+                    p += format_unsigned(p, rounded % unit, &padded[decimals]);
+                }
+                sink->length = (size_t)(p - sink->buffer);
+                return;
+            }
+        }
+    }
+
+    char text[512];
+    int length = snprintf(text, sizeof(text), "%.*f", decimals, value);
+    if (length < 0) return;
+    if ((size_t)length >= sizeof(text)) {
+        char* large = malloc((size_t)length + 1);
+        if (large == NULL) {
+            sink->error = errno;
+            return;
+        }
+        snprintf(large, (size_t)length + 1, "%.*f", decimals, value);
+        append(sink, large, (size_t)length);
+        free(large);
+        return;
+    }
+    append(sink, text, (size_t)length);
+}
+
+int out_sink_flush(OutSink* sink) {
+    out_sink_lock(sink);
+    flush_buffer(sink);
+    int error = sink->error;
+    out_sink_unlock(sink);
+    if (error != 0) {
+        errno = error;
+        return -1;
+    }
+    return 0;
+}
+
+int out_sink_close(OutSink* sink) {
+    if (sink->buffer == NULL) return 0;
+    int result = out_sink_flush(sink);
+    int error = errno;
+    free(sink->buffer);
+    sink->buffer = NULL;
+    if (sink->mode == OUT_SINK_LOCKED) pthread_mutex_destroy(&sink->lock);
+    errno = error;
+    return result;
+}
+
+void out_bytes(OutSink* sink, const char* data, size_t length) {
+    out_sink_lock(sink);
+    append(sink, data, length);
+    out_sink_unlock(sink);
+}
+
+void out_str(OutSink* sink, const char* text) {
+    out_bytes(sink, text, strlen(text));
+}
+
+void out_char(OutSink* sink, char c) {
+    out_sink_lock(sink);
+    if (sink->error == 0) {
+        reserve(sink, 1);
+        sink->buffer[sink->length++] = c;
+    }
+    out_sink_unlock(sink);
+}
+
+void out_int(OutSink* sink, int64_t value) {
+    out_sink_lock(sink);
+    if (sink->error == 0) {
+        reserve(sink, FORMAT_DECIMAL_SIZE);
+        sink->length += format_int64(sink->buffer + sink->length, value);
+    }
+    out_sink_unlock(sink);
+}
+
+void out_uint(OutSink* sink, uint64_t value) {
+    out_sink_lock(sink);
+    if (sink->error == 0) append_uint(sink, value);
+    out_sink_unlock(sink);
+}
+
+void out_double(OutSink* sink, double value, int decimals) {
+    out_sink_lock(sink);
+    if (sink->error == 0) append_double(sink, value, decimals);
+    out_sink_unlock(sink);
+}
+
+void out_str_width(OutSink* sink, const char* text, int width) {
+    size_t length = strlen(text);
+    out_sink_lock(sink);
+    append(sink, text, length);
+    if (width > 0 && length < (size_t)width) fill(sink, ' ', (size_t)width - length);
+    out_sink_unlock(sink);
+}
+
+void out_uint_width(OutSink* sink, uint64_t value, int width) {
+    out_sink_lock(sink);
+    unsigned digits = decimal_digit_count(value);
+    if (width > 0 && digits < (unsigned)width) fill(sink, ' ', (unsigned)width - digits);
+    if (sink->error == 0) append_uint(sink, value);
+    out_sink_unlock(sink);
+}
@@ -0,0 +1,94 @@
+/*
+ * out_sink.h - Buffered output straight to a file descriptor
+ *
+ * A report that prints one line per record with printf() pays for the
+ * same work on every line: the format string is parsed again, the stream
+ * lock is taken and released, and %f goes through the general-purpose
+ * floating-point converter. When stdout is a pipe or a file, that
+ * overhead - not the write - decides how many lines per second come out.
+ *
+ * An OutSink is a plain byte buffer in front of a file descriptor:
+ * - out_str()/out_int()/out_double()... append text with their own
+ *   formatters (num_format.h for integers) instead of a format string
+ * - nothing reaches the kernel until the buffer is full or
+ *   out_sink_flush() is called, and then it is one write(2)
+ * - OUT_SINK_UNLOCKED (for a sink used by one thread) skips the mutex
+ *   that OUT_SINK_LOCKED takes around every call
+ *
+ * The sink writes to the descriptor directly, so it knows nothing about
+ * stdio's buffer for the same file: fflush(stdout) before a sink on
+ * STDOUT_FILENO writes, and out_sink_flush() before going back to
+ * printf(), or the two outputs come out in the wrong order.
+ *
+ * Write errors are sticky, like ferror(): the first one is kept, later
+ * output is dropped, and out_sink_flush()/out_sink_close() report it.
+ *
+ * For frontend developers: Like collecting the rows of a table into an
+ * array and calling res.write(rows.join("")) once, instead of one
+ * res.write() per row.
+ */
+
+#ifndef OUT_SINK_H
+#define OUT_SINK_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define OUT_SINK_DEFAULT_CAPACITY (64 * 1024)
+
+typedef enum {
+    OUT_SINK_LOCKED,        // Every call takes a mutex (like FILE*)
+    OUT_SINK_UNLOCKED       // Single thread: no locking at all
+} OutSinkMode;
+
+typedef struct {
+    int fd;
+    char* buffer;
+    size_t capacity;
+    size_t length;          // Bytes waiting for the next flush
+    OutSinkMode mode;
+    int error;              // First errno from write(2), 0 if none
+    uint64_t bytes_written; // Bytes handed to the kernel so far
+    uint64_t flushes;       // write(2) calls made so far
+    pthread_mutex_t lock;   // Recursive; only used in OUT_SINK_LOCKED mode
+} OutSink;
+
+// Set up a sink for `fd` with a `capacity`-byte buffer (0 = the default).
+// Returns 0, or -1 with errno set. The descriptor stays the caller's.
+int out_sink_init(OutSink* sink, int fd, size_t capacity, OutSinkMode mode);
+
+// Flush, then free the buffer. Returns 0, or -1 with errno set to the
+// first write error.
+int out_sink_close(OutSink* sink);
+
+// Write everything buffered with one write(2) (more only if the kernel
+// takes less). Returns 0, or -1 with errno set to the first write error.
+int out_sink_flush(OutSink* sink);
+
+// Hold the sink's lock across several calls so a line from one thread
+// isn't interleaved with another's (like flockfile()). The lock is
+// recursive: out_*() calls in between take it again without blocking.
+// Every out_sink_lock() needs its out_sink_unlock(). No-ops in
+// OUT_SINK_UNLOCKED mode.
+void out_sink_lock(OutSink* sink);
+void out_sink_unlock(OutSink* sink);
+
+// Append text. Nothing is written until the buffer fills up.
+void out_bytes(OutSink* sink, const char* data, size_t length);
+void out_str(OutSink* sink, const char* text);
+void out_char(OutSink* sink, char c);
+void out_int(OutSink* sink, int64_t value);                 // %lld
+void out_uint(OutSink* sink, uint64_t value);               // %llu
+
+// Fixed-point like printf("%.*f", decimals, value) and with the same
+// digits; decimals above 9, huge values, NaN and infinity are handed to
+// snprintf().
+void out_double(OutSink* sink, double value, int decimals);
+
+// Padded to `width` columns: text on the left like "%-*s", numbers on
+// the right like "%*llu"
+void out_str_width(OutSink* sink, const char* text, int width);
+void out_uint_width(OutSink* sink, uint64_t value, int width);
+
+#endif // OUT_SINK_H
@@ -0,0 +1,47 @@
+/*
+ * parallel_sort.c - Multi-threaded merge sort on a work-stealing pool
+ *
+ * Implementation notes:
+ * - The array is halved recursively, one task per half, down to pieces
+ *   of count / (8 x threads) elements (at least 32768) that sort_int32()
+ *   sorts. 8 pieces per thread let the pool even out threads that get
+ *   slower pieces or run on a busy core.
+ * - Levels alternate between the array and the scratch buffer (a piece
+ *   whose merged result must end up in scratch is copied there once after
+ *   sorting), so every merge writes straight to where the next level reads.
+ * - Merges are split recursively (see parallel_sort_template.h) down to
+ *   the same grain, and the sequential merge is branchless.
+ * - Below 64K elements, or with a one-thread pool, the task overhead isn't
+ *   worth it and the sequential sort runs on the calling thread.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "parallel_sort.h"
+#include "sort.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PARALLEL_SORT_MIN_COUNT (64 * 1024)
+#define PARALLEL_SORT_MIN_GRAIN (32 * 1024)
+#define PARALLEL_SORT_PIECES_PER_THREAD 8
+
+#define PSORT_T int32_t
+#define PSORT_NAME(name) name##_int32
+#define PSORT_LEAF sort_int32
+#include "parallel_sort_template.h"
+
+#define PSORT_T int64_t
+#define PSORT_NAME(name) name##_int64
+#define PSORT_LEAF sort_int64
+#include "parallel_sort_template.h"
+
+int parallel_sort_int32(TaskPool* pool, int32_t* values, size_t count) {
+    return run_parallel_sort_int32(pool, values, count);
+}
+
+int parallel_sort_int64(TaskPool* pool, int64_t* values, size_t count) {
+    return run_parallel_sort_int64(pool, values, count);
+}
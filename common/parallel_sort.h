@@ -0,0 +1,33 @@
+/*
+ * parallel_sort.h - Multi-threaded merge sort on a work-stealing pool
+ *
+ * A sort is mostly independent work: the two halves of a merge sort
+ * don't look at each other until they are merged. parallel_sort_int32()
+ * splits the array into a few pieces per thread, sorts the pieces with
+ * pdqsort (sort.h) as separate tasks, then merges them pairwise. The
+ * merges are split too - the middle element of one run is looked up in
+ * the other with a binary search, and the two sides are merged as two
+ * tasks - so the last merge, which touches every element, still keeps
+ * every thread busy.
+ *
+ * The tasks run on a TaskPool (task_pool.h) that the caller creates
+ * once and can reuse for other work. Scratch memory is as large as the
+ * input; the function returns 0, or -1 with errno = ENOMEM.
+ *
+ * For frontend developers: Like splitting a big Array.prototype.sort()
+ * across Web Workers, except the workers share the array instead of
+ * copying it with postMessage().
+ */
+
+#ifndef PARALLEL_SORT_H
+#define PARALLEL_SORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "task_pool.h"
+
+int parallel_sort_int32(TaskPool* pool, int32_t* values, size_t count);
+int parallel_sort_int64(TaskPool* pool, int64_t* values, size_t count);
+
+#endif // PARALLEL_SORT_H
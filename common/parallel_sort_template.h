@@ -0,0 +1,149 @@
+/*
+ * parallel_sort_template.h - Parallel merge sort for one element type
+ *
+ * Not a public header: parallel_sort.c includes it once per element
+ * type, after defining
+ *   PSORT_T            the element type (compared with <)
+ *   PSORT_NAME(name)   the name of a function for this type (name##_int32)
+ *   PSORT_LEAF         the sequential sort for the pieces (sort_int32)
+ * The macros are undefined again at the end, like sort_template.h.
+ */
+
+typedef struct {
+    TaskPool* pool;
+    const PSORT_T* left;
+    size_t left_count;
+    const PSORT_T* right;
+    size_t right_count;
+    PSORT_T* target;
+    size_t grain;           // Merge sequentially below this many elements
+} PSORT_NAME(MergeJob);
+
+typedef struct {
+    TaskPool* pool;
+    PSORT_T* values;
+    PSORT_T* scratch;       // Same size as values
+    size_t count;
+    size_t grain;           // Pieces up to this size are sorted with PSORT_LEAF
+    int into_scratch;       // Leave the result in scratch instead of values
+} PSORT_NAME(SortJob);
+
+// Branchless merge: the comparison picks the source, it isn't a jump
+static void PSORT_NAME(merge_runs)(const PSORT_T* left, size_t left_count,
+                                   const PSORT_T* right, size_t right_count,
+                                   PSORT_T* target) {
+    size_t i = 0, j = 0, k = 0;
+    while (i < left_count && j < right_count) {
+        PSORT_T a = left[i];
+        PSORT_T b = right[j];
+        int take_right = b < a;
+        target[k++] = take_right ? b : a;
+        j += (size_t)take_right;
+        i += (size_t)!take_right;
+    }
+    memcpy(target + k, left + i, (left_count - i) * sizeof(PSORT_T));
+    k += left_count - i;
+    memcpy(target + k, right + j, (right_count - j) * sizeof(PSORT_T));
+}
+
+// Merge two sorted runs into target: the middle element of the longer
+// run goes straight to its final place, and the elements before and
+// after it are merged as two independent tasks
+static void PSORT_NAME(merge_task)(void* argument) {
+    PSORT_NAME(MergeJob)* job = argument;
+    const PSORT_T* left = job->left;
+    const PSORT_T* right = job->right;
+    size_t left_count = job->left_count;
+    size_t right_count = job->right_count;
+
+    if (left_count + right_count <= job->grain) {
+        PSORT_NAME(merge_runs)(left, left_count, right, right_count, job->target);
+        return;
+    }
+    if (left_count < right_count) {
+        const PSORT_T* run = left;
+        left = right;
+        right = run;
+        size_t n = left_count;
+        left_count = right_count;
+        right_count = n;
+    }
+
+    size_t middle = left_count / 2;
+    PSORT_T pivot = left[middle];
+    // First element of `right` that isn't less than the pivot
+    size_t low = 0, high = right_count;
+    while (low < high) {
+        size_t probe = low + (high - low) / 2;
+        if (right[probe] < pivot) {
+            low = probe + 1;
+        } else {
+            high = probe;
+        }
+    }
+    job->target[middle + low] = pivot;
+
+    PSORT_NAME(MergeJob) lower = {job->pool, left, middle, right, low, job->target, job->grain};
+    PSORT_NAME(MergeJob) upper = {job->pool, left + middle + 1, left_count - middle - 1,
+                                  right + low, right_count - low,
+                                  job->target + middle + low + 1, job->grain};
+    TaskGroup group;
+    task_group_init(&group);
+    Task task;
+    task_spawn(job->pool, &group, &task, PSORT_NAME(merge_task), &upper);
+    PSORT_NAME(merge_task)(&lower);
+    task_group_wait(job->pool, &group);
+}
+
+// Sort both halves as separate tasks, each leaving its result in the
+// other buffer, then merge them back: no copying between levels
+static void PSORT_NAME(sort_task)(void* argument) {
+    PSORT_NAME(SortJob)* job = argument;
+    if (job->count <= job->grain) {
+        PSORT_LEAF(job->values, job->count);
+        if (job->into_scratch) memcpy(job->scratch, job->values, job->count * sizeof(PSORT_T));
+        return;
+    }
+
+    size_t half = job->count / 2;
+    PSORT_NAME(SortJob) lower = {job->pool, job->values, job->scratch, half, job->grain,
+                                 !job->into_scratch};
+    PSORT_NAME(SortJob) upper = {job->pool, job->values + half, job->scratch + half,
+                                 job->count - half, job->grain, !job->into_scratch};
+    TaskGroup group;
+    task_group_init(&group);
+    Task task;
+    task_spawn(job->pool, &group, &task, PSORT_NAME(sort_task), &upper);
+    PSORT_NAME(sort_task)(&lower);
+    task_group_wait(job->pool, &group);
+
+    PSORT_T* source = job->into_scratch ? job->values : job->scratch;
+    PSORT_T* target = job->into_scratch ? job->scratch : job->values;
+    PSORT_NAME(MergeJob) merge = {job->pool, source, half, source + half, job->count - half,
+                                  target, job->grain};
+    PSORT_NAME(merge_task)(&merge);
+}
+
+static int PSORT_NAME(run_parallel_sort)(TaskPool* pool, PSORT_T* values, size_t count) {
+    if (pool->thread_count < 2 || count < PARALLEL_SORT_MIN_COUNT) {
+        PSORT_LEAF(values, count);
+        return 0;
+    }
+    PSORT_T* scratch = malloc(count * sizeof(PSORT_T));
+    if (scratch == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    size_t grain = count / ((size_t)pool->thread_count * PARALLEL_SORT_PIECES_PER_THREAD);
+    if (grain < PARALLEL_SORT_MIN_GRAIN) grain = PARALLEL_SORT_MIN_GRAIN;
+    PSORT_NAME(SortJob) job = {pool, values, scratch, count, grain, 0};
+    task_pool_run(pool, PSORT_NAME(sort_task), &job);
+
+    free(scratch);
+    return 0;
+}
+
+#undef PSORT_T
+#undef PSORT_NAME
+#undef PSORT_LEAF
@@ -0,0 +1,291 @@
+/*
+ * perf_counters.c - Hardware performance counters around code regions
+ *
+ * Implementation notes:
+ * - Every counter is its own perf event (not one group): a group is
+ *   scheduled all-or-nothing, so one event the PMU can't fit would
+ *   silence all of them. Events count from the moment they are opened,
+ *   user space only (exclude_kernel: allowed at perf_event_paranoid 2,
+ *   the common default), for the calling thread on any CPU and the
+ *   threads it starts afterwards (inherit): a read adds up the counts of
+ *   all of them, running or joined, so a parallel region is counted whole.
+ * - Nothing is reset or enabled per measurement: start and stop read the
+ *   running totals (one read() per counter) and subtract, which makes
+ *   nesting free. Each read also returns the time the event was enabled
+ *   and actually counting; the count is scaled by their ratio, which
+ *   corrects for multiplexing. A counter that never got on the PMU reads
+ *   as unavailable for that interval.
+ * - LLC misses are PERF_COUNT_HW_CACHE_MISSES, the generic event that
+ *   x86 and most ARM cores map to last-level cache misses; the L1D and
+ *   dTLB events are the "read miss" cache events.
+ */
+
+#define _GNU_SOURCE
+
+#include "perf_counters.h"
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#define PERF_HAVE_EVENTS 1
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#else
+#define PERF_HAVE_EVENTS 0
+#endif
+
+static const char* const counter_names[PERF_COUNTER_COUNT] = {
+    "cycles", "instructions", "L1D misses", "LLC misses", "branch misses", "dTLB misses"
+};
+
+// The misses reported per 1000 instructions, and their short labels
+static const PerfCounter miss_counters[] = {
+    PERF_L1D_MISSES, PERF_LLC_MISSES, PERF_BRANCH_MISSES, PERF_DTLB_MISSES
+};
+static const char* const miss_labels[] = {"L1D", "LLC", "br", "dTLB"};
+#define MISS_COUNT 4
+
+#define HAS(sample, counter) (((sample)->available >> (counter)) & 1u)
+
+#if PERF_HAVE_EVENTS
+#define CACHE_READ_MISS(cache) \
+    ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+static int open_event(PerfCounter counter) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    switch (counter) {
+    case PERF_CYCLES:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+    case PERF_INSTRUCTIONS:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+    case PERF_L1D_MISSES:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = CACHE_READ_MISS(PERF_COUNT_HW_CACHE_L1D);
+        break;
+    case PERF_LLC_MISSES:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        break;
+    case PERF_BRANCH_MISSES:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+        break;
+    case PERF_DTLB_MISSES:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = CACHE_READ_MISS(PERF_COUNT_HW_CACHE_DTLB);
+        break;
+    default:
+        errno = EINVAL;
+        return -1;
+    }
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.inherit = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+}
+#endif
+
+void perf_counters_open(PerfCounters* counters) {
+    memset(counters, 0, sizeof(*counters));
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) counters->fds[i] = -1;
+#if PERF_HAVE_EVENTS
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        int fd = open_event((PerfCounter)i);
+        if (fd < 0) {
+            if (counters->error == 0) counters->error = errno;
+            continue;
+        }
+        counters->fds[i] = fd;
+        counters->available |= 1u << i;
+    }
+#else
+    counters->error = ENOSYS;
+#endif
+}
+
+void perf_counters_close(PerfCounters* counters) {
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        if (counters->fds[i] >= 0) close(counters->fds[i]);
+        counters->fds[i] = -1;
+    }
+    counters->available = 0;
+}
+
+// Running totals, scaled for multiplexing
+static void read_totals(const PerfCounters* counters, PerfSample* sample) {
+    sample->available = 0;
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        sample->values[i] = 0;
+        if (counters->fds[i] < 0) continue;
+        uint64_t data[3];   // Count, time enabled, time running
+        if (read(counters->fds[i], data, sizeof(data)) != (ssize_t)sizeof(data)) continue;
+        if (data[2] == 0) continue;
+        double scale = data[2] < data[1] ? (double)data[1] / (double)data[2] : 1.0;
+        sample->values[i] = (double)data[0] * scale;
+        sample->available |= 1u << i;
+    }
+}
+
+static void subtract(const PerfSample* end, const PerfSample* start, PerfSample* delta) {
+    delta->available = end->available & start->available;
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        delta->values[i] = HAS(delta, i) ? end->values[i] - start->values[i] : 0;
+    }
+}
+
+void perf_counters_start(PerfCounters* counters) {
+    read_totals(counters, &counters->start);
+}
+
+void perf_counters_stop(PerfCounters* counters, PerfSample* sample) {
+    PerfSample end;
+    read_totals(counters, &end);
+    subtract(&end, &counters->start, sample);
+}
+
+static double monotonic_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void perf_region_begin(PerfCounters* counters, const char* name) {
+    int depth = counters->depth++;
+    if (depth >= PERF_MAX_DEPTH) return;
+
+    int index = -1;
+    for (int i = 0; i < counters->region_count; i++) {
+        if (strcmp(counters->regions[i].name, name) == 0) {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0 && counters->region_count < PERF_MAX_REGIONS) {
+        index = counters->region_count++;
+        PerfRegion* region = &counters->regions[index];
+        memset(region, 0, sizeof(*region));
+        region->name = name;
+        region->totals.available = counters->available;
+    }
+    counters->open_regions[depth] = index;
+    if (index < 0) return;
+    counters->open_seconds[depth] = monotonic_seconds();
+    read_totals(counters, &counters->open_starts[depth]);
+}
+
+void perf_region_end(PerfCounters* counters) {
+    if (counters->depth == 0) return;
+    int depth = --counters->depth;
+    if (depth >= PERF_MAX_DEPTH || counters->open_regions[depth] < 0) return;
+
+    PerfSample end, delta;
+    read_totals(counters, &end);
+    double seconds = monotonic_seconds() - counters->open_seconds[depth];
+    subtract(&end, &counters->open_starts[depth], &delta);
+
+    PerfRegion* region = &counters->regions[counters->open_regions[depth]];
+    region->calls++;
+    region->seconds += seconds;
+    perf_sample_add(&region->totals, &delta);
+}
+
+void perf_sample_add(PerfSample* total, const PerfSample* sample) {
+    total->available &= sample->available;
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) total->values[i] += sample->values[i];
+}
+
+double perf_ipc(const PerfSample* sample) {
+    if (!HAS(sample, PERF_CYCLES) || !HAS(sample, PERF_INSTRUCTIONS)) return -1;
+    if (sample->values[PERF_CYCLES] <= 0) return -1;
+    return sample->values[PERF_INSTRUCTIONS] / sample->values[PERF_CYCLES];
+}
+
+double perf_mpki(const PerfSample* sample, PerfCounter counter) {
+    if (!HAS(sample, PERF_INSTRUCTIONS) || !HAS(sample, counter)) return -1;
+    if (sample->values[PERF_INSTRUCTIONS] <= 0) return -1;
+    return 1000.0 * sample->values[counter] / sample->values[PERF_INSTRUCTIONS];
+}
+
+void perf_format_summary(const PerfSample* sample, char* out, size_t size) {
+    size_t length = 0;
+    if (size == 0) return;
+    out[0] = '\0';
+
+    double ipc = perf_ipc(sample);
+    if (ipc >= 0) length += (size_t)snprintf(out, size, "IPC %.2f", ipc);
+    int any_misses = 0;
+    for (int i = 0; i < MISS_COUNT && length < size; i++) {
+        double mpki = perf_mpki(sample, miss_counters[i]);
+        if (mpki < 0) continue;
+        length += (size_t)snprintf(out + length, size - length, "%s%s %.1f",
+                                   length > 0 ? "  " : "", miss_labels[i], mpki);
+        any_misses = 1;
+    }
+    if (any_misses && length < size) snprintf(out + length, size - length, " /1k instr");
+}
+
+void perf_report_regions(const PerfCounters* counters, FILE* out) {
+    fprintf(out, "%-24s %10s %12s %6s %8s %8s %8s %8s\n", "region", "calls", "total ms", "IPC",
+            "L1D/ki", "LLC/ki", "br/ki", "dTLB/ki");
+    for (int r = 0; r < counters->region_count; r++) {
+        const PerfRegion* region = &counters->regions[r];
+        fprintf(out, "%-24s %10llu %12.3f", region->name, (unsigned long long)region->calls,
+                region->seconds * 1e3);
+        double ipc = perf_ipc(&region->totals);
+        if (ipc >= 0) {
+            fprintf(out, " %6.2f", ipc);
+        } else {
+            fprintf(out, " %6s", "-");
+        }
+        for (int i = 0; i < MISS_COUNT; i++) {
+            double mpki = perf_mpki(&region->totals, miss_counters[i]);
+            if (mpki >= 0) {
+                fprintf(out, " %8.2f", mpki);
+            } else {
+                fprintf(out, " %8s", "-");
+            }
+        }
+        fputc('\n', out);
+    }
+}
+
+void perf_counters_status(const PerfCounters* counters, char* out, size_t size) {
+    int open = 0;
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) open += HAS(counters, i);
+    const char* reason = "";
+    switch (counters->error) {
+    case 0:
+        break;
+    case EACCES:
+    case EPERM:
+        reason = "not permitted: see /proc/sys/kernel/perf_event_paranoid";
+        break;
+    case ENOENT:
+    case ENODEV:
+    case EOPNOTSUPP:
+        reason = "not supported by this CPU, or no PMU in this VM/container";
+        break;
+    case ENOSYS:
+        reason = "perf_event_open() is not available on this system";
+        break;
+    default:
+        reason = strerror(counters->error);
+        break;
+    }
+    snprintf(out, size, "%d of %d hardware counters%s%s", open, PERF_COUNTER_COUNT,
+             open < PERF_COUNTER_COUNT ? " - " : "", open < PERF_COUNTER_COUNT ? reason : "");
+}
+
+const char* perf_counter_name(PerfCounter counter) {
+    return (unsigned)counter < PERF_COUNTER_COUNT ? counter_names[counter] : "unknown";
+}
@@ -0,0 +1,119 @@
+/*
+ * perf_counters.h - Hardware performance counters around code regions
+ *
+ * A timing says how long a loop took, not why. The CPU counts the why
+ * itself - cycles, instructions retired, cache and TLB misses,
+ * mispredicted branches - and Linux exposes those counters through
+ * perf_event_open(2). Two numbers usually tell the story:
+ * - IPC (instructions per cycle): a modern core retires 3-4 per cycle
+ *   when the data is in L1 and the branches are predictable; well under
+ *   1 means it is mostly waiting
+ * - misses per 1000 instructions (MPKI): many LLC misses per 1000
+ *   instructions mean waiting for memory (cache-bound); many branch
+ *   misses mean throwing work away after a wrong guess (branch-bound)
+ *
+ * Counters that can't be opened - no PMU in a VM or container,
+ * kernel.perf_event_paranoid too strict, not Linux, an event the CPU
+ * doesn't have - are simply left out: the other counters still work,
+ * and with none available every call is a cheap no-op, so programs run
+ * the same everywhere. Counts cover user space in the thread that opened
+ * the counters and every thread it starts after that (worker threads,
+ * pools), so a parallel region is counted whole.
+ *
+ * Two ways to use it:
+ * - perf_counters_start() / perf_counters_stop() around one piece of
+ *   code, giving a PerfSample (bench_harness.h does this around every
+ *   benchmark)
+ * - perf_region_begin(counters, "name") / perf_region_end() around
+ *   code that runs many times; the counts add up per name, and
+ *   perf_report_regions() prints a table of all regions
+ *
+ * For frontend developers: The CPU-level equivalent of the Performance
+ * panel's breakdown of where the time went, instead of one total from
+ * console.time().
+ */
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef enum {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,            // L1 data cache read misses
+    PERF_LLC_MISSES,            // Last-level cache misses (memory accesses)
+    PERF_BRANCH_MISSES,
+    PERF_DTLB_MISSES,           // Data TLB read misses (page table walks)
+    PERF_COUNTER_COUNT
+} PerfCounter;
+
+#define PERF_MAX_REGIONS 64
+#define PERF_MAX_DEPTH 16
+
+// Counts over some interval, corrected for multiplexing (when more
+// counters are open than the CPU has, the kernel time-slices them and
+// each count is scaled up by enabled / running time)
+typedef struct {
+    double values[PERF_COUNTER_COUNT];
+    unsigned available;         // Bit 1 << counter for every counter in values
+} PerfSample;
+
+typedef struct {
+    const char* name;
+    uint64_t calls;
+    double seconds;
+    PerfSample totals;
+} PerfRegion;
+
+typedef struct {
+    int fds[PERF_COUNTER_COUNT];    // -1 for counters that couldn't be opened
+    unsigned available;
+    int error;                      // errno of the first counter that failed, or 0
+    PerfSample start;               // Of the running perf_counters_start()
+    PerfRegion regions[PERF_MAX_REGIONS];
+    int region_count;
+    // Regions begun and not yet ended, innermost last
+    int open_regions[PERF_MAX_DEPTH];
+    PerfSample open_starts[PERF_MAX_DEPTH];
+    double open_seconds[PERF_MAX_DEPTH];
+    int depth;
+} PerfCounters;
+
+// Open every counter that can be opened. Always succeeds; see
+// counters->available and perf_counters_status() for what did.
+void perf_counters_open(PerfCounters* counters);
+void perf_counters_close(PerfCounters* counters);
+
+// Counts since perf_counters_start(); nothing available = all zero
+void perf_counters_start(PerfCounters* counters);
+void perf_counters_stop(PerfCounters* counters, PerfSample* sample);
+
+// Nested regions: counts and time add up per name (compared by content;
+// the string must stay valid - a literal). Beyond PERF_MAX_REGIONS names
+// or PERF_MAX_DEPTH nesting, regions are not counted.
+void perf_region_begin(PerfCounters* counters, const char* name);
+void perf_region_end(PerfCounters* counters);
+void perf_report_regions(const PerfCounters* counters, FILE* out);
+
+// Add `sample` to `total`, keeping only the counters both have: start
+// `total` at zero with available = counters->available
+void perf_sample_add(PerfSample* total, const PerfSample* sample);
+
+// Instructions per cycle, and misses per 1000 instructions, or a
+// negative value when the counters needed aren't available
+double perf_ipc(const PerfSample* sample);
+double perf_mpki(const PerfSample* sample, PerfCounter counter);
+
+// One line for a result: "IPC 2.31  L1D 12.3  LLC 0.4  br 5.1  dTLB 0.1 /1k instr",
+// leaving out what isn't available; "" when nothing is
+void perf_format_summary(const PerfSample* sample, char* out, size_t size);
+
+// "6 of 6 hardware counters", or fewer and why the others couldn't be opened
+void perf_counters_status(const PerfCounters* counters, char* out, size_t size);
+
+const char* perf_counter_name(PerfCounter counter);
+
+#endif // PERF_COUNTERS_H
@@ -0,0 +1,280 @@
+/*
+ * radix_sort.c - LSD radix sort for integer keys, MSD radix sort for strings
+ *
+ * Implementation notes:
+ * - The LSD loop is written once, in radix_template.h, for 32-bit values,
+ *   64-bit values and (key, index) pairs. Signed keys are sorted as
+ *   unsigned with the sign bit flipped on the fly, so negative numbers
+ *   come first without a conversion pass.
+ * - Counters are uint32_t (half the cache footprint of size_t): 6 passes
+ *   x 2048 digits for 64-bit keys is 48 KB. Inputs of 2^32 elements or
+ *   more go to sort.h instead.
+ * - Records: every key is extracted once, with its minimum subtracted,
+ *   so a column of years (range < 200) has one nonzero digit and needs
+ *   one pass. When the range and the index both fit in 32 bits, the pair
+ *   is packed into one uint64_t as (key << 32 | index) and only the upper
+ *   half is sorted: 8 bytes per element moved per pass instead of 16.
+ *   After sorting, each record is copied once into a scratch buffer in
+ *   key order.
+ * - Strings: each level reads the character at the current depth of
+ *   every string once into a byte cache, counts and distributes the
+ *   pointers, and recurses into each group of strings sharing that
+ *   character. A level where all strings share the character moves
+ *   nothing and goes one deeper; strings that end at the current depth
+ *   are equal and are done. Groups under 32 strings are insertion-sorted
+ *   with strcmp() from the current depth.
+ */
+
+#include "radix_sort.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Below this, sort.h (insertion sort / pdqsort) beats clearing and
+// summing 2048 counters per pass
+#define RADIX_MIN_COUNT 256
+// 64-bit keys with 11-bit digits: 6 passes x 2048 counters
+#define RADIX_MAX_COUNTERS (6 * 2048)
+// String groups smaller than this are insertion-sorted
+#define RADIX_STRING_INSERTION 32
+
+static int digit_bits = 11;
+
+typedef struct {
+    uint64_t key;       // Key minus the smallest key
+    size_t index;       // Position of the record before sorting
+} RadixPair;
+
+#define RADIX_T uint32_t
+#define RADIX_NAME(name) name##_u32
+#define RADIX_KEY(e) ((uint64_t)(e))
+#define RADIX_KEY_BITS 32
+#include "radix_template.h"
+
+#define RADIX_T uint64_t
+#define RADIX_NAME(name) name##_u64
+#define RADIX_KEY(e) (e)
+#define RADIX_KEY_BITS 64
+#include "radix_template.h"
+
+#define RADIX_T RadixPair
+#define RADIX_NAME(name) name##_pair
+#define RADIX_KEY(e) ((e).key)
+#define RADIX_KEY_BITS 64
+#include "radix_template.h"
+
+int radix_sort_set_digit_bits(int bits) {
+    if (bits != 8 && bits != 11) {
+        errno = EINVAL;
+        return -1;
+    }
+    digit_bits = bits;
+    return 0;
+}
+
+int radix_sort_digit_bits(void) {
+    return digit_bits;
+}
+
+static int radix_sort_32(uint32_t* values, size_t count, uint32_t flip) {
+    if (count < RADIX_MIN_COUNT || count > UINT32_MAX) {
+        // sort.h sorts signed values: flip unsigned ones into signed order
+        int32_t* signed_values = (int32_t*)values;
+        if (flip == 0) {
+            for (size_t i = 0; i < count; i++) values[i] ^= 0x80000000u;
+        }
+        sort_int32(signed_values, count);
+        if (flip == 0) {
+            for (size_t i = 0; i < count; i++) values[i] ^= 0x80000000u;
+        }
+        return 0;
+    }
+    uint32_t* scratch = malloc(count * sizeof(uint32_t));
+    if (scratch == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    lsd_u32(values, scratch, count, flip, 0, digit_bits);
+    free(scratch);
+    return 0;
+}
+
+static int radix_sort_64(uint64_t* values, size_t count, uint64_t flip) {
+    if (count < RADIX_MIN_COUNT || count > UINT32_MAX) {
+        int64_t* signed_values = (int64_t*)values;
+        const uint64_t sign = 0x8000000000000000ull;
+        if (flip == 0) {
+            for (size_t i = 0; i < count; i++) values[i] ^= sign;
+        }
+        sort_int64(signed_values, count);
+        if (flip == 0) {
+            for (size_t i = 0; i < count; i++) values[i] ^= sign;
+        }
+        return 0;
+    }
+    uint64_t* scratch = malloc(count * sizeof(uint64_t));
+    if (scratch == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    lsd_u64(values, scratch, count, flip, 0, digit_bits);
+    free(scratch);
+    return 0;
+}
+
+int radix_sort_int32(int32_t* values, size_t count) {
+    return radix_sort_32((uint32_t*)values, count, 0x80000000u);
+}
+
+int radix_sort_uint32(uint32_t* values, size_t count) {
+    return radix_sort_32(values, count, 0);
+}
+
+int radix_sort_int64(int64_t* values, size_t count) {
+    return radix_sort_64((uint64_t*)values, count, 0x8000000000000000ull);
+}
+
+int radix_sort_uint64(uint64_t* values, size_t count) {
+    return radix_sort_64(values, count, 0);
+}
+
+// Copy the records into key order: `order(i)` is the original index of
+// the i-th record
+#define GATHER_RECORDS(order)                                                  \
+    do {                                                                       \
+        for (size_t i = 0; i < count; i++) {                                   \
+            memcpy(sorted + i * size, records + (order) * size, size);         \
+        }                                                                      \
+    } while (0)
+
+int radix_sort_records_by_key(void* base, size_t count, size_t size, SortKey key,
+                              void* context) {
+    if (count < RADIX_MIN_COUNT || count > UINT32_MAX) {
+        return sort_records_by_key(base, count, size, key, context);
+    }
+    if (size == 0) return 0;
+    if (count > SIZE_MAX / size) {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    char* records = base;
+    char* sorted = malloc(count * size);
+    RadixPair* pairs = malloc(2 * count * sizeof(RadixPair));
+    if (sorted == NULL || pairs == NULL) {
+        free(sorted);
+        free(pairs);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    // Keys in unsigned order (sign bit flipped), and their range
+    uint64_t min = UINT64_MAX, max = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint64_t k = (uint64_t)key(records + i * size, context) ^ 0x8000000000000000ull;
+        pairs[i].key = k;
+        if (k < min) min = k;
+        if (k > max) max = k;
+    }
+
+    if (max - min <= UINT32_MAX) {
+        // (key << 32 | index) in one uint64_t; the pair array has room
+        // for both the packed values and their scratch copy
+        uint64_t* packed = (uint64_t*)pairs;
+        uint64_t* scratch = packed + count;
+        for (size_t i = 0; i < count; i++) packed[i] = ((pairs[i].key - min) << 32) | i;
+        lsd_u64(packed, scratch, count, 0, 32, digit_bits);
+        GATHER_RECORDS(packed[i] & 0xFFFFFFFFu);
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            pairs[i].key -= min;
+            pairs[i].index = i;
+        }
+        lsd_pair(pairs, pairs + count, count, 0, 0, digit_bits);
+        GATHER_RECORDS(pairs[i].index);
+    }
+    memcpy(base, sorted, count * size);
+
+    free(sorted);
+    free(pairs);
+    return 0;
+}
+
+static void insertion_sort_strings(const char** strings, size_t count, size_t depth) {
+    for (size_t i = 1; i < count; i++) {
+        const char* s = strings[i];
+        size_t j = i;
+        while (j > 0 && strcmp(strings[j - 1] + depth, s + depth) > 0) {
+            strings[j] = strings[j - 1];
+            j--;
+        }
+        strings[j] = s;
+    }
+}
+
+// `chars` and `scratch` are the slices of the whole-array buffers that
+// belong to this group
+static void msd_strings(const char** strings, const char** scratch, unsigned char* chars,
+                        size_t count, size_t depth) {
+    for (;;) {
+        if (count < RADIX_STRING_INSERTION) {
+            insertion_sort_strings(strings, count, depth);
+            return;
+        }
+
+        size_t counts[256] = {0};
+        for (size_t i = 0; i < count; i++) {
+            unsigned char c = (unsigned char)strings[i][depth];
+            chars[i] = c;
+            counts[c]++;
+        }
+
+        // One shared character: nothing to distribute, look one deeper
+        if (counts[chars[0]] == count) {
+            if (chars[0] == '\0') return;
+            depth++;
+            continue;
+        }
+
+        size_t offsets[256];
+        size_t sum = 0;
+        for (int c = 0; c < 256; c++) {
+            offsets[c] = sum;
+            sum += counts[c];
+        }
+        for (size_t i = 0; i < count; i++) scratch[offsets[chars[i]]++] = strings[i];
+        memcpy(strings, scratch, count * sizeof(const char*));
+
+        // Group 0 ended at this depth: those strings are equal
+        size_t start = counts[0];
+        for (int c = 1; c < 256; c++) {
+            if (counts[c] > 1) {
+                msd_strings(strings + start, scratch + start, chars + start, counts[c],
+                            depth + 1);
+            }
+            start += counts[c];
+        }
+        return;
+    }
+}
+
+int radix_sort_strings(const char** strings, size_t count) {
+    if (count < 2) return 0;
+    if (count < RADIX_STRING_INSERTION) {
+        insertion_sort_strings(strings, count, 0);
+        return 0;
+    }
+    const char** scratch = malloc(count * sizeof(const char*));
+    unsigned char* chars = malloc(count);
+    if (scratch == NULL || chars == NULL) {
+        free(scratch);
+        free(chars);
+        errno = ENOMEM;
+        return -1;
+    }
+    msd_strings(strings, scratch, chars, count, 0);
+    free(scratch);
+    free(chars);
+    return 0;
+}
@@ -0,0 +1,58 @@
+/*
+ * radix_sort.h - LSD radix sort for integer keys, MSD radix sort for strings
+ *
+ * A comparison sort needs about n log2(n) comparisons: 23 per element
+ * for 10 million elements. A radix sort never compares two elements. It
+ * reads the key one digit at a time (11 bits here: 2048 possible digits)
+ * and, per digit, counts how many keys have each value, turns the
+ * counts into start positions and copies every element straight to its
+ * place. A 32-bit key takes 3 such passes whatever n is.
+ *
+ * - radix_sort_int32()/_uint32()/_int64()/_uint64(): least significant
+ *   digit first. The counts for every pass come from one read of the
+ *   input, and a pass where all keys have the same digit (the high bits
+ *   of a year, of IDs below 2^22, ...) is skipped.
+ * - radix_sort_records_by_key(): sorts (key, index) pairs instead of the
+ *   records, so a 200-byte struct is moved once at the end instead of on
+ *   every pass. Stable, like every LSD radix sort.
+ * - radix_sort_strings(): most significant character first, recursing
+ *   into each group of strings that share a prefix, so only the
+ *   characters needed to tell strings apart are ever read.
+ *
+ * All of them need scratch memory as large as the input (n pointers for
+ * strings) and return 0, or -1 with errno = ENOMEM. Below a few hundred
+ * elements they hand over to sort.h, which is faster there.
+ *
+ * For frontend developers: How a postal office sorts letters - first into
+ * bins by country, then each bin by city - instead of comparing
+ * addresses pairwise.
+ */
+
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sort.h"
+
+int radix_sort_int32(int32_t* values, size_t count);
+int radix_sort_uint32(uint32_t* values, size_t count);
+int radix_sort_int64(int64_t* values, size_t count);
+int radix_sort_uint64(uint64_t* values, size_t count);
+
+// Stable sort of `count` records of `size` bytes by an int64_t key
+int radix_sort_records_by_key(void* base, size_t count, size_t size, SortKey key,
+                              void* context);
+
+// Sort an array of NUL-terminated strings in strcmp() order (bytes
+// compared as unsigned char). Only the pointers move; the order is stable.
+int radix_sort_strings(const char** strings, size_t count);
+
+// Bits per LSD digit: 8 (256 counters per pass, more passes) or 11 (2048
+// counters, fewer passes; the default). Returns 0, or -1 with errno =
+// EINVAL for any other value. For benchmarks.
+int radix_sort_set_digit_bits(int bits);
+int radix_sort_digit_bits(void);
+
+#endif // RADIX_SORT_H
@@ -0,0 +1,65 @@
+/*
+ * radix_template.h - LSD radix sort for one element type
+ *
+ * Not a public header: radix_sort.c includes it once per element type,
+ * after defining
+ *   RADIX_T            the element type
+ *   RADIX_NAME(name)   the name of a function for this type (name##_u32)
+ *   RADIX_KEY(e)       the element's key as a uint64_t
+ *   RADIX_KEY_BITS     how many low bits of RADIX_KEY(e) can be nonzero
+ * The macros are undefined again at the end, like sort_template.h.
+ */
+
+// Sort `count` elements by bits [first_bit, RADIX_KEY_BITS) of
+// RADIX_KEY(e) ^ flip (flip = the sign bit turns two's complement into
+// unsigned order). `scratch` holds `count` elements; the result ends up
+// in `values`. count must fit in a uint32_t.
+static void RADIX_NAME(lsd)(RADIX_T* values, RADIX_T* scratch, size_t count, uint64_t flip,
+                            int first_bit, int digit_bits) {
+    int passes = (RADIX_KEY_BITS - first_bit + digit_bits - 1) / digit_bits;
+    size_t radix = (size_t)1 << digit_bits;
+    uint64_t mask = radix - 1;
+    uint32_t counts[RADIX_MAX_COUNTERS];
+
+    // One read of the input counts the digits of every pass
+    memset(counts, 0, (size_t)passes * radix * sizeof(uint32_t));
+    for (size_t i = 0; i < count; i++) {
+        uint64_t key = (RADIX_KEY(values[i]) ^ flip) >> first_bit;
+        for (int p = 0; p < passes; p++) {
+            counts[(size_t)p * radix + ((key >> (p * digit_bits)) & mask)]++;
+        }
+    }
+
+    RADIX_T* source = values;
+    RADIX_T* target = scratch;
+    uint64_t first_key = (RADIX_KEY(values[0]) ^ flip) >> first_bit;
+    for (int p = 0; p < passes; p++) {
+        uint32_t* offsets = counts + (size_t)p * radix;
+        int shift = first_bit + p * digit_bits;
+
+        // Every key has the same digit here: the pass wouldn't move anything
+        if (offsets[(first_key >> (p * digit_bits)) & mask] == count) continue;
+
+        uint32_t sum = 0;
+        for (size_t d = 0; d < radix; d++) {
+            uint32_t n = offsets[d];
+            offsets[d] = sum;
+            sum += n;
+        }
+        for (size_t i = 0; i < count; i++) {
+            RADIX_T element = source[i];
+            target[offsets[((RADIX_KEY(element) ^ flip) >> shift) & mask]++] = element;
+        }
+
+        RADIX_T* tmp = source;
+        source = target;
+        target = tmp;
+    }
+
+    if (source != values) memcpy(values, source, count * sizeof(RADIX_T));
+}
+
+#undef RADIX_T
+#undef RADIX_NAME
+#undef RADIX_KEY
+#undef RADIX_KEY_BITS
@@ -0,0 +1,285 @@
+/*
+ * rng.c - Fast, seeded, reproducible random numbers
+ *
+ * Implementation notes:
+ * - Seeding runs splitmix64 from the seed: every output is a full
+ *   64-bit mix, so nearby seeds give unrelated states, and the state is
+ *   never all zero (the one state xoshiro must not have).
+ *   rng_seed_index() starts splitmix64 at seed + 4 x index steps, so the
+ *   states of consecutive items are disjoint runs of one splitmix64
+ *   sequence.
+ * - rng_below() uses the upper 32 bits (the best ones of any generator)
+ *   and Lemire's method: x * bound is a 64-bit number whose upper half is
+ *   the result; the lower half tells whether x fell into the 2^32 mod
+ *   bound values that would bias it. Only then is the exact threshold
+ *   computed with a %, and x redrawn.
+ * - Fills split the array into parts of at least 64K values (at most 64
+ *   parts); part p is filled by four lanes, the generators of streams
+ *   4p .. 4p + 3, with value i of the part coming from lane i % 4. The
+ *   four lanes are four independent xoshiro states stepped side by side,
+ *   which the compiler turns into vector instructions (or at least four
+ *   independent dependency chains). All states are jumped to on the
+ *   calling thread first; the parts are then independent tasks.
+ * - rng_fill_int32() takes two values from each 64-bit output (upper,
+ *   then lower half); a value in the rejection zone is redrawn from its
+ *   lane's next output.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "rng.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define RNG_LANES 4
+#define RNG_FILL_MIN_PART (64 * 1024)
+#define RNG_FILL_MAX_PARTS 64
+// Outputs generated at a time by rng_fill_int32(), before reducing them
+#define RNG_FILL_BLOCK 256
+
+static const uint64_t JUMP[4] = {
+    0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull, 0xa9582618e03fc9aaull, 0x39abdc4529b1661cull
+};
+
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t splitmix64(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t next(uint64_t s[4]) {
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+void rng_seed(Rng* rng, uint64_t seed) {
+    for (int i = 0; i < 4; i++) rng->s[i] = splitmix64(&seed);
+}
+
+void rng_seed_index(Rng* rng, uint64_t seed, uint64_t index) {
+    uint64_t state = seed + 4 * index * 0x9E3779B97F4A7C15ull;
+    for (int i = 0; i < 4; i++) rng->s[i] = splitmix64(&state);
+}
+
+void rng_jump(Rng* rng) {
+    uint64_t jumped[4] = {0, 0, 0, 0};
+    for (int i = 0; i < 4; i++) {
+        for (int bit = 0; bit < 64; bit++) {
+            if (JUMP[i] & (1ull << bit)) {
+                for (int w = 0; w < 4; w++) jumped[w] ^= rng->s[w];
+            }
+            next(rng->s);
+        }
+    }
+    memcpy(rng->s, jumped, sizeof(jumped));
+}
+
+void rng_stream(Rng* rng, uint64_t seed, unsigned stream) {
+    rng_seed(rng, seed);
+    for (unsigned i = 0; i < stream; i++) rng_jump(rng);
+}
+
+uint64_t rng_next(Rng* rng) {
+    return next(rng->s);
+}
+
+uint32_t rng_below(Rng* rng, uint32_t bound) {
+    uint64_t product = (next(rng->s) >> 32) * bound;
+    if ((uint32_t)product < bound) {
+        uint32_t threshold = (uint32_t)-bound % bound;
+        while ((uint32_t)product < threshold) product = (next(rng->s) >> 32) * bound;
+    }
+    return (uint32_t)(product >> 32);
+}
+
+// High and low 64 bits of a * b
+static inline uint64_t multiply_high(uint64_t a, uint64_t b, uint64_t* low) {
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 product = (unsigned __int128)a * b;
+    *low = (uint64_t)product;
+    return (uint64_t)(product >> 64);
+#else
+    uint64_t a_low = a & 0xFFFFFFFFu, a_high = a >> 32;
+    uint64_t b_low = b & 0xFFFFFFFFu, b_high = b >> 32;
+    uint64_t low_low = a_low * b_low;
+    uint64_t middle1 = a_high * b_low + (low_low >> 32);
+    uint64_t middle2 = a_low * b_high + (middle1 & 0xFFFFFFFFu);
+    *low = (middle2 << 32) | (low_low & 0xFFFFFFFFu);
+    return a_high * b_high + (middle1 >> 32) + (middle2 >> 32);
+#endif
+}
+
+uint64_t rng_below64(Rng* rng, uint64_t bound) {
+    uint64_t low;
+    uint64_t high = multiply_high(next(rng->s), bound, &low);
+    if (low < bound) {
+        uint64_t threshold = -bound % bound;
+        while (low < threshold) high = multiply_high(next(rng->s), bound, &low);
+    }
+    return high;
+}
+
+int64_t rng_between(Rng* rng, int64_t low, int64_t high) {
+    if (high <= low) return low;
+    uint64_t span = (uint64_t)high - (uint64_t)low + 1;
+    uint64_t offset = span == 0 ? next(rng->s) : rng_below64(rng, span);
+    return (int64_t)((uint64_t)low + offset);
+}
+
+double rng_double(Rng* rng) {
+    return (double)(next(rng->s) >> 11) * 0x1.0p-53;
+}
+
+// Four generators side by side: s[word][lane]
+typedef struct {
+    uint64_t s[4][RNG_LANES];
+} Lanes;
+
+// One output of `lane`, for the odd values the lockstep loop can't give
+static uint64_t lane_next(Lanes* lanes, int lane) {
+    uint64_t s[4] = {lanes->s[0][lane], lanes->s[1][lane], lanes->s[2][lane], lanes->s[3][lane]};
+    uint64_t result = next(s);
+    for (int w = 0; w < 4; w++) lanes->s[w][lane] = s[w];
+    return result;
+}
+
+// out[i] from lane i % RNG_LANES
+static void lanes_fill(Lanes* lanes, uint64_t* out, size_t count) {
+    uint64_t s0[RNG_LANES], s1[RNG_LANES], s2[RNG_LANES], s3[RNG_LANES];
+    memcpy(s0, lanes->s[0], sizeof(s0));
+    memcpy(s1, lanes->s[1], sizeof(s1));
+    memcpy(s2, lanes->s[2], sizeof(s2));
+    memcpy(s3, lanes->s[3], sizeof(s3));
+    size_t i = 0;
+    for (; i + RNG_LANES <= count; i += RNG_LANES) {
+        for (int l = 0; l < RNG_LANES; l++) {
+            out[i + l] = rotl(s1[l] * 5, 7) * 9;
+            uint64_t t = s1[l] << 17;
+            s2[l] ^= s0[l];
+            s3[l] ^= s1[l];
+            s1[l] ^= s2[l];
+            s0[l] ^= s3[l];
+            s2[l] ^= t;
+            s3[l] = rotl(s3[l], 45);
+        }
+    }
+    memcpy(lanes->s[0], s0, sizeof(s0));
+    memcpy(lanes->s[1], s1, sizeof(s1));
+    memcpy(lanes->s[2], s2, sizeof(s2));
+    memcpy(lanes->s[3], s3, sizeof(s3));
+    for (int lane = 0; i < count; i++, lane++) out[i] = lane_next(lanes, lane);
+}
+
+typedef struct {
+    Lanes* parts;
+    size_t part_count;
+    size_t count;
+    void* values;
+    int is_int32;
+    int32_t low;
+    uint32_t span;          // high - low + 1; 0 for all 2^32 values
+    uint32_t threshold;     // 2^32 % span: products below it are redrawn
+} FillJob;
+
+static size_t part_begin(const FillJob* job, size_t part) {
+    size_t size = job->count / job->part_count, extra = job->count % job->part_count;
+    return part * size + (part < extra ? part : extra);
+}
+
+// low + x * span / 2^32, redrawing from `lane` in the rejection zone
+static inline int32_t reduce(uint32_t x, uint32_t low, uint32_t span, uint32_t threshold,
+                             Lanes* lanes, int lane) {
+    if (span == 0) return (int32_t)(low + x);
+    uint64_t product = (uint64_t)x * span;
+    while ((uint32_t)product < threshold) product = (lane_next(lanes, lane) >> 32) * span;
+    return (int32_t)(low + (uint32_t)(product >> 32));
+}
+
+static void fill_part(FillJob* job, size_t part) {
+    Lanes* lanes = &job->parts[part];
+    size_t begin = part_begin(job, part), end = part_begin(job, part + 1);
+    if (!job->is_int32) {
+        lanes_fill(lanes, (uint64_t*)job->values + begin, end - begin);
+        return;
+    }
+
+    // Locals: stores through `out` could otherwise alias the job's fields
+    int32_t* out = (int32_t*)job->values;
+    uint32_t low = (uint32_t)job->low, span = job->span, threshold = job->threshold;
+    uint64_t block[RNG_FILL_BLOCK];
+    size_t i = begin;
+    while (i < end) {
+        size_t outputs = (end - i + 1) / 2;
+        if (outputs > RNG_FILL_BLOCK) outputs = RNG_FILL_BLOCK;
+        lanes_fill(lanes, block, outputs);
+        for (size_t b = 0; b < outputs && i < end; b++) {
+            int lane = (int)(b % RNG_LANES);
+            out[i++] = reduce((uint32_t)(block[b] >> 32), low, span, threshold, lanes, lane);
+            if (i < end) out[i++] = reduce((uint32_t)block[b], low, span, threshold, lanes, lane);
+        }
+    }
+}
+
+static void fill_parts(size_t begin, size_t end, void* argument) {
+    for (size_t part = begin; part < end; part++) fill_part((FillJob*)argument, part);
+}
+
+static void run_fill(TaskPool* pool, FillJob* job, uint64_t seed) {
+    if (job->count == 0) return;
+    size_t part_count = job->count / RNG_FILL_MIN_PART;
+    if (part_count < 1) part_count = 1;
+    if (part_count > RNG_FILL_MAX_PARTS) part_count = RNG_FILL_MAX_PARTS;
+
+    Lanes parts[RNG_FILL_MAX_PARTS];
+    Rng rng;
+    rng_seed(&rng, seed);
+    for (size_t part = 0; part < part_count; part++) {
+        for (int lane = 0; lane < RNG_LANES; lane++) {
+            for (int w = 0; w < 4; w++) parts[part].s[w][lane] = rng.s[w];
+            rng_jump(&rng);
+        }
+    }
+    job->parts = parts;
+    job->part_count = part_count;
+
+    if (pool != NULL && pool->thread_count > 1 && part_count > 1) {
+        task_parallel_for(pool, part_count, 1, fill_parts, job);
+    } else {
+        fill_parts(0, part_count, job);
+    }
+}
+
+void rng_fill_uint64(TaskPool* pool, uint64_t* values, size_t count, uint64_t seed) {
+    FillJob job;
+    memset(&job, 0, sizeof(job));
+    job.count = count;
+    job.values = values;
+    run_fill(pool, &job, seed);
+}
+
+void rng_fill_int32(TaskPool* pool, int32_t* values, size_t count, int32_t low, int32_t high,
+                    uint64_t seed) {
+    FillJob job;
+    memset(&job, 0, sizeof(job));
+    job.count = count;
+    job.values = values;
+    job.is_int32 = 1;
+    job.low = low;
+    if (high < low) high = low;
+    job.span = (uint32_t)((uint32_t)high - (uint32_t)low + 1u);
+    job.threshold = job.span != 0 ? (uint32_t)-job.span % job.span : 0;
+    run_fill(pool, &job, seed);
+}
@@ -0,0 +1,74 @@
+/*
+ * rng.h - Fast, seeded, reproducible random numbers
+ *
+ * srand(time(NULL)) + rand() % n has four problems: every run gets
+ * different numbers, so timings and bugs can't be reproduced; rand()
+ * has one hidden global state, so threads share (and fight over) it;
+ * % n favors small values whenever n doesn't divide RAND_MAX + 1; and
+ * RAND_MAX may be as small as 32767. This module has instead:
+ * - xoshiro256** (Blackman and Vigna): 256 bits of state in an Rng the
+ *   caller owns, a period of 2^256 - 1, about 1 ns per 64-bit value
+ * - unbiased ranges without a division in the common case (Lemire's
+ *   multiply-shift: a 32x32 -> 64-bit multiply, and a % only when the
+ *   rare rejection zone is hit)
+ * - rng_jump(): skip 2^128 values at once, so thread i can use the
+ *   stream seed + i jumps and never overlap with another thread's
+ * - rng_seed_index(): a generator for item `index` of a dataset, so
+ *   items can be made independently, in any order, on any thread, and
+ *   item 1000000 is the same whether it was made first or last
+ * - rng_fill_uint64() / rng_fill_int32(): fill huge arrays with four
+ *   interleaved generators (lanes the compiler can vectorize), split
+ *   into parts that a TaskPool fills in parallel. The values depend only
+ *   on the seed and count - not on the pool or its thread count.
+ *
+ * Not for cryptography: the output is predictable from a few values.
+ *
+ * For frontend developers: Math.random() with a seed you choose, a
+ * separate generator per Web Worker, and randomInt(min, max) without
+ * the Math.floor(Math.random() * n) rounding bias.
+ */
+
+#ifndef RNG_H
+#define RNG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "task_pool.h"
+
+typedef struct {
+    uint64_t s[4];
+} Rng;
+
+// Expand a 64-bit seed into the state with splitmix64 (never all zero)
+void rng_seed(Rng* rng, uint64_t seed);
+
+// The generator for item `index` of the dataset made from `seed`
+void rng_seed_index(Rng* rng, uint64_t seed, uint64_t index);
+
+// Stream `stream` of `seed`: rng_seed(), then rng_jump() `stream` times
+void rng_stream(Rng* rng, uint64_t seed, unsigned stream);
+
+// Advance by 2^128 values
+void rng_jump(Rng* rng);
+
+uint64_t rng_next(Rng* rng);
+
+// Uniform in [0, bound); 0 when bound is 0
+uint32_t rng_below(Rng* rng, uint32_t bound);
+uint64_t rng_below64(Rng* rng, uint64_t bound);
+
+// Uniform in [low, high], both included; low when high < low
+int64_t rng_between(Rng* rng, int64_t low, int64_t high);
+
+// Uniform in [0, 1), with 53 random bits
+double rng_double(Rng* rng);
+
+// Fill values[0..count) from `seed`. pool may be NULL (calling thread
+// only); the result is the same either way.
+void rng_fill_uint64(TaskPool* pool, uint64_t* values, size_t count, uint64_t seed);
+// Uniform in [low, high], both included
+void rng_fill_int32(TaskPool* pool, int32_t* values, size_t count, int32_t low, int32_t high,
+                    uint64_t seed);
+
+#endif // RNG_H
@@ -0,0 +1,184 @@
+/*
+ * sort.c - Pattern-defeating quicksort and stable merge sort
+ *
+ * Implementation notes:
+ * - The algorithms are written once, in sort_template.h, and instantiated
+ *   here for each element type: int32_t, int64_t, (key, index) pairs and
+ *   record pointers. Each copy has its comparison inlined, where qsort()
+ *   makes an indirect call per comparison and swaps byte by byte.
+ * - Integer and key sorts partition branchlessly (BlockQuicksort): with
+ *   random data, "is this element smaller than the pivot" is a coin flip
+ *   the branch predictor gets wrong half the time, ~15 cycles each. Record
+ *   sorts call the user's comparator anyway, so they keep the plain
+ *   partition loop.
+ * - sort_records*() sort an array of pointers to the records and then
+ *   copy each record once into a scratch buffer in sorted order: moving a
+ *   pointer is one store however large the record is.
+ * - sort_records_by_key() extracts every key once into (key, index)
+ *   pairs and sorts those. Ties are broken by the original index, which
+ *   makes the unstable pdqsort produce a stable order.
+ * - The merge sort copies only the left half out before merging, so it
+ *   needs count / 2 elements of scratch space. It skips the merge when
+ *   the two halves are already in order and swaps them when they are in
+ *   reverse order, so sorted and reversed input cost one pass per level.
+ */
+
+#include "sort.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Ranges shorter than this are insertion-sorted
+#define SORT_INSERTION_THRESHOLD 24
+// Ranges longer than this take the pivot from 9 elements instead of 3
+#define SORT_NINTHER_THRESHOLD 128
+// Elements a partial insertion sort may move before it gives up
+#define SORT_PARTIAL_LIMIT 8
+// Elements per side scanned at once by the branchless partition (the
+// offsets must fit in an unsigned char)
+#define SORT_BLOCK_SIZE 64
+// Merge sort runs of this length are insertion-sorted
+#define SORT_MERGE_RUN 16
+
+typedef struct {
+    int64_t key;
+    size_t index;       // Position before sorting: the tie-breaker
+} KeyIndex;
+
+typedef struct {
+    SortCompare compare;
+    void* context;
+} RecordOrder;
+
+#define SORT_T int32_t
+#define SORT_NAME(name) name##_int32
+#define SORT_LESS(a, b) ((a) < (b))
+#define SORT_BRANCHLESS 1
+#include "sort_template.h"
+
+#define SORT_T int64_t
+#define SORT_NAME(name) name##_int64
+#define SORT_LESS(a, b) ((a) < (b))
+#define SORT_BRANCHLESS 1
+#include "sort_template.h"
+
+// & and | instead of && and || so the comparison stays branch-free
+static inline int key_index_less(KeyIndex a, KeyIndex b) {
+    return (a.key < b.key) | ((a.key == b.key) & (a.index < b.index));
+}
+
+#define SORT_T KeyIndex
+#define SORT_NAME(name) name##_key
+#define SORT_LESS(a, b) key_index_less((a), (b))
+#define SORT_BRANCHLESS 1
+#include "sort_template.h"
+
+#define SORT_T const char*
+#define SORT_NAME(name) name##_record
+#define SORT_LESS(a, b) \
+    (((const RecordOrder*)context)->compare((a), (b), ((const RecordOrder*)context)->context) < 0)
+#define SORT_BRANCHLESS 0
+#include "sort_template.h"
+
+void sort_int32(int32_t* values, size_t count) {
+    pdqsort_int32(values, count, NULL);
+}
+
+void sort_int64(int64_t* values, size_t count) {
+    pdqsort_int64(values, count, NULL);
+}
+
+int sort_int32_stable(int32_t* values, size_t count) {
+    if (count < 2) return 0;
+    int32_t* buffer = malloc((count / 2) * sizeof(int32_t));
+    if (buffer == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    merge_sort_int32(values, count, buffer, NULL);
+    free(buffer);
+    return 0;
+}
+
+// Sort pointers to the records, stable or not, then copy the records
+// into place
+static int sort_record_pointers(void* base, size_t count, size_t size, SortCompare compare,
+                                void* context, int stable) {
+    if (count < 2 || size == 0) return 0;
+    if (count > SIZE_MAX / size) {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    // Pointers, the merge sort's half-size buffer and the sorted records
+    size_t pointer_count = count + (stable ? count / 2 : 0);
+    const char** pointers = malloc(pointer_count * sizeof(const char*));
+    char* sorted = malloc(count * size);
+    if (pointers == NULL || sorted == NULL) {
+        free(pointers);
+        free(sorted);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    const char* records = base;
+    for (size_t i = 0; i < count; i++) pointers[i] = records + i * size;
+
+    RecordOrder order = {compare, context};
+    if (stable) {
+        merge_sort_record(pointers, count, pointers + count, &order);
+    } else {
+        pdqsort_record(pointers, count, &order);
+    }
+
+    for (size_t i = 0; i < count; i++) memcpy(sorted + i * size, pointers[i], size);
+    memcpy(base, sorted, count * size);
+
+    free(pointers);
+    free(sorted);
+    return 0;
+}
+
+int sort_records(void* base, size_t count, size_t size, SortCompare compare, void* context) {
+    return sort_record_pointers(base, count, size, compare, context, 0);
+}
+
+int sort_records_stable(void* base, size_t count, size_t size, SortCompare compare,
+                        void* context) {
+    return sort_record_pointers(base, count, size, compare, context, 1);
+}
+
+int sort_records_by_key(void* base, size_t count, size_t size, SortKey key, void* context) {
+    if (count < 2 || size == 0) return 0;
+    if (count > SIZE_MAX / size) {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    KeyIndex* keys = malloc(count * sizeof(KeyIndex));
+    char* sorted = malloc(count * size);
+    if (keys == NULL || sorted == NULL) {
+        free(keys);
+        free(sorted);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    char* records = base;
+    for (size_t i = 0; i < count; i++) {
+        keys[i].key = key(records + i * size, context);
+        keys[i].index = i;
+    }
+
+    pdqsort_key(keys, count, NULL);
+
+    for (size_t i = 0; i < count; i++) {
+        memcpy(sorted + i * size, records + keys[i].index * size, size);
+    }
+    memcpy(base, sorted, count * size);
+
+    free(keys);
+    free(sorted);
+    return 0;
+}
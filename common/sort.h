@@ -0,0 +1,61 @@
+/*
+ * sort.h - Pattern-defeating quicksort and stable merge sort
+ *
+ * The lessons' bubble, selection and insertion sorts compare every pair
+ * of elements, O(n^2): fine for 12 numbers, hours for 10 million. qsort()
+ * is O(n log n) but calls the comparison function through a pointer for
+ * every comparison and moves elements byte by byte, because it knows
+ * neither their type nor their size at compile time.
+ *
+ * This module provides:
+ * - sort_int32()/sort_int64(): pdqsort (pattern-defeating quicksort)
+ *   specialised for the type. Small partitions use insertion sort,
+ *   partitioning is branchless (the comparisons become offsets instead of
+ *   unpredictable jumps), sorted, reversed and few-distinct inputs are
+ *   detected and finish in (near) linear time, and a run of bad pivots
+ *   falls back to heapsort, so the worst case stays O(n log n)
+ * - sort_int32_stable(): merge sort, for when equal elements must keep
+ *   their order (or a guaranteed O(n log n) without randomness matters)
+ * - sort_records()/sort_records_stable(): the same for any element type
+ *   with a comparison function, like qsort() but with a context pointer.
+ *   Pointers to the records are sorted and each record is moved once at
+ *   the end, so a 200-byte struct costs the same to sort as an int
+ * - sort_records_by_key(): stable sort by an int64_t key extracted once
+ *   per record (a year, an ID, a negated count for descending order), with
+ *   no comparison function calls while sorting
+ *
+ * Functions that need scratch memory return 0, or -1 with errno = ENOMEM.
+ *
+ * For frontend developers: array.sort() in V8 is TimSort, a stable merge
+ * sort; sort_records_by_key() is like lodash's _.sortBy(array, key).
+ */
+
+#ifndef SORT_H
+#define SORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Like qsort()'s comparator, plus the context given to the sort call:
+// negative if a sorts before b, 0 if equal, positive if after
+typedef int (*SortCompare)(const void* a, const void* b, void* context);
+
+// Sort key of one record; records sort by ascending key
+typedef int64_t (*SortKey)(const void* record, void* context);
+
+// Unstable, in place, no allocation
+void sort_int32(int32_t* values, size_t count);
+void sort_int64(int64_t* values, size_t count);
+
+// Stable merge sort; allocates count / 2 values of scratch space
+int sort_int32_stable(int32_t* values, size_t count);
+
+// `count` records of `size` bytes each, in the order given by `compare`
+int sort_records(void* base, size_t count, size_t size, SortCompare compare, void* context);
+int sort_records_stable(void* base, size_t count, size_t size, SortCompare compare,
+                        void* context);
+
+// Stable: records with equal keys keep their order
+int sort_records_by_key(void* base, size_t count, size_t size, SortKey key, void* context);
+
+#endif // SORT_H
@@ -0,0 +1,418 @@
+/*
+ * sort_template.h - pdqsort and merge sort for one element type
+ *
+ * Not a public header: sort.c includes it once per element type, after
+ * defining
+ *   SORT_T            the element type
+ *   SORT_NAME(name)   the name of a function for this type (name##_int32)
+ *   SORT_LESS(a, b)   1 if a sorts before b; may use `context`, and must
+ *                     evaluate each argument once (they can be *--last)
+ *   SORT_BRANCHLESS   1 to partition with offset blocks (cheap, inlined
+ *                     comparisons), 0 for the classic Hoare loop
+ * Every function takes a `void* context` for SORT_LESS, whether it uses
+ * it or not, and the macros are undefined again at the end.
+ *
+ * The pdqsort functions follow Orson Peters' reference implementation.
+ */
+
+static inline void SORT_NAME(swap)(SORT_T* a, SORT_T* b) {
+    SORT_T tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+static inline void SORT_NAME(sort2)(SORT_T* a, SORT_T* b, void* context) {
+    (void)context;
+    if (SORT_LESS(*b, *a)) SORT_NAME(swap)(a, b);
+}
+
+static inline void SORT_NAME(sort3)(SORT_T* a, SORT_T* b, SORT_T* c, void* context) {
+    SORT_NAME(sort2)(a, b, context);
+    SORT_NAME(sort2)(b, c, context);
+    SORT_NAME(sort2)(a, b, context);
+}
+
+static void SORT_NAME(insertion_sort)(SORT_T* begin, SORT_T* end, void* context) {
+    (void)context;
+    if (begin == end) return;
+    for (SORT_T* cur = begin + 1; cur != end; cur++) {
+        SORT_T* sift = cur;
+        SORT_T* sift_1 = cur - 1;
+        if (SORT_LESS(*sift, *sift_1)) {
+            SORT_T tmp = *sift;
+            do {
+                *sift-- = *sift_1;
+            } while (sift != begin && SORT_LESS(tmp, *--sift_1));
+            *sift = tmp;
+        }
+    }
+}
+
+// begin[-1] is known to be <= every element, so the inner loop needs no
+// bounds check
+static void SORT_NAME(unguarded_insertion_sort)(SORT_T* begin, SORT_T* end, void* context) {
+    (void)context;
+    if (begin == end) return;
+    for (SORT_T* cur = begin + 1; cur != end; cur++) {
+        SORT_T* sift = cur;
+        SORT_T* sift_1 = cur - 1;
+        if (SORT_LESS(*sift, *sift_1)) {
+            SORT_T tmp = *sift;
+            do {
+                *sift-- = *sift_1;
+            } while (SORT_LESS(tmp, *--sift_1));
+            *sift = tmp;
+        }
+    }
+}
+
+// Insertion sort that gives up after moving SORT_PARTIAL_LIMIT elements:
+// returns 1 if the range is now sorted
+static int SORT_NAME(partial_insertion_sort)(SORT_T* begin, SORT_T* end, void* context) {
+    (void)context;
+    if (begin == end) return 1;
+    size_t moved = 0;
+    for (SORT_T* cur = begin + 1; cur != end; cur++) {
+        SORT_T* sift = cur;
+        SORT_T* sift_1 = cur - 1;
+        if (SORT_LESS(*sift, *sift_1)) {
+            SORT_T tmp = *sift;
+            do {
+                *sift-- = *sift_1;
+            } while (sift != begin && SORT_LESS(tmp, *--sift_1));
+            *sift = tmp;
+            moved += (size_t)(cur - sift);
+            if (moved > SORT_PARTIAL_LIMIT) return 0;
+        }
+    }
+    return 1;
+}
+
+static void SORT_NAME(sift_down)(SORT_T* heap, size_t i, size_t count, void* context) {
+    (void)context;
+    SORT_T value = heap[i];
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= count) break;
+        if (child + 1 < count && SORT_LESS(heap[child], heap[child + 1])) child++;
+        if (!SORT_LESS(value, heap[child])) break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = value;
+}
+
+static void SORT_NAME(heap_sort)(SORT_T* begin, SORT_T* end, void* context) {
+    size_t count = (size_t)(end - begin);
+    for (size_t i = count / 2; i-- > 0;) SORT_NAME(sift_down)(begin, i, count, context);
+    for (size_t i = count; i-- > 1;) {
+        SORT_NAME(swap)(begin, begin + i);
+        SORT_NAME(sift_down)(begin, 0, i, context);
+    }
+}
+
+// Elements equal to the pivot *begin go to the left. Used when the pivot
+// equals the element before the range, so everything equal to it is
+// already in place and only the larger elements need sorting.
+static SORT_T* SORT_NAME(partition_left)(SORT_T* begin, SORT_T* end, void* context) {
+    (void)context;
+    SORT_T pivot = *begin;
+    SORT_T* first = begin;
+    SORT_T* last = end;
+
+    while (SORT_LESS(pivot, *--last)) {}
+    if (last + 1 == end) {
+        while (first < last && !SORT_LESS(pivot, *++first)) {}
+    } else {
+        while (!SORT_LESS(pivot, *++first)) {}
+    }
+    while (first < last) {
+        SORT_NAME(swap)(first, last);
+        while (SORT_LESS(pivot, *--last)) {}
+        while (!SORT_LESS(pivot, *++first)) {}
+    }
+
+    *begin = *last;
+    *last = pivot;
+    return last;
+}
+
+#if SORT_BRANCHLESS
+// Swap the elements at first + offsets_l[i] and last - offsets_r[i]. With
+// unequal counts a cyclic rotation needs one move per element instead of
+// the three of a swap.
+static inline void SORT_NAME(swap_offsets)(SORT_T* first, SORT_T* last,
+                                           const unsigned char* offsets_l,
+                                           const unsigned char* offsets_r, size_t count,
+                                           int use_swaps) {
+    if (use_swaps) {
+        for (size_t i = 0; i < count; i++) {
+            SORT_NAME(swap)(first + offsets_l[i], last - offsets_r[i]);
+        }
+    } else if (count > 0) {
+        SORT_T* l = first + offsets_l[0];
+        SORT_T* r = last - offsets_r[0];
+        SORT_T tmp = *l;
+        *l = *r;
+        for (size_t i = 1; i < count; i++) {
+            l = first + offsets_l[i];
+            *r = *l;
+            r = last - offsets_r[i];
+            *l = *r;
+        }
+        *r = tmp;
+    }
+}
+#endif
+
+// Partition around the pivot *begin: smaller elements to the left, the
+// rest to the right. Returns the pivot's final position; *already_partitioned
+// is set if no element had to move.
+static SORT_T* SORT_NAME(partition_right)(SORT_T* begin, SORT_T* end, int* already_partitioned,
+                                          void* context) {
+    (void)context;
+    SORT_T pivot = *begin;
+    SORT_T* first = begin;
+    SORT_T* last = end;
+
+    // The median-of-3 left an element >= pivot at the end, so this stops
+    while (SORT_LESS(*++first, pivot)) {}
+    if (first - 1 == begin) {
+        while (first < last && !SORT_LESS(*--last, pivot)) {}
+    } else {
+        while (!SORT_LESS(*--last, pivot)) {}
+    }
+
+    *already_partitioned = first >= last;
+
+#if SORT_BRANCHLESS
+    if (!*already_partitioned) {
+        SORT_NAME(swap)(first, last);
+        first++;
+
+        // Scan a block from each side, recording the offsets of elements on
+        // the wrong side: "offsets[n] = i; n += wrong" has no branch to
+        // mispredict. Then swap pairs of recorded elements.
+        unsigned char offsets_l[SORT_BLOCK_SIZE];
+        unsigned char offsets_r[SORT_BLOCK_SIZE];
+        SORT_T* offsets_l_base = first;
+        SORT_T* offsets_r_base = last;
+        size_t num_l = 0, num_r = 0, start_l = 0, start_r = 0;
+
+        while (first < last) {
+            // Split what is left between the sides that need a new block
+            size_t unknown = (size_t)(last - first);
+            size_t left_split = num_l == 0 ? (num_r == 0 ? unknown / 2 : unknown) : 0;
+            size_t right_split = num_r == 0 ? unknown - left_split : 0;
+
+            if (left_split >= SORT_BLOCK_SIZE) {
+                for (size_t i = 0; i < SORT_BLOCK_SIZE;) {
+                    offsets_l[num_l] = (unsigned char)i++; num_l += !SORT_LESS(*first, pivot); first++;
+                    offsets_l[num_l] = (unsigned char)i++; num_l += !SORT_LESS(*first, pivot); first++;
+                    offsets_l[num_l] = (unsigned char)i++; num_l += !SORT_LESS(*first, pivot); first++;
+                    offsets_l[num_l] = (unsigned char)i++; num_l += !SORT_LESS(*first, pivot); first++;
+                    offsets_l[num_l] = (unsigned char)i++; num_l += !SORT_LESS(*first, pivot); first++;
+                    offsets_l[num_l] = (unsigned char)i++; num_l += !SORT_LESS(*first, pivot); first++;
+                    offsets_l[num_l] = (unsigned char)i++; num_l += !SORT_LESS(*first, pivot); first++;
+                    offsets_l[num_l] = (unsigned char)i++; num_l += !SORT_LESS(*first, pivot); first++;
+                }
+            } else {
+                for (size_t i = 0; i < left_split;) {
+                    offsets_l[num_l] = (unsigned char)i++; num_l += !SORT_LESS(*first, pivot); first++;
+                }
+            }
+
+            if (right_split >= SORT_BLOCK_SIZE) {
+                for (size_t i = 0; i < SORT_BLOCK_SIZE;) {
+                    offsets_r[num_r] = (unsigned char)++i; num_r += SORT_LESS(*--last, pivot);
+                    offsets_r[num_r] = (unsigned char)++i; num_r += SORT_LESS(*--last, pivot);
+                    offsets_r[num_r] = (unsigned char)++i; num_r += SORT_LESS(*--last, pivot);
+                    offsets_r[num_r] = (unsigned char)++i; num_r += SORT_LESS(*--last, pivot);
+                    offsets_r[num_r] = (unsigned char)++i; num_r += SORT_LESS(*--last, pivot);
+                    offsets_r[num_r] = (unsigned char)++i; num_r += SORT_LESS(*--last, pivot);
+                    offsets_r[num_r] = (unsigned char)++i; num_r += SORT_LESS(*--last, pivot);
+                    offsets_r[num_r] = (unsigned char)++i; num_r += SORT_LESS(*--last, pivot);
+                }
+            } else {
+                for (size_t i = 0; i < right_split;) {
+                    offsets_r[num_r] = (unsigned char)++i; num_r += SORT_LESS(*--last, pivot);
+                }
+            }
+
+            size_t count = num_l < num_r ? num_l : num_r;
+            SORT_NAME(swap_offsets)(offsets_l_base, offsets_r_base, offsets_l + start_l,
+                                    offsets_r + start_r, count, num_l == num_r);
+            num_l -= count;
+            num_r -= count;
+            start_l += count;
+            start_r += count;
+            if (num_l == 0) {
+                start_l = 0;
+                offsets_l_base = first;
+            }
+            if (num_r == 0) {
+                start_r = 0;
+                offsets_r_base = last;
+            }
+        }
+
+        // One side may still hold recorded elements: move them to the
+        // middle, next to the other side's part
+        if (num_l > 0) {
+            while (num_l-- > 0) SORT_NAME(swap)(offsets_l_base + offsets_l[start_l + num_l], --last);
+            first = last;
+        }
+        if (num_r > 0) {
+            while (num_r-- > 0) SORT_NAME(swap)(offsets_r_base - offsets_r[start_r + num_r], first++);
+            last = first;
+        }
+    }
+#else
+    while (first < last) {
+        SORT_NAME(swap)(first, last);
+        while (SORT_LESS(*++first, pivot)) {}
+        while (!SORT_LESS(*--last, pivot)) {}
+    }
+#endif
+
+    SORT_T* pivot_pos = first - 1;
+    *begin = *pivot_pos;
+    *pivot_pos = pivot;
+    return pivot_pos;
+}
+
+static void SORT_NAME(pdqsort_loop)(SORT_T* begin, SORT_T* end, int bad_allowed, int leftmost,
+                                    void* context) {
+    for (;;) {
+        size_t size = (size_t)(end - begin);
+
+        if (size < SORT_INSERTION_THRESHOLD) {
+            if (leftmost) {
+                SORT_NAME(insertion_sort)(begin, end, context);
+            } else {
+                SORT_NAME(unguarded_insertion_sort)(begin, end, context);
+            }
+            return;
+        }
+
+        // Pivot: median of 3, or for large ranges the median of three
+        // medians of 3 (Tukey's ninther), moved to *begin
+        size_t s2 = size / 2;
+        if (size > SORT_NINTHER_THRESHOLD) {
+            SORT_NAME(sort3)(begin, begin + s2, end - 1, context);
+            SORT_NAME(sort3)(begin + 1, begin + (s2 - 1), end - 2, context);
+            SORT_NAME(sort3)(begin + 2, begin + (s2 + 1), end - 3, context);
+            SORT_NAME(sort3)(begin + (s2 - 1), begin + s2, begin + (s2 + 1), context);
+            SORT_NAME(swap)(begin, begin + s2);
+        } else {
+            SORT_NAME(sort3)(begin + s2, begin, end - 1, context);
+        }
+
+        // The element before this range is the pivot of an earlier
+        // partition. If ours equals it, every element equal to the pivot
+        // is in place: keep only the larger ones. This makes inputs with
+        // few distinct values O(n log k).
+        if (!leftmost && !SORT_LESS(*(begin - 1), *begin)) {
+            begin = SORT_NAME(partition_left)(begin, end, context) + 1;
+            continue;
+        }
+
+        int already_partitioned;
+        SORT_T* pivot_pos = SORT_NAME(partition_right)(begin, end, &already_partitioned, context);
+
+        size_t l_size = (size_t)(pivot_pos - begin);
+        size_t r_size = (size_t)(end - (pivot_pos + 1));
+        int highly_unbalanced = l_size < size / 8 || r_size < size / 8;
+
+        if (highly_unbalanced) {
+            // Too many bad pivots: heapsort keeps the worst case O(n log n)
+            if (--bad_allowed == 0) {
+                SORT_NAME(heap_sort)(begin, end, context);
+                return;
+            }
+
+            // Otherwise break up patterns that fool the median-of-3
+            if (l_size >= SORT_INSERTION_THRESHOLD) {
+                SORT_NAME(swap)(begin, begin + l_size / 4);
+                SORT_NAME(swap)(pivot_pos - 1, pivot_pos - l_size / 4);
+                if (l_size > SORT_NINTHER_THRESHOLD) {
+                    SORT_NAME(swap)(begin + 1, begin + (l_size / 4 + 1));
+                    SORT_NAME(swap)(begin + 2, begin + (l_size / 4 + 2));
+                    SORT_NAME(swap)(pivot_pos - 2, pivot_pos - (l_size / 4 + 1));
+                    SORT_NAME(swap)(pivot_pos - 3, pivot_pos - (l_size / 4 + 2));
+                }
+            }
+            if (r_size >= SORT_INSERTION_THRESHOLD) {
+                SORT_NAME(swap)(pivot_pos + 1, pivot_pos + (1 + r_size / 4));
+                SORT_NAME(swap)(end - 1, end - r_size / 4);
+                if (r_size > SORT_NINTHER_THRESHOLD) {
+                    SORT_NAME(swap)(pivot_pos + 2, pivot_pos + (2 + r_size / 4));
+                    SORT_NAME(swap)(pivot_pos + 3, pivot_pos + (3 + r_size / 4));
+                    SORT_NAME(swap)(end - 2, end - (1 + r_size / 4));
+                    SORT_NAME(swap)(end - 3, end - (2 + r_size / 4));
+                }
+            }
+        } else if (already_partitioned &&
+                   SORT_NAME(partial_insertion_sort)(begin, pivot_pos, context) &&
+                   SORT_NAME(partial_insertion_sort)(pivot_pos + 1, end, context)) {
+            // Nothing moved and both halves were (nearly) sorted: done.
+            // This is what makes sorted and reversed input linear.
+            return;
+        }
+
+        // Recurse into the left part, loop on the right one
+        SORT_NAME(pdqsort_loop)(begin, pivot_pos, bad_allowed, leftmost, context);
+        begin = pivot_pos + 1;
+        leftmost = 0;
+    }
+}
+
+// Not every type uses both entry points
+__attribute__((unused))
+static void SORT_NAME(pdqsort)(SORT_T* values, size_t count, void* context) {
+    if (count < 2) return;
+    int log2 = 0;
+    for (size_t n = count; n > 1; n >>= 1) log2++;
+    SORT_NAME(pdqsort_loop)(values, values + count, log2, 1, context);
+}
+
+// Top-down merge sort; `buffer` holds count / 2 elements. Only the left
+// half is copied out, and ties take the left element, so it is stable.
+__attribute__((unused))
+static void SORT_NAME(merge_sort)(SORT_T* values, size_t count, SORT_T* buffer, void* context) {
+    if (count <= SORT_MERGE_RUN) {
+        SORT_NAME(insertion_sort)(values, values + count, context);
+        return;
+    }
+    size_t half = count / 2;
+    SORT_NAME(merge_sort)(values, half, buffer, context);
+    SORT_NAME(merge_sort)(values + half, count - half, buffer, context);
+
+    // Already in order (sorted input): nothing to merge
+    if (!SORT_LESS(values[half], values[half - 1])) return;
+
+    memcpy(buffer, values, half * sizeof(SORT_T));
+
+    // Every right element sorts before every left one (reversed input):
+    // swap the halves instead of merging
+    if (SORT_LESS(values[count - 1], buffer[0])) {
+        memmove(values, values + half, (count - half) * sizeof(SORT_T));
+        memcpy(values + (count - half), buffer, half * sizeof(SORT_T));
+        return;
+    }
+
+    size_t i = 0, j = half, k = 0;
+    while (i < half && j < count) {
+        // k <= j, so the right half is never overwritten before it is read
+        int take_right = SORT_LESS(values[j], buffer[i]);
+        values[k++] = take_right ? values[j] : buffer[i];
+        j += (size_t)take_right;
+        i += (size_t)!take_right;
+    }
+    while (i < half) values[k++] = buffer[i++];
+}
+
+#undef SORT_T
+#undef SORT_NAME
+#undef SORT_LESS
+#undef SORT_BRANCHLESS
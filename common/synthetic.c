@@ -0,0 +1,458 @@
+/*
+ * synthetic.c - Reproducible synthetic people, books and log entries
+ *
+ * Implementation notes:
+ * - Text is built with a bounded appender and num_format.h, not
+ *   snprintf(): a record is a handful of table lookups and short copies,
+ *   and formatting stays cheap next to generating. Fields are cut at
+ *   their array size, so a record never overflows a struct or
+ *   SYNTH_LINE_MAX.
+ * - Log timestamps count 16 lines per second from 2024-01-15, with the
+ *   date from the day number by Howard Hinnant's civil-from-days
+ *   algorithm, so long files run on into the following days and months.
+ * - synth_write_file() formats rounds of chunks (4096 records each, four
+ *   chunks per pool thread per round) into separate buffers with
+ *   task_parallel_for(), then writes the chunks in index order on the
+ *   calling thread. In min_bytes mode it stops after the first chunk
+ *   that reaches min_bytes; chunks formatted past it are dropped, so the
+ *   file doesn't depend on the thread count.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "synthetic.h"
+#include "num_format.h"
+#include "rng.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SYNTH_CHUNK_RECORDS 4096
+#define SYNTH_CHUNKS_PER_THREAD 4
+#define SYNTH_MAX_ROUND_CHUNKS 64
+#define SYNTH_LINES_PER_SECOND 16
+#define ARRAY_COUNT(array) (sizeof(array) / sizeof((array)[0]))
+
+static const char* const FIRST_NAMES[] = {
+    "Alice", "Bob", "Carol", "Dave", "Erin", "Frank", "Grace", "Heidi", "Ivan", "Judy",
+    "Mallory", "Niaj", "Olivia", "Peggy", "Rupert", "Sybil", "Trent", "Uma", "Victor",
+    "Wendy", "Xavier", "Yolanda", "Zoe", "Amir", "Beatriz", "Chen", "Dmitri", "Esther",
+    "Fatima", "Gunnar", "Hiroshi", "Ingrid"
+};
+static const char* const LAST_NAMES[] = {
+    "Smith", "Johnson", "Garcia", "Miller", "Davis", "Rodriguez", "Martinez", "Hernandez",
+    "Lopez", "Wilson", "Anderson", "Thomas", "Taylor", "Moore", "Jackson", "Martin", "Lee",
+    "Thompson", "White", "Harris", "Clark", "Lewis", "Robinson", "Walker", "Young", "Allen",
+    "King", "Wright", "Scott", "Nguyen", "Hill", "Van der Berg"
+};
+static const char* const DOMAINS[] = {
+    "example.com", "company.com", "mail.example.org", "corp.example.net"
+};
+static const char* const ADJECTIVES[] = {
+    "Silent", "Hidden", "Last", "Broken", "Golden", "Distant", "Quiet", "Burning", "Lost",
+    "Crimson", "Endless", "Forgotten", "Northern", "Hollow", "Bright", "Winter"
+};
+static const char* const NOUNS[] = {
+    "River", "Garden", "Kingdom", "Signal", "Mirror", "Harbor", "Forest", "Engine", "Archive",
+    "Compiler", "Lighthouse", "Empire", "Pointer", "Station", "Orchard", "Machine"
+};
+static const char* const GENRES[] = {
+    "Fiction", "Mystery", "Science Fiction", "Fantasy", "Biography", "History", "Romance",
+    "Programming", "Poetry", "Travel"
+};
+static const char* const COMPONENTS[] = {
+    "Server", "Database", "Auth", "Network", "Cache", "Billing", "Search", "Mailer"
+};
+
+// Appends to [p, end), always leaving room for a terminating NUL
+typedef struct {
+    char* p;
+    char* end;
+} Text;
+
+static Text text_start(char* out, size_t size) {
+    Text text = {out, out + size - 1};
+    return text;
+}
+
+static void append(Text* text, const char* string) {
+    while (*string != '\0' && text->p < text->end) *text->p++ = *string++;
+}
+
+static void append_char(Text* text, char c) {
+    if (text->p < text->end) *text->p++ = c;
+}
+
+static void append_uint(Text* text, uint64_t value) {
+    char digits[FORMAT_DECIMAL_SIZE];
+    format_uint64(digits, value);
+    append(text, digits);
+}
+
+static void append_two_digits(Text* text, unsigned value) {
+    append_char(text, (char)('0' + value / 10 % 10));
+    append_char(text, (char)('0' + value % 10));
+}
+
+// 1234567 -> "12345.67"
+static void append_cents(Text* text, uint64_t cents) {
+    append_uint(text, cents / 100);
+    append_char(text, '.');
+    append_two_digits(text, (unsigned)(cents % 100));
+}
+
+static void text_end(Text* text) {
+    *text->p = '\0';
+}
+
+// An email address can't have spaces: "Van der Berg" -> "vanderberg"
+static void append_lowercase_word(Text* text, const char* word) {
+    for (; *word != '\0'; word++) {
+        char c = *word;
+        if (c == ' ') continue;
+        append_char(text, c >= 'A' && c <= 'Z' ? (char)(c - 'A' + 'a') : c);
+    }
+}
+
+#define PICK(rng, table) ((table)[rng_below((rng), (uint32_t)ARRAY_COUNT(table))])
+
+void synth_person(uint64_t seed, uint64_t index, SynthPerson* person) {
+    Rng rng;
+    rng_seed_index(&rng, seed, index);
+    const char* first = PICK(&rng, FIRST_NAMES);
+    const char* last = PICK(&rng, LAST_NAMES);
+
+    person->id = (int32_t)(1000 + index);
+    Text name = text_start(person->name, sizeof(person->name));
+    if (index % 4 == 0) {
+        append(&name, last);
+        append(&name, ", ");
+        append(&name, first);
+    } else {
+        append(&name, first);
+        append_char(&name, ' ');
+        append(&name, last);
+    }
+    text_end(&name);
+
+    Text email = text_start(person->email, sizeof(person->email));
+    append_lowercase_word(&email, first);
+    append_char(&email, '.');
+    append_lowercase_word(&email, last);
+    append_uint(&email, index);
+    append_char(&email, '@');
+    append(&email, PICK(&rng, DOMAINS));
+    text_end(&email);
+
+    person->age = (int32_t)rng_between(&rng, 18, 67);
+    person->salary = (double)rng_between(&rng, 3000000, 14999999) / 100.0;
+}
+
+void synth_book(uint64_t seed, uint64_t index, SynthBook* book) {
+    Rng rng;
+    rng_seed_index(&rng, seed, index);
+
+    book->id = (int32_t)(1 + index);
+    Text title = text_start(book->title, sizeof(book->title));
+    switch (rng_below(&rng, 4)) {
+    case 0:
+        append(&title, "The ");
+        append(&title, PICK(&rng, ADJECTIVES));
+        append_char(&title, ' ');
+        append(&title, PICK(&rng, NOUNS));
+        break;
+    case 1:
+        append(&title, PICK(&rng, NOUNS));
+        append(&title, " of the ");
+        append(&title, PICK(&rng, ADJECTIVES));
+        append_char(&title, ' ');
+        append(&title, PICK(&rng, NOUNS));
+        break;
+    case 2:     // A comma, for CSV quoting
+        append(&title, PICK(&rng, NOUNS));
+        append(&title, ", ");
+        append(&title, PICK(&rng, NOUNS));
+        append(&title, " and the ");
+        append(&title, PICK(&rng, NOUNS));
+        break;
+    default:
+        append(&title, PICK(&rng, ADJECTIVES));
+        append_char(&title, ' ');
+        append(&title, PICK(&rng, NOUNS));
+        break;
+    }
+    text_end(&title);
+
+    Text author = text_start(book->author, sizeof(book->author));
+    append(&author, PICK(&rng, FIRST_NAMES));
+    append_char(&author, ' ');
+    append(&author, PICK(&rng, LAST_NAMES));
+    text_end(&author);
+
+    book->year = (int32_t)rng_between(&rng, 1950, 2024);
+    book->price = (double)(rng_between(&rng, 4, 79) * 100 + (rng_below(&rng, 2) ? 99 : 49)) / 100.0;
+    book->pages = (int32_t)rng_between(&rng, 80, 1200);
+    book->genre = PICK(&rng, GENRES);
+    book->available = rng_below(&rng, 5) != 0;
+}
+
+// Year, month (1-12) and day (1-31) of `days` since 1970-01-01
+static void civil_from_days(int64_t days, int64_t* year, unsigned* month, unsigned* day) {
+    days += 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    unsigned day_of_era = (unsigned)(days - era * 146097);
+    unsigned year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 -
+                            day_of_era / 146096) / 365;
+    unsigned day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    unsigned month_index = (5 * day_of_year + 2) / 153;     // March = 0
+    *day = day_of_year - (153 * month_index + 2) / 5 + 1;
+    *month = month_index < 10 ? month_index + 3 : month_index - 9;
+    *year = (int64_t)year_of_era + era * 400 + (*month <= 2);
+}
+
+// 2024-01-15, in days since 1970-01-01
+#define SYNTH_LOG_FIRST_DAY 19737
+
+void synth_log_entry(uint64_t seed, uint64_t index, SynthLogEntry* entry) {
+    Rng rng;
+    rng_seed_index(&rng, seed, index);
+
+    uint64_t second = index / SYNTH_LINES_PER_SECOND;
+    int64_t year;
+    unsigned month, day;
+    civil_from_days(SYNTH_LOG_FIRST_DAY + (int64_t)(second / 86400), &year, &month, &day);
+    unsigned of_day = (unsigned)(second % 86400);
+    Text timestamp = text_start(entry->timestamp, sizeof(entry->timestamp));
+    append_uint(&timestamp, (uint64_t)year);
+    append_char(&timestamp, '-');
+    append_two_digits(&timestamp, month);
+    append_char(&timestamp, '-');
+    append_two_digits(&timestamp, day);
+    append_char(&timestamp, ' ');
+    append_two_digits(&timestamp, of_day / 3600);
+    append_char(&timestamp, ':');
+    append_two_digits(&timestamp, of_day / 60 % 60);
+    append_char(&timestamp, ':');
+    append_two_digits(&timestamp, of_day % 60);
+    text_end(&timestamp);
+
+    uint32_t roll = rng_below(&rng, 100);
+    entry->component = PICK(&rng, COMPONENTS);
+    Text message = text_start(entry->message, sizeof(entry->message));
+    if (roll < 5) {
+        entry->level = "ERROR";
+        if (rng_below(&rng, 2)) {
+            append(&message, "Timeout after ");
+            append_uint(&message, rng_between(&rng, 1000, 30000));
+            append(&message, " ms waiting for db-");
+            append_uint(&message, rng_below(&rng, 8));
+        } else {
+            append(&message, "Payment ");
+            append_uint(&message, rng_below(&rng, 1000000));
+            append(&message, " failed: card declined");
+        }
+    } else if (roll < 15) {
+        entry->level = "WARN";
+        append(&message, "Slow request ");
+        append_uint(&message, index);
+        append(&message, " took ");
+        append_uint(&message, rng_between(&rng, 500, 5000));
+        append(&message, " ms");
+    } else if (roll < 30) {
+        entry->level = "DEBUG";
+        append(&message, "Cache miss for key item:");
+        append_uint(&message, rng_below(&rng, 100000));
+    } else {
+        entry->level = "INFO";
+        if (rng_below(&rng, 4) == 0) {
+            append(&message, "User ");
+            append_uint(&message, rng_below(&rng, 100000));
+            append(&message, " logged in from 10.");
+            append_uint(&message, rng_below(&rng, 256));
+            append_char(&message, '.');
+            append_uint(&message, rng_below(&rng, 256));
+            append_char(&message, '.');
+            append_uint(&message, rng_below(&rng, 256));
+        } else {
+            append(&message, "Request ");
+            append_uint(&message, index);
+            append(&message, " handled in ");
+            append_uint(&message, rng_between(&rng, 1, 499));
+            append(&message, " ms");
+        }
+    }
+    text_end(&message);
+}
+
+const char* synth_header(SynthKind kind) {
+    switch (kind) {
+    case SYNTH_PEOPLE_CSV:
+        return "id,name,email,age,salary\n";
+    case SYNTH_BOOKS_CSV:
+        return "id,title,author,year,price,pages,genre,available\n";
+    default:
+        return "";
+    }
+}
+
+// Quoted when it has a comma (the generators make no quotes or newlines)
+static void append_csv_field(Text* text, const char* field) {
+    int quote = strchr(field, ',') != NULL;
+    if (quote) append_char(text, '"');
+    append(text, field);
+    if (quote) append_char(text, '"');
+}
+
+size_t synth_format_line(SynthKind kind, uint64_t seed, uint64_t index, char* out) {
+    Text line = text_start(out, SYNTH_LINE_MAX);
+    switch (kind) {
+    case SYNTH_PEOPLE_CSV: {
+        SynthPerson person;
+        synth_person(seed, index, &person);
+        append_uint(&line, (uint64_t)person.id);
+        append_char(&line, ',');
+        append_csv_field(&line, person.name);
+        append_char(&line, ',');
+        append(&line, person.email);
+        append_char(&line, ',');
+        append_uint(&line, (uint64_t)person.age);
+        append_char(&line, ',');
+        append_cents(&line, (uint64_t)(person.salary * 100 + 0.5));
+        break;
+    }
+    case SYNTH_BOOKS_CSV: {
+        SynthBook book;
+        synth_book(seed, index, &book);
+        append_uint(&line, (uint64_t)book.id);
+        append_char(&line, ',');
+        append_csv_field(&line, book.title);
+        append_char(&line, ',');
+        append(&line, book.author);
+        append_char(&line, ',');
+        append_uint(&line, (uint64_t)book.year);
+        append_char(&line, ',');
+        append_cents(&line, (uint64_t)(book.price * 100 + 0.5));
+        append_char(&line, ',');
+        append_uint(&line, (uint64_t)book.pages);
+        append_char(&line, ',');
+        append(&line, book.genre);
+        append_char(&line, ',');
+        append_char(&line, book.available ? '1' : '0');
+        break;
+    }
+    case SYNTH_LOG: {
+        SynthLogEntry entry;
+        synth_log_entry(seed, index, &entry);
+        append(&line, entry.timestamp);
+        append_char(&line, ' ');
+        append(&line, entry.level);
+        append_char(&line, ' ');
+        append(&line, entry.component);
+        append_char(&line, ' ');
+        append(&line, entry.message);
+        break;
+    }
+    }
+    // The fields' sizes keep every line far below SYNTH_LINE_MAX; the
+    // newline has its byte reserved either way
+    line.end++;
+    append_char(&line, '\n');
+    return (size_t)(line.p - out);
+}
+
+typedef struct {
+    SynthKind kind;
+    uint64_t seed;
+    uint64_t first;         // Index of the round's first record
+    uint64_t limit;         // No records from this index on
+    char* buffers;          // SYNTH_CHUNK_RECORDS lines per chunk
+    size_t* lengths;
+} Round;
+
+static void format_chunks(size_t begin, size_t end, void* argument) {
+    Round* round = (Round*)argument;
+    for (size_t chunk = begin; chunk < end; chunk++) {
+        char* out = round->buffers + chunk * SYNTH_CHUNK_RECORDS * SYNTH_LINE_MAX;
+        char* p = out;
+        uint64_t index = round->first + chunk * SYNTH_CHUNK_RECORDS;
+        uint64_t stop = index + SYNTH_CHUNK_RECORDS;
+        if (stop > round->limit) stop = round->limit;
+        for (; index < stop; index++) {
+            p += synth_format_line(round->kind, round->seed, index, p);
+        }
+        round->lengths[chunk] = (size_t)(p - out);
+    }
+}
+
+int synth_write_file(TaskPool* pool, const char* path, SynthKind kind, uint64_t seed,
+                     uint64_t records, uint64_t min_bytes, uint64_t* records_written,
+                     uint64_t* bytes_written) {
+    int parallel = pool != NULL && pool->thread_count > 1;
+    size_t round_chunks = parallel ? (size_t)pool->thread_count * SYNTH_CHUNKS_PER_THREAD : 1;
+    if (round_chunks > SYNTH_MAX_ROUND_CHUNKS) round_chunks = SYNTH_MAX_ROUND_CHUNKS;
+
+    Round round;
+    round.kind = kind;
+    round.seed = seed;
+    round.limit = records > 0 ? records : UINT64_MAX;
+    round.buffers = malloc(round_chunks * SYNTH_CHUNK_RECORDS * SYNTH_LINE_MAX);
+    round.lengths = malloc(round_chunks * sizeof(size_t));
+    FILE* file = fopen(path, "wb");
+    if (round.buffers == NULL || round.lengths == NULL || file == NULL) {
+        int error = file == NULL ? errno : ENOMEM;
+        if (file != NULL) fclose(file);
+        free(round.buffers);
+        free(round.lengths);
+        errno = error;
+        return -1;
+    }
+
+    const char* header = synth_header(kind);
+    size_t header_length = strlen(header);
+    int failed = fwrite(header, 1, header_length, file) != header_length;
+    uint64_t bytes = header_length;
+    uint64_t next_record = 0;
+    int done = records > 0 ? next_record >= records : bytes >= min_bytes;
+    while (!failed && !done) {
+        round.first = next_record;
+        size_t chunks = round_chunks;
+        if (records > 0) {
+            uint64_t left = (records - next_record + SYNTH_CHUNK_RECORDS - 1) / SYNTH_CHUNK_RECORDS;
+            if (left < chunks) chunks = (size_t)left;
+        }
+        if (parallel && chunks > 1) {
+            task_parallel_for(pool, chunks, 1, format_chunks, &round);
+        } else {
+            format_chunks(0, chunks, &round);
+        }
+
+        for (size_t chunk = 0; chunk < chunks && !done; chunk++) {
+            const char* data = round.buffers + chunk * SYNTH_CHUNK_RECORDS * SYNTH_LINE_MAX;
+            if (fwrite(data, 1, round.lengths[chunk], file) != round.lengths[chunk]) {
+                failed = 1;
+                break;
+            }
+            bytes += round.lengths[chunk];
+            next_record += SYNTH_CHUNK_RECORDS;
+            if (next_record > round.limit) next_record = round.limit;
+            done = records > 0 ? next_record >= records : bytes >= min_bytes;
+        }
+    }
+
+    int error = failed ? errno : 0;
+    if (fclose(file) != 0 && !failed) {
+        failed = 1;
+        error = errno;
+    }
+    free(round.buffers);
+    free(round.lengths);
+    if (records_written != NULL) *records_written = next_record;
+    if (bytes_written != NULL) *bytes_written = bytes;
+    if (failed) {
+        errno = error != 0 ? error : EIO;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * synthetic.h - Reproducible synthetic people, books and log entries
+ *
+ * Benchmarks and tests need data that looks like the real thing (names
+ * of different lengths, a few names with commas that CSV must quote,
+ * mostly INFO log lines with the odd ERROR) and that is the same on
+ * every run and every machine. Each record here depends only on the
+ * seed and its index: record i comes from its own generator,
+ * rng_seed_index(seed, i) (rng.h). So any range of records can be made
+ * on its own, on any thread, without making the ones before it, and a
+ * file written with 64 threads is byte for byte the one written with one.
+ *
+ * Records:
+ * - SynthPerson: id, "First Last" name (every fourth one "Last, First"),
+ *   email, age 18-67, salary 30000.00-149999.99
+ * - SynthBook: id, title, author, year 1950-2024, price, pages, genre,
+ *   availability
+ * - SynthLogEntry: timestamp (16 lines per second from 2024-01-15
+ *   00:00:00), level (70% INFO, 15% DEBUG, 10% WARN, 5% ERROR),
+ *   component, message
+ *
+ * synth_write_file() writes CSV (people, books) or log lines
+ * ("2024-01-15 00:00:01 INFO Server Request 4211 handled in 37 ms"),
+ * formatting chunks of records in parallel on a TaskPool and writing
+ * them in order: gigabytes in seconds. Text fields fit the lessons'
+ * structs (Person in lesson 10, Book in lesson 9, LogEntry in lesson 10).
+ *
+ * For frontend developers: Like faker.js with faker.seed(), except
+ * record 1000000 can be generated without generating the first 999999.
+ */
+
+#ifndef SYNTHETIC_H
+#define SYNTHETIC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "task_pool.h"
+
+// Longest line synth_format_line() writes, newline included
+#define SYNTH_LINE_MAX 256
+
+typedef struct {
+    int32_t id;
+    char name[48];
+    char email[64];
+    int32_t age;
+    double salary;              // Whole cents
+} SynthPerson;
+
+typedef struct {
+    int32_t id;
+    char title[64];
+    char author[48];
+    int32_t year;
+    double price;               // Whole cents, ending in .99 or .49
+    int32_t pages;
+    const char* genre;          // Static string
+    int available;
+} SynthBook;
+
+typedef struct {
+    char timestamp[20];         // "YYYY-MM-DD HH:MM:SS"
+    const char* level;          // "INFO", "DEBUG", "WARN" or "ERROR" (static)
+    const char* component;      // Static string
+    char message[96];
+} SynthLogEntry;
+
+typedef enum { SYNTH_PEOPLE_CSV, SYNTH_BOOKS_CSV, SYNTH_LOG } SynthKind;
+
+void synth_person(uint64_t seed, uint64_t index, SynthPerson* person);
+void synth_book(uint64_t seed, uint64_t index, SynthBook* book);
+void synth_log_entry(uint64_t seed, uint64_t index, SynthLogEntry* entry);
+
+// The CSV header line ("id,name,...\n"), or "" for SYNTH_LOG
+const char* synth_header(SynthKind kind);
+
+// Record `index` as one line, newline included, into `out` (at least
+// SYNTH_LINE_MAX bytes, not terminated). Returns the line's length.
+size_t synth_format_line(SynthKind kind, uint64_t seed, uint64_t index, char* out);
+
+// Write the header and records [0, records) to `path`. With records = 0,
+// writes records until the file has at least min_bytes bytes instead.
+// pool may be NULL. Stores the number of records and bytes written (either
+// pointer may be NULL). Returns 0, or -1 with errno set.
+int synth_write_file(TaskPool* pool, const char* path, SynthKind kind, uint64_t seed,
+                     uint64_t records, uint64_t min_bytes, uint64_t* records_written,
+                     uint64_t* bytes_written);
+
+#endif // SYNTHETIC_H
@@ -0,0 +1,345 @@
+/*
+ * task_pool.c - Work-stealing thread pool for fork-join parallelism
+ *
+ * Implementation notes:
+ * - Deque (Chase-Lev, with the memory orders of Le et al., "Correct and
+ *   Efficient Work-Stealing for Weak Memory Models"): push stores the
+ *   task, then publishes it by moving bottom with a release store. pop
+ *   moves bottom down first and only then reads top (a full fence in
+ *   between), so an owner and a thief can't both take the same task
+ *   unnoticed; when exactly one task was left, both compare-and-swap top
+ *   and one of them loses. A thief reads top, then bottom, and claims the
+ *   task at top with a compare-and-swap. The slot array doesn't grow: a
+ *   full deque makes task_spawn() run the task at once, which for
+ *   divide-and-conquer code happens only at recursion depths that already
+ *   have far more tasks than threads.
+ * - Workers are found through thread-local variables, so task_spawn()
+ *   needs no worker argument. The thread calling task_pool_run() is
+ *   worker 0 for the run.
+ * - Idle workers steal from random victims. After 64 failed rounds they
+ *   back off with a short sleep instead of sched_yield(), so spinning
+ *   threads don't take the CPU from threads doing work when there are
+ *   more threads than cores. Between runs they wait on a condition
+ *   variable and use no CPU at all.
+ * - thread_count is set before the first worker starts. If a worker
+ *   can't be created, task_pool_init() lowers it to the workers that did
+ *   start with one atomic store, and steal_task() loads it atomically;
+ *   the deques past the new count stay empty, so a thief that still used
+ *   the old count only finds nothing there.
+ * - A finished task decrements its group's counter last: after that the
+ *   worker doesn't touch the task or the group, which may already be gone.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "task_pool.h"
+
+#include <errno.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TASK_DEQUE_MASK (TASK_DEQUE_CAPACITY - 1)
+// Failed steal rounds before an idle worker starts sleeping between rounds
+#define TASK_SPIN_ROUNDS 64
+#define TASK_IDLE_SLEEP_NS 20000
+
+struct TaskWorker {
+    TaskPool* pool;
+    int index;
+    pthread_t thread;
+};
+
+// The pool and deque of the current thread, while it works for a pool
+static __thread TaskPool* current_pool = NULL;
+static __thread int current_index = 0;
+static __thread uint64_t steal_seed = 0;
+
+static int deque_push(TaskDeque* deque, Task* task) {
+    int64_t bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED);
+    int64_t top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+    if (bottom - top >= TASK_DEQUE_CAPACITY) return -1;
+    __atomic_store_n(&deque->slots[bottom & TASK_DEQUE_MASK], task, __ATOMIC_RELAXED);
+    __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+static Task* deque_pop(TaskDeque* deque) {
+    int64_t bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED) - 1;
+    __atomic_store_n(&deque->bottom, bottom, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t top = __atomic_load_n(&deque->top, __ATOMIC_RELAXED);
+
+    if (top > bottom) {
+        // Empty
+        __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+    Task* task = __atomic_load_n(&deque->slots[bottom & TASK_DEQUE_MASK], __ATOMIC_RELAXED);
+    if (top == bottom) {
+        // The last task: a thief may be taking it right now
+        if (!__atomic_compare_exchange_n(&deque->top, &top, top + 1, 0, __ATOMIC_SEQ_CST,
+                                         __ATOMIC_RELAXED)) {
+            task = NULL;
+        }
+        __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+    }
+    return task;
+}
+
+static Task* deque_steal(TaskDeque* deque) {
+    int64_t top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t bottom = __atomic_load_n(&deque->bottom, __ATOMIC_ACQUIRE);
+    if (top >= bottom) return NULL;
+
+    Task* task = __atomic_load_n(&deque->slots[top & TASK_DEQUE_MASK], __ATOMIC_RELAXED);
+    if (!__atomic_compare_exchange_n(&deque->top, &top, top + 1, 0, __ATOMIC_SEQ_CST,
+                                     __ATOMIC_RELAXED)) {
+        return NULL;    // Another thief or the owner got it
+    }
+    return task;
+}
+
+static void run_task(Task* task) {
+    TaskGroup* group = task->group;
+    task->function(task->argument);
+    __atomic_sub_fetch(&group->pending, 1, __ATOMIC_RELEASE);
+}
+
+// xorshift64: picks steal victims
+static uint64_t next_victim_seed(void) {
+    uint64_t x = steal_seed;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    steal_seed = x;
+    return x;
+}
+
+// One round over the other deques, starting at a random one
+static Task* steal_task(TaskPool* pool) {
+    // Workers already run while task_pool_init() may still shrink the count
+    int count = __atomic_load_n(&pool->thread_count, __ATOMIC_RELAXED);
+    if (count < 2) return NULL;
+    int start = (int)(next_victim_seed() % (uint64_t)count);
+    for (int i = 0; i < count; i++) {
+        int victim = (start + i) % count;
+        if (victim == current_index) continue;
+        Task* task = deque_steal(&pool->deques[victim]);
+        if (task != NULL) {
+            __atomic_add_fetch(&pool->steals, 1, __ATOMIC_RELAXED);
+            return task;
+        }
+    }
+    return NULL;
+}
+
+static void idle_wait(int* failed_rounds) {
+    if (++*failed_rounds < TASK_SPIN_ROUNDS) {
+        sched_yield();
+    } else {
+        struct timespec pause = {0, TASK_IDLE_SLEEP_NS};
+        nanosleep(&pause, NULL);
+    }
+}
+
+static void enter_pool(TaskPool* pool, int index) {
+    current_pool = pool;
+    current_index = index;
+    steal_seed = 0x9E3779B97F4A7C15ull * (uint64_t)(index + 1);
+}
+
+static void* worker_main(void* argument) {
+    struct TaskWorker* worker = argument;
+    TaskPool* pool = worker->pool;
+    enter_pool(pool, worker->index);
+
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        while (!pool->running && !pool->shutdown) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        int shutdown = pool->shutdown;
+        pthread_mutex_unlock(&pool->lock);
+        if (shutdown) break;
+
+        int failed_rounds = 0;
+        while (__atomic_load_n(&pool->running, __ATOMIC_ACQUIRE)) {
+            Task* task = deque_pop(&pool->deques[worker->index]);
+            if (task == NULL) task = steal_task(pool);
+            if (task != NULL) {
+                run_task(task);
+                failed_rounds = 0;
+            } else {
+                idle_wait(&failed_rounds);
+            }
+        }
+    }
+    return NULL;
+}
+
+int task_pool_init(TaskPool* pool, int threads) {
+    if (threads < 0 || threads > TASK_POOL_MAX_THREADS) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus < 1 ? 1 : cpus > TASK_POOL_MAX_THREADS ? TASK_POOL_MAX_THREADS : (int)cpus;
+    }
+
+    memset(pool, 0, sizeof(*pool));
+    pool->thread_count = threads;
+
+    void* deques = NULL;
+    if (posix_memalign(&deques, 64, (size_t)threads * sizeof(TaskDeque)) != 0) {
+        errno = ENOMEM;
+        return -1;
+    }
+    memset(deques, 0, (size_t)threads * sizeof(TaskDeque));
+    pool->deques = deques;
+
+    pool->workers = calloc((size_t)threads, sizeof(struct TaskWorker));
+    if (pool->workers == NULL) {
+        free(pool->deques);
+        errno = ENOMEM;
+        return -1;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_mutex_init(&pool->run_lock, NULL);
+
+    int started = 1;
+    for (int i = 1; i < threads; i++) {
+        struct TaskWorker* worker = &pool->workers[i - 1];
+        worker->pool = pool;
+        worker->index = i;
+        if (pthread_create(&worker->thread, NULL, worker_main, worker) != 0) break;
+        started++;
+    }
+    // Keep the workers already started
+    if (started < threads) __atomic_store_n(&pool->thread_count, started, __ATOMIC_RELAXED);
+    return 0;
+}
+
+void task_pool_destroy(TaskPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 1; i < pool->thread_count; i++) {
+        pthread_join(pool->workers[i - 1].thread, NULL);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->run_lock);
+    free(pool->workers);
+    free(pool->deques);
+    pool->workers = NULL;
+    pool->deques = NULL;
+}
+
+void task_pool_run(TaskPool* pool, TaskFunction function, void* argument) {
+    // Already a worker of this pool: a nested run is just a call
+    if (current_pool == pool) {
+        function(argument);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->run_lock);
+    TaskPool* outer_pool = current_pool;
+    int outer_index = current_index;
+    enter_pool(pool, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    __atomic_store_n(&pool->running, 1, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    function(argument);
+
+    pthread_mutex_lock(&pool->lock);
+    __atomic_store_n(&pool->running, 0, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&pool->lock);
+
+    current_pool = outer_pool;
+    current_index = outer_index;
+    pthread_mutex_unlock(&pool->run_lock);
+}
+
+void task_group_init(TaskGroup* group) {
+    group->pending = 0;
+}
+
+void task_spawn(TaskPool* pool, TaskGroup* group, Task* task, TaskFunction function,
+                void* argument) {
+    if (current_pool != pool) {
+        function(argument);
+        return;
+    }
+    task->function = function;
+    task->argument = argument;
+    task->group = group;
+    __atomic_add_fetch(&group->pending, 1, __ATOMIC_RELAXED);
+    if (deque_push(&pool->deques[current_index], task) != 0) {
+        run_task(task);
+    }
+}
+
+void task_group_wait(TaskPool* pool, TaskGroup* group) {
+    if (current_pool != pool) return;   // Everything ran in task_spawn()
+
+    int failed_rounds = 0;
+    while (__atomic_load_n(&group->pending, __ATOMIC_ACQUIRE) > 0) {
+        Task* task = deque_pop(&pool->deques[current_index]);
+        if (task == NULL) task = steal_task(pool);
+        if (task != NULL) {
+            run_task(task);
+            failed_rounds = 0;
+        } else {
+            idle_wait(&failed_rounds);
+        }
+    }
+}
+
+typedef struct {
+    TaskPool* pool;
+    size_t begin;
+    size_t end;
+    size_t grain;
+    TaskRangeFunction function;
+    void* argument;
+} TaskRange;
+
+// Halve the range until it's no larger than the grain; the other halves
+// are left for thieves
+static void run_range(void* argument) {
+    TaskRange* range = argument;
+    if (range->end - range->begin <= range->grain) {
+        range->function(range->begin, range->end, range->argument);
+        return;
+    }
+
+    TaskGroup group;
+    task_group_init(&group);
+    Task task;
+    TaskRange upper = *range;
+    upper.begin = range->begin + (range->end - range->begin) / 2;
+    task_spawn(range->pool, &group, &task, run_range, &upper);
+
+    TaskRange lower = *range;
+    lower.end = upper.begin;
+    run_range(&lower);
+    task_group_wait(range->pool, &group);
+}
+
+void task_parallel_for(TaskPool* pool, size_t count, size_t grain, TaskRangeFunction function,
+                       void* argument) {
+    if (count == 0) return;
+    TaskRange range = {pool, 0, count, grain == 0 ? 1 : grain, function, argument};
+    task_pool_run(pool, run_range, &range);
+}
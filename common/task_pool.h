@@ -0,0 +1,111 @@
+/*
+ * task_pool.h - Work-stealing thread pool for fork-join parallelism
+ *
+ * Splitting work into one chunk per thread up front works when every
+ * chunk costs the same. Divide-and-conquer work doesn't: a quicksort
+ * partition, a merge, a directory tree can be lopsided, and the thread
+ * that finishes first sits idle while another still has most of the work.
+ *
+ * Here every worker thread has its own double-ended queue of tasks:
+ * - task_spawn() pushes a task onto the bottom of the calling worker's
+ *   deque; the worker pops from the bottom too, so it works on its most
+ *   recent (smallest, cache-warm) task first, with no locks
+ * - a worker whose deque is empty steals from the top of a random other
+ *   deque - the oldest, largest piece of work that thread has
+ * - task_group_wait() doesn't block: while the group's tasks are not all
+ *   done, the waiting thread runs tasks itself (its own or stolen ones)
+ *
+ * The deques are Chase-Lev deques: the owner's push and pop touch only
+ * its end with plain loads and stores, and only a pop racing a thief
+ * for the last task needs a compare-and-swap.
+ *
+ * Task and TaskGroup memory belongs to the caller and must stay valid
+ * until task_group_wait() returns - a local variable in the function
+ * that spawns and waits is the usual place.
+ *
+ * For frontend developers: Like a pool of Web Workers where an idle
+ * worker takes queued jobs from a busy one instead of waiting for the
+ * main thread to hand out more.
+ */
+
+#ifndef TASK_POOL_H
+#define TASK_POOL_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TASK_POOL_MAX_THREADS 256
+// Tasks a deque holds; task_spawn() runs the task at once when it's full
+#define TASK_DEQUE_CAPACITY 1024
+
+typedef void (*TaskFunction)(void* argument);
+
+// Tasks that task_group_wait() waits for together
+typedef struct {
+    int64_t pending;        // Spawned and not finished yet
+} TaskGroup;
+
+typedef struct {
+    TaskFunction function;
+    void* argument;
+    TaskGroup* group;
+} Task;
+
+// One per worker: top is where thieves take from, bottom where the
+// owner pushes and pops. On separate cache lines, so thieves bumping top
+// don't slow the owner down.
+typedef struct {
+    int64_t top;
+    char pad_top[56];
+    int64_t bottom;
+    char pad_bottom[56];
+    Task* slots[TASK_DEQUE_CAPACITY];
+} TaskDeque;
+
+struct TaskWorker;
+
+typedef struct {
+    int thread_count;               // Workers, including the caller of task_pool_run()
+    TaskDeque* deques;              // One per worker, 64-byte aligned
+    struct TaskWorker* workers;     // Threads 1..thread_count-1
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_mutex_t run_lock;       // One task_pool_run() at a time
+    int running;                    // A task_pool_run() is in progress
+    int shutdown;
+    uint64_t steals;                // Tasks taken from another worker
+} TaskPool;
+
+// Start `threads` - 1 worker threads (0 = one per CPU); the thread that
+// calls task_pool_run() is the last worker. Returns 0, or -1 with errno
+// set (EINVAL for more than TASK_POOL_MAX_THREADS).
+int task_pool_init(TaskPool* pool, int threads);
+
+// Stop and join the worker threads. No task_pool_run() may be running.
+void task_pool_destroy(TaskPool* pool);
+
+// Run function(argument) on the calling thread as a pool worker, so it
+// can spawn tasks, and return once it has - with its tasks - finished.
+// Workers sleep between runs.
+void task_pool_run(TaskPool* pool, TaskFunction function, void* argument);
+
+void task_group_init(TaskGroup* group);
+
+// Make function(argument) available to the pool as part of `group`. Runs
+// it at once if the caller isn't one of this pool's workers (or its
+// deque is full), so code using the pool also works outside a run.
+void task_spawn(TaskPool* pool, TaskGroup* group, Task* task, TaskFunction function,
+                void* argument);
+
+// Run queued tasks until every task of `group` has finished
+void task_group_wait(TaskPool* pool, TaskGroup* group);
+
+// Call function(begin, end, argument) on ranges of at most `grain`
+// indexes covering [0, count), in parallel. Returns when all are done.
+// Works inside a task_pool_run() or on its own.
+typedef void (*TaskRangeFunction)(size_t begin, size_t end, void* argument);
+void task_parallel_for(TaskPool* pool, size_t count, size_t grain, TaskRangeFunction function,
+                       void* argument);
+
+#endif // TASK_POOL_H
@@ -0,0 +1,581 @@
+/*
+ * async_reader.c - Keep many reads in flight across a list of files
+ *
+ * Implementation notes:
+ * - There is no liburing dependency: the ring is set up with the raw
+ *   io_uring_setup/enter/register system calls and the structures from
+ *   <linux/io_uring.h>. Only the parts a reader needs are used - READ and
+ *   READ_FIXED requests, one submission batch per io_uring_enter().
+ * - Every buffer is one slot. Reads are numbered in the order they are
+ *   submitted, and order[] maps a number to its slot; at most
+ *   queue_depth numbers are outstanding, so order[] is a ring of that
+ *   size. Completions arrive in any order, but next() always waits for
+ *   the oldest number, which is what keeps blocks in file order.
+ * - Files are opened when their first read is submitted and closed when
+ *   their last block is delivered, so only a few are open at a time no
+ *   matter how many are in the list.
+ * - Registering buffers pins them in memory and can fail under a low
+ *   RLIMIT_MEMLOCK. The reader then uses plain READ requests into the
+ *   same buffers.
+ * - A read can come back short before end of file. The rest is asked
+ *   for again into the same buffer; a block is only delivered whole.
+ * - The thread fallback runs queue_depth threads that take slots from a
+ *   FIFO and pread() them, so the same number of reads is in flight.
+ *   One mutex covers the FIFO and every slot's `done` flag.
+ */
+
+#define _GNU_SOURCE
+
+#include "async_reader.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define ASYNC_HAVE_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+#endif
+
+#define DIRECT_ALIGNMENT 4096
+
+struct AsyncPool {
+    pthread_mutex_t lock;
+    pthread_cond_t work;            // Signaled when a slot is queued
+    pthread_cond_t done;            // Signaled when a read finishes
+    unsigned* queue;                // FIFO of slots to read
+    unsigned head;
+    unsigned count;
+    int stop;
+    unsigned thread_count;
+    pthread_t* threads;
+    AsyncReader* reader;
+};
+
+#ifdef ASYNC_HAVE_IO_URING
+
+struct AsyncRing {
+    int fd;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    struct io_uring_sqe* sqes;
+    struct io_uring_cqe* cqes;
+    void* sq_map;
+    size_t sq_map_size;
+    void* cq_map;                   // Same as sq_map with IORING_FEAT_SINGLE_MMAP
+    size_t cq_map_size;
+    size_t sqes_size;
+    unsigned pending;               // Prepared but not yet submitted
+    int fixed_buffers;
+};
+
+static void ring_destroy(struct AsyncRing* ring) {
+    if (ring->sqes != NULL) munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_map != NULL && ring->cq_map != ring->sq_map) munmap(ring->cq_map, ring->cq_map_size);
+    if (ring->sq_map != NULL) munmap(ring->sq_map, ring->sq_map_size);
+    if (ring->fd >= 0) close(ring->fd);
+    free(ring);
+}
+
+static struct AsyncRing* ring_create(unsigned entries, char* buffers, size_t buffer_size) {
+    struct AsyncRing* ring = calloc(1, sizeof(struct AsyncRing));
+    if (ring == NULL) return NULL;
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (ring->fd < 0) {
+        int saved = errno;
+        free(ring);
+        errno = saved;
+        return NULL;
+    }
+
+    ring->sq_map_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cq_map_size > ring->sq_map_size) ring->sq_map_size = ring->cq_map_size;
+        ring->cq_map_size = ring->sq_map_size;
+    }
+
+    ring->sq_map = mmap(NULL, ring->sq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_map == MAP_FAILED) ring->sq_map = NULL;
+    if (ring->sq_map != NULL && (params.features & IORING_FEAT_SINGLE_MMAP)) {
+        ring->cq_map = ring->sq_map;
+    } else if (ring->sq_map != NULL) {
+        ring->cq_map = mmap(NULL, ring->cq_map_size, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+        if (ring->cq_map == MAP_FAILED) ring->cq_map = NULL;
+    }
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) ring->sqes = NULL;
+    if (ring->sq_map == NULL || ring->cq_map == NULL || ring->sqes == NULL) {
+        int saved = errno;
+        ring_destroy(ring);
+        errno = saved;
+        return NULL;
+    }
+
+    char* sq = (char*)ring->sq_map;
+    char* cq = (char*)ring->cq_map;
+    ring->sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned*)(sq + params.sq_off.array);
+    ring->cq_head = (unsigned*)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+    // One iovec per buffer, so a request names its buffer by index
+    struct iovec* iovecs = malloc(entries * sizeof(struct iovec));
+    if (iovecs != NULL) {
+        for (unsigned i = 0; i < entries; i++) {
+            iovecs[i].iov_base = buffers + (size_t)i * buffer_size;
+            iovecs[i].iov_len = buffer_size;
+        }
+        ring->fixed_buffers = syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_BUFFERS,
+                                      iovecs, entries) == 0;
+        free(iovecs);
+    }
+    return ring;
+}
+
+static void ring_prepare_read(AsyncReader* reader, unsigned slot_index) {
+    struct AsyncRing* ring = reader->ring;
+    AsyncSlot* slot = &reader->slots[slot_index];
+    unsigned tail = *ring->sq_tail;
+    unsigned index = tail & *ring->sq_mask;
+    struct io_uring_sqe* sqe = &ring->sqes[index];
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = ring->fixed_buffers ? IORING_OP_READ_FIXED : IORING_OP_READ;
+    sqe->fd = slot->fd;
+    sqe->off = slot->offset + slot->filled;
+    sqe->addr = (uint64_t)(uintptr_t)(reader->buffers + (size_t)slot_index * reader->options.block_size +
+                                      slot->filled);
+    sqe->len = (uint32_t)(slot->request - slot->filled);
+    sqe->buf_index = ring->fixed_buffers ? (uint16_t)slot_index : 0;
+    sqe->user_data = slot_index;
+
+    ring->sq_array[index] = index;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring->pending++;
+}
+
+// Submit what's prepared and, if `wait` is set, block for at least one
+// completion. Every available completion is then applied to its slot.
+static int ring_enter(AsyncReader* reader, int wait) {
+    struct AsyncRing* ring = reader->ring;
+    unsigned flags = wait ? IORING_ENTER_GETEVENTS : 0;
+    while (ring->pending > 0 || wait) {
+        long submitted = syscall(__NR_io_uring_enter, ring->fd, ring->pending, wait ? 1 : 0,
+                                 flags, NULL, 0);
+        if (submitted < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        ring->pending -= (unsigned)submitted;
+        if (ring->pending == 0) break;
+    }
+
+    unsigned head = *ring->cq_head;
+    unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++) {
+        const struct io_uring_cqe* cqe = &ring->cqes[head & *ring->cq_mask];
+        unsigned slot_index = (unsigned)cqe->user_data;
+        AsyncSlot* slot = &reader->slots[slot_index];
+
+        if (cqe->res < 0) {
+            slot->error = -cqe->res;
+            slot->done = 1;
+        } else if (cqe->res == 0 || slot->filled + (size_t)cqe->res >= slot->wanted) {
+            // Done, or the file got shorter: deliver what there is
+            slot->filled += (size_t)cqe->res;
+            if (slot->filled > slot->wanted) slot->filled = slot->wanted;
+            slot->done = 1;
+        } else {
+            slot->filled += (size_t)cqe->res;
+            ring_prepare_read(reader, slot_index);
+        }
+    }
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    return 0;
+}
+
+#else
+
+struct AsyncRing {
+    int unused;
+};
+
+#endif // ASYNC_HAVE_IO_URING
+
+static void* pool_worker_main(void* arg) {
+    struct AsyncPool* pool = (struct AsyncPool*)arg;
+    AsyncReader* reader = pool->reader;
+    unsigned depth = reader->options.queue_depth;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->stop && pool->count == 0) pthread_cond_wait(&pool->work, &pool->lock);
+        if (pool->count == 0) break;
+        unsigned slot_index = pool->queue[pool->head];
+        pool->head = (pool->head + 1) % depth;
+        pool->count--;
+        AsyncSlot* slot = &reader->slots[slot_index];
+        pthread_mutex_unlock(&pool->lock);
+
+        char* buffer = reader->buffers + (size_t)slot_index * reader->options.block_size;
+        size_t filled = 0;
+        int error = 0;
+        while (filled < slot->wanted) {
+            ssize_t got = pread(slot->fd, buffer + filled, slot->request - filled,
+                                (off_t)(slot->offset + filled));
+            if (got < 0 && errno == EINTR) continue;
+            if (got < 0) error = errno;
+            if (got <= 0) break;
+            filled += (size_t)got;
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        slot->filled = filled < slot->wanted ? filled : slot->wanted;
+        slot->error = error;
+        slot->done = 1;
+        pthread_cond_broadcast(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+static void pool_destroy(struct AsyncPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+    for (unsigned t = 0; t < pool->thread_count; t++) pthread_join(pool->threads[t], NULL);
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work);
+    pthread_cond_destroy(&pool->done);
+    free(pool->queue);
+    free(pool->threads);
+    free(pool);
+}
+
+static struct AsyncPool* pool_create(AsyncReader* reader) {
+    unsigned depth = reader->options.queue_depth;
+    struct AsyncPool* pool = calloc(1, sizeof(struct AsyncPool));
+    if (pool == NULL) return NULL;
+    pool->reader = reader;
+    pool->queue = malloc(depth * sizeof(unsigned));
+    pool->threads = malloc(depth * sizeof(pthread_t));
+    if (pool->queue == NULL || pool->threads == NULL) {
+        free(pool->queue);
+        free(pool->threads);
+        free(pool);
+        errno = ENOMEM;
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    while (pool->thread_count < depth &&
+           pthread_create(&pool->threads[pool->thread_count], NULL, pool_worker_main, pool) == 0) {
+        pool->thread_count++;
+    }
+    if (pool->thread_count == 0) {
+        pool_destroy(pool);
+        errno = EAGAIN;
+        return NULL;
+    }
+    return pool;
+}
+
+static void backend_submit(AsyncReader* reader, unsigned slot_index) {
+#ifdef ASYNC_HAVE_IO_URING
+    if (reader->ring != NULL) {
+        ring_prepare_read(reader, slot_index);
+        return;
+    }
+#endif
+    struct AsyncPool* pool = reader->pool;
+    pthread_mutex_lock(&pool->lock);
+    pool->queue[(pool->head + pool->count) % reader->options.queue_depth] = slot_index;
+    pool->count++;
+    pthread_cond_signal(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// Block until `slot_index` has finished. Returns 0, or -1 if the ring
+// itself failed.
+static int backend_wait(AsyncReader* reader, unsigned slot_index) {
+#ifdef ASYNC_HAVE_IO_URING
+    if (reader->ring != NULL) {
+        while (!reader->slots[slot_index].done) {
+            if (ring_enter(reader, 1) != 0) return -1;
+        }
+        return 0;
+    }
+#endif
+    struct AsyncPool* pool = reader->pool;
+    pthread_mutex_lock(&pool->lock);
+    while (!reader->slots[slot_index].done) pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+    return 0;
+}
+
+static int more_to_submit(const AsyncReader* reader) {
+    return reader->next_fd >= 0 || reader->next_file < reader->file_count;
+}
+
+// Fill every free buffer with the next read
+static void submit_reads(AsyncReader* reader) {
+    size_t block_size = reader->options.block_size;
+
+    while (reader->free_count > 0 && more_to_submit(reader)) {
+        unsigned slot_index = reader->free_slots[reader->free_count - 1];
+        AsyncSlot* slot = &reader->slots[slot_index];
+        memset(slot, 0, sizeof(*slot));
+        slot->fd = -1;
+
+        if (reader->next_fd < 0) {
+            int flags = O_RDONLY | O_CLOEXEC;
+            if (reader->options.flags & ASYNC_READ_DIRECT) flags |= O_DIRECT;
+            struct stat info;
+            int fd = open(reader->filenames[reader->next_file], flags);
+            if (fd >= 0 && fstat(fd, &info) != 0) {
+                int saved = errno;
+                close(fd);
+                errno = saved;
+                fd = -1;
+            }
+
+            if (fd < 0) {
+                // Becomes a failed block, delivered in its turn
+                slot->file = reader->next_file++;
+                slot->error = errno;
+                slot->done = 1;
+                slot->last = 1;
+            } else if (info.st_size == 0) {
+                close(fd);
+                reader->next_file++;
+                continue;
+            } else {
+                reader->next_fd = fd;
+                reader->next_offset = 0;
+                reader->next_size = (uint64_t)info.st_size;
+            }
+        }
+
+        if (slot->error == 0) {
+            uint64_t remaining = reader->next_size - reader->next_offset;
+            slot->fd = reader->next_fd;
+            slot->file = reader->next_file;
+            slot->offset = reader->next_offset;
+            slot->wanted = remaining < block_size ? (size_t)remaining : block_size;
+            slot->request = slot->wanted;
+            if (reader->options.flags & ASYNC_READ_DIRECT) {
+                slot->request = (slot->wanted + DIRECT_ALIGNMENT - 1) & ~(size_t)(DIRECT_ALIGNMENT - 1);
+            }
+
+            reader->next_offset += slot->wanted;
+            if (reader->next_offset >= reader->next_size) {
+                slot->last = 1;
+                reader->next_fd = -1;
+                reader->next_file++;
+            }
+        }
+
+        reader->free_count--;
+        reader->order[reader->submitted % reader->options.queue_depth] = slot_index;
+        reader->submitted++;
+        if (!slot->done) backend_submit(reader, slot_index);
+    }
+
+#ifdef ASYNC_HAVE_IO_URING
+    // One system call for the whole batch; errors show up when waiting
+    if (reader->ring != NULL && reader->ring->pending > 0) ring_enter(reader, 0);
+#endif
+}
+
+int async_reader_open(AsyncReader* reader, const char* const* filenames, size_t file_count,
+                      const AsyncReaderOptions* options) {
+    memset(reader, 0, sizeof(*reader));
+    if (options != NULL) reader->options = *options;
+    if (reader->options.block_size == 0) reader->options.block_size = ASYNC_DEFAULT_BLOCK_SIZE;
+    if (reader->options.queue_depth == 0) reader->options.queue_depth = ASYNC_DEFAULT_QUEUE_DEPTH;
+    if (reader->options.block_size % DIRECT_ALIGNMENT != 0 || reader->options.block_size > UINT32_MAX ||
+        reader->options.queue_depth > ASYNC_MAX_QUEUE_DEPTH) {
+        errno = EINVAL;
+        return -1;
+    }
+#ifndef ASYNC_HAVE_IO_URING
+    if (reader->options.backend == ASYNC_BACKEND_IO_URING) {
+        errno = ENOSYS;
+        return -1;
+    }
+#endif
+
+    unsigned depth = reader->options.queue_depth;
+    reader->filenames = filenames;
+    reader->file_count = file_count;
+    reader->next_fd = -1;
+    reader->skip_file = SIZE_MAX;
+    reader->slots = calloc(depth, sizeof(AsyncSlot));
+    reader->order = malloc(depth * sizeof(unsigned));
+    reader->free_slots = malloc(depth * sizeof(unsigned));
+    if (posix_memalign((void**)&reader->buffers, DIRECT_ALIGNMENT,
+                       (size_t)depth * reader->options.block_size) != 0) {
+        reader->buffers = NULL;
+    }
+    if (reader->slots == NULL || reader->order == NULL || reader->free_slots == NULL ||
+        reader->buffers == NULL) {
+        async_reader_close(reader);
+        errno = ENOMEM;
+        return -1;
+    }
+    for (unsigned i = 0; i < depth; i++) reader->free_slots[i] = depth - 1 - i;
+    reader->free_count = depth;
+
+#ifdef ASYNC_HAVE_IO_URING
+    if (reader->options.backend != ASYNC_BACKEND_THREADS) {
+        reader->ring = ring_create(depth, reader->buffers, reader->options.block_size);
+        if (reader->ring == NULL && reader->options.backend == ASYNC_BACKEND_IO_URING) {
+            int saved = errno;
+            async_reader_close(reader);
+            errno = saved;
+            return -1;
+        }
+    }
+#endif
+    if (reader->ring != NULL) {
+        reader->backend = ASYNC_BACKEND_IO_URING;
+    } else {
+        reader->pool = pool_create(reader);
+        if (reader->pool == NULL) {
+            int saved = errno;
+            async_reader_close(reader);
+            errno = saved;
+            return -1;
+        }
+        reader->backend = ASYNC_BACKEND_THREADS;
+    }
+
+    submit_reads(reader);
+    return 0;
+}
+
+int async_reader_next(AsyncReader* reader, AsyncBlock* block) {
+    for (;;) {
+        submit_reads(reader);
+        if (reader->delivered == reader->submitted) {
+            if (!more_to_submit(reader)) return 0;
+            errno = ENOBUFS;
+            return -1;
+        }
+
+        unsigned slot_index = reader->order[reader->delivered % reader->options.queue_depth];
+        AsyncSlot* slot = &reader->slots[slot_index];
+        if (backend_wait(reader, slot_index) != 0) return -1;
+        reader->delivered++;
+
+        block->file = slot->file;
+        block->offset = slot->offset;
+        block->data = reader->buffers + (size_t)slot_index * reader->options.block_size;
+        block->length = slot->filled;
+        block->slot = slot_index;
+        if (slot->last && slot->fd >= 0) close(slot->fd);
+
+        if (slot->file == reader->skip_file) {
+            // Read ahead before an earlier block of this file failed
+            async_reader_release(reader, block);
+            continue;
+        }
+        if (slot->error == 0) return 1;
+
+        if (!slot->last) {
+            // Drop the rest of the file. Reads of it still in flight are
+            // skipped on delivery, and the newest one closes the file.
+            reader->skip_file = slot->file;
+            if (reader->next_file == slot->file && reader->next_fd >= 0) {
+                uint64_t newest = reader->submitted - 1;
+                AsyncSlot* newest_slot =
+                    &reader->slots[reader->order[newest % reader->options.queue_depth]];
+                if (newest >= reader->delivered && newest_slot->file == slot->file) {
+                    newest_slot->last = 1;
+                } else {
+                    close(reader->next_fd);
+                }
+                reader->next_fd = -1;
+                reader->next_file++;
+            }
+        }
+        int error = slot->error;
+        block->length = 0;
+        async_reader_release(reader, block);
+        errno = error;
+        return -1;
+    }
+}
+
+void async_reader_release(AsyncReader* reader, const AsyncBlock* block) {
+    reader->free_slots[reader->free_count++] = block->slot;
+    submit_reads(reader);
+}
+
+void async_reader_close(AsyncReader* reader) {
+    // The kernel or a worker may still be writing into the buffers
+    if (reader->slots != NULL && (reader->ring != NULL || reader->pool != NULL)) {
+        while (reader->delivered < reader->submitted) {
+            unsigned slot_index = reader->order[reader->delivered % reader->options.queue_depth];
+            AsyncSlot* slot = &reader->slots[slot_index];
+            if (backend_wait(reader, slot_index) != 0) break;
+            if (slot->last && slot->fd >= 0) close(slot->fd);
+            reader->delivered++;
+        }
+    }
+    if (reader->next_fd >= 0) close(reader->next_fd);
+    reader->next_fd = -1;
+
+#ifdef ASYNC_HAVE_IO_URING
+    if (reader->ring != NULL) ring_destroy(reader->ring);
+#endif
+    if (reader->pool != NULL) pool_destroy(reader->pool);
+    reader->ring = NULL;
+    reader->pool = NULL;
+
+    free(reader->buffers);
+    free(reader->slots);
+    free(reader->order);
+    free(reader->free_slots);
+    reader->buffers = NULL;
+    reader->slots = NULL;
+    reader->order = NULL;
+    reader->free_slots = NULL;
+}
+
+const char* async_reader_backend_name(const AsyncReader* reader) {
+#ifdef ASYNC_HAVE_IO_URING
+    if (reader->ring != NULL) {
+        return reader->ring->fixed_buffers ? "io_uring, registered buffers" : "io_uring";
+    }
+#endif
+    return reader->pool != NULL ? "pread threads" : "closed";
+}
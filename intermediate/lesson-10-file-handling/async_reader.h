@@ -0,0 +1,122 @@
+/*
+ * async_reader.h - Keep many reads in flight across a list of files
+ *
+ * fread() asks for one block and then waits for it. Between the request
+ * and the data the program does nothing, and the disk works on one
+ * request at a time. An asynchronous reader queues N reads up front -
+ * into N buffers - and hands each block to the caller as soon as it is
+ * complete; when the caller gives a buffer back, the next read goes out
+ * in it. The disk always has N requests to work on, and parsing block k
+ * overlaps with reading blocks k+1..k+N-1.
+ *
+ * On Linux the reads go through io_uring: requests are written into a
+ * ring shared with the kernel, and one io_uring_enter() call submits a
+ * whole batch and collects finished reads. The buffers are registered
+ * with the kernel once, so it doesn't have to pin and map the pages again
+ * for every read. Where io_uring is missing or blocked (old kernels,
+ * seccomp filters in containers), a pool of threads doing blocking
+ * pread() calls keeps the same number of reads in flight.
+ *
+ * Blocks are delivered in file order - every block of file 0, then file
+ * 1, and so on - so a line parser can carry a partial line from one
+ * block to the next. With ASYNC_READ_DIRECT the files are opened with
+ * O_DIRECT and bypass the page cache.
+ *
+ * For frontend developers: Like firing off N fetch() calls at once and
+ * processing the responses in order, instead of awaiting each request
+ * before sending the next.
+ */
+
+#ifndef ASYNC_READER_H
+#define ASYNC_READER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ASYNC_DEFAULT_BLOCK_SIZE (1024 * 1024)
+#define ASYNC_DEFAULT_QUEUE_DEPTH 16
+#define ASYNC_MAX_QUEUE_DEPTH 1024
+
+// Flags for AsyncReaderOptions.flags
+#define ASYNC_READ_DIRECT 0x01u     // O_DIRECT: don't go through the page cache
+
+typedef enum {
+    ASYNC_BACKEND_AUTO,             // io_uring if it works, threads otherwise
+    ASYNC_BACKEND_IO_URING,
+    ASYNC_BACKEND_THREADS
+} AsyncBackend;
+
+typedef struct {
+    size_t block_size;      // Bytes per read, a multiple of 4096 (0 = 1 MB)
+    unsigned queue_depth;   // Reads in flight = number of buffers (0 = 16)
+    unsigned flags;
+    AsyncBackend backend;
+} AsyncReaderOptions;
+
+typedef struct {
+    size_t file;            // Index into the filenames given to open
+    uint64_t offset;        // File offset of data[0]
+    const char* data;       // Valid until the block is released
+    size_t length;
+    unsigned slot;          // Which buffer this is (for release)
+} AsyncBlock;
+
+typedef struct {
+    int fd;
+    size_t file;
+    uint64_t offset;
+    size_t wanted;          // Bytes this block should hold
+    size_t request;         // Bytes asked for (rounded up for O_DIRECT)
+    size_t filled;
+    int error;              // errno of a failed open or read
+    int done;
+    int last;               // Last block of its file: close fd on delivery
+} AsyncSlot;
+
+struct AsyncRing;
+struct AsyncPool;
+
+// Lives where the caller put it: worker threads keep a pointer to it
+typedef struct {
+    AsyncReaderOptions options;
+    AsyncBackend backend;           // The one in use
+    const char* const* filenames;
+    size_t file_count;
+    char* buffers;                  // queue_depth buffers, 4096-aligned
+    AsyncSlot* slots;
+    unsigned* order;                // Slot of sequence number s at [s % queue_depth]
+    unsigned* free_slots;
+    unsigned free_count;
+    uint64_t submitted;             // Sequence numbers handed to the backend
+    uint64_t delivered;             // ... and handed on to the caller
+    size_t next_file;               // Where the next read comes from
+    uint64_t next_offset;
+    uint64_t next_size;
+    int next_fd;
+    size_t skip_file;               // File whose read failed (SIZE_MAX = none)
+    struct AsyncRing* ring;
+    struct AsyncPool* pool;
+} AsyncReader;
+
+// Start reading `filenames` (the array must stay valid until close).
+// `options` may be NULL for the defaults. Returns 0 on success, -1 with
+// errno set; EINVAL for a bad block size or queue depth, ENOSYS if
+// ASYNC_BACKEND_IO_URING was asked for and isn't available.
+int async_reader_open(AsyncReader* reader, const char* const* filenames, size_t file_count,
+                      const AsyncReaderOptions* options);
+
+// Wait for the next block. Returns 1 with `block` filled in, 0 when every
+// file has been read, or -1 with errno set. A file that can't be opened
+// or read gives -1 with block->file set; the next call moves on to the
+// following file. ENOBUFS means every buffer is held by the caller.
+int async_reader_next(AsyncReader* reader, AsyncBlock* block);
+
+// Give a block's buffer back so the next read can use it
+void async_reader_release(AsyncReader* reader, const AsyncBlock* block);
+
+// Waits for reads still in flight, then frees everything
+void async_reader_close(AsyncReader* reader);
+
+const char* async_reader_backend_name(const AsyncReader* reader);
+
+#endif // ASYNC_READER_H
@@ -0,0 +1,199 @@
+/*
+ * bench_async_read.c - fread() one file after another vs. the async reader
+ *
+ * Generates a set of log-like files (default 100 files of 100 MB) and
+ * counts their lines:
+ * - fread():  each file in turn, 1 MB at a time, one read outstanding
+ * - async reader with io_uring and with the pread thread pool, 16 reads
+ *   of 1 MB in flight
+ *
+ * Each is run twice: with the files in the page cache (skipped when they
+ * don't fit in memory), and cold - the cache is dropped first, and the
+ * async reader uses O_DIRECT. For O_DIRECT a queue depth of 1 is shown
+ * too, which is what a plain blocking read() loop gets from the disk.
+ *
+ * Usage: ./bench_async_read [files] [megabytes per file]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "async_reader.h"
+#include "bench_harness.h"
+
+#define READ_SIZE (1024 * 1024)
+
+static BenchTimer timer;
+
+static size_t count_newlines(const char* data, size_t size) {
+    size_t lines = 0;
+    const char* end = data + size;
+    for (const char* p = data; (p = memchr(p, '\n', (size_t)(end - p))) != NULL; p++) {
+        lines++;
+    }
+    return lines;
+}
+
+static int generate_files(const char* const* names, size_t file_count, size_t megabytes) {
+    // One megabyte of log lines, written over and over
+    static char block[READ_SIZE];
+    size_t used = 0;
+    for (unsigned long i = 0; ; i++) {
+        char line[128];
+        int length = snprintf(line, sizeof(line),
+                              "2024-01-15 09:%02lu:%02lu INFO  Worker%lu request %lu handled\n",
+                              (i / 60) % 60, i % 60, i % 8, i);
+        if (used + (size_t)length > sizeof(block)) break;
+        memcpy(block + used, line, (size_t)length);
+        used += (size_t)length;
+    }
+
+    for (size_t f = 0; f < file_count; f++) {
+        FILE* file = fopen(names[f], "wb");
+        if (file == NULL) {
+            perror(names[f]);
+            return -1;
+        }
+        for (size_t i = 0; i < megabytes; i++) {
+            if (fwrite(block, 1, used, file) != used) {
+                perror(names[f]);
+                fclose(file);
+                return -1;
+            }
+        }
+        fclose(file);
+    }
+    return 0;
+}
+
+static void drop_cache(const char* const* names, size_t file_count) {
+    for (size_t f = 0; f < file_count; f++) {
+        int fd = open(names[f], O_RDONLY);
+        if (fd < 0) continue;
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+}
+
+static size_t lines_fread(const char* const* names, size_t file_count, size_t* bytes) {
+    static char buffer[READ_SIZE];
+    size_t lines = 0;
+    for (size_t f = 0; f < file_count; f++) {
+        FILE* file = fopen(names[f], "rb");
+        if (file == NULL) continue;
+        size_t got;
+        while ((got = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            *bytes += got;
+            lines += count_newlines(buffer, got);
+        }
+        fclose(file);
+    }
+    return lines;
+}
+
+static size_t lines_async(const char* const* names, size_t file_count, size_t* bytes,
+                          const AsyncReaderOptions* options, const char** backend) {
+    AsyncReader reader;
+    if (async_reader_open(&reader, names, file_count, options) != 0) {
+        *backend = "unavailable";
+        return 0;
+    }
+    *backend = async_reader_backend_name(&reader);
+
+    size_t lines = 0;
+    AsyncBlock block;
+    int status;
+    while ((status = async_reader_next(&reader, &block)) != 0) {
+        if (status < 0) {
+            perror(names[block.file]);
+            continue;
+        }
+        *bytes += block.length;
+        lines += count_newlines(block.data, block.length);
+        async_reader_release(&reader, &block);
+    }
+    async_reader_close(&reader);
+    return lines;
+}
+
+static void run(const char* label, const char* const* names, size_t file_count,
+                const AsyncReaderOptions* options, int cold) {
+    if (cold) drop_cache(names, file_count);
+
+    size_t bytes = 0, lines;
+    const char* backend = "stdio";
+    bench_timer_start(&timer);
+    if (options == NULL) {
+        lines = lines_fread(names, file_count, &bytes);
+    } else {
+        lines = lines_async(names, file_count, &bytes, options, &backend);
+    }
+    double elapsed = bench_timer_stop(&timer);
+
+    char counts[BENCH_COUNTS_TEXT_SIZE];
+    printf("  %-30s %-30s %8.3f s  %9.1f MB/s  (%zu lines)%s\n", label, backend, elapsed,
+           bytes / elapsed / (1024.0 * 1024.0), lines,
+           bench_counts_text(&timer.counts, counts, sizeof(counts)));
+}
+
+int main(int argc, char* argv[]) {
+    size_t file_count = argc > 1 ? (size_t)atol(argv[1]) : 100;
+    size_t megabytes = argc > 2 ? (size_t)atol(argv[2]) : 100;
+    if (file_count == 0 || megabytes == 0) {
+        fprintf(stderr, "Usage: %s [files] [megabytes per file]\n", argv[0]);
+        return 1;
+    }
+
+    char** names = malloc(file_count * sizeof(char*));
+    if (names == NULL) return 1;
+    for (size_t f = 0; f < file_count; f++) {
+        names[f] = malloc(40);
+        if (names[f] == NULL) return 1;
+        snprintf(names[f], 40, "bench_async_%03zu.log", f);
+    }
+    const char* const* list = (const char* const*)names;
+
+    bench_timer_open(&timer);
+    printf("Async read benchmark: %zu files x %zu MB\n", file_count, megabytes);
+    bench_timer_print_status(&timer, stdout);
+    if (generate_files(list, file_count, megabytes) != 0) return 1;
+
+    AsyncReaderOptions uring = {READ_SIZE, 16, 0, ASYNC_BACKEND_IO_URING};
+    AsyncReaderOptions threads = {READ_SIZE, 16, 0, ASYNC_BACKEND_THREADS};
+
+    double total = (double)file_count * megabytes * 1024 * 1024;
+    double memory = (double)sysconf(_SC_PHYS_PAGES) * (double)sysconf(_SC_PAGESIZE);
+    if (total < memory * 0.75) {
+        printf("Page cache (warm):\n");
+        size_t bytes = 0;
+        lines_fread(list, file_count, &bytes);
+        run("fread", list, file_count, NULL, 0);
+        run("async, 16 in flight", list, file_count, &uring, 0);
+        run("async, 16 in flight", list, file_count, &threads, 0);
+    } else {
+        printf("Page cache (warm): skipped, %.1f GB of files doesn't fit in %.1f GB of memory\n",
+               total / 1e9, memory / 1e9);
+    }
+
+    printf("Cold (cache dropped; async uses O_DIRECT):\n");
+    run("fread", list, file_count, NULL, 1);
+    uring.flags = threads.flags = ASYNC_READ_DIRECT;
+    run("async O_DIRECT, 16 in flight", list, file_count, &uring, 1);
+    run("async O_DIRECT, 16 in flight", list, file_count, &threads, 1);
+    uring.queue_depth = 1;
+    run("async O_DIRECT, 1 in flight", list, file_count, &uring, 1);
+
+    for (size_t f = 0; f < file_count; f++) {
+        remove(names[f]);
+        free(names[f]);
+    }
+    free(names);
+    bench_timer_close(&timer);
+    return 0;
+}
@@ -0,0 +1,381 @@
+/*
+ * bench_block_file.c - Block compression: ratio, MB/s and scan time
+ *
+ * Three inputs of the same raw size:
+ * - employee records in the record_codec.h wire format (default 2M
+ *   records, 130 MB): names from a small list plus the ID, salaries in
+ *   whole dollars, a few departments
+ * - the MYFT version 2 column file of the same rows (id, age, salary)
+ * - random bytes, the worst case, stored as-is block by block
+ *
+ * For each it reports the compression ratio, lz_compress() and
+ * lz_decompress() MB/s on 64 KB blocks in memory, and
+ * block_file_read_all() with one thread and with one per CPU.
+ *
+ * Then the end-to-end scan: sum the salaries of all employees, reading
+ * the plain file through a RecordStream on a FILE* vs. the compressed one
+ * through a RecordStream on a BlockFile, and the same for the column
+ * file with column_file_open(). The files are in the page cache, so this
+ * is the CPU price of decompressing; from a disk that delivers less than
+ * the decompression speed, reading fewer bytes wins it back.
+ *
+ * The counts on a codec line are lz_decompress()'s, on a container line
+ * the 1-thread block_file_read_all()'s.
+ *
+ * Usage: ./bench_block_file [records]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "bench_harness.h"
+#include "block_file.h"
+#include "column_file.h"
+#include "lz_codec.h"
+#include "record_codec.h"
+
+static const char* PLAIN_FILE = "bench_block_plain.bin";
+static const char* COMPRESSED_FILE = "bench_block_lz.bin";
+static const char* COLUMN_FILE = "bench_block_columns.dat";
+static const char* COLUMN_LZ_FILE = "bench_block_columns_lz.dat";
+
+static const char* const NAMES[] = {
+    "Alice Johnson", "Bob Smith", "Carol Davis", "David Wilson", "Eve Brown", "Frank Garcia",
+    "Hannah Lee", "Ivan Petrov"
+};
+
+static uint64_t rng_state = 88172645463325252ull;
+
+static uint64_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static BenchTimer timer;
+
+static double mb_per_second(size_t bytes, double seconds) {
+    return bytes / seconds / (1024.0 * 1024.0);
+}
+
+static long long file_size(const char* filename) {
+    struct stat info;
+    return stat(filename, &info) == 0 ? (long long)info.st_size : -1;
+}
+
+static void make_employees(Employee* records, size_t count) {
+    memset(records, 0, count * sizeof(Employee));
+    for (size_t i = 0; i < count; i++) {
+        records[i].id = 1000 + (uint32_t)i;
+        snprintf(records[i].name, sizeof(records[i].name), "%s #%zu", NAMES[next_random() % 8], i);
+        records[i].salary = 30000.0 + (double)(next_random() % 90000);
+        records[i].department_id = (uint16_t)(1 + next_random() % 12);
+        records[i].active = next_random() % 10 != 0;
+    }
+}
+
+// Compress `size` bytes block by block in memory and back, checking the
+// round trip. Prints ratio and MB/s both ways.
+static void bench_codec(const char* label, const unsigned char* data, size_t size) {
+    size_t blocks = (size + BLOCK_FILE_BLOCK_SIZE - 1) / BLOCK_FILE_BLOCK_SIZE;
+    unsigned char* compressed = malloc(blocks * lz_compress_bound(BLOCK_FILE_BLOCK_SIZE));
+    size_t* sizes = malloc(blocks * sizeof(size_t));
+    unsigned char* copy = malloc(size);
+    if (compressed == NULL || sizes == NULL || copy == NULL) {
+        free(compressed);
+        free(sizes);
+        free(copy);
+        return;
+    }
+
+    size_t bound = lz_compress_bound(BLOCK_FILE_BLOCK_SIZE);
+    size_t total = 0;
+    bench_timer_start(&timer);
+    for (size_t k = 0; k < blocks; k++) {
+        size_t n = size - k * BLOCK_FILE_BLOCK_SIZE;
+        if (n > BLOCK_FILE_BLOCK_SIZE) n = BLOCK_FILE_BLOCK_SIZE;
+        sizes[k] = lz_compress(data + k * BLOCK_FILE_BLOCK_SIZE, n, compressed + k * bound, bound);
+        total += sizes[k];
+    }
+    double compress_seconds = bench_timer_stop(&timer);
+
+    // Touch the output first so page faults aren't timed
+    for (size_t i = 0; i < size; i += 4096) copy[i] = 0;
+    int ok = 1;
+    bench_timer_start(&timer);
+    for (size_t k = 0; k < blocks; k++) {
+        size_t n = size - k * BLOCK_FILE_BLOCK_SIZE;
+        if (n > BLOCK_FILE_BLOCK_SIZE) n = BLOCK_FILE_BLOCK_SIZE;
+        if (lz_decompress(compressed + k * bound, sizes[k], copy + k * BLOCK_FILE_BLOCK_SIZE, n) != 0) {
+            ok = 0;
+        }
+    }
+    double decompress_seconds = bench_timer_stop(&timer);
+    ok = ok && memcmp(copy, data, size) == 0;
+
+    char counts[BENCH_COUNTS_TEXT_SIZE];
+    printf("  %-18s ratio %5.2fx  compress %7.0f MB/s  decompress %7.0f MB/s  %s%s\n", label,
+           (double)size / (double)total, mb_per_second(size, compress_seconds),
+           mb_per_second(size, decompress_seconds), ok ? "✓" : "✗ MISMATCH",
+           bench_counts_text(&timer.counts, counts, sizeof(counts)));
+    free(compressed);
+    free(sizes);
+    free(copy);
+}
+
+// Write `data` as a MYBZ file and time block_file_read_all() with 1 and
+// `threads` threads
+static void bench_container(const char* label, const unsigned char* data, size_t size,
+                            int threads) {
+    BlockWriter writer;
+    bench_timer_start(&timer);
+    if (block_writer_open(&writer, COMPRESSED_FILE) != 0) return;
+    int failed = block_writer_write(&writer, data, size) != 0;
+    if (block_writer_close(&writer) != 0 || failed) return;
+    double write_seconds = bench_timer_stop(&timer);
+
+    BlockFile file;
+    unsigned char* copy = malloc(size ? size : 1);
+    if (copy == NULL || block_file_open(&file, COMPRESSED_FILE) != 0) {
+        free(copy);
+        return;
+    }
+    size_t stored = 0;
+    for (size_t k = 0; k < file.block_count; k++) stored += file.blocks[k].encoding == BLOCK_STORED;
+
+    double seconds[2];
+    int thread_counts[2] = {1, threads};
+    char counts[BENCH_COUNTS_TEXT_SIZE] = "";
+    int ok = 1;
+    for (int t = 0; t < 2; t++) {
+        memset(copy, 0, size);
+        bench_timer_start(&timer);
+        if (block_file_read_all(&file, copy, thread_counts[t]) != 0) ok = 0;
+        seconds[t] = bench_timer_stop(&timer);
+        if (t == 0) bench_counts_text(&timer.counts, counts, sizeof(counts));
+        ok = ok && memcmp(copy, data, size) == 0;
+    }
+
+    printf("  %-18s %5.1f MB -> %5.1f MB  write %6.0f MB/s  read_all 1 thread %6.0f MB/s, "
+           "%d threads %6.0f MB/s  (%zu of %zu blocks stored raw)  %s%s\n", label,
+           size / (1024.0 * 1024.0), file.file.size / (1024.0 * 1024.0),
+           mb_per_second(size, write_seconds), mb_per_second(size, seconds[0]), threads,
+           mb_per_second(size, seconds[1]), stored, file.block_count, ok ? "✓" : "✗ MISMATCH",
+           counts);
+    free(copy);
+    block_file_close(&file);
+    remove(COMPRESSED_FILE);
+}
+
+// Sum of all salaries through a RecordStream
+static double sum_salaries(RecordStream* stream, size_t* count) {
+    Employee batch[1024];
+    double total = 0.0;
+    uint32_t expected = 0;
+    *count = 0;
+    if (record_read_u32(stream, &expected) != 1) return 0.0;
+    size_t n;
+    while ((n = record_read_employees(stream, batch, 1024)) > 0) {
+        for (size_t i = 0; i < n; i++) total += batch[i].salary;
+        *count += n;
+    }
+    return total;
+}
+
+static int write_records(RecordStream* stream, const Employee* records, size_t count) {
+    return record_write_u32(stream, (uint32_t)count) != 0 ||
+           record_write_employees(stream, records, count) != 0 ||
+           record_stream_flush(stream) != 0 ? -1 : 0;
+}
+
+static void bench_record_scan(const Employee* records, size_t count) {
+    RecordStream stream;
+    FILE* file = fopen(PLAIN_FILE, "wb");
+    if (file == NULL || record_stream_init(&stream, file, RECORD_LITTLE_ENDIAN) != 0) return;
+    int failed = write_records(&stream, records, count);
+    record_stream_free(&stream);
+    if (fclose(file) != 0 || failed) return;
+
+    BlockWriter writer;
+    if (block_writer_open(&writer, COMPRESSED_FILE) != 0 ||
+        record_stream_init_block_writer(&stream, &writer, RECORD_LITTLE_ENDIAN) != 0) return;
+    failed = write_records(&stream, records, count);
+    record_stream_free(&stream);
+    if (block_writer_close(&writer) != 0 || failed) return;
+
+    // Plain: a RecordStream on a FILE*
+    size_t plain_count = 0;
+    bench_timer_start(&timer);
+    file = fopen(PLAIN_FILE, "rb");
+    if (file == NULL || record_stream_init(&stream, file, RECORD_LITTLE_ENDIAN) != 0) return;
+    double plain_total = sum_salaries(&stream, &plain_count);
+    record_stream_free(&stream);
+    fclose(file);
+    double plain_seconds = bench_timer_stop(&timer);
+    char plain_counts[BENCH_COUNTS_TEXT_SIZE];
+    bench_counts_text(&timer.counts, plain_counts, sizeof(plain_counts));
+
+    // Compressed: the same stream on a BlockFile
+    size_t lz_count = 0;
+    BlockFile blocks;
+    bench_timer_start(&timer);
+    if (block_file_open(&blocks, COMPRESSED_FILE) != 0 ||
+        record_stream_init_block_reader(&stream, &blocks, RECORD_LITTLE_ENDIAN) != 0) return;
+    double lz_total = sum_salaries(&stream, &lz_count);
+    record_stream_free(&stream);
+    block_file_close(&blocks);
+    double lz_seconds = bench_timer_stop(&timer);
+    char lz_counts[BENCH_COUNTS_TEXT_SIZE];
+    bench_counts_text(&timer.counts, lz_counts, sizeof(lz_counts));
+
+    int ok = plain_count == count && lz_count == count && plain_total == lz_total;
+    printf("  %-30s %9lld bytes  %8.1f ms  %7.1f M rec/s%s\n", "records, plain FILE*",
+           file_size(PLAIN_FILE), plain_seconds * 1e3, count / plain_seconds / 1e6, plain_counts);
+    printf("  %-30s %9lld bytes  %8.1f ms  %7.1f M rec/s  (%.2fx the time)  %s%s\n",
+           "records, compressed BlockFile", file_size(COMPRESSED_FILE), lz_seconds * 1e3,
+           count / lz_seconds / 1e6, lz_seconds / plain_seconds, ok ? "✓" : "✗ MISMATCH",
+           lz_counts);
+    remove(PLAIN_FILE);
+    remove(COMPRESSED_FILE);
+}
+
+static int write_columns(const char* filename, const Employee* records, size_t count,
+                         int compress, unsigned char** raw, size_t* raw_size) {
+    int32_t* ids = malloc(count * sizeof(int32_t));
+    int32_t* ages = malloc(count * sizeof(int32_t));
+    double* salaries = malloc(count * sizeof(double));
+    int result = -1;
+    if (ids != NULL && ages != NULL && salaries != NULL) {
+        for (size_t i = 0; i < count; i++) {
+            ids[i] = (int32_t)records[i].id;
+            ages[i] = 22 + (int32_t)(records[i].id % 43);
+            salaries[i] = records[i].salary;
+        }
+        ColumnSpec schema[] = {{"id", COLUMN_INT32}, {"age", COLUMN_INT32}, {"salary", COLUMN_FLOAT64}};
+        const void* columns[] = {ids, ages, salaries};
+        ColumnWriter writer;
+        if (column_writer_open(&writer, filename, schema, 3, 0) == 0) {
+            int failed = (compress && column_writer_set_compression(&writer, 1) != 0) ||
+                         column_writer_append(&writer, columns, count) != 0;
+            result = column_writer_close(&writer) == 0 && !failed ? 0 : -1;
+        }
+    }
+    free(ids);
+    free(ages);
+    free(salaries);
+
+    // The raw bytes of the plain file, for the codec table
+    if (result == 0 && raw != NULL) {
+        MappedFile mapped;
+        if (mapped_file_open(&mapped, filename, 0) != 0) return -1;
+        *raw = malloc(mapped.size);
+        if (*raw != NULL) memcpy(*raw, mapped.data, mapped.size);
+        *raw_size = mapped.size;
+        mapped_file_close(&mapped);
+        if (*raw == NULL) return -1;
+    }
+    return result;
+}
+
+// Seconds to sum the salary column; its counts go to `counts`
+static double time_column_scan(const char* filename, double* total, char* counts, size_t size) {
+    bench_timer_start(&timer);
+    ColumnFile file;
+    if (column_file_open(&file, filename) != 0) return -1;
+    int column = column_file_find(&file, "salary");
+    *total = 0.0;
+    for (size_t k = 0; k < file.chunk_count; k++) {
+        const ColumnChunk* chunk = column_file_chunk(&file, (size_t)column, k);
+        const double* values = chunk->data;
+        for (uint32_t i = 0; i < chunk->rows; i++) *total += values[i];
+    }
+    column_file_close(&file);
+    double seconds = bench_timer_stop(&timer);
+    bench_counts_text(&timer.counts, counts, size);
+    return seconds;
+}
+
+static void bench_column_scan(void) {
+    double plain_total, lz_total;
+    char plain_counts[BENCH_COUNTS_TEXT_SIZE], lz_counts[BENCH_COUNTS_TEXT_SIZE];
+    double plain_seconds = time_column_scan(COLUMN_FILE, &plain_total, plain_counts,
+                                            sizeof(plain_counts));
+    double lz_seconds = time_column_scan(COLUMN_LZ_FILE, &lz_total, lz_counts, sizeof(lz_counts));
+    if (plain_seconds < 0 || lz_seconds < 0) return;
+    printf("  %-30s %9lld bytes  %8.1f ms%s\n", "columns, mapped", file_size(COLUMN_FILE),
+           plain_seconds * 1e3, plain_counts);
+    printf("  %-30s %9lld bytes  %8.1f ms  (%.2fx the time)  %s%s\n",
+           "columns, decompressed at open", file_size(COLUMN_LZ_FILE), lz_seconds * 1e3,
+           lz_seconds / plain_seconds, plain_total == lz_total ? "✓" : "✗ MISMATCH", lz_counts);
+}
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? (size_t)atol(argv[1]) : 2000000;
+    if (count == 0 || count > UINT32_MAX) {
+        fprintf(stderr, "Usage: %s [records]\n", argv[0]);
+        return 1;
+    }
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = cpus > 0 ? (int)cpus : 1;
+
+    Employee* records = malloc(count * sizeof(Employee));
+    unsigned char* wire = malloc(count * EMPLOYEE_WIRE_SIZE);
+    if (records == NULL || wire == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    make_employees(records, count);
+    record_encode_employees(wire, records, count, RECORD_LITTLE_ENDIAN);
+    size_t wire_size = count * EMPLOYEE_WIRE_SIZE;
+
+    unsigned char* columns = NULL;
+    size_t columns_size = 0;
+    if (write_columns(COLUMN_FILE, records, count, 0, &columns, &columns_size) != 0 ||
+        write_columns(COLUMN_LZ_FILE, records, count, 1, NULL, NULL) != 0) {
+        perror("Failed to write column files");
+        return 1;
+    }
+
+    unsigned char* noise = malloc(wire_size);
+    if (noise == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    for (size_t i = 0; i + 8 <= wire_size; i += 8) {
+        uint64_t value = next_random();
+        memcpy(noise + i, &value, 8);
+    }
+    memset(noise + wire_size / 8 * 8, 0, wire_size % 8);
+
+    bench_timer_open(&timer);
+    bench_timer_print_status(&timer, stdout);
+    printf("\n");
+    printf("Codec, 64 KB blocks in memory (%zu records):\n", count);
+    bench_codec("employee records", wire, wire_size);
+    bench_codec("MYFT columns", columns, columns_size);
+    bench_codec("random bytes", noise, wire_size);
+
+    printf("\nMYBZ container (%d CPUs):\n", threads);
+    bench_container("employee records", wire, wire_size, threads);
+    bench_container("MYFT columns", columns, columns_size, threads);
+    bench_container("random bytes", noise, wire_size, threads);
+
+    printf("\nEnd-to-end scan, sum of all salaries (files in page cache):\n");
+    bench_record_scan(records, count);
+    bench_column_scan();
+
+    remove(COLUMN_FILE);
+    remove(COLUMN_LZ_FILE);
+    free(records);
+    free(wire);
+    free(columns);
+    free(noise);
+    bench_timer_close(&timer);
+    return 0;
+}
@@ -0,0 +1,89 @@
+/*
+ * bench_checksum.c - Checksum throughput over an in-memory buffer
+ *
+ * Hashes the same buffer (default 1 GB) with:
+ * - the legacy MYFT checksum, (checksum << 1) ^ byte
+ * - CRC32C, slicing-by-8 in portable C
+ * - CRC32C with the SSE4.2 crc32 instruction (if the CPU has it)
+ * - xxHash64
+ *
+ * The buffer is already in memory, so this is the cost a checksum adds
+ * on top of reading a file from the page cache (bench_read reports that
+ * side).
+ *
+ * Usage: ./bench_checksum [megabytes]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench_harness.h"
+#include "checksum.h"
+
+static BenchTimer timer;
+
+static void run(const char* label, ChecksumType type, const unsigned char* data, size_t size) {
+    // Best of three, so a page fault or a context switch doesn't count
+    double best = 0;
+    uint64_t result = 0;
+    PerfSample best_counts;
+    for (int attempt = 0; attempt < 3; attempt++) {
+        bench_timer_start(&timer);
+        result = checksum_compute(type, data, size);
+        double elapsed = bench_timer_stop(&timer);
+        if (attempt == 0 || elapsed < best) {
+            best = elapsed;
+            best_counts = timer.counts;
+        }
+    }
+
+    char counts[BENCH_COUNTS_TEXT_SIZE];
+    printf("  %-28s %8.3f s  %7.2f GB/s  (0x%016llx)%s\n", label, best,
+           size / best / 1e9, (unsigned long long)result,
+           bench_counts_text(&best_counts, counts, sizeof(counts)));
+}
+
+int main(int argc, char* argv[]) {
+    size_t megabytes = argc > 1 ? (size_t)atol(argv[1]) : 1024;
+    if (megabytes == 0) {
+        fprintf(stderr, "Usage: %s [megabytes]\n", argv[0]);
+        return 1;
+    }
+
+    size_t size = megabytes * 1024 * 1024;
+    unsigned char* data = malloc(size);
+    if (data == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    uint64_t seed = 88172645463325252ull;
+    for (size_t i = 0; i < size; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        data[i] = (unsigned char)seed;
+    }
+
+    bench_timer_open(&timer);
+    printf("Checksum benchmark: %zu MB\n", megabytes);
+    bench_timer_print_status(&timer, stdout);
+    run("legacy shift-xor", CHECKSUM_LEGACY, data, size);
+
+    checksum_set_simd(0);
+    run("CRC32C slicing-by-8", CHECKSUM_CRC32C, data, size);
+
+    if (checksum_set_simd(1)) {
+        run("CRC32C SSE4.2 (3 lanes)", CHECKSUM_CRC32C, data, size);
+    } else {
+        printf("  CRC32C SSE4.2                not supported on this CPU\n");
+    }
+
+    run("xxHash64", CHECKSUM_XXH64, data, size);
+
+    free(data);
+    bench_timer_close(&timer);
+    return 0;
+}
@@ -0,0 +1,241 @@
+/*
+ * bench_column_file.c - MYFT version 1 records vs. version 2 columns
+ *
+ * Writes the same data (default 20M rows of id, age, salary) in both
+ * formats and measures:
+ * - write: v1 one fwrite+htonl per value vs. v2 column_writer_append()
+ * - sum of one column: v1 fread+ntohl per value, v1 through
+ *   column_file_open(), and v2 straight from the mapped chunks
+ * - verifying the v2 chunk checksums (CRC32C over all three columns)
+ * - a 1% id-range query on v2 with and without min/max chunk skipping
+ *
+ * v1 can only hold one column, so it stores just the ages.
+ *
+ * Usage: ./bench_column_file [rows]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_harness.h"
+#include "column_file.h"
+
+static const char* V1_FILE = "bench_column_v1.dat";
+static const char* V2_FILE = "bench_column_v2.dat";
+
+static BenchTimer timer;
+
+// One result line, with the counts of the last bench_timer_stop()
+static void report(const char* label, double seconds, size_t bytes, long long result) {
+    char counts[BENCH_COUNTS_TEXT_SIZE];
+    printf("  %-34s %8.3f s  %9.1f MB/s  (result %lld)%s\n", label, seconds,
+           bytes / seconds / (1024.0 * 1024.0), result,
+           bench_counts_text(&timer.counts, counts, sizeof(counts)));
+}
+
+static int write_v1(const int32_t* ages, size_t rows) {
+    FILE* file = fopen(V1_FILE, "wb");
+    if (file == NULL) return -1;
+
+    // Same layout as FileHeader in binary_file_operations.c (checksum left 0)
+    unsigned char header[16] = {'M', 'Y', 'F', 'T', 0, 1};
+    uint32_t count = htonl((uint32_t)rows);
+    memcpy(header + 8, &count, 4);
+    fwrite(header, 1, sizeof(header), file);
+
+    for (size_t i = 0; i < rows; i++) {
+        uint32_t value = htonl((uint32_t)ages[i]);
+        fwrite(&value, sizeof(value), 1, file);
+    }
+    return fclose(file);
+}
+
+static int write_v2(const int32_t* ids, const int32_t* ages, const double* salaries, size_t rows) {
+    ColumnSpec schema[] = {
+        {"id", COLUMN_INT32},
+        {"age", COLUMN_INT32},
+        {"salary", COLUMN_FLOAT64}
+    };
+    const void* columns[] = {ids, ages, salaries};
+
+    ColumnWriter writer;
+    if (column_writer_open(&writer, V2_FILE, schema, 3, 0) != 0) return -1;
+    if (column_writer_append(&writer, columns, rows) != 0) {
+        column_writer_close(&writer);
+        return -1;
+    }
+    return column_writer_close(&writer);
+}
+
+static long long sum_v1_fread(void) {
+    FILE* file = fopen(V1_FILE, "rb");
+    if (file == NULL) return -1;
+
+    unsigned char header[16];
+    if (fread(header, 1, sizeof(header), file) != sizeof(header)) {
+        fclose(file);
+        return -1;
+    }
+
+    uint32_t count;
+    memcpy(&count, header + 8, 4);
+    count = ntohl(count);
+
+    long long total = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t value;
+        if (fread(&value, sizeof(value), 1, file) != 1) break;
+        total += (int32_t)ntohl(value);
+    }
+    fclose(file);
+    return total;
+}
+
+static long long sum_chunks(const ColumnFile* file, size_t column) {
+    long long total = 0;
+    for (size_t k = 0; k < file->chunk_count; k++) {
+        const ColumnChunk* chunk = column_file_chunk(file, column, k);
+        const int32_t* values = chunk->data;
+        for (uint32_t i = 0; i < chunk->rows; i++) total += values[i];
+    }
+    return total;
+}
+
+static long long sum_column_file(const char* filename) {
+    ColumnFile file;
+    if (column_file_open(&file, filename) != 0) return -1;
+
+    int column = column_file_find(&file, file.version == 1 ? "value" : "age");
+    long long total = column < 0 ? -1 : sum_chunks(&file, (size_t)column);
+    column_file_close(&file);
+    return total;
+}
+
+// Sum of ages where low <= id <= high, visiting only chunks the
+// predicate can match (or every chunk when skip is 0)
+static long long query_v2(int32_t low, int32_t high, int skip, size_t* chunks_read) {
+    ColumnFile file;
+    if (column_file_open(&file, V2_FILE) != 0) return -1;
+
+    ColumnPredicate predicate = {0, {0}, {0}};
+    predicate.column = (size_t)column_file_find(&file, "id");
+    predicate.low.i = low;
+    predicate.high.i = high;
+    size_t age_column = (size_t)column_file_find(&file, "age");
+
+    long long total = 0;
+    *chunks_read = 0;
+    for (size_t k = skip ? column_file_next_chunk(&file, &predicate, 0) : 0; k < file.chunk_count;
+         k = skip ? column_file_next_chunk(&file, &predicate, k + 1) : k + 1) {
+        const ColumnChunk* id_chunk = column_file_chunk(&file, predicate.column, k);
+        const int32_t* ids = id_chunk->data;
+        const int32_t* ages = column_file_chunk(&file, age_column, k)->data;
+        (*chunks_read)++;
+        for (uint32_t i = 0; i < id_chunk->rows; i++) {
+            total += (ids[i] >= low && ids[i] <= high) ? ages[i] : 0;
+        }
+    }
+    column_file_close(&file);
+    return total;
+}
+
+int main(int argc, char* argv[]) {
+    size_t rows = argc > 1 ? (size_t)atol(argv[1]) : 20000000;
+    if (rows == 0 || rows > UINT32_MAX) {
+        fprintf(stderr, "Usage: %s [rows]\n", argv[0]);
+        return 1;
+    }
+
+    int32_t* ids = malloc(rows * sizeof(int32_t));
+    int32_t* ages = malloc(rows * sizeof(int32_t));
+    double* salaries = malloc(rows * sizeof(double));
+    if (ids == NULL || ages == NULL || salaries == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < rows; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        ids[i] = (int32_t)i;
+        ages[i] = 18 + (int32_t)(seed >> 16) % 50;
+        salaries[i] = 30000.0 + (seed >> 8) % 100000;
+    }
+
+    bench_timer_open(&timer);
+    printf("Column file benchmark: %zu rows\n", rows);
+    bench_timer_print_status(&timer, stdout);
+    size_t column_bytes = rows * sizeof(int32_t);
+
+    printf("Write:\n");
+    bench_timer_start(&timer);
+    if (write_v1(ages, rows) != 0) {
+        perror("Failed to write v1 file");
+        return 1;
+    }
+    report("v1 fwrite+htonl per value (1 col)", bench_timer_stop(&timer), column_bytes,
+           (long long)rows);
+
+    bench_timer_start(&timer);
+    if (write_v2(ids, ages, salaries, rows) != 0) {
+        perror("Failed to write v2 file");
+        return 1;
+    }
+    report("v2 column_writer (3 cols)", bench_timer_stop(&timer), rows * 16, (long long)rows);
+
+    free(ids);
+    free(ages);
+    free(salaries);
+
+    // Warm the page cache so every read below starts from the same place
+    sum_column_file(V1_FILE);
+    sum_column_file(V2_FILE);
+
+    printf("Sum of ages:\n");
+    bench_timer_start(&timer);
+    long long total = sum_v1_fread();
+    report("v1 fread+ntohl per value", bench_timer_stop(&timer), column_bytes, total);
+
+    bench_timer_start(&timer);
+    total = sum_column_file(V1_FILE);
+    report("v1 via column_file_open", bench_timer_stop(&timer), column_bytes, total);
+
+    bench_timer_start(&timer);
+    total = sum_column_file(V2_FILE);
+    report("v2 mapped chunks", bench_timer_stop(&timer), column_bytes, total);
+
+    ColumnFile file;
+    if (column_file_open(&file, V2_FILE) == 0) {
+        bench_timer_start(&timer);
+        size_t bad_chunks = column_file_verify(&file);
+        report("v2 verify CRC32C (3 cols)", bench_timer_stop(&timer), rows * 16,
+               (long long)bad_chunks);
+        column_file_close(&file);
+    }
+
+    // 1% of the ids, somewhere in the middle
+    int32_t low = (int32_t)(rows / 2), high = low + (int32_t)(rows / 100);
+    size_t chunks_read;
+    printf("Query %d <= id <= %d, sum of ages:\n", low, high);
+
+    bench_timer_start(&timer);
+    total = query_v2(low, high, 0, &chunks_read);
+    double seconds = bench_timer_stop(&timer);
+    report("v2 scan every chunk", seconds, column_bytes * 2, total);
+    printf("    chunks read: %zu\n", chunks_read);
+
+    bench_timer_start(&timer);
+    total = query_v2(low, high, 1, &chunks_read);
+    double skip_seconds = bench_timer_stop(&timer);
+    report("v2 skip chunks by min/max", skip_seconds, column_bytes * 2, total);
+    printf("    chunks read: %zu (%.0fx faster)\n", chunks_read, seconds / skip_seconds);
+
+    remove(V1_FILE);
+    remove(V2_FILE);
+    bench_timer_close(&timer);
+    return 0;
+}
@@ -0,0 +1,162 @@
+/*
+ * bench_config.c - Config lookup latency: linear scan vs. hashed store
+ *
+ * Builds a config file with N integer settings and looks keys up in a
+ * shuffled order (so branch prediction can't learn the sequence) with:
+ * - a ConfigEntry array, strcmp() scan + atoi(), as the original
+ *   demonstrate_config_file_parsing() did
+ * - config_get_int() on a snapshot: one hash probe, pre-parsed value
+ * - the same inside a config_read_begin()/end() section per lookup
+ * - the same while another thread reloads the file in a loop
+ *
+ * Results are in nanoseconds per lookup. Default sizes are 10, 100 and
+ * 1000 keys (app.conf has 10).
+ *
+ * Usage: ./bench_config [keys ...]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_harness.h"
+#include "config_store.h"
+
+#define LOOKUPS 2000000
+
+static const char* BENCH_FILE = "bench_config.conf";
+
+// Same layout as ConfigEntry in file_processing.c
+typedef struct {
+    char key[50];
+    char value[100];
+} ConfigEntry;
+
+typedef struct {
+    ConfigStore* store;
+    int stop;
+    unsigned long reloads;
+} Reloader;
+
+static BenchTimer timer;
+
+// One result line, with the counts of the last bench_timer_stop()
+static void report(const char* label, double seconds, long long checksum) {
+    char counts[BENCH_COUNTS_TEXT_SIZE];
+    printf("  %-34s %8.1f ns/lookup  (sum %lld)%s\n", label, seconds / LOOKUPS * 1e9,
+           checksum, bench_counts_text(&timer.counts, counts, sizeof(counts)));
+}
+
+static long long linear_get_int(const ConfigEntry* entries, size_t count, const char* key) {
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(entries[i].key, key) == 0) return atoi(entries[i].value);
+    }
+    return -1;
+}
+
+static void* reload_main(void* arg) {
+    Reloader* reloader = (Reloader*)arg;
+    while (!__atomic_load_n(&reloader->stop, __ATOMIC_RELAXED)) {
+        if (config_store_reload(reloader->store) == 0) reloader->reloads++;
+    }
+    return NULL;
+}
+
+static void run(size_t key_count) {
+    FILE* file = fopen(BENCH_FILE, "w");
+    if (file == NULL) return;
+    ConfigEntry* entries = malloc(key_count * sizeof(ConfigEntry));
+    const char** order = malloc(LOOKUPS * sizeof(char*));
+    if (entries == NULL || order == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+
+    fprintf(file, "# Generated by bench_config\n");
+    for (size_t i = 0; i < key_count; i++) {
+        snprintf(entries[i].key, sizeof(entries[i].key), "setting_%zu_timeout", i);
+        snprintf(entries[i].value, sizeof(entries[i].value), "%zu", i * 7);
+        fprintf(file, "%s = %s\n", entries[i].key, entries[i].value);
+    }
+    fclose(file);
+
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < LOOKUPS; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        order[i] = entries[(seed >> 8) % key_count].key;
+    }
+
+    ConfigStore store;
+    if (config_store_open(&store, BENCH_FILE) != 0) {
+        perror("Failed to load config");
+        exit(1);
+    }
+
+    printf("%zu keys:\n", key_count);
+
+    long long sum = 0;
+    bench_timer_start(&timer);
+    for (size_t i = 0; i < LOOKUPS; i++) sum += linear_get_int(entries, key_count, order[i]);
+    report("linear scan + atoi", bench_timer_stop(&timer), sum);
+
+    unsigned long ticket;
+    const ConfigSnapshot* snapshot = config_read_begin(&store, &ticket);
+    sum = 0;
+    bench_timer_start(&timer);
+    for (size_t i = 0; i < LOOKUPS; i++) sum += config_get_int(snapshot, order[i], -1);
+    report("hash lookup (one read section)", bench_timer_stop(&timer), sum);
+    config_read_end(&store, ticket);
+
+    sum = 0;
+    bench_timer_start(&timer);
+    for (size_t i = 0; i < LOOKUPS; i++) {
+        snapshot = config_read_begin(&store, &ticket);
+        sum += config_get_int(snapshot, order[i], -1);
+        config_read_end(&store, ticket);
+    }
+    report("hash lookup (section per lookup)", bench_timer_stop(&timer), sum);
+
+    Reloader reloader = {&store, 0, 0};
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, reload_main, &reloader) == 0) {
+        sum = 0;
+        bench_timer_start(&timer);
+        for (size_t i = 0; i < LOOKUPS; i++) {
+            snapshot = config_read_begin(&store, &ticket);
+            sum += config_get_int(snapshot, order[i], -1);
+            config_read_end(&store, ticket);
+        }
+        double seconds = bench_timer_stop(&timer);
+        __atomic_store_n(&reloader.stop, 1, __ATOMIC_RELAXED);
+        pthread_join(thread, NULL);
+        report("  ... during continuous reloads", seconds, sum);
+        printf("    reloads meanwhile: %lu\n", reloader.reloads);
+    }
+
+    config_store_close(&store);
+    remove(BENCH_FILE);
+    free(entries);
+    free(order);
+}
+
+int main(int argc, char* argv[]) {
+    static const size_t default_keys[] = {10, 100, 1000};
+    size_t size_count = argc > 1 ? (size_t)(argc - 1) : 3;
+
+    bench_timer_open(&timer);
+    printf("Config lookup benchmark: %d lookups per method\n", LOOKUPS);
+    bench_timer_print_status(&timer, stdout);
+    for (size_t s = 0; s < size_count; s++) {
+        size_t keys = argc > 1 ? (size_t)atol(argv[s + 1]) : default_keys[s];
+        if (keys == 0 || keys > 65535) {
+            fprintf(stderr, "Usage: %s [keys ...] (1 to 65535 each)\n", argv[0]);
+            return 1;
+        }
+        run(keys);
+    }
+    bench_timer_close(&timer);
+    return 0;
+}
@@ -0,0 +1,133 @@
+/*
+ * bench_csv.c - Throughput benchmark for the zero-copy CSV reader
+ *
+ * Generates an employee export with N rows (default 1,000,000), then
+ * compares:
+ * - fgets() + strtok() line splitting (the classic approach)
+ * - csv_read_file(), zero-copy slices of the memory-mapped file
+ * Both sum the salary column: atof() on the strtok() token vs.
+ * csv_field_double() on the field slice.
+ *
+ * Usage: ./bench_csv [rows]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_harness.h"
+#include "csv_reader.h"
+#include "synthetic.h"
+
+static const char* BENCH_FILE = "bench_employees.csv";
+
+static BenchTimer timer;
+
+// Synthetic people (synthetic.h): every fourth name is "Last, First",
+// so quoting is exercised
+static int generate_file(long rows) {
+    TaskPool pool;
+    if (task_pool_init(&pool, 0) != 0) {
+        perror("task_pool_init");
+        return -1;
+    }
+    int status = synth_write_file(&pool, BENCH_FILE, SYNTH_PEOPLE_CSV, 42, (uint64_t)rows, 0,
+                                  NULL, NULL);
+    if (status != 0) perror("Failed to create benchmark file");
+    task_pool_destroy(&pool);
+    return status;
+}
+
+// One result line, with the counts of the last bench_timer_stop()
+static void report(const char* label, size_t records, size_t bytes, double seconds) {
+    char counts[BENCH_COUNTS_TEXT_SIZE];
+    printf("  %-28s %10zu records  %8.3f s  %12.0f records/s  %8.1f MB/s%s\n",
+           label, records, seconds, records / seconds, bytes / seconds / (1024.0 * 1024.0),
+           bench_counts_text(&timer.counts, counts, sizeof(counts)));
+}
+
+static int sum_salary(const CsvRecord* record, void* user_data) {
+    double* total = (double*)user_data;
+    if (record->record_number > 1 && record->field_count >= 5) {
+        double salary;
+        if (csv_field_double(&record->fields[4], &salary) == 0) *total += salary;
+    }
+    return 1;
+}
+
+static void warm_page_cache(void) {
+    FILE* file = fopen(BENCH_FILE, "rb");
+    if (file == NULL) return;
+
+    static char block[1 << 16];
+    while (fread(block, 1, sizeof(block), file) == sizeof(block)) { }
+    fclose(file);
+}
+
+static void bench_fgets_strtok(void) {
+    FILE* file = fopen(BENCH_FILE, "r");
+    if (file == NULL) return;
+
+    char line[256];
+    size_t records = 0, bytes = 0;
+    double total = 0.0;
+
+    bench_timer_start(&timer);
+    while (fgets(line, sizeof(line), file) != NULL) {
+        bytes += strlen(line);
+        records++;
+        if (records == 1) continue;
+
+        // Salary is the last column; strtok can't see through quotes, so
+        // count from the end of the line instead of the start
+        char* last = strrchr(line, ',');
+        if (last != NULL) total += atof(last + 1);
+        strtok(line, ",");
+        while (strtok(NULL, ",") != NULL) { }
+    }
+    double elapsed = bench_timer_stop(&timer);
+    fclose(file);
+
+    report("fgets + strtok", records, bytes, elapsed);
+    printf("    (salary checksum %.2f)\n", total);
+}
+
+static void bench_streaming(void) {
+    CsvStats stats;
+    double total = 0.0;
+
+    bench_timer_start(&timer);
+    if (csv_read_file(BENCH_FILE, sum_salary, &total, &stats) != 0) {
+        perror("csv_read_file");
+        return;
+    }
+    double elapsed = bench_timer_stop(&timer);
+
+    report("csv_read_file (mapped)", stats.records, stats.bytes, elapsed);
+    printf("    (salary checksum %.2f)\n", total);
+}
+
+int main(int argc, char* argv[]) {
+    long rows = argc > 1 ? atol(argv[1]) : 1000000;
+    if (rows <= 0) {
+        fprintf(stderr, "Usage: %s [rows]\n", argv[0]);
+        return 1;
+    }
+
+    bench_timer_open(&timer);
+    printf("CSV reader benchmark: %ld rows\n", rows);
+    bench_timer_print_status(&timer, stdout);
+    if (generate_file(rows) != 0) return 1;
+
+    // Warm the page cache so both runs measure parsing, not the disk
+    warm_page_cache();
+    printf("Results:\n");
+    bench_fgets_strtok();
+    bench_streaming();
+
+    remove(BENCH_FILE);
+    bench_timer_close(&timer);
+    return 0;
+}
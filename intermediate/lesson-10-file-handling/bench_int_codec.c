@@ -0,0 +1,306 @@
+/*
+ * bench_int_codec.c - Integer column encodings on employee-shaped data
+ *
+ * Generates columns like those of an employee table (default 10M rows):
+ * sorted IDs with and without gaps, ages, department IDs in random order
+ * and sorted by department, salaries in cents and hire timestamps
+ * (int64), and random integers as the worst case.
+ *
+ * Each column is cut into 64K-row chunks, as column_file.c does, and
+ * every chunk is encoded with what int_codec_choose() picks. Reported:
+ * - bits per value of every encoding, and of the chosen ones (MYFT
+ *   version 1 spends 32 on every value)
+ * - decode GB/s (of decoded values) with AVX2 and portable unpacking,
+ *   next to a plain memcpy() of the same bytes
+ * - a MYFT v2 file of all columns, plain and encoded: size, and the time
+ *   for column_file_open() (which decodes encoded chunks) plus a sum
+ *   over every column
+ *
+ * The counts on a decode table line are the AVX2 decode's.
+ *
+ * Usage: ./bench_int_codec [rows]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "bench_harness.h"
+#include "column_file.h"
+#include "int_codec.h"
+
+#define CHUNK_ROWS 65536
+#define MIN_SECONDS 0.25
+
+static const char* PLAIN_FILE = "bench_int_plain.dat";
+static const char* ENCODED_FILE = "bench_int_encoded.dat";
+
+typedef struct {
+    const char* name;
+    size_t value_size;
+    void* data;
+} Column;
+
+typedef struct {
+    IntEncoding encoding;
+    size_t offset;              // In the column's encoded buffer
+    size_t size;
+} EncodedChunk;
+
+static uint64_t rng_state = 88172645463325252ull;
+
+static uint64_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static BenchTimer timer;
+
+static long long file_size(const char* filename) {
+    struct stat info;
+    return stat(filename, &info) == 0 ? (long long)info.st_size : -1;
+}
+
+static int make_columns(Column* columns, size_t rows) {
+    static const char* const names[] = {
+        "id (sorted)", "id (gaps)", "age", "department_id", "department (sorted)",
+        "salary_cents", "hired_at", "random"
+    };
+    static const size_t sizes[] = {4, 4, 4, 4, 4, 8, 8, 4};
+    for (int c = 0; c < 8; c++) {
+        columns[c].name = names[c];
+        columns[c].value_size = sizes[c];
+        columns[c].data = malloc(rows * sizes[c]);
+        if (columns[c].data == NULL) return -1;
+    }
+
+    int32_t* id = columns[0].data;
+    int32_t* id_gaps = columns[1].data;
+    int32_t* age = columns[2].data;
+    int32_t* department = columns[3].data;
+    int32_t* department_sorted = columns[4].data;
+    int64_t* salary = columns[5].data;
+    int64_t* hired = columns[6].data;
+    int32_t* noise = columns[7].data;
+
+    int32_t next_id = 1000;
+    int64_t when = 1262304000;      // 2010-01-01
+    for (size_t i = 0; i < rows; i++) {
+        id[i] = 1000 + (int32_t)i;
+        next_id += 1 + (int32_t)(next_random() % 20);
+        id_gaps[i] = next_id;
+        age[i] = 22 + (int32_t)(next_random() % 43);
+        department[i] = 1 + (int32_t)(next_random() % 12);
+        department_sorted[i] = 1 + (int32_t)(i * 12 / rows);
+        salary[i] = 3000000 + (int64_t)(next_random() % 12000000);
+        // Mostly minutes apart, now and then a hiring freeze of months
+        when += next_random() % 1000 == 0 ? 5000000 + (int64_t)(next_random() % 10000000)
+                                           : (int64_t)(next_random() % 600);
+        hired[i] = when;
+        noise[i] = (int32_t)next_random();
+    }
+    return 0;
+}
+
+// Encode every chunk with the encoding int_codec_choose() picks
+static size_t encode_column(const Column* column, size_t rows, unsigned char* out,
+                            EncodedChunk* chunks, size_t counts[INT_ENCODING_COUNT]) {
+    size_t total = 0;
+    for (size_t k = 0; k * CHUNK_ROWS < rows; k++) {
+        size_t n = rows - k * CHUNK_ROWS < CHUNK_ROWS ? rows - k * CHUNK_ROWS : CHUNK_ROWS;
+        const char* values = (const char*)column->data + k * CHUNK_ROWS * column->value_size;
+        chunks[k].encoding = int_codec_choose(values, n, column->value_size, NULL);
+        chunks[k].offset = total;
+        chunks[k].size = int_codec_encode(chunks[k].encoding, values, n, column->value_size,
+                                          out + total);
+        total += chunks[k].size;
+        counts[chunks[k].encoding]++;
+    }
+    return total;
+}
+
+// Decode all chunks into `out` until MIN_SECONDS have passed; returns GB/s
+// of decoded values, or -1 if a chunk fails or differs from the column
+static double time_decode(const Column* column, size_t rows, const unsigned char* encoded,
+                          const EncodedChunk* chunks, void* out) {
+    size_t chunk_count = (rows + CHUNK_ROWS - 1) / CHUNK_ROWS;
+    size_t bytes = 0;
+    double elapsed;
+    bench_timer_start(&timer);
+    do {
+        for (size_t k = 0; k < chunk_count; k++) {
+            size_t n = rows - k * CHUNK_ROWS < CHUNK_ROWS ? rows - k * CHUNK_ROWS : CHUNK_ROWS;
+            char* values = (char*)out + k * CHUNK_ROWS * column->value_size;
+            if (int_codec_decode(chunks[k].encoding, encoded + chunks[k].offset, chunks[k].size,
+                                 values, n, column->value_size) != 0) return -1;
+        }
+        bytes += rows * column->value_size;
+        elapsed = bench_timer_stop(&timer);
+    } while (elapsed < MIN_SECONDS);
+    if (memcmp(out, column->data, rows * column->value_size) != 0) return -1;
+    return bytes / elapsed / 1e9;
+}
+
+static double time_memcpy(const Column* column, size_t rows, void* out) {
+    size_t bytes = 0;
+    double elapsed;
+    bench_timer_start(&timer);
+    do {
+        memcpy(out, column->data, rows * column->value_size);
+        bytes += rows * column->value_size;
+        elapsed = bench_timer_stop(&timer);
+    } while (elapsed < MIN_SECONDS);
+    return bytes / elapsed / 1e9;
+}
+
+// Bits per value of each encoding over the whole column, chunk by chunk
+static void print_encoding_sizes(const Column* column, size_t rows) {
+    size_t totals[INT_ENCODING_COUNT] = {0};
+    for (size_t k = 0; k * CHUNK_ROWS < rows; k++) {
+        size_t n = rows - k * CHUNK_ROWS < CHUNK_ROWS ? rows - k * CHUNK_ROWS : CHUNK_ROWS;
+        size_t sizes[INT_ENCODING_COUNT];
+        int_codec_measure((const char*)column->data + k * CHUNK_ROWS * column->value_size, n,
+                          column->value_size, sizes);
+        for (int e = 0; e < INT_ENCODING_COUNT; e++) {
+            totals[e] = sizes[e] == SIZE_MAX || totals[e] == SIZE_MAX ? SIZE_MAX : totals[e] + sizes[e];
+        }
+    }
+    printf("  %-20s", column->name);
+    for (int e = 0; e < INT_ENCODING_COUNT; e++) {
+        if (totals[e] == SIZE_MAX) {
+            printf("  %8s", "-");
+        } else {
+            printf("  %8.2f", 8.0 * (double)totals[e] / (double)rows);
+        }
+    }
+    printf("\n");
+}
+
+static int write_file(const char* filename, const Column* columns, size_t rows, int encode) {
+    ColumnSpec schema[8];
+    const void* values[8];
+    for (int c = 0; c < 8; c++) {
+        schema[c].name = columns[c].name;
+        schema[c].type = columns[c].value_size == 4 ? COLUMN_INT32 : COLUMN_INT64;
+        values[c] = columns[c].data;
+    }
+    ColumnWriter writer;
+    if (column_writer_open(&writer, filename, schema, 8, CHUNK_ROWS) != 0) return -1;
+    int failed = column_writer_set_encoding(&writer, encode) != 0 ||
+                 column_writer_append(&writer, values, rows) != 0;
+    return column_writer_close(&writer) == 0 && !failed ? 0 : -1;
+}
+
+// column_file_open() plus a sum over every value; returns seconds
+static double time_open_and_sum(const char* filename, long long* total) {
+    bench_timer_start(&timer);
+    ColumnFile file;
+    if (column_file_open(&file, filename) != 0) return -1;
+    *total = 0;
+    for (size_t c = 0; c < file.column_count; c++) {
+        for (size_t k = 0; k < file.chunk_count; k++) {
+            const ColumnChunk* chunk = column_file_chunk(&file, c, k);
+            if (file.columns[c].type == COLUMN_INT32) {
+                const int32_t* values = chunk->data;
+                for (uint32_t i = 0; i < chunk->rows; i++) *total += values[i];
+            } else {
+                const int64_t* values = chunk->data;
+                for (uint32_t i = 0; i < chunk->rows; i++) *total += values[i];
+            }
+        }
+    }
+    column_file_close(&file);
+    return bench_timer_stop(&timer);
+}
+
+int main(int argc, char* argv[]) {
+    size_t rows = argc > 1 ? (size_t)atol(argv[1]) : 10000000;
+    if (rows == 0) {
+        fprintf(stderr, "Usage: %s [rows]\n", argv[0]);
+        return 1;
+    }
+
+    Column columns[8];
+    size_t chunk_count = (rows + CHUNK_ROWS - 1) / CHUNK_ROWS;
+    unsigned char* encoded = malloc(rows * 8);
+    EncodedChunk* chunks = malloc(chunk_count * sizeof(EncodedChunk));
+    void* decoded = malloc(rows * 8);
+    if (encoded == NULL || chunks == NULL || decoded == NULL || make_columns(columns, rows) != 0) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    memset(decoded, 0, rows * 8);
+
+    bench_timer_open(&timer);
+    bench_timer_print_status(&timer, stdout);
+    printf("Bits per value by encoding (%zu rows, chunks of %d):\n", rows, CHUNK_ROWS);
+    printf("  %-20s  %8s  %8s  %8s  %8s  %8s\n", "column", "plain", "FOR", "delta", "varint", "RLE");
+    for (int c = 0; c < 8; c++) print_encoding_sizes(&columns[c], rows);
+
+    printf("\nChosen per chunk, decode GB/s of decoded values:\n");
+    printf("  %-20s  %-14s %10s  %9s  %8s  %9s  %8s\n", "column", "encoding", "bits/value",
+           "smaller", "AVX2", "portable", "memcpy");
+    int ok = 1;
+    for (int c = 0; c < 8; c++) {
+        const Column* column = &columns[c];
+        size_t counts[INT_ENCODING_COUNT] = {0};
+        size_t total = encode_column(column, rows, encoded, chunks, counts);
+
+        // Most common encoding, and how many chunks differ from it
+        int common = 0;
+        for (int e = 1; e < INT_ENCODING_COUNT; e++) common = counts[e] > counts[common] ? e : common;
+        char label[32];
+        if (counts[common] == chunk_count) {
+            snprintf(label, sizeof(label), "%s", int_encoding_name((IntEncoding)common));
+        } else {
+            snprintf(label, sizeof(label), "%s +%zu other", int_encoding_name((IntEncoding)common),
+                     chunk_count - counts[common]);
+        }
+
+        int_codec_set_simd(1);
+        double avx2 = time_decode(column, rows, encoded, chunks, decoded);
+        char avx2_counts[BENCH_COUNTS_TEXT_SIZE];
+        bench_counts_text(&timer.counts, avx2_counts, sizeof(avx2_counts));
+        int_codec_set_simd(0);
+        double portable = time_decode(column, rows, encoded, chunks, decoded);
+        double copy = time_memcpy(column, rows, decoded);
+        if (avx2 < 0 || portable < 0) ok = 0;
+
+        double bits = 8.0 * (double)total / (double)rows;
+        printf("  %-20s  %-14s %10.2f  %8.1fx  %8.2f  %9.2f  %8.2f  %s%s\n", column->name, label,
+               bits, 8.0 * (double)column->value_size / bits, avx2, portable, copy, avx2 < 0 || portable < 0 ? "✗ MISMATCH" : "✓",
+               avx2_counts);
+    }
+    int_codec_set_simd(1);
+
+    printf("\nMYFT v2 file of all 8 columns, open + sum of every value:\n");
+    long long plain_total = 0, encoded_total = 0;
+    if (write_file(PLAIN_FILE, columns, rows, 0) != 0 || write_file(ENCODED_FILE, columns, rows, 1) != 0) {
+        perror("Failed to write column files");
+        return 1;
+    }
+    char counts[BENCH_COUNTS_TEXT_SIZE];
+    double plain_seconds = time_open_and_sum(PLAIN_FILE, &plain_total);
+    printf("  %-10s %12lld bytes  %8.1f ms%s\n", "plain", file_size(PLAIN_FILE),
+           plain_seconds * 1e3, bench_counts_text(&timer.counts, counts, sizeof(counts)));
+    double encoded_seconds = time_open_and_sum(ENCODED_FILE, &encoded_total);
+    printf("  %-10s %12lld bytes  %8.1f ms  (%.1fx smaller)  %s%s\n", "encoded",
+           file_size(ENCODED_FILE), encoded_seconds * 1e3,
+           (double)file_size(PLAIN_FILE) / (double)file_size(ENCODED_FILE),
+           plain_total == encoded_total && plain_seconds >= 0 && encoded_seconds >= 0 ? "✓" : "✗ MISMATCH",
+           bench_counts_text(&timer.counts, counts, sizeof(counts)));
+    remove(PLAIN_FILE);
+    remove(ENCODED_FILE);
+
+    for (int c = 0; c < 8; c++) free(columns[c].data);
+    free(encoded);
+    free(chunks);
+    free(decoded);
+    bench_timer_close(&timer);
+    return ok ? 0 : 1;
+}
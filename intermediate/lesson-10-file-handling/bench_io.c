@@ -0,0 +1,585 @@
+/*
+ * bench_io.c - Write, fsync and read throughput of the file I/O APIs
+ *
+ * For every file size and buffer size it times:
+ * - stdio-int: fwrite()/fread() of one int at a time through a setvbuf()
+ *   buffer of the given size (what demonstrate_performance_comparison does)
+ * - stdio:     fwrite()/fread() of whole buffers, setvbuf() to the same size
+ * - syscall:   write(2)/read(2) of whole buffers, no stdio
+ * - vectored:  writev(2)/readv(2), each buffer split into 16 iovecs
+ * - mmap:      memcpy() into / reads out of a shared mapping (no buffer size)
+ * - direct:    O_DIRECT write(2)/read(2) from an aligned buffer
+ * as three operations: "write" (data handed to the kernel), "fsync"
+ * (write + fsync()/msync() - data on the disk) and "read".
+ *
+ * Every case is repeated (--trials, after --warmup untimed rounds) and the
+ * cases of a round run in a shuffled order, so no method always gets the
+ * cache state its predecessor left behind. Times are wall clock
+ * (CLOCK_MONOTONIC, including open and close); the report has the median,
+ * p99 (nearest rank - the maximum below 100 trials) and minimum of each
+ * case, and MB/s at the median. Reads use the page cache unless --cold is
+ * given, which drops a file's cached pages before each read; O_DIRECT reads
+ * are always cold. A case's hardware counts add up all its timed trials.
+ *
+ * Usage: ./bench_io [--sizes 64K,1M,64M] [--buffers 4K,64K,1M,4M]
+ *                   [--methods stdio-int,stdio,syscall,vectored,mmap,direct]
+ *                   [--trials N] [--warmup N] [--cold] [--dir DIR]
+ *                   [--format text|csv|json]
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "bench_harness.h"
+
+#define MAX_VALUES 16
+#define DIRECT_ALIGNMENT 4096
+#define IOV_PER_BUFFER 16
+
+typedef enum { OP_WRITE, OP_FSYNC, OP_READ, OP_COUNT } IoOp;
+
+typedef enum {
+    METHOD_STDIO_INT,
+    METHOD_STDIO,
+    METHOD_SYSCALL,
+    METHOD_VECTORED,
+    METHOD_MMAP,
+    METHOD_DIRECT,
+    METHOD_COUNT
+} IoMethod;
+
+static const char* const OP_NAMES[OP_COUNT] = {"write", "fsync", "read"};
+static const char* const METHOD_NAMES[METHOD_COUNT] = {
+    "stdio-int", "stdio", "syscall", "vectored", "mmap", "direct"
+};
+
+typedef struct {
+    IoOp op;
+    IoMethod method;
+    size_t size;
+    size_t buffer;          // 0 for mmap
+    double* times;          // One per trial
+    PerfSample counts;      // Added up over the timed trials
+    int failed;             // errno of the first failure, 0 if none
+} IoCase;
+
+typedef struct {
+    size_t sizes[MAX_VALUES];
+    int size_count;
+    size_t buffers[MAX_VALUES];
+    int buffer_count;
+    int methods[METHOD_COUNT];
+    int trials;
+    int warmup;
+    int cold;
+    const char* dir;
+    const char* format;
+} IoOptions;
+
+// Source of written data and destination of reads (max buffer size)
+static unsigned char* data_buffer;
+static size_t data_capacity;
+// Keeps the compiler from dropping reads whose result is never used
+static volatile uint64_t sink;
+static BenchTimer timer;
+
+// "64K", "4M", "1G" or plain bytes; 0 on a malformed value
+static size_t parse_size(const char* text) {
+    char* end;
+    unsigned long long value = strtoull(text, &end, 10);
+    switch (*end) {
+        case 'k': case 'K': value <<= 10; end++; break;
+        case 'm': case 'M': value <<= 20; end++; break;
+        case 'g': case 'G': value <<= 30; end++; break;
+        default: break;
+    }
+    if (end == text || *end != '\0') return 0;
+    return (size_t)value;
+}
+
+static int parse_size_list(const char* text, size_t* values) {
+    char copy[256];
+    snprintf(copy, sizeof(copy), "%s", text);
+    int count = 0;
+    for (char* item = strtok(copy, ","); item != NULL; item = strtok(NULL, ",")) {
+        if (count == MAX_VALUES) return -1;
+        values[count] = parse_size(item);
+        if (values[count] == 0) return -1;
+        count++;
+    }
+    return count > 0 ? count : -1;
+}
+
+static int parse_methods(const char* text, int* methods) {
+    char copy[256];
+    snprintf(copy, sizeof(copy), "%s", text);
+    memset(methods, 0, METHOD_COUNT * sizeof(int));
+    for (char* item = strtok(copy, ","); item != NULL; item = strtok(NULL, ",")) {
+        int found = 0;
+        for (int m = 0; m < METHOD_COUNT; m++) {
+            if (strcmp(item, METHOD_NAMES[m]) == 0) methods[m] = found = 1;
+        }
+        if (!found) return -1;
+    }
+    return 0;
+}
+
+static void format_size(size_t bytes, char* out, size_t out_size) {
+    if (bytes == 0) {
+        snprintf(out, out_size, "-");
+    } else if (bytes % (1u << 30) == 0) {
+        snprintf(out, out_size, "%zuG", bytes >> 30);
+    } else if (bytes % (1u << 20) == 0) {
+        snprintf(out, out_size, "%zuM", bytes >> 20);
+    } else if (bytes % (1u << 10) == 0) {
+        snprintf(out, out_size, "%zuK", bytes >> 10);
+    } else {
+        snprintf(out, out_size, "%zu", bytes);
+    }
+}
+
+static uint64_t consume(const unsigned char* data, size_t length) {
+    uint64_t sum = 0;
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        sum += word;
+    }
+    for (; i < length; i++) sum += data[i];
+    return sum;
+}
+
+static void drop_cache(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return;
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+// Write `size` bytes of data_buffer (repeated) with full writes of `chunk`
+static int write_all(int fd, size_t size, size_t chunk) {
+    for (size_t done = 0; done < size; ) {
+        size_t want = size - done < chunk ? size - done : chunk;
+        ssize_t n = write(fd, data_buffer, want);
+        if (n <= 0) return -1;
+        done += (size_t)n;
+    }
+    return 0;
+}
+
+static int run_write(const IoCase* c, const char* path) {
+    int sync = c->op == OP_FSYNC;
+    size_t size = c->size, chunk = c->buffer;
+
+    if (c->method == METHOD_STDIO_INT || c->method == METHOD_STDIO) {
+        FILE* file = fopen(path, "wb");
+        if (file == NULL) return -1;
+        setvbuf(file, NULL, _IOFBF, chunk);
+        int ok = 1;
+        if (c->method == METHOD_STDIO_INT) {
+            const int* values = (const int*)data_buffer;
+            size_t per_buffer = chunk / sizeof(int);
+            for (size_t i = 0; i < size / sizeof(int) && ok; i++) {
+                ok = fwrite(&values[i % per_buffer], sizeof(int), 1, file) == 1;
+            }
+            if (ok && size % sizeof(int) != 0) {
+                ok = fwrite(data_buffer, 1, size % sizeof(int), file) == size % sizeof(int);
+            }
+        } else {
+            for (size_t done = 0; done < size && ok; done += chunk) {
+                size_t want = size - done < chunk ? size - done : chunk;
+                ok = fwrite(data_buffer, 1, want, file) == want;
+            }
+        }
+        if (ok && sync) ok = fflush(file) == 0 && fsync(fileno(file)) == 0;
+        return fclose(file) == 0 && ok ? 0 : -1;
+    }
+
+    int flags = O_WRONLY | O_CREAT | O_TRUNC;
+    if (c->method == METHOD_DIRECT) flags |= O_DIRECT;
+    if (c->method == METHOD_MMAP) flags = O_RDWR | O_CREAT | O_TRUNC;
+    int fd = open(path, flags, 0644);
+    if (fd < 0) return -1;
+    int result = 0;
+
+    switch (c->method) {
+        case METHOD_SYSCALL:
+            result = write_all(fd, size, chunk);
+            break;
+        case METHOD_VECTORED: {
+            struct iovec iov[IOV_PER_BUFFER];
+            size_t piece = chunk / IOV_PER_BUFFER;
+            for (size_t done = 0; done < size && result == 0; ) {
+                size_t left = size - done;
+                int count = 0;
+                for (; count < IOV_PER_BUFFER && left > 0; count++) {
+                    size_t take = left < piece ? left : piece;
+                    iov[count].iov_base = data_buffer + (size_t)count * piece;
+                    iov[count].iov_len = take;
+                    left -= take;
+                }
+                ssize_t n = writev(fd, iov, count);
+                if (n <= 0) result = -1;
+                else done += (size_t)n;
+            }
+            break;
+        }
+        case METHOD_MMAP: {
+            if (ftruncate(fd, (off_t)size) != 0) {
+                result = -1;
+                break;
+            }
+            unsigned char* map = mmap(NULL, size, PROT_WRITE, MAP_SHARED, fd, 0);
+            if (map == MAP_FAILED) {
+                result = -1;
+                break;
+            }
+            for (size_t done = 0; done < size; done += data_capacity) {
+                size_t want = size - done < data_capacity ? size - done : data_capacity;
+                memcpy(map + done, data_buffer, want);
+            }
+            if (sync && msync(map, size, MS_SYNC) != 0) result = -1;
+            munmap(map, size);
+            break;
+        }
+        case METHOD_DIRECT: {
+            // O_DIRECT needs block-aligned lengths: the tail goes through
+            // the page cache once O_DIRECT is switched off
+            size_t aligned = size / DIRECT_ALIGNMENT * DIRECT_ALIGNMENT;
+            result = write_all(fd, aligned, chunk);
+            if (result == 0 && aligned < size) {
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_DIRECT);
+                result = write_all(fd, size - aligned, chunk);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+
+    // mmap already synced with msync()
+    if (result == 0 && sync && c->method != METHOD_MMAP) result = fsync(fd);
+    if (close(fd) != 0) result = -1;
+    return result;
+}
+
+static int run_read(const IoCase* c, const char* path) {
+    size_t chunk = c->buffer;
+    uint64_t sum = 0;
+    int result = 0;
+
+    if (c->method == METHOD_STDIO_INT || c->method == METHOD_STDIO) {
+        FILE* file = fopen(path, "rb");
+        if (file == NULL) return -1;
+        setvbuf(file, NULL, _IOFBF, chunk);
+        if (c->method == METHOD_STDIO_INT) {
+            int value;
+            while (fread(&value, sizeof(int), 1, file) == 1) sum += (unsigned)value;
+        } else {
+            size_t got;
+            while ((got = fread(data_buffer, 1, chunk, file)) > 0) {
+                sum += consume(data_buffer, got);
+            }
+        }
+        if (ferror(file)) result = -1;
+        fclose(file);
+        sink = sum;
+        return result;
+    }
+
+    int fd = open(path, c->method == METHOD_DIRECT ? O_RDONLY | O_DIRECT : O_RDONLY);
+    if (fd < 0) return -1;
+
+    switch (c->method) {
+        case METHOD_SYSCALL:
+        case METHOD_DIRECT:
+            for (;;) {
+                // An O_DIRECT read at the end of the file returns short
+                ssize_t n = read(fd, data_buffer, chunk);
+                if (n < 0) result = -1;
+                if (n <= 0) break;
+                sum += consume(data_buffer, (size_t)n);
+            }
+            break;
+        case METHOD_VECTORED: {
+            struct iovec iov[IOV_PER_BUFFER];
+            size_t piece = chunk / IOV_PER_BUFFER;
+            for (int i = 0; i < IOV_PER_BUFFER; i++) {
+                iov[i].iov_base = data_buffer + (size_t)i * piece;
+                iov[i].iov_len = piece;
+            }
+            for (;;) {
+                ssize_t n = readv(fd, iov, IOV_PER_BUFFER);
+                if (n < 0) result = -1;
+                if (n <= 0) break;
+                sum += consume(data_buffer, (size_t)n);
+            }
+            break;
+        }
+        case METHOD_MMAP: {
+            const unsigned char* map = mmap(NULL, c->size, PROT_READ, MAP_SHARED, fd, 0);
+            if (map == MAP_FAILED) {
+                result = -1;
+                break;
+            }
+            madvise((void*)map, c->size, MADV_SEQUENTIAL);
+            sum = consume(map, c->size);
+            munmap((void*)map, c->size);
+            break;
+        }
+        default:
+            break;
+    }
+
+    close(fd);
+    sink = sum;
+    return result;
+}
+
+static void data_path(const IoOptions* options, size_t size, char* path, size_t path_size) {
+    snprintf(path, path_size, "%s/bench_io_%zu.bin", options->dir, size);
+}
+
+static void run_case(const IoOptions* options, IoCase* c, int trial) {
+    char path[4096];
+    if (c->op == OP_READ) {
+        data_path(options, c->size, path, sizeof(path));
+        if (options->cold) drop_cache(path);
+    } else {
+        snprintf(path, sizeof(path), "%s/bench_io_scratch.bin", options->dir);
+    }
+
+    bench_timer_start(&timer);
+    int status = c->op == OP_READ ? run_read(c, path) : run_write(c, path);
+    double elapsed = bench_timer_stop(&timer);
+
+    if (status != 0 && c->failed == 0) c->failed = errno ? errno : EIO;
+    if (trial >= 0) {
+        c->times[trial] = elapsed;
+        // Ratios of the sums, so every trial weighs by its length
+        if (trial == 0) {
+            c->counts = timer.counts;
+        } else {
+            perf_sample_add(&c->counts, &timer.counts);
+        }
+    }
+    if (c->op != OP_READ) remove(path);
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void report(const IoOptions* options, IoCase* cases, size_t case_count) {
+    int csv = strcmp(options->format, "csv") == 0;
+    int json = strcmp(options->format, "json") == 0;
+    BenchFormat format = csv ? BENCH_FORMAT_CSV : json ? BENCH_FORMAT_JSON : BENCH_FORMAT_TEXT;
+
+    int have_counters = timer.counters.available != 0;
+    char status[160];
+    perf_counters_status(&timer.counters, status, sizeof(status));
+
+    if (csv) {
+        printf("op,method,size,buffer,trials,median_s,p99_s,min_s,mb_per_s,cold");
+        bench_print_counts_header(stdout, format);
+        printf(",error\n");
+    } else if (json) {
+        printf("{\n  \"trials\": %d,\n  \"warmup\": %d,\n  \"cold\": %s,\n"
+               "  \"counters\": \"%s\",\n  \"results\": [\n",
+               options->trials, options->warmup, options->cold ? "true" : "false", status);
+    } else {
+        if (!have_counters) printf("%s\n", status);
+        printf("%-6s %-10s %6s %6s %12s %12s %12s %10s", "op", "method", "size", "buffer",
+               "median ms", "p99 ms", "min ms", "MB/s");
+        if (have_counters) bench_print_counts_header(stdout, format);
+        printf("\n");
+    }
+
+    int n = options->trials;
+    for (size_t i = 0; i < case_count; i++) {
+        IoCase* c = &cases[i];
+        qsort(c->times, (size_t)n, sizeof(double), compare_doubles);
+        double median = n % 2 ? c->times[n / 2] : (c->times[n / 2 - 1] + c->times[n / 2]) / 2;
+        int p99_rank = (99 * n + 99) / 100;       // ceil(0.99 * n)
+        double p99 = c->times[p99_rank - 1];
+        double best = c->times[0];
+        double rate = c->size / median / (1024.0 * 1024.0);
+        const char* error = c->failed ? strerror(c->failed) : "";
+
+        char size[24], buffer[24];
+        format_size(c->size, size, sizeof(size));
+        format_size(c->buffer, buffer, sizeof(buffer));
+
+        if (csv) {
+            printf("%s,%s,%zu,%zu,%d,%.9f,%.9f,%.9f,%.2f,%d", OP_NAMES[c->op],
+                   METHOD_NAMES[c->method], c->size, c->buffer, n, median, p99, best,
+                   c->failed ? 0.0 : rate, options->cold);
+            bench_print_counts(stdout, format, &c->counts);
+            printf(",%s\n", error);
+        } else if (json) {
+            printf("    {\"op\": \"%s\", \"method\": \"%s\", \"size\": %zu, \"buffer\": %zu, "
+                   "\"median_s\": %.9f, \"p99_s\": %.9f, \"min_s\": %.9f, \"mb_per_s\": %.2f",
+                   OP_NAMES[c->op], METHOD_NAMES[c->method], c->size, c->buffer,
+                   median, p99, best, c->failed ? 0.0 : rate);
+            bench_print_counts(stdout, format, &c->counts);
+            printf(", \"error\": \"%s\"}%s\n", error, i + 1 < case_count ? "," : "");
+        } else if (c->failed) {
+            printf("%-6s %-10s %6s %6s  failed: %s\n", OP_NAMES[c->op], METHOD_NAMES[c->method],
+                   size, buffer, error);
+        } else {
+            printf("%-6s %-10s %6s %6s %12.3f %12.3f %12.3f %10.1f", OP_NAMES[c->op],
+                   METHOD_NAMES[c->method], size, buffer, median * 1e3, p99 * 1e3, best * 1e3,
+                   rate);
+            if (have_counters) bench_print_counts(stdout, format, &c->counts);
+            printf("\n");
+        }
+    }
+    if (json) printf("  ]\n}\n");
+}
+
+static int usage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [--sizes 64K,1M,64M] [--buffers 4K,64K,1M,4M]\n"
+            "          [--methods stdio-int,stdio,syscall,vectored,mmap,direct]\n"
+            "          [--trials N] [--warmup N] [--cold] [--dir DIR] [--format text|csv|json]\n",
+            program);
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    IoOptions options = {
+        .sizes = {64 << 10, 1 << 20, 64 << 20}, .size_count = 3,
+        .buffers = {4 << 10, 64 << 10, 1 << 20, 4 << 20}, .buffer_count = 4,
+        .methods = {1, 1, 1, 1, 1, 1},
+        .trials = 5, .warmup = 1, .cold = 0, .dir = ".", .format = "text"
+    };
+
+    for (int i = 1; i < argc; i++) {
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "--cold") == 0) {
+            options.cold = 1;
+        } else if (value == NULL) {
+            return usage(argv[0]);
+        } else if (strcmp(argv[i], "--sizes") == 0) {
+            if ((options.size_count = parse_size_list(value, options.sizes)) < 0) return usage(argv[0]);
+            i++;
+        } else if (strcmp(argv[i], "--buffers") == 0) {
+            if ((options.buffer_count = parse_size_list(value, options.buffers)) < 0) return usage(argv[0]);
+            i++;
+        } else if (strcmp(argv[i], "--methods") == 0) {
+            if (parse_methods(value, options.methods) != 0) return usage(argv[0]);
+            i++;
+        } else if (strcmp(argv[i], "--trials") == 0) {
+            options.trials = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--warmup") == 0) {
+            options.warmup = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--dir") == 0) {
+            options.dir = argv[++i];
+        } else if (strcmp(argv[i], "--format") == 0) {
+            options.format = argv[++i];
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    if (options.trials < 1 || options.warmup < 0) return usage(argv[0]);
+
+    // O_DIRECT transfers must be whole blocks, so every buffer must be too
+    for (int b = 0; b < options.buffer_count; b++) {
+        if (options.buffers[b] % DIRECT_ALIGNMENT != 0) {
+            fprintf(stderr, "Buffer sizes must be multiples of %d bytes\n", DIRECT_ALIGNMENT);
+            return 1;
+        }
+        if (options.buffers[b] > data_capacity) data_capacity = options.buffers[b];
+    }
+    void* aligned;
+    if (posix_memalign(&aligned, DIRECT_ALIGNMENT, data_capacity) != 0) return 1;
+    data_buffer = aligned;
+    for (size_t i = 0; i < data_capacity / sizeof(int); i++) {
+        int value = (int)(i * i);
+        memcpy(data_buffer + i * sizeof(int), &value, sizeof(int));
+    }
+
+    // Every (op, method, size, buffer) combination; mmap ignores the buffer
+    size_t max_cases = (size_t)OP_COUNT * METHOD_COUNT * options.size_count * options.buffer_count;
+    IoCase* cases = calloc(max_cases, sizeof(IoCase));
+    double* times = calloc(max_cases * (size_t)options.trials, sizeof(double));
+    if (cases == NULL || times == NULL) return 1;
+    size_t case_count = 0;
+    for (int op = 0; op < OP_COUNT; op++) {
+        for (int m = 0; m < METHOD_COUNT; m++) {
+            if (!options.methods[m]) continue;
+            for (int s = 0; s < options.size_count; s++) {
+                int buffer_count = m == METHOD_MMAP ? 1 : options.buffer_count;
+                for (int b = 0; b < buffer_count; b++) {
+                    IoCase* c = &cases[case_count];
+                    c->op = (IoOp)op;
+                    c->method = (IoMethod)m;
+                    c->size = options.sizes[s];
+                    c->buffer = m == METHOD_MMAP ? 0 : options.buffers[b];
+                    c->times = times + case_count * (size_t)options.trials;
+                    case_count++;
+                }
+            }
+        }
+    }
+
+    // The files read by the read cases, written once up front
+    for (int s = 0; s < options.size_count; s++) {
+        char path[4096];
+        data_path(&options, options.sizes[s], path, sizeof(path));
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0 || write_all(fd, options.sizes[s], data_capacity) != 0) {
+            perror(path);
+            return 1;
+        }
+        close(fd);
+    }
+
+    size_t* order = malloc(case_count * sizeof(size_t));
+    if (order == NULL) return 1;
+    bench_timer_open(&timer);
+    uint64_t seed = 0x9E3779B97F4A7C15ull;
+    for (int round = -options.warmup; round < options.trials; round++) {
+        // A fresh shuffled order every round (xorshift64)
+        for (size_t i = 0; i < case_count; i++) order[i] = i;
+        for (size_t i = case_count; i > 1; i--) {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            size_t j = (size_t)(seed % i);
+            size_t swap = order[i - 1];
+            order[i - 1] = order[j];
+            order[j] = swap;
+        }
+        for (size_t i = 0; i < case_count; i++) {
+            run_case(&options, &cases[order[i]], round);
+        }
+    }
+
+    report(&options, cases, case_count);
+
+    for (int s = 0; s < options.size_count; s++) {
+        char path[4096];
+        data_path(&options, options.sizes[s], path, sizeof(path));
+        remove(path);
+    }
+    free(order);
+    free(times);
+    free(cases);
+    free(data_buffer);
+    bench_timer_close(&timer);
+    return 0;
+}
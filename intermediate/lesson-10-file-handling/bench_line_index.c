@@ -0,0 +1,151 @@
+/*
+ * bench_line_index.c - Reaching line N: fgets() from the start vs. an index
+ *
+ * Generates a log-like file (default 512 MB) and measures:
+ * - counting its lines with fgets() vs. building the line index (one
+ *   SIMD newline pass), in MB/s
+ * - bringing the index up to date after 1 MB is appended
+ * - jumping to random lines: fgets() from the start of the file vs.
+ *   seek_line(), in microseconds per line
+ *
+ * Usage: ./bench_line_index [megabytes]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "bench_harness.h"
+#include "line_index.h"
+
+#define FGETS_JUMPS 5
+#define INDEX_JUMPS 10000
+
+static const char* BENCH_FILE = "bench_line_index.log";
+static const char* BENCH_INDEX = "bench_line_index.log.idx";
+
+static BenchTimer timer;
+
+static unsigned long long append_lines(size_t bytes, unsigned long long first_line) {
+    FILE* file = fopen(BENCH_FILE, "a");
+    if (file == NULL) return first_line;
+    static const char* const levels[] = {"INFO ", "WARN ", "ERROR", "DEBUG"};
+    size_t written = 0;
+    unsigned long long line = first_line;
+    while (written < bytes) {
+        int n = fprintf(file, "2024-01-15 %02llu:%02llu:%02llu %s Worker%llu request %llu took %llu ms\n",
+                        line / 3600 % 24, line / 60 % 60, line % 60, levels[line % 4],
+                        line % 16, line, line * 7919 % 1000);
+        if (n < 0) break;
+        written += (size_t)n;
+        line++;
+    }
+    fclose(file);
+    return line;
+}
+
+// Line `target` the classic way: fgets() every line before it
+static long long fgets_to_line(FILE* file, unsigned long long target) {
+    char line[256];
+    rewind(file);
+    for (unsigned long long i = 0; i < target; i++) {
+        if (fgets(line, sizeof(line), file) == NULL) return -1;
+    }
+    return ftell(file);
+}
+
+int main(int argc, char* argv[]) {
+    size_t megabytes = argc > 1 ? (size_t)atol(argv[1]) : 512;
+    if (megabytes == 0) {
+        fprintf(stderr, "Usage: %s [megabytes]\n", argv[0]);
+        return 1;
+    }
+
+    remove(BENCH_FILE);
+    remove(BENCH_INDEX);
+    unsigned long long lines = append_lines(megabytes * 1024 * 1024, 0);
+    double size_mb = megabytes;
+    bench_timer_open(&timer);
+    printf("Line index benchmark: %zu MB, %llu lines\n", megabytes, lines);
+    bench_timer_print_status(&timer, stdout);
+
+    FILE* file = fopen(BENCH_FILE, "r");
+    if (file == NULL) {
+        perror("Failed to open benchmark file");
+        return 1;
+    }
+
+    // Warm the page cache so both passes start from memory
+    fgets_to_line(file, lines);
+
+    printf("Count lines:\n");
+    bench_timer_start(&timer);
+    long long end = fgets_to_line(file, lines);
+    double seconds = bench_timer_stop(&timer);
+    char counts[BENCH_COUNTS_TEXT_SIZE];
+    printf("  %-30s %8.3f s  %8.1f MB/s  (offset %lld)%s\n", "fgets loop", seconds,
+           size_mb / seconds, end, bench_counts_text(&timer.counts, counts, sizeof(counts)));
+
+    LineIndex index;
+    bench_timer_start(&timer);
+    if (line_index_open(&index, BENCH_FILE, 0) != 0) {
+        perror("Failed to build index");
+        return 1;
+    }
+    seconds = bench_timer_stop(&timer);
+    printf("  %-30s %8.3f s  %8.1f MB/s  (%llu lines)%s\n", "line_index_open (build+save)",
+           seconds, size_mb / seconds, (unsigned long long)index.line_count,
+           bench_counts_text(&timer.counts, counts, sizeof(counts)));
+
+    struct stat info;
+    if (stat(BENCH_INDEX, &info) == 0) {
+        printf("  sidecar: %lld bytes for %zu samples (%.2f bytes/sample)\n",
+               (long long)info.st_size, index.sample_count,
+               (double)info.st_size / (double)index.sample_count);
+    }
+    line_index_free(&index);
+
+    lines = append_lines(1024 * 1024, lines);
+    bench_timer_start(&timer);
+    if (line_index_open(&index, BENCH_FILE, 0) != 0) {
+        perror("Failed to update index");
+        return 1;
+    }
+    seconds = bench_timer_stop(&timer);
+    printf("  %-30s %8.3f ms  (%llu lines now)%s\n", "reopen after 1 MB append", seconds * 1e3,
+           (unsigned long long)index.line_count,
+           bench_counts_text(&timer.counts, counts, sizeof(counts)));
+
+    printf("Jump to a random line:\n");
+    unsigned long long seed = 12345;
+    long long checksum = 0;
+    bench_timer_start(&timer);
+    for (int i = 0; i < FGETS_JUMPS; i++) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        checksum += fgets_to_line(file, (seed >> 33) % lines);
+    }
+    double fgets_us = bench_timer_stop(&timer) / FGETS_JUMPS * 1e6;
+    printf("  %-30s %12.1f us/line  (sum %lld)%s\n", "fgets from the start", fgets_us, checksum,
+           bench_counts_text(&timer.counts, counts, sizeof(counts)));
+
+    seed = 12345;
+    checksum = 0;
+    bench_timer_start(&timer);
+    for (int i = 0; i < INDEX_JUMPS; i++) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        checksum += line_index_offset(&index, file, (seed >> 33) % lines);
+    }
+    double index_us = bench_timer_stop(&timer) / INDEX_JUMPS * 1e6;
+    printf("  %-30s %12.1f us/line  (%.0fx faster)%s\n", "seek_line", index_us,
+           fgets_us / index_us, bench_counts_text(&timer.counts, counts, sizeof(counts)));
+
+    line_index_free(&index);
+    fclose(file);
+    remove(BENCH_FILE);
+    remove(BENCH_INDEX);
+    bench_timer_close(&timer);
+    return 0;
+}
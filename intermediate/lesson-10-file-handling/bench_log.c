@@ -0,0 +1,95 @@
+/*
+ * bench_log.c - Scaling benchmark for the parallel log analyzer
+ *
+ * Generates an application.log-style file (default 512 MB) with
+ * synthetic.h - random levels, components and messages, the same file
+ * on every run - on all CPUs, then runs
+ * log_analyze_file() with 1, 2, 4, ... threads up to the CPU count and
+ * reports throughput and speedup over one thread.
+ *
+ * Usage: ./bench_log [megabytes] [max_threads] [--per-thread]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_harness.h"
+#include "log_analyzer.h"
+#include "synthetic.h"
+
+static const char* BENCH_FILE = "bench_application.log";
+
+static BenchTimer timer;
+
+static int generate_log(size_t megabytes) {
+    TaskPool pool;
+    if (task_pool_init(&pool, 0) != 0) {
+        perror("task_pool_init");
+        return -1;
+    }
+    int status = synth_write_file(&pool, BENCH_FILE, SYNTH_LOG, 42, 0,
+                                  (uint64_t)megabytes * 1024 * 1024, NULL, NULL);
+    if (status != 0) perror("Failed to create benchmark log");
+    task_pool_destroy(&pool);
+    return status;
+}
+
+int main(int argc, char* argv[]) {
+    size_t megabytes = argc > 1 ? (size_t)atol(argv[1]) : 512;
+    int max_threads = argc > 2 ? atoi(argv[2]) : 0;
+    int per_thread = argc > 3 && strcmp(argv[3], "--per-thread") == 0;
+
+    if (max_threads <= 0) max_threads = log_default_thread_count();
+    if (max_threads > LOG_MAX_THREADS) max_threads = LOG_MAX_THREADS;
+
+    bench_timer_open(&timer);
+    printf("Log analyzer benchmark: %zu MB, up to %d threads\n", megabytes, max_threads);
+    bench_timer_print_status(&timer, stdout);
+    if (generate_log(megabytes) != 0) return 1;
+
+    LogAnalysis analysis;
+
+    // Untimed pass to pull the file into the page cache
+    if (log_analyze_file(BENCH_FILE, max_threads, &analysis) == 0) {
+        log_analysis_free(&analysis);
+    }
+
+    double single_thread_seconds = 0.0;
+    for (int threads = 1; ; threads *= 2) {
+        if (threads > max_threads) threads = max_threads;
+
+        // The analyzer times itself; the timer is for the counts
+        bench_timer_start(&timer);
+        if (log_analyze_file(BENCH_FILE, threads, &analysis) != 0) {
+            perror("log_analyze_file");
+            break;
+        }
+        bench_timer_stop(&timer);
+        if (threads == 1) single_thread_seconds = analysis.seconds;
+
+        char counts[BENCH_COUNTS_TEXT_SIZE];
+        printf("  %3d threads: %10zu lines  %7.3f s  %8.1f MB/s  speedup %5.2fx%s\n",
+               threads, analysis.total.lines, analysis.seconds,
+               analysis.file_size / analysis.seconds / (1024.0 * 1024.0),
+               single_thread_seconds / analysis.seconds,
+               bench_counts_text(&timer.counts, counts, sizeof(counts)));
+
+        if (per_thread) {
+            for (int t = 0; t < analysis.thread_count; t++) {
+                const LogCounters* part = &analysis.per_thread[t];
+                printf("      thread %2d: %8.1f MB/s\n", t,
+                       part->seconds > 0 ? part->bytes / part->seconds / (1024.0 * 1024.0) : 0.0);
+            }
+        }
+
+        log_analysis_free(&analysis);
+        if (threads == max_threads) break;
+    }
+
+    remove(BENCH_FILE);
+    bench_timer_close(&timer);
+    return 0;
+}
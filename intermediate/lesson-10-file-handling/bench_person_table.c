@@ -0,0 +1,202 @@
+/*
+ * bench_person_table.c - Array-of-structs vs. columnar aggregates
+ *
+ * Computes the CSV demo's statistics (salary sum/min/max/argmax, age
+ * sum/min/max) over N employees stored two ways:
+ * - an array of Person structs (~170 bytes per row), one loop doing all
+ *   the aggregates, as the original demo did
+ * - a PersonTable, one column kernel per aggregate (portable and AVX2)
+ *
+ * Default sizes are 1M, 10M and 100M rows. A layout that doesn't fit in
+ * three quarters of physical memory is skipped (100M Person structs need ~17 GB).
+ *
+ * The structs' cache misses per row are what the columns save.
+ *
+ * Usage: ./bench_person_table [rows ...]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "bench_harness.h"
+#include "person_table.h"
+
+#define REPEATS 5
+
+// Same layout as the Person struct in file_processing.c
+typedef struct {
+    int id;
+    char name[50];
+    char email[100];
+    int age;
+    double salary;
+} Person;
+
+typedef struct {
+    double salary_sum;
+    double salary_min;
+    double salary_max;
+    size_t salary_argmax;
+    int64_t age_sum;
+    int32_t age_min;
+    int32_t age_max;
+} Aggregates;
+
+static BenchTimer timer;
+static PerfSample best_counts;      // Of the fastest of the last REPEATS runs
+
+static int fits_in_memory(size_t bytes) {
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long page_size = sysconf(_SC_PAGESIZE);
+    if (pages <= 0 || page_size <= 0) return 1;
+    return bytes <= (size_t)pages * (size_t)page_size / 4 * 3;
+}
+
+// Deterministic pseudo-random salary and age for row i
+static double row_salary(size_t i) {
+    return 40000.0 + (double)((i * 2654435761u) % 9000000) / 100.0;
+}
+
+static int32_t row_age(size_t i) {
+    return 20 + (int32_t)((i * 40503u) % 45);
+}
+
+static void aggregate_structs(const Person* people, size_t count, Aggregates* result) {
+    Aggregates a = {0.0, people[0].salary, people[0].salary, 0, 0, people[0].age, people[0].age};
+
+    for (size_t i = 0; i < count; i++) {
+        double salary = people[i].salary;
+        int32_t age = people[i].age;
+
+        a.salary_sum += salary;
+        if (salary < a.salary_min) a.salary_min = salary;
+        if (salary > a.salary_max) {
+            a.salary_max = salary;
+            a.salary_argmax = i;
+        }
+        a.age_sum += age;
+        if (age < a.age_min) a.age_min = age;
+        if (age > a.age_max) a.age_max = age;
+    }
+    *result = a;
+}
+
+static void aggregate_columns(const PersonTable* table, Aggregates* result) {
+    result->salary_sum = column_sum_f64(table->salary, table->count);
+    result->salary_min = column_min_f64(table->salary, table->count);
+    result->salary_max = column_max_f64(table->salary, table->count);
+    result->salary_argmax = column_argmax_f64(table->salary, table->count);
+    result->age_sum = column_sum_i32(table->age, table->count);
+    result->age_min = column_min_i32(table->age, table->count);
+    result->age_max = column_max_i32(table->age, table->count);
+}
+
+// One result line, with the counts of the fastest run
+static void report(const char* label, size_t rows, double seconds, const Aggregates* a) {
+    char counts[BENCH_COUNTS_TEXT_SIZE];
+    printf("  %-22s %9.2f ms  %8.1f Mrows/s  (salary sum %.0f, top row %zu, ages %lld/%d-%d)%s\n",
+           label, seconds * 1000.0, rows / seconds / 1e6, a->salary_sum, a->salary_argmax,
+           (long long)a->age_sum, a->age_min, a->age_max,
+           bench_counts_text(&best_counts, counts, sizeof(counts)));
+}
+
+static void bench_structs(size_t rows) {
+    if (!fits_in_memory(rows * sizeof(Person))) {
+        printf("  %-22s skipped (%.1f GB does not fit in memory)\n", "array of structs",
+               rows * sizeof(Person) / 1e9);
+        return;
+    }
+
+    Person* people = calloc(rows, sizeof(Person));
+    if (people == NULL) {
+        printf("  %-22s skipped (allocation failed)\n", "array of structs");
+        return;
+    }
+    for (size_t i = 0; i < rows; i++) {
+        people[i].id = (int)i;
+        people[i].age = row_age(i);
+        people[i].salary = row_salary(i);
+    }
+
+    Aggregates result;
+    double best = 1e30;
+    for (int r = 0; r < REPEATS; r++) {
+        bench_timer_start(&timer);
+        aggregate_structs(people, rows, &result);
+        double elapsed = bench_timer_stop(&timer);
+        if (elapsed < best) {
+            best = elapsed;
+            best_counts = timer.counts;
+        }
+    }
+    report("array of structs", rows, best, &result);
+    free(people);
+}
+
+static void bench_columns(size_t rows) {
+    // Columns plus the text offset and two empty strings per row
+    size_t row_bytes = 2 * sizeof(int32_t) + sizeof(double) + sizeof(size_t) + 2;
+    if (!fits_in_memory(rows * row_bytes)) {
+        printf("  %-22s skipped (does not fit in memory)\n", "columns");
+        return;
+    }
+
+    PersonTable table;
+    if (person_table_init(&table, rows) != 0) {
+        printf("  %-22s skipped (allocation failed)\n", "columns");
+        return;
+    }
+    for (size_t i = 0; i < rows; i++) {
+        person_table_append(&table, (int32_t)i, "", 0, "", 0, row_age(i), row_salary(i));
+    }
+
+    for (int simd = 0; simd <= 1; simd++) {
+        if (simd && !column_set_simd(1)) break;
+        if (!simd) column_set_simd(0);
+
+        Aggregates result;
+        double best = 1e30;
+        for (int r = 0; r < REPEATS; r++) {
+            bench_timer_start(&timer);
+            aggregate_columns(&table, &result);
+            double elapsed = bench_timer_stop(&timer);
+            if (elapsed < best) {
+                best = elapsed;
+                best_counts = timer.counts;
+            }
+        }
+
+        char label[32];
+        snprintf(label, sizeof(label), "columns (%s)", column_backend_name());
+        report(label, rows, best, &result);
+    }
+    person_table_free(&table);
+}
+
+int main(int argc, char* argv[]) {
+    static const size_t default_rows[] = {1000000, 10000000, 100000000};
+    size_t size_count = argc > 1 ? (size_t)(argc - 1) : 3;
+
+    bench_timer_open(&timer);
+    printf("Person aggregates benchmark (best of %d, sizeof(Person) = %zu bytes)\n",
+           REPEATS, sizeof(Person));
+    bench_timer_print_status(&timer, stdout);
+
+    for (size_t s = 0; s < size_count; s++) {
+        size_t rows = argc > 1 ? (size_t)atol(argv[s + 1]) : default_rows[s];
+        if (rows == 0) {
+            fprintf(stderr, "Usage: %s [rows ...]\n", argv[0]);
+            return 1;
+        }
+
+        printf("\n%zu rows:\n", rows);
+        bench_structs(rows);
+        bench_columns(rows);
+    }
+    bench_timer_close(&timer);
+    return 0;
+}
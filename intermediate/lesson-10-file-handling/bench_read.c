@@ -0,0 +1,191 @@
+/*
+ * bench_read.c - Whole-file read throughput: stdio vs. mmap
+ *
+ * Generates a text file (default 1 GB) and counts its lines four ways:
+ * - fgetc():  one library call per character
+ * - fgets():  one call per line, copied into a line buffer
+ * - fread():  fseek/ftell, malloc the whole size, one big read (a full copy)
+ * - mmap():   mapped_file_open(), no copy at all
+ *
+ * By default the file is read from the page cache. With --cold each run
+ * first asks the kernel to drop the file's cached pages (posix_fadvise),
+ * so the disk is part of the measurement.
+ *
+ * The kernel's copy in fread() isn't in the hardware counts (user space
+ * only), but mmap()'s page faults show up as dTLB and cache misses on the
+ * first touch.
+ *
+ * Usage: ./bench_read [megabytes] [--cold]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench_harness.h"
+#include "mapped_file.h"
+
+static const char* BENCH_FILE = "bench_read.txt";
+
+static BenchTimer timer;
+
+static int generate_file(size_t megabytes) {
+    FILE* file = fopen(BENCH_FILE, "wb");
+    if (file == NULL) {
+        perror("Failed to create benchmark file");
+        return -1;
+    }
+
+    // One megabyte of log-like lines, written over and over
+    static char block[1024 * 1024];
+    size_t used = 0;
+    for (unsigned long i = 0; ; i++) {
+        char line[128];
+        int length = snprintf(line, sizeof(line),
+                              "2024-01-15 09:%02lu:%02lu INFO  Server    Request %lu handled\n",
+                              (i / 60) % 60, i % 60, i);
+        if (used + (size_t)length > sizeof(block)) break;
+        memcpy(block + used, line, (size_t)length);
+        used += (size_t)length;
+    }
+
+    for (size_t i = 0; i < megabytes; i++) {
+        if (fwrite(block, 1, used, file) != used) {
+            perror("Failed to write benchmark file");
+            fclose(file);
+            return -1;
+        }
+    }
+    fclose(file);
+    return 0;
+}
+
+static void drop_cache(void) {
+    int fd = open(BENCH_FILE, O_RDONLY);
+    if (fd < 0) return;
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+static size_t count_newlines(const char* data, size_t size) {
+    size_t lines = 0;
+    const char* end = data + size;
+    for (const char* p = data; (p = memchr(p, '\n', (size_t)(end - p))) != NULL; p++) {
+        lines++;
+    }
+    return lines;
+}
+
+static size_t lines_fgetc(size_t* bytes) {
+    FILE* file = fopen(BENCH_FILE, "rb");
+    if (file == NULL) return 0;
+
+    size_t lines = 0;
+    int ch;
+    while ((ch = fgetc(file)) != EOF) {
+        (*bytes)++;
+        if (ch == '\n') lines++;
+    }
+    fclose(file);
+    return lines;
+}
+
+static size_t lines_fgets(size_t* bytes) {
+    FILE* file = fopen(BENCH_FILE, "rb");
+    if (file == NULL) return 0;
+
+    char line[4096];
+    size_t lines = 0;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        size_t length = strlen(line);
+        *bytes += length;
+        if (length > 0 && line[length - 1] == '\n') lines++;
+    }
+    fclose(file);
+    return lines;
+}
+
+static size_t lines_fread_whole(size_t* bytes) {
+    FILE* file = fopen(BENCH_FILE, "rb");
+    if (file == NULL) return 0;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    rewind(file);
+
+    char* content = malloc((size_t)size);
+    if (content == NULL) {
+        fclose(file);
+        return 0;
+    }
+    *bytes = fread(content, 1, (size_t)size, file);
+    size_t lines = count_newlines(content, *bytes);
+
+    free(content);
+    fclose(file);
+    return lines;
+}
+
+static size_t lines_mmap(size_t* bytes) {
+    MappedFile mapped;
+    if (mapped_file_open(&mapped, BENCH_FILE, MAPPED_FILE_SEQUENTIAL) != 0) return 0;
+
+    *bytes = mapped.size;
+    size_t lines = count_newlines(mapped.data, mapped.size);
+    mapped_file_close(&mapped);
+    return lines;
+}
+
+static void run(const char* label, size_t (*method)(size_t*), int cold) {
+    if (cold) drop_cache();
+
+    size_t bytes = 0;
+    bench_timer_start(&timer);
+    size_t lines = method(&bytes);
+    double elapsed = bench_timer_stop(&timer);
+
+    char counts[BENCH_COUNTS_TEXT_SIZE];
+    printf("  %-22s %12zu lines  %8.3f s  %9.1f MB/s%s\n", label, lines, elapsed,
+           bytes / elapsed / (1024.0 * 1024.0),
+           bench_counts_text(&timer.counts, counts, sizeof(counts)));
+}
+
+int main(int argc, char* argv[]) {
+    size_t megabytes = 1024;
+    int cold = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--cold") == 0) {
+            cold = 1;
+        } else if (atol(argv[i]) > 0) {
+            megabytes = (size_t)atol(argv[i]);
+        } else {
+            fprintf(stderr, "Usage: %s [megabytes] [--cold]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    bench_timer_open(&timer);
+    printf("Read benchmark: %zu MB file, %s page cache\n", megabytes, cold ? "cold" : "warm");
+    bench_timer_print_status(&timer, stdout);
+    if (generate_file(megabytes) != 0) return 1;
+
+    // Warm the page cache (or make sure it's empty) before the first run
+    size_t bytes = 0;
+    if (!cold) lines_mmap(&bytes);
+
+    printf("Results:\n");
+    run("fgetc (per char)", lines_fgetc, cold);
+    run("fgets (per line)", lines_fgets, cold);
+    run("fread (whole file)", lines_fread_whole, cold);
+    run("mmap (mapped_file)", lines_mmap, cold);
+
+    remove(BENCH_FILE);
+    bench_timer_close(&timer);
+    return 0;
+}
@@ -0,0 +1,229 @@
+/*
+ * bench_records.c - Raw struct fwrite vs. the portable record serializer
+ *
+ * Writes and reads back the same Employee records (default 5M) as:
+ * - raw structs: one fwrite()/fread() of the whole array (padding and
+ *   host byte order included - fast, but not portable)
+ * - per field: htonl()/htons() and one fwrite() per field, the way
+ *   demonstrate_endianness_handling() converts values
+ * - RecordStream, little-endian wire order (no swapping on x86/ARM)
+ * - RecordStream, big-endian wire order, SSSE3 and portable swapping
+ *
+ * Files are written to the page cache, so the numbers show the CPU cost
+ * of each approach. A second table times just the conversion, on a batch
+ * that stays in cache. A round trip's counts are the write's and the
+ * read's together.
+ *
+ * Usage: ./bench_records [records]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_harness.h"
+#include "record_codec.h"
+
+static const char* BENCH_FILE = "bench_records.bin";
+
+static BenchTimer timer;
+
+// One round trip; the read's counts are the timer's
+static void report(const char* label, double write_seconds, const PerfSample* write_counts,
+                   double read_seconds, size_t count, int ok) {
+    PerfSample round_trip = timer.counts;
+    perf_sample_add(&round_trip, write_counts);
+
+    char counts[BENCH_COUNTS_TEXT_SIZE];
+    printf("  %-32s write %7.1f M rec/s   read %7.1f M rec/s  %s%s\n", label,
+           count / write_seconds / 1e6, count / read_seconds / 1e6, ok ? "✓" : "✗ MISMATCH",
+           bench_counts_text(&round_trip, counts, sizeof(counts)));
+}
+
+static int same_records(const Employee* a, const Employee* b, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (a[i].id != b[i].id || a[i].salary != b[i].salary ||
+            a[i].department_id != b[i].department_id || a[i].active != b[i].active ||
+            memcmp(a[i].name, b[i].name, sizeof(a[i].name)) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void bench_raw(const Employee* records, Employee* copy, size_t count) {
+    remove(BENCH_FILE);
+    bench_timer_start(&timer);
+    FILE* file = fopen(BENCH_FILE, "wb");
+    if (file == NULL) return;
+    fwrite(records, sizeof(Employee), count, file);
+    fclose(file);
+    double write_seconds = bench_timer_stop(&timer);
+    PerfSample write_counts = timer.counts;
+
+    bench_timer_start(&timer);
+    file = fopen(BENCH_FILE, "rb");
+    if (file == NULL) return;
+    size_t got = fread(copy, sizeof(Employee), count, file);
+    fclose(file);
+    double read_seconds = bench_timer_stop(&timer);
+
+    report("raw structs (fwrite)", write_seconds, &write_counts, read_seconds, count,
+           got == count && same_records(records, copy, count));
+}
+
+static void bench_per_field(const Employee* records, Employee* copy, size_t count) {
+    remove(BENCH_FILE);
+    bench_timer_start(&timer);
+    FILE* file = fopen(BENCH_FILE, "wb");
+    if (file == NULL) return;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t id = htonl(records[i].id);
+        uint64_t salary;
+        memcpy(&salary, &records[i].salary, sizeof(salary));
+        uint32_t salary_high = htonl((uint32_t)(salary >> 32));
+        uint32_t salary_low = htonl((uint32_t)salary);
+        uint16_t department = htons(records[i].department_id);
+        fwrite(&id, sizeof(id), 1, file);
+        fwrite(records[i].name, sizeof(records[i].name), 1, file);
+        fwrite(&salary_high, sizeof(salary_high), 1, file);
+        fwrite(&salary_low, sizeof(salary_low), 1, file);
+        fwrite(&department, sizeof(department), 1, file);
+        fwrite(&records[i].active, 1, 1, file);
+    }
+    fclose(file);
+    double write_seconds = bench_timer_stop(&timer);
+    PerfSample write_counts = timer.counts;
+
+    bench_timer_start(&timer);
+    file = fopen(BENCH_FILE, "rb");
+    if (file == NULL) return;
+    size_t got = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t id, salary_high, salary_low;
+        uint16_t department;
+        Employee* record = &copy[i];
+        if (fread(&id, sizeof(id), 1, file) != 1 ||
+            fread(record->name, sizeof(record->name), 1, file) != 1 ||
+            fread(&salary_high, sizeof(salary_high), 1, file) != 1 ||
+            fread(&salary_low, sizeof(salary_low), 1, file) != 1 ||
+            fread(&department, sizeof(department), 1, file) != 1 ||
+            fread(&record->active, 1, 1, file) != 1) {
+            break;
+        }
+        uint64_t salary = (uint64_t)ntohl(salary_high) << 32 | ntohl(salary_low);
+        record->id = ntohl(id);
+        memcpy(&record->salary, &salary, sizeof(salary));
+        record->department_id = ntohs(department);
+        got++;
+    }
+    fclose(file);
+    double read_seconds = bench_timer_stop(&timer);
+
+    report("per field (htonl + fwrite)", write_seconds, &write_counts, read_seconds, count,
+           got == count && same_records(records, copy, count));
+}
+
+static void bench_stream(const char* label, RecordByteOrder order,
+                         const Employee* records, Employee* copy, size_t count) {
+    RecordStream stream;
+    remove(BENCH_FILE);
+    bench_timer_start(&timer);
+    FILE* file = fopen(BENCH_FILE, "wb");
+    if (file == NULL || record_stream_init(&stream, file, order) != 0) return;
+    record_write_employees(&stream, records, count);
+    record_stream_flush(&stream);
+    record_stream_free(&stream);
+    fclose(file);
+    double write_seconds = bench_timer_stop(&timer);
+    PerfSample write_counts = timer.counts;
+
+    bench_timer_start(&timer);
+    file = fopen(BENCH_FILE, "rb");
+    if (file == NULL || record_stream_init(&stream, file, order) != 0) return;
+    size_t got = record_read_employees(&stream, copy, count);
+    record_stream_free(&stream);
+    fclose(file);
+    double read_seconds = bench_timer_stop(&timer);
+
+    report(label, write_seconds, &write_counts, read_seconds, count,
+           got == count && same_records(records, copy, count));
+}
+
+// Conversion only: encode and decode the same cache-sized batch over and
+// over, so memory bandwidth doesn't hide the cost of the conversion
+static void bench_convert(const char* label, RecordByteOrder order,
+                          const Employee* records, size_t count) {
+    enum { BATCH = 512 };
+    static unsigned char wire[BATCH * EMPLOYEE_WIRE_SIZE];
+    static Employee decoded[BATCH];
+    size_t n = count < BATCH ? count : BATCH;
+
+    bench_timer_start(&timer);
+    for (size_t done = 0; done < count; done += n) {
+        record_encode_employees(wire, records, n, order);
+        record_decode_employees(decoded, wire, n, order);
+    }
+    double seconds = bench_timer_stop(&timer);
+
+    char counts[BENCH_COUNTS_TEXT_SIZE];
+    printf("  %-32s %7.1f M rec/s  %s%s\n", label, count / seconds / 1e6,
+           same_records(records, decoded, n) ? "✓" : "✗ MISMATCH",
+           bench_counts_text(&timer.counts, counts, sizeof(counts)));
+}
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? (size_t)atol(argv[1]) : 5000000;
+    if (count == 0) {
+        fprintf(stderr, "Usage: %s [records]\n", argv[0]);
+        return 1;
+    }
+
+    Employee* records = calloc(count, sizeof(Employee));
+    Employee* copy = calloc(count, sizeof(Employee));
+    if (records == NULL || copy == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    for (size_t i = 0; i < count; i++) {
+        records[i].id = (uint32_t)(1000 + i);
+        snprintf(records[i].name, sizeof(records[i].name), "Employee %zu", i);
+        records[i].salary = 40000.0 + (double)(i % 60000);
+        records[i].department_id = (uint16_t)(100 + i % 12);
+        records[i].active = (uint8_t)(i % 7 != 0);
+    }
+
+    // Touch the destination once so page faults don't count against the first method
+    memset(copy, 0, count * sizeof(Employee));
+
+    bench_timer_open(&timer);
+    printf("Record serialization benchmark: %zu employees (%zu bytes in memory, %d on the wire)\n",
+           count, sizeof(Employee), EMPLOYEE_WIRE_SIZE);
+    bench_timer_print_status(&timer, stdout);
+    printf("File round trip:\n");
+    bench_raw(records, copy, count);
+    bench_per_field(records, copy, count);
+    bench_stream("RecordStream little-endian", RECORD_LITTLE_ENDIAN, records, copy, count);
+    if (record_codec_set_simd(1)) {
+        bench_stream("RecordStream big-endian SSSE3", RECORD_BIG_ENDIAN, records, copy, count);
+    }
+    record_codec_set_simd(0);
+    bench_stream("RecordStream big-endian portable", RECORD_BIG_ENDIAN, records, copy, count);
+
+    printf("Encode + decode in memory:\n");
+    bench_convert("little-endian", RECORD_LITTLE_ENDIAN, records, count);
+    if (record_codec_set_simd(1)) {
+        bench_convert("big-endian SSSE3", RECORD_BIG_ENDIAN, records, count);
+    }
+    record_codec_set_simd(0);
+    bench_convert("big-endian portable", RECORD_BIG_ENDIAN, records, count);
+
+    remove(BENCH_FILE);
+    free(records);
+    free(copy);
+    bench_timer_close(&timer);
+    return 0;
+}
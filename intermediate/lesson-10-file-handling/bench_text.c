@@ -0,0 +1,145 @@
+/*
+ * bench_text.c - Throughput of the text statistics engine
+ *
+ * Generates an English-like text file (default 1 GB) and counts lines,
+ * words and letter frequencies:
+ * - fgetc() + isspace() + isalpha() per character (the original demo)
+ * - text_stats_file() with the portable kernel, 1 thread
+ * - text_stats_file() with the AVX2 kernel, 1 thread and all CPUs
+ * - lines and words only (what `wc -lw` does), AVX2, 1 thread
+ *
+ * Usage: ./bench_text [megabytes]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench_harness.h"
+#include "text_stats.h"
+
+static const char* BENCH_FILE = "bench_text.txt";
+
+static BenchTimer timer;
+
+static int generate_file(size_t megabytes) {
+    static const char* words[] = {
+        "the", "quick", "brown", "fox", "jumps", "over", "lazy", "dog", "File", "processing",
+        "in", "C", "requires", "careful", "memory", "management.", "Unlike", "JavaScript,",
+        "parsing", "gives", "you", "complete", "control", "with", "proper", "buffers"
+    };
+    FILE* file = fopen(BENCH_FILE, "wb");
+    if (file == NULL) {
+        perror("Failed to create benchmark file");
+        return -1;
+    }
+
+    // Build one megabyte of text, then write it repeatedly
+    static char block[1024 * 1024];
+    size_t used = 0;
+    for (unsigned long i = 0; ; i++) {
+        const char* word = words[(i * 7 + i / 26) % 26];
+        size_t length = strlen(word);
+        if (used + length + 1 > sizeof(block)) break;
+        memcpy(block + used, word, length);
+        used += length;
+        block[used++] = (i % 11 == 10) ? '\n' : ' ';
+    }
+
+    for (size_t i = 0; i < megabytes; i++) {
+        if (fwrite(block, 1, used, file) != used) {
+            perror("Failed to write benchmark file");
+            fclose(file);
+            return -1;
+        }
+    }
+    fclose(file);
+    return 0;
+}
+
+static int stats_fgetc(TextStats* stats) {
+    FILE* file = fopen(BENCH_FILE, "rb");
+    if (file == NULL) return -1;
+
+    memset(stats, 0, sizeof(*stats));
+    int in_word = 0;
+    int ch;
+    while ((ch = fgetc(file)) != EOF) {
+        stats->bytes++;
+        if (ch == '\n') stats->lines++;
+        if (isspace(ch)) {
+            in_word = 0;
+        } else {
+            if (!in_word) stats->words++;
+            in_word = 1;
+            if (isalpha(ch)) stats->letters[tolower(ch) - 'a']++;
+        }
+    }
+    fclose(file);
+    return 0;
+}
+
+// One result line, with the counts of the last bench_timer_stop()
+static void report(const char* label, double seconds, const TextStats* stats) {
+    char counts[BENCH_COUNTS_TEXT_SIZE];
+    printf("  %-26s %8.3f s  %8.2f GB/s  (%llu lines, %llu words, %llu e's)%s\n", label,
+           seconds, stats->bytes / seconds / 1e9, (unsigned long long)stats->lines,
+           (unsigned long long)stats->words, (unsigned long long)stats->letters['e' - 'a'],
+           bench_counts_text(&timer.counts, counts, sizeof(counts)));
+}
+
+static void run_engine(const char* label, int simd, int threads, unsigned flags) {
+    if (simd && !text_stats_set_simd(1)) return;
+    if (!simd) text_stats_set_simd(0);
+
+    TextStats stats;
+    bench_timer_start(&timer);
+    if (text_stats_file(BENCH_FILE, threads, flags, &stats) != 0) {
+        perror("text_stats_file");
+        return;
+    }
+    report(label, bench_timer_stop(&timer), &stats);
+}
+
+int main(int argc, char* argv[]) {
+    size_t megabytes = argc > 1 ? (size_t)atol(argv[1]) : 1024;
+    if (megabytes == 0) {
+        fprintf(stderr, "Usage: %s [megabytes]\n", argv[0]);
+        return 1;
+    }
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = cpus > 0 ? (int)cpus : 1;
+
+    bench_timer_open(&timer);
+    printf("Text statistics benchmark: %zu MB, %d CPUs\n", megabytes, threads);
+    bench_timer_print_status(&timer, stdout);
+    if (generate_file(megabytes) != 0) return 1;
+
+    // Warm the page cache so every run measures counting, not the disk
+    TextStats stats;
+    text_stats_file(BENCH_FILE, threads, 0, &stats);
+
+    printf("Results:\n");
+    bench_timer_start(&timer);
+    int fgetc_status = stats_fgetc(&stats);
+    double fgetc_seconds = bench_timer_stop(&timer);
+    if (fgetc_status == 0) report("fgetc + isspace/isalpha", fgetc_seconds, &stats);
+
+    run_engine("blocks, portable, 1 thread", 0, 1, TEXT_STATS_LETTERS);
+    run_engine("blocks, AVX2, 1 thread", 1, 1, TEXT_STATS_LETTERS);
+
+    char label[64];
+    snprintf(label, sizeof(label), "blocks, AVX2, %d threads", threads);
+    if (threads > 1) run_engine(label, 1, threads, TEXT_STATS_LETTERS);
+
+    run_engine("lines+words only, AVX2", 1, 1, 0);
+
+    remove(BENCH_FILE);
+    bench_timer_close(&timer);
+    return 0;
+}
@@ -6,33 +6,31 @@
  * - Structure serialization to files
  * - Endianness and portability concerns
  * - Performance implications of binary I/O
+ * - A versioned columnar file format that can be read via mmap
+ * - Block compression of both formats (block_file.h)
+ * - Bit-packed, delta, varint and run-length integer columns (int_codec.h)
  * 
  * For frontend developers: Unlike JavaScript's automatic JSON serialization,
  * C requires manual binary data layout and endianness handling.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdint.h>
 #include <time.h>
 #include <sys/stat.h>
+#include <arpa/inet.h>
 
-// Define structures for binary serialization
-typedef struct {
-    uint32_t id;
-    char name[50];
-    double salary;
-    uint16_t department_id;
-    uint8_t active;
-} Employee;
-
-typedef struct {
-    uint16_t department_id;
-    char department_name[30];
-    uint32_t budget;
-} Department;
+#include "block_file.h"
+#include "checksum.h"
+#include "column_file.h"
+#include "record_codec.h"
 
+// Employee and Department (the structures we serialize) live in record_codec.h
 typedef struct {
     char magic[4];        // File format identifier
     uint16_t version;     // File format version
@@ -45,8 +43,8 @@ void demonstrate_binary_vs_text(void);
 void demonstrate_structure_serialization(void);
 void demonstrate_endianness_handling(void);
 void demonstrate_binary_file_format(void);
+void demonstrate_columnar_file_format(void);
 void demonstrate_performance_comparison(void);
-uint32_t calculate_checksum(const void* data, size_t size);
 void show_binary_data_layout(const void* data, size_t size, const char* description);
 
 void demonstrate_binary_vs_text(void) {
@@ -147,24 +145,42 @@ void demonstrate_structure_serialization(void) {
     printf("  salary offset: %zu\n", offsetof(Employee, salary));
     printf("  department_id offset: %zu\n", offsetof(Employee, department_id));
     printf("  active offset: %zu\n", offsetof(Employee, active));
+    printf("  Padding: %zu bytes - fwrite() of the struct would store them too\n",
+           sizeof(Employee) - EMPLOYEE_WIRE_SIZE);
+    printf("Wire layout: %d bytes per employee, %d per department, little-endian\n",
+           EMPLOYEE_WIRE_SIZE, DEPARTMENT_WIRE_SIZE);
     
-    // Write structures to binary file
+    // Write structures in the portable wire format
     FILE* file = fopen("company_data.bin", "wb");
     if (file == NULL) {
         perror("Failed to create company data file");
         return;
     }
     
-    // Write employee count and data
-    fwrite(&emp_count, sizeof(int), 1, file);
-    fwrite(employees, sizeof(Employee), emp_count, file);
+    RecordStream stream;
+    if (record_stream_init(&stream, file, RECORD_LITTLE_ENDIAN) != 0) {
+        fprintf(stderr, "Out of memory\n");
+        fclose(file);
+        return;
+    }
     
-    // Write department count and data
-    fwrite(&dept_count, sizeof(int), 1, file);
-    fwrite(departments, sizeof(Department), dept_count, file);
+    // Counts and records are encoded into one buffer: a single fwrite()
+    int write_failed = record_write_u32(&stream, (uint32_t)emp_count) != 0 ||
+                       record_write_employees(&stream, employees, (size_t)emp_count) != 0 ||
+                       record_write_u32(&stream, (uint32_t)dept_count) != 0 ||
+                       record_write_departments(&stream, departments, (size_t)dept_count) != 0 ||
+                       record_stream_flush(&stream) != 0;
+    record_stream_free(&stream);
+    if (fclose(file) != 0 || write_failed) {
+        perror("Failed to write company data file");
+        return;
+    }
     
-    fclose(file);
-    printf("Data serialized to company_data.bin\n");
+    struct stat info;
+    stat("company_data.bin", &info);
+    printf("Data serialized to company_data.bin (%lld bytes, raw structs would be %zu)\n",
+           (long long)info.st_size,
+           2 * sizeof(int) + emp_count * sizeof(Employee) + dept_count * sizeof(Department));
     
     // Read back and verify
     file = fopen("company_data.bin", "rb");
@@ -172,37 +188,89 @@ void demonstrate_structure_serialization(void) {
         perror("Failed to open company data file");
         return;
     }
+    if (record_stream_init(&stream, file, RECORD_LITTLE_ENDIAN) != 0) {
+        fprintf(stderr, "Out of memory\n");
+        fclose(file);
+        return;
+    }
     
     // Read employee data
-    int read_emp_count;
-    fread(&read_emp_count, sizeof(int), 1, file);
-    printf("\nReading back %d employees:\n", read_emp_count);
+    uint32_t read_emp_count = 0;
+    record_read_u32(&stream, &read_emp_count);
+    printf("\nReading back %u employees:\n", read_emp_count);
     
     Employee* read_employees = malloc(read_emp_count * sizeof(Employee));
-    fread(read_employees, sizeof(Employee), read_emp_count, file);
+    read_emp_count = (uint32_t)record_read_employees(&stream, read_employees, read_emp_count);
     
-    for (int i = 0; i < read_emp_count; i++) {
-        printf("  Employee %d: ID=%u, Name=\"%s\", Salary=$%.2f, Dept=%u, Active=%s\n",
+    for (uint32_t i = 0; i < read_emp_count; i++) {
+        printf("  Employee %u: ID=%u, Name=\"%s\", Salary=$%.2f, Dept=%u, Active=%s\n",
                i + 1, read_employees[i].id, read_employees[i].name,
                read_employees[i].salary, read_employees[i].department_id,
                read_employees[i].active ? "Yes" : "No");
     }
     
     // Read department data
-    int read_dept_count;
-    fread(&read_dept_count, sizeof(int), 1, file);
-    printf("\nReading back %d departments:\n", read_dept_count);
+    uint32_t read_dept_count = 0;
+    record_read_u32(&stream, &read_dept_count);
+    printf("\nReading back %u departments:\n", read_dept_count);
     
     Department* read_departments = malloc(read_dept_count * sizeof(Department));
-    fread(read_departments, sizeof(Department), read_dept_count, file);
+    read_dept_count = (uint32_t)record_read_departments(&stream, read_departments, read_dept_count);
     
-    for (int i = 0; i < read_dept_count; i++) {
-        printf("  Department %d: ID=%u, Name=\"%s\", Budget=$%u\n",
+    for (uint32_t i = 0; i < read_dept_count; i++) {
+        printf("  Department %u: ID=%u, Name=\"%s\", Budget=$%u\n",
                i + 1, read_departments[i].department_id,
                read_departments[i].department_name, read_departments[i].budget);
     }
     
+    record_stream_free(&stream);
     fclose(file);
+
+    // The same stream again, compressed in 64 KB blocks on the way out
+    BlockWriter blocks;
+    if (block_writer_open(&blocks, "company_data_lz.bin") != 0 ||
+        record_stream_init_block_writer(&stream, &blocks, RECORD_LITTLE_ENDIAN) != 0) {
+        perror("Failed to create compressed company data file");
+        free(read_employees);
+        free(read_departments);
+        return;
+    }
+    write_failed = record_write_u32(&stream, (uint32_t)emp_count) != 0 ||
+                   record_write_employees(&stream, employees, (size_t)emp_count) != 0 ||
+                   record_write_u32(&stream, (uint32_t)dept_count) != 0 ||
+                   record_write_departments(&stream, departments, (size_t)dept_count) != 0 ||
+                   record_stream_flush(&stream) != 0;
+    record_stream_free(&stream);
+    if (block_writer_close(&blocks) != 0 || write_failed) {
+        perror("Failed to write compressed company data file");
+        free(read_employees);
+        free(read_departments);
+        return;
+    }
+
+    BlockFile compressed;
+    if (block_file_open(&compressed, "company_data_lz.bin") != 0 ||
+        record_stream_init_block_reader(&stream, &compressed, RECORD_LITTLE_ENDIAN) != 0) {
+        perror("Failed to open compressed company data file");
+        free(read_employees);
+        free(read_departments);
+        return;
+    }
+    uint32_t count = 0;
+    int same = record_read_u32(&stream, &count) == 1 && count == read_emp_count;
+    for (uint32_t i = 0; same && i < count; i++) {
+        Employee employee;
+        same = record_read_employees(&stream, &employee, 1) == 1 &&
+               employee.id == read_employees[i].id &&
+               strcmp(employee.name, read_employees[i].name) == 0 &&
+               employee.salary == read_employees[i].salary;
+    }
+    printf("\nCompressed copy company_data_lz.bin: %zu bytes in %zu block(s) for %llu raw, "
+           "read back %s\n", compressed.file.size, compressed.block_count,
+           (unsigned long long)compressed.raw_size, same ? "✓" : "✗");
+    record_stream_free(&stream);
+    block_file_close(&compressed);
+
     free(read_employees);
     free(read_departments);
     printf("\n");
@@ -277,6 +345,15 @@ void demonstrate_endianness_handling(void) {
         
         fclose(file);
     }
+    
+    // Converting a value at a time doesn't scale to millions of records:
+    // record_encode_employees() converts a whole batch (SSSE3 shuffles when
+    // bytes must be swapped, plain copies when they don't)
+    Employee sample = {0x12345678, "Dana", 1.5, 0x1234, 1};
+    unsigned char wire[EMPLOYEE_WIRE_SIZE];
+    record_encode_employees(wire, &sample, 1, RECORD_BIG_ENDIAN);
+    printf("\nBatch conversion (%s):\n", record_codec_backend_name());
+    show_binary_data_layout(wire, sizeof(wire), "  Employee id=0x12345678, big-endian wire format");
     printf("\n");
 }
 
@@ -301,7 +378,9 @@ void demonstrate_binary_file_format(void) {
     memcpy(header.magic, "MYFT", 4);  // Magic number
     header.version = htons(1);        // Version 1
     header.record_count = htonl(data_count);
-    header.checksum = htonl(calculate_checksum(data, sizeof(data)));
+    // Version 1 is defined with the legacy shift-xor checksum; version 2
+    // records a stronger one in its header (see column_file.h)
+    header.checksum = htonl(checksum_legacy(data, sizeof(data)));
     
     printf("Writing file header:\n");
     printf("  Magic: %.4s\n", header.magic);
@@ -362,7 +441,7 @@ void demonstrate_binary_file_format(void) {
     }
     
     // Verify checksum
-    uint32_t calculated_checksum = calculate_checksum(read_data, record_count * sizeof(uint32_t));
+    uint32_t calculated_checksum = checksum_legacy(read_data, record_count * sizeof(uint32_t));
     printf("  Calculated checksum: 0x%08X %s\n", calculated_checksum,
            (calculated_checksum == stored_checksum) ? "✓" : "✗");
     
@@ -374,58 +453,264 @@ void demonstrate_binary_file_format(void) {
     
     fclose(file);
     free(read_data);
+
+    // The version 2 reader still understands version 1 files
+    ColumnFile legacy;
+    if (column_file_open(&legacy, filename) == 0) {
+        printf("\nOpened with column_file_open(): version %d, %llu rows, column \"%s\", "
+               "%s checksum %s\n",
+               legacy.version, (unsigned long long)legacy.row_count, legacy.columns[0].name,
+               checksum_name(legacy.checksum_type),
+               column_file_verify(&legacy) == 0 ? "✓" : "✗");
+        column_file_close(&legacy);
+    } else {
+        perror("Failed to open version 1 file with column_file_open");
+    }
     printf("\n");
 }
 
+void demonstrate_columnar_file_format(void) {
+    printf("=== Columnar Binary File Format (MYFT version 2) ===\n");
+
+    const char* filename = "custom_format_v2.dat";
+    const size_t rows = 10000;
+    const uint32_t rows_per_chunk = 1000;
+
+    int32_t* ids = malloc(rows * sizeof(int32_t));
+    int32_t* ages = malloc(rows * sizeof(int32_t));
+    double* salaries = malloc(rows * sizeof(double));
+    if (ids == NULL || ages == NULL || salaries == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        free(ids);
+        free(ages);
+        free(salaries);
+        return;
+    }
+
+    for (size_t i = 0; i < rows; i++) {
+        ids[i] = 1000 + (int32_t)i;                 // Sorted: chunks have tight ranges
+        ages[i] = 22 + (int32_t)(i * 7 % 43);
+        salaries[i] = 40000.0 + (double)(i * 37 % 80000);
+    }
+
+    // Write: one bulk write per column chunk, no per-record conversion
+    ColumnSpec schema[] = {
+        {"id", COLUMN_INT32},
+        {"age", COLUMN_INT32},
+        {"salary", COLUMN_FLOAT64}
+    };
+    const void* columns[] = {ids, ages, salaries};
+
+    ColumnWriter writer;
+    if (column_writer_open(&writer, filename, schema, 3, rows_per_chunk) != 0 ||
+        column_writer_append(&writer, columns, rows) != 0 ||
+        column_writer_close(&writer) != 0) {
+        perror("Failed to write columnar file");
+        free(ids);
+        free(ages);
+        free(salaries);
+        return;
+    }
+
+    struct stat info;
+    stat(filename, &info);
+    printf("Wrote %zu rows x 3 columns in chunks of %u rows (%lld bytes)\n",
+           rows, rows_per_chunk, (long long)info.st_size);
+
+    // Read: map the file, the footer index says where everything is
+    ColumnFile file;
+    if (column_file_open(&file, filename) != 0) {
+        perror("Failed to open columnar file");
+        free(ids);
+        free(ages);
+        free(salaries);
+        return;
+    }
+
+    printf("Version %d, %llu rows, %zu chunks per column\n",
+           file.version, (unsigned long long)file.row_count, file.chunk_count);
+    for (size_t c = 0; c < file.column_count; c++) {
+        const ColumnInfo* column = &file.columns[c];
+        if (column->type == COLUMN_FLOAT64) {
+            printf("  %-8s float64  min %.2f  max %.2f\n", column->name, column->min.f, column->max.f);
+        } else {
+            printf("  %-8s int%-2d    min %lld  max %lld\n", column->name,
+                   column->type == COLUMN_INT32 ? 32 : 64,
+                   (long long)column->min.i, (long long)column->max.i);
+        }
+    }
+
+    size_t bad_chunks = column_file_verify(&file);
+    printf("Checksums: %s (%s), %zu chunks verified %s\n",
+           checksum_name(file.checksum_type), checksum_backend_name(),
+           file.chunk_count * file.column_count - bad_chunks, bad_chunks == 0 ? "✓" : "✗");
+
+    // Chunk data is used in place: a pointer into the mapped file
+    const ColumnChunk* first = column_file_chunk(&file, 0, 0);
+    printf("Chunk 0 of \"id\" at file offset %td (64-byte aligned: %s)\n",
+           (const char*)first->data - file.file.data,
+           ((uintptr_t)first->data % COLUMN_FILE_ALIGNMENT == 0) ? "✓" : "✗");
+
+    // Predicate: 5500 <= id <= 5700. Only chunks whose min/max overlap
+    // the range are read; the rest are skipped without touching them.
+    ColumnPredicate predicate = {0, {0}, {0}};
+    predicate.column = (size_t)column_file_find(&file, "id");
+    predicate.low.i = 5500;
+    predicate.high.i = 5700;
+    int age_column = column_file_find(&file, "age");
+
+    size_t matches = 0, chunks_read = 0;
+    long long age_total = 0;
+    for (size_t k = column_file_next_chunk(&file, &predicate, 0); k < file.chunk_count;
+         k = column_file_next_chunk(&file, &predicate, k + 1)) {
+        const ColumnChunk* id_chunk = column_file_chunk(&file, predicate.column, k);
+        const int32_t* id_values = id_chunk->data;
+        const int32_t* age_values = column_file_chunk(&file, (size_t)age_column, k)->data;
+        chunks_read++;
+        for (uint32_t i = 0; i < id_chunk->rows; i++) {
+            if (id_values[i] >= predicate.low.i && id_values[i] <= predicate.high.i) {
+                matches++;
+                age_total += age_values[i];
+            }
+        }
+    }
+
+    printf("Query 5500 <= id <= 5700: %zu rows, average age %.1f\n",
+           matches, matches ? (double)age_total / matches : 0.0);
+    printf("  Read %zu of %zu chunks, skipped %zu using min/max statistics\n",
+           chunks_read, file.chunk_count, file.chunk_count - chunks_read);
+
+    column_file_close(&file);
+
+    // Compressed: written through a temporary file into a MYBZ container,
+    // which column_file_open() recognizes and decompresses in parallel
+    const char* compressed_name = "custom_format_v2_lz.dat";
+    ColumnFile compressed;
+    if (column_writer_open(&writer, compressed_name, schema, 3, rows_per_chunk) != 0 ||
+        column_writer_set_compression(&writer, 1) != 0 ||
+        column_writer_append(&writer, columns, rows) != 0 ||
+        column_writer_close(&writer) != 0 ||
+        column_file_open(&compressed, compressed_name) != 0) {
+        perror("Failed to write compressed columnar file");
+        free(ids);
+        free(ages);
+        free(salaries);
+        return;
+    }
+    printf("Compressed copy %s: %llu bytes (%.0f%% of %zu), %llu rows, checksums %s\n",
+           compressed_name, (unsigned long long)compressed.stored_size,
+           100.0 * (double)compressed.stored_size / (double)compressed.file.size,
+           compressed.file.size, (unsigned long long)compressed.row_count,
+           column_file_verify(&compressed) == 0 ? "✓" : "✗");
+    column_file_close(&compressed);
+
+    // Encoded: each integer chunk in whichever of FOR / delta / varint /
+    // RLE bit-packing is smallest for it, decoded at open
+    const char* encoded_name = "custom_format_v2_enc.dat";
+    ColumnFile encoded;
+    if (column_writer_open(&writer, encoded_name, schema, 3, rows_per_chunk) != 0 ||
+        column_writer_set_encoding(&writer, 1) != 0 ||
+        column_writer_append(&writer, columns, rows) != 0 ||
+        column_writer_close(&writer) != 0 ||
+        column_file_open(&encoded, encoded_name) != 0) {
+        perror("Failed to write encoded columnar file");
+        free(ids);
+        free(ages);
+        free(salaries);
+        return;
+    }
+    printf("Encoded copy %s: %llu bytes, checksums %s, chunk 0 stored as:\n", encoded_name,
+           (unsigned long long)encoded.stored_size,
+           column_file_verify(&encoded) == 0 ? "✓" : "✗");
+    for (size_t c = 0; c < encoded.column_count; c++) {
+        const ColumnChunk* chunk = column_file_chunk(&encoded, c, 0);
+        printf("  %-8s %-6s %6llu bytes for %u values (%.2f bits each)\n", encoded.columns[c].name,
+               int_encoding_name(chunk->encoding), (unsigned long long)chunk->stored_size,
+               chunk->rows, 8.0 * (double)chunk->stored_size / chunk->rows);
+    }
+    column_file_close(&encoded);
+
+    free(ids);
+    free(ages);
+    free(salaries);
+    printf("\n");
+}
+
+// Wall-clock seconds. clock() counts CPU time, which leaves out the time
+// spent waiting for the disk - the part that matters for I/O.
+static double wall_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int compare_seconds(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void write_strategy(int strategy, const int* data, int count, const char* filename) {
+    FILE* file = fopen(filename, "wb");
+    if (file == NULL) return;
+    
+    if (strategy == 0) {
+        // Individual writes: one fwrite() call per integer
+        for (int i = 0; i < count; i++) {
+            fwrite(&data[i], sizeof(int), 1, file);
+        }
+    } else if (strategy == 1) {
+        // Bulk write: the entire array in one call
+        fwrite(data, sizeof(int), count, file);
+    } else {
+        // Individual writes into a larger custom buffer
+        static char custom_buffer[65536];
+        setvbuf(file, custom_buffer, _IOFBF, sizeof(custom_buffer));
+        for (int i = 0; i < count; i++) {
+            fwrite(&data[i], sizeof(int), 1, file);
+        }
+    }
+    fclose(file);
+}
+
 void demonstrate_performance_comparison(void) {
     printf("=== Performance Comparison ===\n");
     
     const int data_size = 100000;
     int* test_data = malloc(data_size * sizeof(int));
+    if (test_data == NULL) return;
     
     // Initialize test data
     for (int i = 0; i < data_size; i++) {
         test_data[i] = i * i;
     }
     
-    clock_t start, end;
-    
-    // Test 1: Write individual integers (many system calls)
-    start = clock();
-    FILE* file = fopen("perf_individual.bin", "wb");
-    for (int i = 0; i < data_size; i++) {
-        fwrite(&test_data[i], sizeof(int), 1, file);
+    static const char* const names[] = {"Individual writes", "Bulk write", "Buffered writes (64 KB)"};
+    static const char* const files[] = {"perf_individual.bin", "perf_bulk.bin", "perf_buffered.bin"};
+    enum { TRIALS = 7 };
+    double times[3][TRIALS];
+    
+    // One run alone is mostly noise, and a fixed order hands every strategy
+    // the cache state the previous one left behind: repeat each strategy,
+    // start each round with a different one, and compare medians
+    for (int trial = 0; trial < TRIALS; trial++) {
+        for (int k = 0; k < 3; k++) {
+            int strategy = (trial + k) % 3;
+            double start = wall_seconds();
+            write_strategy(strategy, test_data, data_size, files[strategy]);
+            times[strategy][trial] = wall_seconds() - start;
+        }
     }
-    fclose(file);
-    end = clock();
-    double individual_time = ((double)(end - start)) / CLOCKS_PER_SEC;
     
-    // Test 2: Write entire array (single system call)
-    start = clock();
-    file = fopen("perf_bulk.bin", "wb");
-    fwrite(test_data, sizeof(int), data_size, file);
-    fclose(file);
-    end = clock();
-    double bulk_time = ((double)(end - start)) / CLOCKS_PER_SEC;
-    
-    // Test 3: Write with custom buffer
-    start = clock();
-    file = fopen("perf_buffered.bin", "wb");
-    char custom_buffer[8192];
-    setvbuf(file, custom_buffer, _IOFBF, sizeof(custom_buffer));
-    for (int i = 0; i < data_size; i++) {
-        fwrite(&test_data[i], sizeof(int), 1, file);
+    printf("Median wall time of %d runs, %d integers:\n", TRIALS, data_size);
+    double median[3];
+    for (int s = 0; s < 3; s++) {
+        qsort(times[s], TRIALS, sizeof(double), compare_seconds);
+        median[s] = times[s][TRIALS / 2];
+        printf("  %-24s %8.3f ms", names[s], median[s] * 1e3);
+        if (s > 0) printf("  (%.1fx faster)", median[0] / median[s]);
+        printf("\n");
     }
-    fclose(file);
-    end = clock();
-    double buffered_time = ((double)(end - start)) / CLOCKS_PER_SEC;
-    
-    printf("Performance results for %d integers:\n", data_size);
-    printf("  Individual writes: %.4f seconds\n", individual_time);
-    printf("  Bulk write: %.4f seconds (%.1fx faster)\n", 
-           bulk_time, individual_time / bulk_time);
-    printf("  Buffered writes: %.4f seconds (%.1fx faster)\n",
-           buffered_time, individual_time / buffered_time);
+    printf("  (bench_io covers more APIs, file sizes, buffer sizes and fsync)\n");
     
     // Verify file sizes are identical
     struct stat stat1, stat2, stat3;
@@ -446,17 +731,6 @@ void demonstrate_performance_comparison(void) {
     printf("\n");
 }
 
-uint32_t calculate_checksum(const void* data, size_t size) {
-    const unsigned char* bytes = (const unsigned char*)data;
-    uint32_t checksum = 0;
-    
-    for (size_t i = 0; i < size; i++) {
-        checksum = (checksum << 1) ^ bytes[i];
-    }
-    
-    return checksum;
-}
-
 void show_binary_data_layout(const void* data, size_t size, const char* description) {
     const unsigned char* bytes = (const unsigned char*)data;
     
@@ -484,6 +758,7 @@ int main(void) {
     demonstrate_structure_serialization();
     demonstrate_endianness_handling();
     demonstrate_binary_file_format();
+    demonstrate_columnar_file_format();
     demonstrate_performance_comparison();
     
     printf("=== Key Implementation Details ===\n");
@@ -493,13 +768,18 @@ int main(void) {
     printf("4. Binary I/O is faster than text conversion\n");
     printf("5. Custom file formats need headers and validation\n");
     printf("6. Bulk operations are much faster than individual calls\n");
+    printf("7. Columnar, aligned, native-order data can be used straight from mmap\n");
     
     // Cleanup test files
     remove("numbers_text.txt");
     remove("numbers_binary.bin");
     remove("company_data.bin");
+    remove("company_data_lz.bin");
     remove("portable_data.bin");
     remove("custom_format.dat");
+    remove("custom_format_v2.dat");
+    remove("custom_format_v2_lz.dat");
+    remove("custom_format_v2_enc.dat");
     printf("\nTest files cleaned up\n");
     
     return 0;
@@ -0,0 +1,440 @@
+/*
+ * block_file.c - MYBZ block-compressed container
+ *
+ * On-disk layout (all integers little-endian):
+ *
+ *   header (64 bytes)
+ *     0  char[4]  magic "MYBZ"
+ *     4  u16      version (1)
+ *     6  u16      checksum type (ChecksumType, 0 = none)
+ *     8  u32      block size (raw bytes per block, the last may be shorter)
+ *     12 u32      flags (0)
+ *     16 u64      raw size
+ *     24 u64      block count
+ *     32 u64      directory offset
+ *     40 u64      directory size
+ *     48          zero padding
+ *   blocks, back to back
+ *   directory, 24 bytes per block:
+ *     u64 offset, u32 stored size, u32 encoding (BlockEncoding), u64 checksum
+ *   then, if the checksum type isn't 0, a u64 checksum of the directory
+ *
+ * Implementation notes:
+ * - Like column_file.c, the header is written last (after seeking back),
+ *   so an unfinished file has an all-zero header and is rejected; and
+ *   the directory goes after the blocks because the writer doesn't know
+ *   how many there will be until it is closed.
+ * - Whole blocks passed to block_writer_write() are compressed straight
+ *   from the caller's buffer; only a partial block is copied.
+ * - A block is stored raw when LZ doesn't make it smaller, so
+ *   incompressible data costs 24 bytes per 64 KB and no decompression.
+ * - block_file_read_all() gives each thread a contiguous run of blocks.
+ *   Blocks decompress to disjoint parts of the output, so the threads
+ *   share nothing but a failure flag.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "block_file.h"
+#include "lz_codec.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define HEADER_SIZE 64
+#define DIRECTORY_ENTRY_SIZE 24
+#define CHECKSUM_SIZE 8
+#define MAX_THREADS 64
+
+static const unsigned char zero_header[HEADER_SIZE];
+
+static void put_u16(unsigned char* out, uint16_t value) {
+    out[0] = (unsigned char)value;
+    out[1] = (unsigned char)(value >> 8);
+}
+
+static void put_u32(unsigned char* out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out[i] = (unsigned char)(value >> (8 * i));
+}
+
+static void put_u64(unsigned char* out, uint64_t value) {
+    for (int i = 0; i < 8; i++) out[i] = (unsigned char)(value >> (8 * i));
+}
+
+static uint16_t get_u16(const unsigned char* in) {
+    return (uint16_t)(in[0] | in[1] << 8);
+}
+
+static uint32_t get_u32(const unsigned char* in) {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; i--) value = value << 8 | in[i];
+    return value;
+}
+
+static uint64_t get_u64(const unsigned char* in) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--) value = value << 8 | in[i];
+    return value;
+}
+
+// Writer
+
+static int write_bytes(BlockWriter* writer, const void* data, size_t size) {
+    if (size > 0 && fwrite(data, 1, size, writer->file) != size) return -1;
+    writer->offset += size;
+    return 0;
+}
+
+static void writer_release(BlockWriter* writer) {
+    if (writer->file != NULL) fclose(writer->file);
+    free(writer->block);
+    free(writer->compressed);
+    free(writer->directory);
+    memset(writer, 0, sizeof(*writer));
+}
+
+// Compress `size` raw bytes (one block) and write them out
+static int write_block(BlockWriter* writer, const unsigned char* data, size_t size) {
+    if (writer->directory_used + DIRECTORY_ENTRY_SIZE > writer->directory_capacity) {
+        size_t capacity = writer->directory_capacity ? writer->directory_capacity * 2
+                                                     : 256 * DIRECTORY_ENTRY_SIZE;
+        unsigned char* bigger = realloc(writer->directory, capacity);
+        if (bigger == NULL) return -1;
+        writer->directory = bigger;
+        writer->directory_capacity = capacity;
+    }
+
+    // Capacity size - 1: anything that doesn't shrink comes back as 0
+    size_t compressed = size > 1 ? lz_compress(data, size, writer->compressed, size - 1) : 0;
+    BlockEncoding encoding = compressed > 0 ? BLOCK_LZ : BLOCK_STORED;
+    const unsigned char* stored = compressed > 0 ? writer->compressed : data;
+    size_t stored_size = compressed > 0 ? compressed : size;
+
+    unsigned char* entry = writer->directory + writer->directory_used;
+    put_u64(entry, writer->offset);
+    put_u32(entry + 8, (uint32_t)stored_size);
+    put_u32(entry + 12, (uint32_t)encoding);
+    put_u64(entry + 16, checksum_compute(writer->checksum, stored, stored_size));
+    if (write_bytes(writer, stored, stored_size) != 0) return -1;
+
+    writer->directory_used += DIRECTORY_ENTRY_SIZE;
+    writer->raw_size += size;
+    return 0;
+}
+
+int block_writer_open(BlockWriter* writer, const char* filename) {
+    memset(writer, 0, sizeof(*writer));
+    writer->checksum = CHECKSUM_CRC32C;
+    writer->block = malloc(BLOCK_FILE_BLOCK_SIZE);
+    writer->compressed = malloc(lz_compress_bound(BLOCK_FILE_BLOCK_SIZE));
+    if (writer->block == NULL || writer->compressed == NULL) {
+        writer_release(writer);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    writer->file = fopen(filename, "wb");
+    // Placeholder header, rewritten by block_writer_close()
+    if (writer->file == NULL || write_bytes(writer, zero_header, HEADER_SIZE) != 0) {
+        int saved = errno;
+        writer_release(writer);
+        errno = saved;
+        return -1;
+    }
+    return 0;
+}
+
+int block_writer_set_checksum(BlockWriter* writer, ChecksumType type) {
+    if (writer->directory_used > 0 ||
+        (type != CHECKSUM_NONE && type != CHECKSUM_CRC32C && type != CHECKSUM_XXH64)) {
+        errno = EINVAL;
+        return -1;
+    }
+    writer->checksum = type;
+    return 0;
+}
+
+int block_writer_write(BlockWriter* writer, const void* data, size_t size) {
+    const unsigned char* in = data;
+    while (size > 0) {
+        // Whole blocks are compressed from the caller's memory
+        if (writer->block_used == 0 && size >= BLOCK_FILE_BLOCK_SIZE) {
+            if (write_block(writer, in, BLOCK_FILE_BLOCK_SIZE) != 0) return -1;
+            in += BLOCK_FILE_BLOCK_SIZE;
+            size -= BLOCK_FILE_BLOCK_SIZE;
+            continue;
+        }
+
+        size_t space = BLOCK_FILE_BLOCK_SIZE - writer->block_used;
+        size_t n = size < space ? size : space;
+        memcpy(writer->block + writer->block_used, in, n);
+        writer->block_used += n;
+        in += n;
+        size -= n;
+
+        if (writer->block_used == BLOCK_FILE_BLOCK_SIZE) {
+            if (write_block(writer, writer->block, BLOCK_FILE_BLOCK_SIZE) != 0) return -1;
+            writer->block_used = 0;
+        }
+    }
+    return 0;
+}
+
+int block_writer_close(BlockWriter* writer) {
+    int result = -1;
+    if (writer->block_used > 0 && write_block(writer, writer->block, writer->block_used) != 0) {
+        goto done;
+    }
+
+    size_t block_count = writer->directory_used / DIRECTORY_ENTRY_SIZE;
+    uint64_t directory_offset = writer->offset;
+    if (write_bytes(writer, writer->directory, writer->directory_used) != 0) goto done;
+    size_t directory_size = writer->directory_used;
+    if (writer->checksum != CHECKSUM_NONE) {
+        unsigned char checksum[CHECKSUM_SIZE];
+        put_u64(checksum, checksum_compute(writer->checksum, writer->directory,
+                                           writer->directory_used));
+        if (write_bytes(writer, checksum, sizeof(checksum)) != 0) goto done;
+        directory_size += CHECKSUM_SIZE;
+    }
+
+    unsigned char header[HEADER_SIZE] = {0};
+    memcpy(header, BLOCK_FILE_MAGIC, 4);
+    put_u16(header + 4, BLOCK_FILE_VERSION);
+    put_u16(header + 6, (uint16_t)writer->checksum);
+    put_u32(header + 8, BLOCK_FILE_BLOCK_SIZE);
+    put_u64(header + 16, writer->raw_size);
+    put_u64(header + 24, block_count);
+    put_u64(header + 32, directory_offset);
+    put_u64(header + 40, directory_size);
+
+    if (fseek(writer->file, 0, SEEK_SET) != 0 ||
+        fwrite(header, 1, sizeof(header), writer->file) != sizeof(header)) goto done;
+    result = 0;
+
+done:
+    if (fclose(writer->file) != 0) result = -1;
+    writer->file = NULL;
+    writer_release(writer);
+    return result;
+}
+
+// Reader
+
+int block_file_detect(const void* data, size_t size) {
+    return size >= HEADER_SIZE && memcmp(data, BLOCK_FILE_MAGIC, 4) == 0;
+}
+
+static int invalid_file(BlockFile* file) {
+    block_file_close(file);
+    errno = EINVAL;
+    return -1;
+}
+
+int block_file_open(BlockFile* file, const char* filename) {
+    memset(file, 0, sizeof(*file));
+    if (mapped_file_open(&file->file, filename, 0) != 0) return -1;
+
+    const unsigned char* bytes = (const unsigned char*)file->file.data;
+    uint64_t size = file->file.size;
+    if (!block_file_detect(bytes, size)) return invalid_file(file);
+
+    uint16_t checksum_type = get_u16(bytes + 6);
+    uint64_t raw_size = get_u64(bytes + 16);
+    uint64_t block_count = get_u64(bytes + 24);
+    uint64_t directory_offset = get_u64(bytes + 32);
+    uint64_t directory_size = get_u64(bytes + 40);
+    uint64_t checksum_size = checksum_type != CHECKSUM_NONE ? CHECKSUM_SIZE : 0;
+
+    if (get_u16(bytes + 4) != BLOCK_FILE_VERSION || get_u32(bytes + 8) != BLOCK_FILE_BLOCK_SIZE ||
+        get_u32(bytes + 12) != 0 ||
+        (checksum_type != CHECKSUM_NONE && checksum_type != CHECKSUM_CRC32C &&
+         checksum_type != CHECKSUM_XXH64) ||
+        directory_offset < HEADER_SIZE || directory_offset > size ||
+        directory_size > size - directory_offset ||
+        block_count > size / DIRECTORY_ENTRY_SIZE ||
+        directory_size != block_count * DIRECTORY_ENTRY_SIZE + checksum_size ||
+        block_count != raw_size / BLOCK_FILE_BLOCK_SIZE + (raw_size % BLOCK_FILE_BLOCK_SIZE != 0)) {
+        return invalid_file(file);
+    }
+
+    // A damaged directory could point anywhere: check it before using it
+    const unsigned char* directory = bytes + directory_offset;
+    size_t entries_size = (size_t)(block_count * DIRECTORY_ENTRY_SIZE);
+    if (checksum_type != CHECKSUM_NONE &&
+        checksum_compute(checksum_type, directory, entries_size) != get_u64(directory + entries_size)) {
+        return invalid_file(file);
+    }
+
+    file->checksum_type = checksum_type;
+    file->raw_size = raw_size;
+    file->block_count = (size_t)block_count;
+    file->blocks = calloc(file->block_count + 1, sizeof(BlockInfo));
+    if (file->blocks == NULL) {
+        block_file_close(file);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    const unsigned char* entry = directory;
+    for (size_t k = 0; k < file->block_count; k++, entry += DIRECTORY_ENTRY_SIZE) {
+        BlockInfo* block = &file->blocks[k];
+        uint64_t first = (uint64_t)k * BLOCK_FILE_BLOCK_SIZE;
+        block->offset = get_u64(entry);
+        block->stored_size = get_u32(entry + 8);
+        block->raw_size = (uint32_t)(raw_size - first < BLOCK_FILE_BLOCK_SIZE ? raw_size - first
+                                                                               : BLOCK_FILE_BLOCK_SIZE);
+        uint32_t encoding = get_u32(entry + 12);
+        block->encoding = (BlockEncoding)encoding;
+        block->checksum = get_u64(entry + 16);
+
+        if ((encoding != BLOCK_STORED && encoding != BLOCK_LZ) ||
+            (encoding == BLOCK_STORED && block->stored_size != block->raw_size) ||
+            block->offset < HEADER_SIZE || block->offset > directory_offset ||
+            block->stored_size > directory_offset - block->offset) {
+            return invalid_file(file);
+        }
+    }
+    return 0;
+}
+
+void block_file_close(BlockFile* file) {
+    mapped_file_close(&file->file);
+    free(file->blocks);
+    memset(file, 0, sizeof(*file));
+}
+
+int block_file_read_block(const BlockFile* file, size_t block, void* out) {
+    if (block >= file->block_count) {
+        errno = EINVAL;
+        return -1;
+    }
+    const BlockInfo* info = &file->blocks[block];
+    const char* stored = file->file.data + info->offset;
+
+    if (file->checksum_type != CHECKSUM_NONE &&
+        checksum_compute(file->checksum_type, stored, info->stored_size) != info->checksum) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (info->encoding == BLOCK_STORED) {
+        memcpy(out, stored, info->raw_size);
+        return 0;
+    }
+    return lz_decompress(stored, info->stored_size, out, info->raw_size);
+}
+
+long long block_file_read(const BlockFile* file, uint64_t offset, void* out, size_t length) {
+    if (offset >= file->raw_size) return 0;
+    if (length > file->raw_size - offset) length = (size_t)(file->raw_size - offset);
+
+    unsigned char* scratch = NULL;
+    unsigned char* dst = out;
+    size_t done = 0;
+    while (done < length) {
+        size_t block = (size_t)((offset + done) / BLOCK_FILE_BLOCK_SIZE);
+        size_t start = (size_t)((offset + done) % BLOCK_FILE_BLOCK_SIZE);
+        size_t raw_size = file->blocks[block].raw_size;
+        size_t n = raw_size - start < length - done ? raw_size - start : length - done;
+
+        if (start == 0 && n == raw_size) {
+            // The whole block is wanted: decompress in place
+            if (block_file_read_block(file, block, dst + done) != 0) goto fail;
+        } else {
+            if (scratch == NULL && (scratch = malloc(BLOCK_FILE_BLOCK_SIZE)) == NULL) goto fail;
+            if (block_file_read_block(file, block, scratch) != 0) goto fail;
+            memcpy(dst + done, scratch + start, n);
+        }
+        done += n;
+    }
+    free(scratch);
+    return (long long)done;
+
+fail:;
+    int saved = errno;
+    free(scratch);
+    errno = saved;
+    return -1;
+}
+
+typedef struct {
+    const BlockFile* file;
+    unsigned char* out;
+    size_t first;
+    size_t end;
+    int error;                  // errno of the first damaged block, or 0
+} ReadTask;
+
+static void* read_blocks(void* argument) {
+    ReadTask* task = argument;
+    for (size_t k = task->first; k < task->end; k++) {
+        unsigned char* out = task->out + (size_t)k * BLOCK_FILE_BLOCK_SIZE;
+        if (block_file_read_block(task->file, k, out) != 0) {
+            task->error = errno;
+            break;
+        }
+    }
+    return NULL;
+}
+
+int block_file_read_all(const BlockFile* file, void* out, int threads) {
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+    if ((size_t)threads > file->block_count) threads = file->block_count > 0 ? (int)file->block_count : 1;
+
+    ReadTask tasks[MAX_THREADS];
+    pthread_t ids[MAX_THREADS];
+    size_t per_thread = file->block_count / (size_t)threads;
+    size_t extra = file->block_count % (size_t)threads;
+    size_t next = 0;
+    int started = 0;
+
+    for (int t = 0; t < threads; t++) {
+        tasks[t].file = file;
+        tasks[t].out = out;
+        tasks[t].first = next;
+        tasks[t].end = next + per_thread + ((size_t)t < extra);
+        tasks[t].error = 0;
+        next = tasks[t].end;
+    }
+    // Thread 0 is the caller itself
+    for (int t = 1; t < threads; t++) {
+        if (pthread_create(&ids[t], NULL, read_blocks, &tasks[t]) != 0) break;
+        started = t;
+    }
+    read_blocks(&tasks[0]);
+    // Runs that got no thread are done here
+    for (int t = started + 1; t < threads; t++) read_blocks(&tasks[t]);
+    for (int t = 1; t <= started; t++) pthread_join(ids[t], NULL);
+
+    for (int t = 0; t < threads; t++) {
+        if (tasks[t].error != 0) {
+            errno = tasks[t].error;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int block_file_compress(const char* source, const char* destination) {
+    MappedFile input;
+    if (mapped_file_open(&input, source, MAPPED_FILE_SEQUENTIAL) != 0) return -1;
+
+    BlockWriter writer;
+    int result = -1;
+    if (block_writer_open(&writer, destination) == 0) {
+        int written = block_writer_write(&writer, input.data, input.size);
+        // Close even after a failed write, so the writer is released
+        if (block_writer_close(&writer) == 0 && written == 0) result = 0;
+    }
+    int saved = errno;
+    mapped_file_close(&input);
+    errno = saved;
+    return result;
+}
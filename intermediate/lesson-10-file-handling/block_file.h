@@ -0,0 +1,127 @@
+/*
+ * block_file.h - "MYBZ": any file, compressed in independent 64 KB blocks
+ *
+ * Compressing a whole file as one stream (gzip) means reading byte 900M
+ * requires decompressing the 900M bytes before it, on one core. This
+ * container cuts the data into 64 KB blocks and compresses each one on
+ * its own with lz_codec.h:
+ *
+ *   [header, 64 bytes][block][block]...[block][block directory]
+ *
+ * - The directory lists where every block is stored, how it is encoded
+ *   (LZ, or stored as-is when it doesn't shrink) and its checksum. The
+ *   header points at it, so opening a file is two small reads no matter
+ *   how large it is.
+ * - Block k always holds raw bytes k * 64 KB onwards, so reading from any
+ *   offset decompresses one or two blocks, not the file up to there.
+ * - Blocks don't depend on each other: block_file_read_all() hands them
+ *   out to several threads.
+ * - Each block carries a CRC32C (or xxHash64) of its stored bytes, and
+ *   the directory a checksum of its own, so damage is found before
+ *   anything is decompressed.
+ *
+ * record_codec.h can stream records through a BlockWriter/BlockFile
+ * (company_data.bin), and column_file_open() opens MYFT files that were
+ * compressed into a MYBZ container.
+ *
+ * For frontend developers: Like serving a large asset as many
+ * independently gzipped chunks with an index, so a client can fetch and
+ * inflate just the Range it needs - or all of them in parallel workers.
+ */
+
+#ifndef BLOCK_FILE_H
+#define BLOCK_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "checksum.h"
+#include "mapped_file.h"
+
+#define BLOCK_FILE_MAGIC "MYBZ"
+#define BLOCK_FILE_VERSION 1
+#define BLOCK_FILE_BLOCK_SIZE 65536
+
+typedef enum {
+    BLOCK_STORED = 0,           // Raw bytes (compression would not have saved anything)
+    BLOCK_LZ = 1
+} BlockEncoding;
+
+// Writing: data is collected into 64 KB blocks, each compressed and
+// written as soon as it is full
+
+typedef struct {
+    FILE* file;
+    ChecksumType checksum;
+    unsigned char* block;       // The block being filled
+    size_t block_used;
+    unsigned char* compressed;  // Output of one lz_compress()
+    unsigned char* directory;   // Encoded entries of the finished blocks
+    size_t directory_used;
+    size_t directory_capacity;
+    uint64_t raw_size;          // Bytes written by the caller so far
+    uint64_t offset;            // Current end of file
+} BlockWriter;
+
+// Create `filename`. Blocks are checksummed with CRC32C unless
+// block_writer_set_checksum() says otherwise. Returns 0, or -1 with
+// errno set.
+int block_writer_open(BlockWriter* writer, const char* filename);
+
+// CHECKSUM_NONE, CHECKSUM_CRC32C or CHECKSUM_XXH64; only before the
+// first block is written. Returns 0, or -1 with errno = EINVAL.
+int block_writer_set_checksum(BlockWriter* writer, ChecksumType type);
+
+// Append `size` bytes. Returns 0, or -1 on a write error.
+int block_writer_write(BlockWriter* writer, const void* data, size_t size);
+
+// Write the last block, the directory and the header. Returns 0, or -1
+// on failure (the writer is released either way).
+int block_writer_close(BlockWriter* writer);
+
+// Reading
+
+typedef struct {
+    uint64_t offset;            // Where the stored bytes start in the file
+    uint32_t stored_size;
+    uint32_t raw_size;          // BLOCK_FILE_BLOCK_SIZE except for the last block
+    BlockEncoding encoding;
+    uint64_t checksum;          // Of the stored bytes
+} BlockInfo;
+
+typedef struct {
+    MappedFile file;
+    ChecksumType checksum_type;
+    uint64_t raw_size;          // Size of the original data
+    size_t block_count;
+    BlockInfo* blocks;
+} BlockFile;
+
+// 1 if `data` starts with a MYBZ header
+int block_file_detect(const void* data, size_t size);
+
+// Map `filename` and check its header and directory. Returns 0, or -1
+// with errno set (EINVAL for a file that isn't a valid MYBZ file).
+int block_file_open(BlockFile* file, const char* filename);
+void block_file_close(BlockFile* file);
+
+// Check and decompress block `block` into `out` (blocks[block].raw_size
+// bytes). Returns 0, or -1 with errno = EINVAL if the block is damaged.
+int block_file_read_block(const BlockFile* file, size_t block, void* out);
+
+// Copy raw bytes [offset, offset + length) into `out`, decompressing only
+// the blocks they are in. Returns the number of bytes copied (less than
+// `length` at the end of the data), or -1 with errno set.
+long long block_file_read(const BlockFile* file, uint64_t offset, void* out, size_t length);
+
+// Decompress everything into `out` (raw_size bytes) with `threads`
+// threads (0 = one per CPU). Returns 0, or -1 with errno set if any
+// block is damaged.
+int block_file_read_all(const BlockFile* file, void* out, int threads);
+
+// Compress the file `source` into a new MYBZ file `destination`.
+// Returns 0, or -1 with errno set.
+int block_file_compress(const char* source, const char* destination);
+
+#endif // BLOCK_FILE_H
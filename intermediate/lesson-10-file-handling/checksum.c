@@ -0,0 +1,290 @@
+/*
+ * checksum.c - CRC32C (SSE4.2 or slicing-by-8) and xxHash64
+ *
+ * Implementation notes:
+ * - Both CRC32C paths work on the raw CRC register; crc32c() inverts it
+ *   before and after, as the standard requires, which is also what makes
+ *   chaining calls work.
+ * - The `crc32` instruction has a latency of 3 cycles but can start one
+ *   per cycle, so a single dependency chain runs at a third of the
+ *   possible speed. Large inputs are therefore hashed as three
+ *   interleaved 4 KB lanes whose CRCs are combined afterwards: CRC is
+ *   linear, so "lane A followed by B" is A shifted over 4 KB of zero
+ *   bytes, xor B. The shift is a fixed linear map, applied with four
+ *   256-entry tables built from its 32 basis vectors.
+ * - Slicing-by-8 looks up each of 8 input bytes in its own table
+ *   (the CRC of that byte followed by 0..7 zero bytes), so one step
+ *   consumes 8 bytes with 8 independent loads instead of 8 dependent
+ *   ones.
+ * - The tables are built once, on first use, under pthread_once().
+ * - xxHash64 follows the reference algorithm (same output as XXH64()),
+ *   reading input as little-endian words on every host.
+ */
+
+#include "checksum.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#define CHECKSUM_HAVE_SSE42 1    // The 64-bit crc32 instruction needs x86-64
+#include <immintrin.h>
+#else
+#define CHECKSUM_HAVE_SSE42 0
+#endif
+
+#define CRC32C_POLY 0x82F63B78u  // Castagnoli polynomial, bit-reflected
+#define CRC_LANE 4096            // Bytes per interleaved lane
+
+// -1 = not detected yet, 0 = portable, 1 = SSE4.2
+static int simd_level = -1;
+
+static pthread_once_t tables_once = PTHREAD_ONCE_INIT;
+static uint32_t slice_table[8][256];
+static uint32_t lane_shift_table[4][256];
+
+static uint64_t load_u64_le(const unsigned char* p) {
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    return value;
+}
+
+static uint32_t load_u32_le(const unsigned char* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap32(value);
+#endif
+    return value;
+}
+
+static void build_tables(void) {
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t crc = n;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (CRC32C_POLY & (0u - (crc & 1)));
+        }
+        slice_table[0][n] = crc;
+    }
+    for (uint32_t n = 0; n < 256; n++) {
+        for (int k = 1; k < 8; k++) {
+            uint32_t previous = slice_table[k - 1][n];
+            slice_table[k][n] = (previous >> 8) ^ slice_table[0][previous & 0xFF];
+        }
+    }
+
+    // Shifting a CRC register over CRC_LANE zero bytes, for each single bit
+    uint32_t basis[32];
+    for (int bit = 0; bit < 32; bit++) {
+        uint32_t crc = 1u << bit;
+        for (int i = 0; i < CRC_LANE; i++) {
+            crc = (crc >> 8) ^ slice_table[0][crc & 0xFF];
+        }
+        basis[bit] = crc;
+    }
+    for (int k = 0; k < 4; k++) {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t shifted = 0;
+            for (int bit = 0; bit < 8; bit++) {
+                if (n & (1u << bit)) shifted ^= basis[8 * k + bit];
+            }
+            lane_shift_table[k][n] = shifted;
+        }
+    }
+}
+
+static uint32_t crc32c_portable(uint32_t crc, const unsigned char* p, size_t length) {
+    while (length >= 8) {
+        uint32_t low = load_u32_le(p) ^ crc;
+        uint32_t high = load_u32_le(p + 4);
+        crc = slice_table[7][low & 0xFF] ^ slice_table[6][(low >> 8) & 0xFF] ^
+              slice_table[5][(low >> 16) & 0xFF] ^ slice_table[4][low >> 24] ^
+              slice_table[3][high & 0xFF] ^ slice_table[2][(high >> 8) & 0xFF] ^
+              slice_table[1][(high >> 16) & 0xFF] ^ slice_table[0][high >> 24];
+        p += 8;
+        length -= 8;
+    }
+    while (length-- > 0) {
+        crc = (crc >> 8) ^ slice_table[0][(crc ^ *p++) & 0xFF];
+    }
+    return crc;
+}
+
+#if CHECKSUM_HAVE_SSE42
+
+static uint32_t shift_over_lane(uint32_t crc) {
+    return lane_shift_table[0][crc & 0xFF] ^ lane_shift_table[1][(crc >> 8) & 0xFF] ^
+           lane_shift_table[2][(crc >> 16) & 0xFF] ^ lane_shift_table[3][crc >> 24];
+}
+
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_sse42(uint32_t crc, const unsigned char* p, size_t length) {
+    while (length >= 3 * CRC_LANE) {
+        uint64_t a = crc, b = 0, c = 0;
+        for (size_t i = 0; i < CRC_LANE; i += 8) {
+            a = _mm_crc32_u64(a, load_u64_le(p + i));
+            b = _mm_crc32_u64(b, load_u64_le(p + CRC_LANE + i));
+            c = _mm_crc32_u64(c, load_u64_le(p + 2 * CRC_LANE + i));
+        }
+        crc = shift_over_lane(shift_over_lane((uint32_t)a) ^ (uint32_t)b) ^ (uint32_t)c;
+        p += 3 * CRC_LANE;
+        length -= 3 * CRC_LANE;
+    }
+
+    uint64_t wide = crc;
+    while (length >= 8) {
+        wide = _mm_crc32_u64(wide, load_u64_le(p));
+        p += 8;
+        length -= 8;
+    }
+    crc = (uint32_t)wide;
+    while (length-- > 0) {
+        crc = _mm_crc32_u8(crc, *p++);
+    }
+    return crc;
+}
+
+#endif // CHECKSUM_HAVE_SSE42
+
+int checksum_set_simd(int enabled) {
+    int level = 0;
+#if CHECKSUM_HAVE_SSE42
+    __builtin_cpu_init();
+    level = enabled && __builtin_cpu_supports("sse4.2");
+#else
+    (void)enabled;
+#endif
+    __atomic_store_n(&simd_level, level, __ATOMIC_RELAXED);
+    return level;
+}
+
+static int use_sse42(void) {
+    int level = __atomic_load_n(&simd_level, __ATOMIC_RELAXED);
+    if (level < 0) level = checksum_set_simd(1);
+    return level;
+}
+
+const char* checksum_backend_name(void) {
+    return use_sse42() ? "SSE4.2" : "portable";
+}
+
+uint32_t crc32c(uint32_t crc, const void* data, size_t length) {
+    pthread_once(&tables_once, build_tables);
+
+    const unsigned char* p = data;
+    crc = ~crc;
+#if CHECKSUM_HAVE_SSE42
+    if (use_sse42()) return ~crc32c_sse42(crc, p, length);
+#endif
+    return ~crc32c_portable(crc, p, length);
+}
+
+uint32_t checksum_legacy(const void* data, size_t length) {
+    const unsigned char* bytes = data;
+    uint32_t checksum = 0;
+
+    for (size_t i = 0; i < length; i++) {
+        checksum = (checksum << 1) ^ bytes[i];
+    }
+    return checksum;
+}
+
+// xxHash64
+
+#define XXH_PRIME1 0x9E3779B185EBCA87ull
+#define XXH_PRIME2 0xC2B2AE3D27D4EB4Full
+#define XXH_PRIME3 0x165667B19E3779F9ull
+#define XXH_PRIME4 0x85EBCA77C2B2AE63ull
+#define XXH_PRIME5 0x27D4EB2F165667C5ull
+
+static uint64_t rotl64(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static uint64_t xxh_round(uint64_t acc, uint64_t input) {
+    acc += input * XXH_PRIME2;
+    acc = rotl64(acc, 31);
+    return acc * XXH_PRIME1;
+}
+
+static uint64_t xxh_merge(uint64_t hash, uint64_t acc) {
+    hash ^= xxh_round(0, acc);
+    return hash * XXH_PRIME1 + XXH_PRIME4;
+}
+
+uint64_t xxhash64(const void* data, size_t length, uint64_t seed) {
+    const unsigned char* p = data;
+    const unsigned char* end = p + length;
+    uint64_t hash;
+
+    if (length >= 32) {
+        // Four independent lanes of 8 bytes each per 32-byte stripe
+        uint64_t v1 = seed + XXH_PRIME1 + XXH_PRIME2;
+        uint64_t v2 = seed + XXH_PRIME2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - XXH_PRIME1;
+        const unsigned char* limit = end - 32;
+        do {
+            v1 = xxh_round(v1, load_u64_le(p));
+            v2 = xxh_round(v2, load_u64_le(p + 8));
+            v3 = xxh_round(v3, load_u64_le(p + 16));
+            v4 = xxh_round(v4, load_u64_le(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        hash = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        hash = xxh_merge(hash, v1);
+        hash = xxh_merge(hash, v2);
+        hash = xxh_merge(hash, v3);
+        hash = xxh_merge(hash, v4);
+    } else {
+        hash = seed + XXH_PRIME5;
+    }
+
+    hash += (uint64_t)length;
+
+    while (end - p >= 8) {
+        hash ^= xxh_round(0, load_u64_le(p));
+        hash = rotl64(hash, 27) * XXH_PRIME1 + XXH_PRIME4;
+        p += 8;
+    }
+    if (end - p >= 4) {
+        hash ^= (uint64_t)load_u32_le(p) * XXH_PRIME1;
+        hash = rotl64(hash, 23) * XXH_PRIME2 + XXH_PRIME3;
+        p += 4;
+    }
+    while (p < end) {
+        hash ^= *p++ * XXH_PRIME5;
+        hash = rotl64(hash, 11) * XXH_PRIME1;
+    }
+
+    // Avalanche: make every input bit affect every output bit
+    hash ^= hash >> 33;
+    hash *= XXH_PRIME2;
+    hash ^= hash >> 29;
+    hash *= XXH_PRIME3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+uint64_t checksum_compute(ChecksumType type, const void* data, size_t length) {
+    switch (type) {
+        case CHECKSUM_LEGACY: return checksum_legacy(data, length);
+        case CHECKSUM_CRC32C: return crc32c(0, data, length);
+        case CHECKSUM_XXH64:  return xxhash64(data, length, 0);
+        default:              return 0;
+    }
+}
+
+const char* checksum_name(ChecksumType type) {
+    switch (type) {
+        case CHECKSUM_NONE:   return "none";
+        case CHECKSUM_LEGACY: return "shift-xor (legacy)";
+        case CHECKSUM_CRC32C: return "CRC32C";
+        case CHECKSUM_XXH64:  return "xxHash64";
+        default:              return "unknown";
+    }
+}
@@ -0,0 +1,824 @@
+/*
+ * column_file.c - "MYFT" version 2 columnar file writer and reader
+ *
+ * On-disk layout (all integers little-endian except the version field,
+ * which stays big-endian exactly where version 1 put it so one check
+ * tells the two versions apart):
+ *
+ *   header (64 bytes)
+ *     0  char[4]  magic "MYFT"
+ *     4  u16      version (big-endian)
+ *     6  u16      column count
+ *     8  u32      rows per chunk
+ *     12 u16      checksum type (ChecksumType, 0 = none)
+ *     14 u16      flags (0)
+ *     16 u64      row count
+ *     24 u64      footer offset
+ *     32 u64      footer size
+ *     40          zero padding
+ *   chunks, each starting on a 64-byte boundary
+ *   footer (starts on a 64-byte boundary)
+ *     column descriptors, 64 bytes each:
+ *       char[32] name, u32 type, u32 reserved, min (8), max (8), 8 reserved
+ *     chunk entries, 40 bytes each, all chunks of column 0 first:
+ *       u64 offset, u64 size, u32 rows, u32 encoding (IntEncoding,
+ *       0 = plain), min, max
+ *     if the checksum type isn't 0:
+ *       u64 checksum per chunk (same order), then u64 checksum of all of
+ *       the footer before it
+ *
+ * Implementation notes:
+ * - The writer buffers one chunk per column and writes a whole row group
+ *   at a time. Appends that cover a full chunk are written straight from
+ *   the caller's arrays without the copy.
+ * - The header is written last (after seeking back), so a file whose
+ *   writer never finished has an all-zero header and is rejected.
+ * - Header and footer fields are encoded byte by byte, so they are
+ *   portable. Chunk data is only touched on big-endian hosts, which swap
+ *   it once while writing and once at open.
+ * - Chunk checksums cover the bytes as stored, so the same file verifies
+ *   on every host. Opening a file checks only the footer checksum; the
+ *   chunks are checked on demand by column_file_verify(), which would
+ *   otherwise force every page of a multi-GB file in at open.
+ * - Encoded chunks hold the bytes int_codec_encode() produced, which are
+ *   little-endian by construction. They are decoded at open into
+ *   `converted`, each on a 64-byte boundary, together with the chunks a
+ *   big-endian host has to swap; plain chunks on little-endian hosts
+ *   still point into the mapping.
+ * - A compressed file is written to a tmpfile() first, because the header
+ *   is only known at the end and a MYBZ block can't be rewritten in place.
+ *   Opening one decompresses it into a 64-byte aligned heap buffer that
+ *   stands in for the mapping (a MappedFile with is_mapped = 0), so the
+ *   rest of the reader can't tell the difference.
+ * - Min/max of a FLOAT64 column ignore NaNs; a chunk of only NaNs has
+ *   min = +inf and max = -inf and matches no range.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "column_file.h"
+#include "block_file.h"
+#include "checksum.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define COLUMN_HOST_BIG_ENDIAN 1
+#else
+#define COLUMN_HOST_BIG_ENDIAN 0
+#endif
+
+#define HEADER_SIZE 64
+#define DESCRIPTOR_SIZE 64
+#define CHUNK_ENTRY_SIZE 40
+#define CHECKSUM_SIZE 8
+#define INDEX_ENTRY_SIZE (CHUNK_ENTRY_SIZE + CHECKSUM_SIZE)   // Writer's in-memory index
+#define V1_HEADER_SIZE 16
+
+static const unsigned char zero_padding[COLUMN_FILE_ALIGNMENT];
+
+size_t column_type_size(ColumnType type) {
+    return type == COLUMN_INT32 ? 4 : 8;
+}
+
+static void put_u16(unsigned char* out, uint16_t value) {
+    out[0] = (unsigned char)value;
+    out[1] = (unsigned char)(value >> 8);
+}
+
+static void put_u32(unsigned char* out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out[i] = (unsigned char)(value >> (8 * i));
+}
+
+static void put_u64(unsigned char* out, uint64_t value) {
+    for (int i = 0; i < 8; i++) out[i] = (unsigned char)(value >> (8 * i));
+}
+
+static uint16_t get_u16(const unsigned char* in) {
+    return (uint16_t)(in[0] | in[1] << 8);
+}
+
+static uint32_t get_u32(const unsigned char* in) {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; i--) value = value << 8 | in[i];
+    return value;
+}
+
+static uint64_t get_u64(const unsigned char* in) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--) value = value << 8 | in[i];
+    return value;
+}
+
+static void put_value(unsigned char* out, ColumnValue value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    put_u64(out, bits);
+}
+
+static ColumnValue get_value(const unsigned char* in) {
+    uint64_t bits = get_u64(in);
+    ColumnValue value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Reverse the byte order of `count` values of `size` bytes
+static void swap_values(void* dst, const void* src, size_t count, size_t size) {
+    if (size == 4) {
+        const uint32_t* in = src;
+        uint32_t* out = dst;
+        for (size_t i = 0; i < count; i++) out[i] = __builtin_bswap32(in[i]);
+    } else {
+        const uint64_t* in = src;
+        uint64_t* out = dst;
+        for (size_t i = 0; i < count; i++) out[i] = __builtin_bswap64(in[i]);
+    }
+}
+
+// "Empty" statistics that any real value replaces
+static void reset_stats(ColumnType type, ColumnValue* min, ColumnValue* max) {
+    if (type == COLUMN_FLOAT64) {
+        min->f = INFINITY;
+        max->f = -INFINITY;
+    } else {
+        min->i = INT64_MAX;
+        max->i = INT64_MIN;
+    }
+}
+
+static void update_stats(ColumnType type, const void* data, size_t rows,
+                         ColumnValue* min, ColumnValue* max) {
+    if (type == COLUMN_INT32) {
+        const int32_t* values = data;
+        int32_t lo = INT32_MAX, hi = INT32_MIN;
+        for (size_t i = 0; i < rows; i++) {
+            lo = values[i] < lo ? values[i] : lo;
+            hi = values[i] > hi ? values[i] : hi;
+        }
+        if (rows > 0 && lo < min->i) min->i = lo;
+        if (rows > 0 && hi > max->i) max->i = hi;
+    } else if (type == COLUMN_INT64) {
+        const int64_t* values = data;
+        for (size_t i = 0; i < rows; i++) {
+            if (values[i] < min->i) min->i = values[i];
+            if (values[i] > max->i) max->i = values[i];
+        }
+    } else {
+        const double* values = data;
+        double lo = min->f, hi = max->f;
+        for (size_t i = 0; i < rows; i++) {
+            // NaN fails both comparisons and never becomes a bound
+            lo = values[i] < lo ? values[i] : lo;
+            hi = values[i] > hi ? values[i] : hi;
+        }
+        min->f = lo;
+        max->f = hi;
+    }
+}
+
+// Writer
+
+static int write_bytes(ColumnWriter* writer, const void* data, size_t size) {
+    if (size > 0 && fwrite(data, 1, size, writer->file) != size) return -1;
+    writer->offset += size;
+    return 0;
+}
+
+static int pad_to_alignment(ColumnWriter* writer) {
+    size_t pad = (size_t)(-writer->offset % COLUMN_FILE_ALIGNMENT);
+    return write_bytes(writer, zero_padding, pad);
+}
+
+static int append_chunk_entry(ColumnWriter* writer, uint64_t offset, uint64_t size,
+                              uint32_t rows, IntEncoding encoding, ColumnValue min,
+                              ColumnValue max, uint64_t checksum) {
+    if (writer->index_used + INDEX_ENTRY_SIZE > writer->index_capacity) {
+        size_t capacity = writer->index_capacity ? writer->index_capacity * 2 : 64 * INDEX_ENTRY_SIZE;
+        unsigned char* bigger = realloc(writer->index, capacity);
+        if (bigger == NULL) return -1;
+        writer->index = bigger;
+        writer->index_capacity = capacity;
+    }
+
+    unsigned char* entry = writer->index + writer->index_used;
+    put_u64(entry, offset);
+    put_u64(entry + 8, size);
+    put_u32(entry + 16, rows);
+    put_u32(entry + 20, (uint32_t)encoding);
+    put_value(entry + 24, min);
+    put_value(entry + 32, max);
+    put_u64(entry + CHUNK_ENTRY_SIZE, checksum);
+    writer->index_used += INDEX_ENTRY_SIZE;
+    return 0;
+}
+
+static int write_chunk(ColumnWriter* writer, size_t column, const void* data, uint32_t rows) {
+    ColumnInfo* info = &writer->columns[column];
+    size_t size = column_type_size(info->type);
+
+    if (pad_to_alignment(writer) != 0) return -1;
+    uint64_t offset = writer->offset;
+
+    ColumnValue min, max;
+    reset_stats(info->type, &min, &max);
+    update_stats(info->type, data, rows, &min, &max);
+    if (info->type == COLUMN_FLOAT64) {
+        if (min.f < info->min.f) info->min.f = min.f;
+        if (max.f > info->max.f) info->max.f = max.f;
+    } else {
+        if (min.i < info->min.i) info->min.i = min.i;
+        if (max.i > info->max.i) info->max.i = max.i;
+    }
+
+    // Checksum and write the bytes exactly as they are stored
+    const void* stored = data;
+    size_t stored_size = (size_t)rows * size;
+    IntEncoding encoding = INT_ENCODING_PLAIN;
+    if (writer->encode && info->type != COLUMN_FLOAT64) {
+        encoding = int_codec_choose(data, rows, size, &stored_size);
+        if (encoding != INT_ENCODING_PLAIN) {
+            if (int_codec_encode(encoding, data, rows, size, writer->encoded) != stored_size) return -1;
+            stored = writer->encoded;
+        }
+    }
+    if (COLUMN_HOST_BIG_ENDIAN && encoding == INT_ENCODING_PLAIN) {
+        swap_values(writer->swapped, data, rows, size);
+        stored = writer->swapped;
+    }
+    uint64_t checksum = checksum_compute(writer->checksum, stored, stored_size);
+
+    if (write_bytes(writer, stored, stored_size) != 0) return -1;
+    return append_chunk_entry(writer, offset, stored_size, rows, encoding, min, max, checksum);
+}
+
+static int flush_buffer(ColumnWriter* writer) {
+    if (writer->buffered == 0) return 0;
+    for (size_t c = 0; c < writer->column_count; c++) {
+        if (write_chunk(writer, c, writer->buffer + writer->buffer_offsets[c],
+                        writer->buffered) != 0) return -1;
+    }
+    writer->row_count += writer->buffered;
+    writer->buffered = 0;
+    return 0;
+}
+
+static void writer_release(ColumnWriter* writer) {
+    if (writer->file != NULL) fclose(writer->file);
+    free(writer->columns);
+    free(writer->buffer);
+    free(writer->buffer_offsets);
+    free(writer->swapped);
+    free(writer->index);
+    free(writer->encoded);
+    free(writer->filename);
+    memset(writer, 0, sizeof(*writer));
+}
+
+int column_writer_open(ColumnWriter* writer, const char* filename,
+                       const ColumnSpec* columns, size_t column_count,
+                       uint32_t rows_per_chunk) {
+    memset(writer, 0, sizeof(*writer));
+    if (column_count == 0 || column_count > UINT16_MAX) {
+        errno = EINVAL;
+        return -1;
+    }
+    for (size_t c = 0; c < column_count; c++) {
+        size_t length = strlen(columns[c].name);
+        if (length == 0 || length >= COLUMN_NAME_MAX ||
+            columns[c].type < COLUMN_INT32 || columns[c].type > COLUMN_FLOAT64) {
+            errno = EINVAL;
+            return -1;
+        }
+    }
+
+    writer->rows_per_chunk = rows_per_chunk ? rows_per_chunk : COLUMN_DEFAULT_CHUNK_ROWS;
+    writer->checksum = CHECKSUM_CRC32C;
+    writer->column_count = column_count;
+    writer->columns = calloc(column_count, sizeof(ColumnInfo));
+    writer->buffer_offsets = malloc(column_count * sizeof(size_t));
+    if (writer->columns == NULL || writer->buffer_offsets == NULL) {
+        writer_release(writer);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    size_t buffer_size = 0;
+    for (size_t c = 0; c < column_count; c++) {
+        ColumnInfo* info = &writer->columns[c];
+        strcpy(info->name, columns[c].name);
+        info->type = columns[c].type;
+        reset_stats(info->type, &info->min, &info->max);
+        writer->buffer_offsets[c] = buffer_size;
+        buffer_size += (size_t)writer->rows_per_chunk * column_type_size(info->type);
+        buffer_size += (size_t)(-buffer_size % COLUMN_FILE_ALIGNMENT);
+    }
+
+    writer->buffer = malloc(buffer_size);
+    writer->filename = malloc(strlen(filename) + 1);
+    if (COLUMN_HOST_BIG_ENDIAN) writer->swapped = malloc((size_t)writer->rows_per_chunk * 8);
+    if (writer->buffer == NULL || writer->filename == NULL ||
+        (COLUMN_HOST_BIG_ENDIAN && writer->swapped == NULL)) {
+        writer_release(writer);
+        errno = ENOMEM;
+        return -1;
+    }
+    strcpy(writer->filename, filename);
+
+    writer->file = fopen(filename, "wb");
+    if (writer->file == NULL) {
+        int saved = errno;
+        writer_release(writer);
+        errno = saved;
+        return -1;
+    }
+
+    // Placeholder header, rewritten by column_writer_close()
+    if (write_bytes(writer, zero_padding, HEADER_SIZE) != 0) {
+        int saved = errno;
+        writer_release(writer);
+        errno = saved;
+        return -1;
+    }
+    return 0;
+}
+
+int column_writer_set_checksum(ColumnWriter* writer, ChecksumType type) {
+    if (writer->index_used > 0 ||
+        (type != CHECKSUM_NONE && type != CHECKSUM_CRC32C && type != CHECKSUM_XXH64)) {
+        errno = EINVAL;
+        return -1;
+    }
+    writer->checksum = type;
+    return 0;
+}
+
+int column_writer_set_encoding(ColumnWriter* writer, int enabled) {
+    // An encoding is only chosen when it is smaller than the plain chunk
+    if (enabled && writer->encoded == NULL) {
+        writer->encoded = malloc((size_t)writer->rows_per_chunk * 8);
+        if (writer->encoded == NULL) {
+            errno = ENOMEM;
+            return -1;
+        }
+    }
+    writer->encode = enabled != 0;
+    return 0;
+}
+
+int column_writer_set_compression(ColumnWriter* writer, int enabled) {
+    enabled = enabled != 0;
+    if (writer->index_used > 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (enabled == writer->compress) return 0;
+
+    // Nothing but the placeholder header has been written: start over in
+    // the other file
+    FILE* file = enabled ? tmpfile() : fopen(writer->filename, "wb");
+    if (file == NULL) return -1;
+    fclose(writer->file);
+    writer->file = file;
+    writer->offset = 0;
+    writer->compress = enabled;
+    return write_bytes(writer, zero_padding, HEADER_SIZE);
+}
+
+// Copy the finished temporary file into a MYBZ file
+static int compress_to_file(ColumnWriter* writer) {
+    BlockWriter blocks;
+    if (fflush(writer->file) != 0 || fseek(writer->file, 0, SEEK_SET) != 0 ||
+        block_writer_open(&blocks, writer->filename) != 0) return -1;
+    if (block_writer_set_checksum(&blocks, writer->checksum) != 0) {
+        block_writer_close(&blocks);
+        return -1;
+    }
+
+    unsigned char* buffer = malloc(16 * BLOCK_FILE_BLOCK_SIZE);
+    int result = buffer != NULL ? 0 : -1;
+    size_t n;
+    while (result == 0 && (n = fread(buffer, 1, 16 * BLOCK_FILE_BLOCK_SIZE, writer->file)) > 0) {
+        result = block_writer_write(&blocks, buffer, n);
+    }
+    if (ferror(writer->file)) result = -1;
+    free(buffer);
+    if (block_writer_close(&blocks) != 0) result = -1;
+    return result;
+}
+
+int column_writer_append(ColumnWriter* writer, const void* const* values, size_t rows) {
+    size_t done = 0;
+    while (done < rows) {
+        size_t remaining = rows - done;
+
+        // Whole chunks go straight from the caller's arrays to the file
+        if (writer->buffered == 0 && remaining >= writer->rows_per_chunk) {
+            for (size_t c = 0; c < writer->column_count; c++) {
+                size_t size = column_type_size(writer->columns[c].type);
+                if (write_chunk(writer, c, (const char*)values[c] + done * size,
+                                writer->rows_per_chunk) != 0) return -1;
+            }
+            writer->row_count += writer->rows_per_chunk;
+            done += writer->rows_per_chunk;
+            continue;
+        }
+
+        size_t space = writer->rows_per_chunk - writer->buffered;
+        size_t n = remaining < space ? remaining : space;
+        for (size_t c = 0; c < writer->column_count; c++) {
+            size_t size = column_type_size(writer->columns[c].type);
+            memcpy(writer->buffer + writer->buffer_offsets[c] + writer->buffered * size,
+                   (const char*)values[c] + done * size, n * size);
+        }
+        writer->buffered += (uint32_t)n;
+        done += n;
+
+        if (writer->buffered == writer->rows_per_chunk && flush_buffer(writer) != 0) return -1;
+    }
+    return 0;
+}
+
+int column_writer_close(ColumnWriter* writer) {
+    int result = -1;
+    unsigned char* footer = NULL;
+    if (flush_buffer(writer) != 0 || pad_to_alignment(writer) != 0) goto done;
+
+    // The footer is small: build it in memory, then write it at once
+    size_t chunks = writer->index_used / INDEX_ENTRY_SIZE;
+    size_t groups = chunks / writer->column_count;
+    size_t checksum_bytes = writer->checksum != CHECKSUM_NONE ? (chunks + 1) * CHECKSUM_SIZE : 0;
+    size_t footer_size = writer->column_count * DESCRIPTOR_SIZE + chunks * CHUNK_ENTRY_SIZE +
+                         checksum_bytes;
+    footer = calloc(1, footer_size);
+    if (footer == NULL) goto done;
+
+    unsigned char* out = footer;
+    for (size_t c = 0; c < writer->column_count; c++, out += DESCRIPTOR_SIZE) {
+        const ColumnInfo* info = &writer->columns[c];
+        memcpy(out, info->name, strlen(info->name));
+        put_u32(out + 32, (uint32_t)info->type);
+        put_value(out + 40, info->min);
+        put_value(out + 48, info->max);
+    }
+
+    // The index was collected row group by row group; store it column by
+    // column, first the entries and then their checksums
+    unsigned char* checksums = out + chunks * CHUNK_ENTRY_SIZE;
+    for (size_t c = 0; c < writer->column_count; c++) {
+        for (size_t g = 0; g < groups; g++) {
+            const unsigned char* entry =
+                writer->index + (g * writer->column_count + c) * INDEX_ENTRY_SIZE;
+            memcpy(out, entry, CHUNK_ENTRY_SIZE);
+            out += CHUNK_ENTRY_SIZE;
+            if (checksum_bytes > 0) {
+                memcpy(checksums, entry + CHUNK_ENTRY_SIZE, CHECKSUM_SIZE);
+                checksums += CHECKSUM_SIZE;
+            }
+        }
+    }
+    if (checksum_bytes > 0) {
+        put_u64(checksums, checksum_compute(writer->checksum, footer, footer_size - CHECKSUM_SIZE));
+    }
+
+    uint64_t footer_offset = writer->offset;
+    if (write_bytes(writer, footer, footer_size) != 0) goto done;
+
+    unsigned char header[HEADER_SIZE] = {0};
+    memcpy(header, COLUMN_FILE_MAGIC, 4);
+    header[4] = 0;
+    header[5] = COLUMN_FILE_VERSION;
+    put_u16(header + 6, (uint16_t)writer->column_count);
+    put_u32(header + 8, writer->rows_per_chunk);
+    put_u16(header + 12, (uint16_t)writer->checksum);
+    put_u64(header + 16, writer->row_count);
+    put_u64(header + 24, footer_offset);
+    put_u64(header + 32, footer_size);
+
+    if (fseek(writer->file, 0, SEEK_SET) != 0 ||
+        fwrite(header, 1, sizeof(header), writer->file) != sizeof(header)) goto done;
+    if (writer->compress && compress_to_file(writer) != 0) goto done;
+
+    result = 0;
+
+done:
+    free(footer);
+    if (fclose(writer->file) != 0) result = -1;
+    writer->file = NULL;
+    writer_release(writer);
+    return result;
+}
+
+// Reader
+
+static int invalid_file(ColumnFile* file) {
+    column_file_close(file);
+    errno = EINVAL;
+    return -1;
+}
+
+// Version 1: 16-byte header (magic, version, record count, checksum in
+// network order with 2 bytes of struct padding) + big-endian uint32s
+static int open_v1(ColumnFile* file) {
+    const unsigned char* bytes = (const unsigned char*)file->file.data;
+    size_t size = file->file.size;
+    if (size < V1_HEADER_SIZE) return invalid_file(file);
+
+    uint32_t count = (uint32_t)bytes[8] << 24 | (uint32_t)bytes[9] << 16 |
+                     (uint32_t)bytes[10] << 8 | bytes[11];
+    uint32_t stored_checksum = (uint32_t)bytes[12] << 24 | (uint32_t)bytes[13] << 16 |
+                               (uint32_t)bytes[14] << 8 | bytes[15];
+    if (count > (size - V1_HEADER_SIZE) / 4) return invalid_file(file);
+
+    file->columns = calloc(1, sizeof(ColumnInfo));
+    file->chunks = calloc(1, sizeof(ColumnChunk));
+    file->converted = malloc(count ? (size_t)count * 4 : 1);
+    if (file->columns == NULL || file->chunks == NULL || file->converted == NULL) {
+        column_file_close(file);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    // The one unavoidable per-record conversion of the old format
+    int32_t* values = file->converted;
+    const unsigned char* in = bytes + V1_HEADER_SIZE;
+    for (uint32_t i = 0; i < count; i++, in += 4) {
+        values[i] = (int32_t)((uint32_t)in[0] << 24 | (uint32_t)in[1] << 16 |
+                              (uint32_t)in[2] << 8 | in[3]);
+    }
+
+    ColumnInfo* info = &file->columns[0];
+    strcpy(info->name, "value");
+    info->type = COLUMN_INT32;
+    reset_stats(COLUMN_INT32, &info->min, &info->max);
+    update_stats(COLUMN_INT32, values, count, &info->min, &info->max);
+
+    file->version = 1;
+    file->checksum_type = CHECKSUM_LEGACY;
+    file->row_count = count;
+    file->rows_per_chunk = count;
+    file->column_count = 1;
+    file->chunk_count = count > 0;
+    file->chunks[0].data = values;
+    file->chunks[0].first_row = 0;
+    file->chunks[0].rows = count;
+    file->chunks[0].min = info->min;
+    file->chunks[0].max = info->max;
+    file->chunks[0].file_offset = V1_HEADER_SIZE;
+    file->chunks[0].checksum = stored_checksum;
+    return 0;
+}
+
+static int open_v2(ColumnFile* file) {
+    const unsigned char* bytes = (const unsigned char*)file->file.data;
+    uint64_t size = file->file.size;
+    if (size < HEADER_SIZE) return invalid_file(file);
+
+    size_t column_count = get_u16(bytes + 6);
+    uint32_t rows_per_chunk = get_u32(bytes + 8);
+    uint64_t row_count = get_u64(bytes + 16);
+    uint64_t footer_offset = get_u64(bytes + 24);
+    uint64_t footer_size = get_u64(bytes + 32);
+
+    uint16_t checksum_type = get_u16(bytes + 12);
+    if (column_count == 0 || rows_per_chunk == 0 || get_u16(bytes + 14) != 0 ||
+        (checksum_type != CHECKSUM_NONE && checksum_type != CHECKSUM_CRC32C &&
+         checksum_type != CHECKSUM_XXH64) ||
+        footer_offset < HEADER_SIZE || footer_offset % COLUMN_FILE_ALIGNMENT != 0 ||
+        footer_offset > size || footer_size > size - footer_offset) {
+        return invalid_file(file);
+    }
+
+    uint64_t chunk_count = row_count / rows_per_chunk + (row_count % rows_per_chunk != 0);
+    uint64_t entry_size = CHUNK_ENTRY_SIZE + (checksum_type != CHECKSUM_NONE ? CHECKSUM_SIZE : 0);
+    uint64_t footer_checksum_size = checksum_type != CHECKSUM_NONE ? CHECKSUM_SIZE : 0;
+    if (chunk_count > size / CHUNK_ENTRY_SIZE / column_count ||
+        footer_size != column_count * (DESCRIPTOR_SIZE + chunk_count * entry_size) +
+                       footer_checksum_size) {
+        return invalid_file(file);
+    }
+
+    // A damaged index could point anywhere: check it before using it
+    if (checksum_type != CHECKSUM_NONE) {
+        const unsigned char* footer = bytes + footer_offset;
+        size_t covered = (size_t)(footer_size - CHECKSUM_SIZE);
+        if (checksum_compute(checksum_type, footer, covered) != get_u64(footer + covered)) {
+            return invalid_file(file);
+        }
+    }
+
+    file->version = 2;
+    file->checksum_type = checksum_type;
+    file->row_count = row_count;
+    file->rows_per_chunk = rows_per_chunk;
+    file->column_count = column_count;
+    file->chunk_count = (size_t)chunk_count;
+    file->columns = calloc(column_count, sizeof(ColumnInfo));
+    file->chunks = calloc(column_count * file->chunk_count + 1, sizeof(ColumnChunk));
+    if (file->columns == NULL || file->chunks == NULL) {
+        column_file_close(file);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    const unsigned char* descriptor = bytes + footer_offset;
+    for (size_t c = 0; c < column_count; c++, descriptor += DESCRIPTOR_SIZE) {
+        ColumnInfo* info = &file->columns[c];
+        uint32_t type = get_u32(descriptor + 32);
+        if (memchr(descriptor, '\0', COLUMN_NAME_MAX) == NULL || type > COLUMN_FLOAT64) {
+            return invalid_file(file);
+        }
+        memcpy(info->name, descriptor, COLUMN_NAME_MAX);
+        info->type = (ColumnType)type;
+        info->min = get_value(descriptor + 40);
+        info->max = get_value(descriptor + 48);
+    }
+
+    const unsigned char* entry = descriptor;
+    const unsigned char* checksums = entry + column_count * file->chunk_count * CHUNK_ENTRY_SIZE;
+    uint64_t converted_bytes = 0;
+    for (size_t c = 0; c < column_count; c++) {
+        size_t value_size = column_type_size(file->columns[c].type);
+        for (size_t k = 0; k < file->chunk_count; k++, entry += CHUNK_ENTRY_SIZE) {
+            ColumnChunk* chunk = &file->chunks[c * file->chunk_count + k];
+            uint64_t offset = get_u64(entry);
+            uint64_t length = get_u64(entry + 8);
+            uint32_t rows = get_u32(entry + 16);
+            uint64_t first_row = (uint64_t)k * rows_per_chunk;
+            uint64_t expected = row_count - first_row < rows_per_chunk ?
+                                row_count - first_row : rows_per_chunk;
+
+            uint32_t encoding = get_u32(entry + 20);
+            int plain = encoding == INT_ENCODING_PLAIN;
+            if (rows != expected || (plain && length != (uint64_t)rows * value_size) ||
+                (!plain && (encoding >= INT_ENCODING_COUNT ||
+                            file->columns[c].type == COLUMN_FLOAT64)) ||
+                offset % COLUMN_FILE_ALIGNMENT != 0 || offset < HEADER_SIZE ||
+                offset > footer_offset || length > footer_offset - offset) {
+                return invalid_file(file);
+            }
+
+            chunk->data = bytes + offset;
+            chunk->stored_size = length;
+            chunk->encoding = (IntEncoding)encoding;
+            chunk->first_row = first_row;
+            chunk->rows = rows;
+            chunk->min = get_value(entry + 24);
+            chunk->max = get_value(entry + 32);
+            chunk->file_offset = offset;
+            if (checksum_type != CHECKSUM_NONE) {
+                chunk->checksum = get_u64(checksums + (c * file->chunk_count + k) * CHECKSUM_SIZE);
+            }
+            if (COLUMN_HOST_BIG_ENDIAN || !plain) {
+                uint64_t decoded = (uint64_t)rows * value_size;
+                converted_bytes += decoded + (-decoded % COLUMN_FILE_ALIGNMENT);
+            }
+        }
+    }
+    if (converted_bytes == 0) return 0;
+
+    // Decode (or, on big-endian hosts, swap) chunks once into a private copy
+    void* converted = NULL;
+    if (posix_memalign(&converted, COLUMN_FILE_ALIGNMENT, (size_t)converted_bytes) != 0) {
+        column_file_close(file);
+        errno = ENOMEM;
+        return -1;
+    }
+    file->converted = converted;
+    char* out = converted;
+    for (size_t c = 0; c < column_count; c++) {
+        size_t value_size = column_type_size(file->columns[c].type);
+        for (size_t k = 0; k < file->chunk_count; k++) {
+            ColumnChunk* chunk = &file->chunks[c * file->chunk_count + k];
+            size_t decoded = (size_t)chunk->rows * value_size;
+            if (chunk->encoding != INT_ENCODING_PLAIN) {
+                if (int_codec_decode(chunk->encoding, chunk->data, (size_t)chunk->stored_size, out,
+                                     chunk->rows, value_size) != 0) {
+                    return invalid_file(file);
+                }
+            } else if (COLUMN_HOST_BIG_ENDIAN) {
+                swap_values(out, chunk->data, chunk->rows, value_size);
+            } else {
+                continue;
+            }
+            chunk->data = out;
+            out += decoded + (-decoded % COLUMN_FILE_ALIGNMENT);
+        }
+    }
+    return 0;
+}
+
+// Replace the mapped MYBZ file with its decompressed contents
+static int decompress_file(ColumnFile* file, const char* filename) {
+    mapped_file_close(&file->file);
+    BlockFile blocks;
+    if (block_file_open(&blocks, filename) != 0) return -1;
+
+    void* data = NULL;
+    size_t size = (size_t)blocks.raw_size;
+    if (posix_memalign(&data, COLUMN_FILE_ALIGNMENT, size ? size : 1) != 0) {
+        block_file_close(&blocks);
+        errno = ENOMEM;
+        return -1;
+    }
+    if (block_file_read_all(&blocks, data, 0) != 0) {
+        int saved = errno;
+        free(data);
+        block_file_close(&blocks);
+        errno = saved;
+        return -1;
+    }
+    file->stored_size = blocks.file.size;
+    block_file_close(&blocks);
+
+    file->file.data = data;
+    file->file.size = size;
+    file->file.is_mapped = 0;
+    file->compressed = 1;
+    return 0;
+}
+
+int column_file_open(ColumnFile* file, const char* filename) {
+    memset(file, 0, sizeof(*file));
+    if (mapped_file_open(&file->file, filename, 0) != 0) return -1;
+    file->stored_size = file->file.size;
+    if (block_file_detect(file->file.data, file->file.size) &&
+        decompress_file(file, filename) != 0) {
+        int saved = errno;
+        column_file_close(file);
+        errno = saved;
+        return -1;
+    }
+
+    const unsigned char* bytes = (const unsigned char*)file->file.data;
+    if (file->file.size < 6 || memcmp(bytes, COLUMN_FILE_MAGIC, 4) != 0) {
+        return invalid_file(file);
+    }
+
+    int version = bytes[4] << 8 | bytes[5];
+    if (version == 1) return open_v1(file);
+    if (version == 2) return open_v2(file);
+    return invalid_file(file);
+}
+
+void column_file_close(ColumnFile* file) {
+    mapped_file_close(&file->file);
+    free(file->columns);
+    free(file->chunks);
+    free(file->converted);
+    memset(file, 0, sizeof(*file));
+}
+
+size_t column_file_verify(const ColumnFile* file) {
+    if (file->checksum_type == CHECKSUM_NONE) return 0;
+
+    size_t mismatches = 0;
+    for (size_t c = 0; c < file->column_count; c++) {
+        size_t value_size = column_type_size(file->columns[c].type);
+        for (size_t k = 0; k < file->chunk_count; k++) {
+            const ColumnChunk* chunk = &file->chunks[c * file->chunk_count + k];
+            // Version 1 checksums were taken over the values in host order
+            const void* stored = file->version == 1 ? chunk->data
+                                                    : file->file.data + chunk->file_offset;
+            size_t stored_size = file->version == 1 ? (size_t)chunk->rows * value_size
+                                                    : (size_t)chunk->stored_size;
+            uint64_t actual = checksum_compute(file->checksum_type, stored, stored_size);
+            if (actual != chunk->checksum) mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+int column_file_find(const ColumnFile* file, const char* name) {
+    for (size_t c = 0; c < file->column_count; c++) {
+        if (strcmp(file->columns[c].name, name) == 0) return (int)c;
+    }
+    return -1;
+}
+
+const ColumnChunk* column_file_chunk(const ColumnFile* file, size_t column, size_t chunk) {
+    if (column >= file->column_count || chunk >= file->chunk_count) return NULL;
+    return &file->chunks[column * file->chunk_count + chunk];
+}
+
+size_t column_file_next_chunk(const ColumnFile* file, const ColumnPredicate* predicate,
+                              size_t chunk) {
+    if (predicate->column >= file->column_count) return file->chunk_count;
+
+    const ColumnChunk* chunks = &file->chunks[predicate->column * file->chunk_count];
+    if (file->columns[predicate->column].type == COLUMN_FLOAT64) {
+        for (; chunk < file->chunk_count; chunk++) {
+            if (chunks[chunk].max.f >= predicate->low.f &&
+                chunks[chunk].min.f <= predicate->high.f) break;
+        }
+    } else {
+        for (; chunk < file->chunk_count; chunk++) {
+            if (chunks[chunk].max.i >= predicate->low.i &&
+                chunks[chunk].min.i <= predicate->high.i) break;
+        }
+    }
+    return chunk;
+}
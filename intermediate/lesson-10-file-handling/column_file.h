@@ -0,0 +1,197 @@
+/*
+ * column_file.h - "MYFT" version 2: a columnar binary file you can mmap
+ *
+ * Version 1 of the custom format (see binary_file_operations.c) is a
+ * 16-byte header followed by big-endian uint32 records. Reading it means
+ * one ntohl() per value, and finding "all records between 200 and 300"
+ * means reading every record.
+ *
+ * Version 2 stores each column separately, split into chunks of
+ * `rows_per_chunk` rows:
+ *
+ *   [header, 64 bytes][chunk][chunk]...[chunk][footer index]
+ *
+ * - Values are stored little-endian, the native order of x86 and ARM, so
+ *   on those hosts a chunk in the mapped file already *is* a C array.
+ * - Every chunk starts on a 64-byte boundary (a cache line, and enough
+ *   alignment for any SIMD load).
+ * - The footer records where each chunk lives plus its min/max values, so
+ *   a reader can jump straight to one column and skip chunks that can't
+ *   contain what it is looking for.
+ * - Each chunk carries a CRC32C (or xxHash64) checksum, so a damaged file
+ *   is detected without trusting a single bit of it.
+ *
+ * Version 1 files can still be opened; they appear as a single INT32
+ * column named "value".
+ *
+ * Integer chunks can also be stored encoded (column_writer_set_encoding()):
+ * the writer picks frame-of-reference or delta bit-packing, varints or
+ * run lengths per chunk, whichever is smallest (int_codec.h), and the
+ * reader decodes them into memory at open.
+ *
+ * A file can also be written compressed (column_writer_set_compression()):
+ * it is then wrapped in a block_file.h container, which column_file_open()
+ * recognizes and decompresses into memory with one thread per CPU.
+ *
+ * For frontend developers: This is the idea behind Parquet and Arrow -
+ * think of a Float64Array per column that you can hand to a Web Worker
+ * without serializing anything.
+ */
+
+#ifndef COLUMN_FILE_H
+#define COLUMN_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "checksum.h"
+#include "int_codec.h"
+#include "mapped_file.h"
+
+#define COLUMN_FILE_MAGIC "MYFT"
+#define COLUMN_FILE_VERSION 2
+#define COLUMN_FILE_ALIGNMENT 64
+#define COLUMN_NAME_MAX 32          // Including the terminating NUL
+#define COLUMN_DEFAULT_CHUNK_ROWS 65536
+
+typedef enum {
+    COLUMN_INT32,
+    COLUMN_INT64,
+    COLUMN_FLOAT64
+} ColumnType;
+
+// Min/max statistics: `i` for integer columns, `f` for COLUMN_FLOAT64
+typedef union {
+    int64_t i;
+    double f;
+} ColumnValue;
+
+typedef struct {
+    const char* name;
+    ColumnType type;
+} ColumnSpec;
+
+typedef struct {
+    char name[COLUMN_NAME_MAX];
+    ColumnType type;
+    ColumnValue min;            // Over the whole column
+    ColumnValue max;
+} ColumnInfo;
+
+typedef struct {
+    const void* data;           // rows values of the column's type, 64-byte aligned
+    uint64_t first_row;
+    uint32_t rows;
+    ColumnValue min;
+    ColumnValue max;
+    uint64_t file_offset;       // Where the chunk is stored in the file
+    uint64_t stored_size;       // Bytes in the file (less than rows * size if encoded)
+    IntEncoding encoding;       // INT_ENCODING_PLAIN unless the writer encoded it
+    uint64_t checksum;          // Of the stored bytes (see ColumnFile.checksum_type)
+} ColumnChunk;
+
+// Inclusive range on one column; use the member matching the column type
+typedef struct {
+    size_t column;
+    ColumnValue low;
+    ColumnValue high;
+} ColumnPredicate;
+
+// Writing: rows are buffered per column and written one chunk at a time
+
+typedef struct {
+    FILE* file;
+    ColumnInfo* columns;
+    size_t column_count;
+    uint32_t rows_per_chunk;
+    uint64_t row_count;
+    uint64_t offset;            // Current end of file
+    char* buffer;               // One chunk per column
+    size_t* buffer_offsets;     // Start of each column's chunk in buffer
+    uint32_t buffered;          // Rows waiting in buffer
+    char* swapped;              // Little-endian copy of a chunk (big-endian hosts only)
+    ChecksumType checksum;
+    unsigned char* index;       // Encoded chunk entries + checksums, row group by row group
+    size_t index_used;
+    size_t index_capacity;
+    int encode;                 // 1 = integer chunks may be stored encoded
+    unsigned char* encoded;     // Output of one int_codec_encode()
+    char* filename;
+    int compress;               // 1 = `file` is a temporary file, compressed into filename at close
+} ColumnWriter;
+
+// Create `filename` with the given columns. rows_per_chunk = 0 picks
+// COLUMN_DEFAULT_CHUNK_ROWS. Chunks are checksummed with CRC32C unless
+// column_writer_set_checksum() says otherwise. Returns 0 on success, -1
+// on failure.
+int column_writer_open(ColumnWriter* writer, const char* filename,
+                       const ColumnSpec* columns, size_t column_count,
+                       uint32_t rows_per_chunk);
+
+// Choose CHECKSUM_NONE, CHECKSUM_CRC32C or CHECKSUM_XXH64. Only possible
+// before the first chunk is written. Returns 0 on success, -1 otherwise.
+int column_writer_set_checksum(ColumnWriter* writer, ChecksumType type);
+
+// Let the writer store each INT32/INT64 chunk in the smallest encoding
+// int_codec_choose() finds for it. Can be switched between chunks.
+// Returns 0 on success, -1 if out of memory.
+int column_writer_set_encoding(ColumnWriter* writer, int enabled);
+
+// Write the file into a temporary file and compress it into a MYBZ
+// block file at close. Only possible before the first chunk is written.
+// Returns 0 on success, -1 otherwise.
+int column_writer_set_compression(ColumnWriter* writer, int enabled);
+
+// Append `rows` rows. values[c] points at `rows` values for column c.
+// Returns 0 on success, -1 on write failure.
+int column_writer_append(ColumnWriter* writer, const void* const* values, size_t rows);
+
+// Flush buffered rows and write the footer index. Returns 0 on success,
+// -1 on failure (the writer is released either way).
+int column_writer_close(ColumnWriter* writer);
+
+// Reading
+
+typedef struct {
+    MappedFile file;
+    int version;                // 1 or 2
+    uint64_t row_count;
+    uint32_t rows_per_chunk;
+    size_t column_count;
+    size_t chunk_count;         // Per column
+    ColumnInfo* columns;
+    ColumnChunk* chunks;        // column_count * chunk_count, column by column
+    void* converted;            // Decoded or byte-swapped chunks that can't be used in place
+    ChecksumType checksum_type; // CHECKSUM_LEGACY for version 1 files
+    uint64_t stored_size;       // Size on disk (smaller than file.size if compressed)
+    int compressed;             // 1 = a MYBZ file, decompressed at open
+} ColumnFile;
+
+// Map and validate `filename`. The footer index is checked against its
+// checksum; chunk data is only read when used. Returns 0 on success, -1
+// on failure with errno set (EINVAL for a file that isn't a valid MYFT
+// file).
+int column_file_open(ColumnFile* file, const char* filename);
+void column_file_close(ColumnFile* file);
+
+// Recompute every chunk checksum. Returns the number of chunks that don't
+// match (0 when all match or the file has no checksums).
+size_t column_file_verify(const ColumnFile* file);
+
+// Column index by name, or -1 if there is no such column
+int column_file_find(const ColumnFile* file, const char* name);
+
+const ColumnChunk* column_file_chunk(const ColumnFile* file, size_t column, size_t chunk);
+
+// Index of the first chunk at or after `chunk` whose min/max overlap the
+// predicate's range, or chunk_count if there is none:
+//
+//   for (size_t k = column_file_next_chunk(f, &p, 0); k < f->chunk_count;
+//        k = column_file_next_chunk(f, &p, k + 1)) { ... }
+size_t column_file_next_chunk(const ColumnFile* file, const ColumnPredicate* predicate,
+                              size_t chunk);
+
+size_t column_type_size(ColumnType type);
+
+#endif // COLUMN_FILE_H
@@ -0,0 +1,379 @@
+/*
+ * config_store.c - Hashed key=value configuration with hot reload
+ *
+ * Implementation notes:
+ * - A snapshot is three allocations: a NUL-terminated copy of the file,
+ *   the value array, and the slot array. Lines are cut in place in the
+ *   copy, so keys and values need no allocations of their own.
+ * - The file is read into memory rather than mapped: a config file is
+ *   small, and a mapping of a file that an editor truncates while we
+ *   parse it would fault (SIGBUS) instead of just reading short.
+ * - The table is the same shape as string_intern.c: linear probing,
+ *   slots with a 16-bit hash tag next to the index, at most half full.
+ *   It is built once and never grows, so lookups need no synchronization.
+ * - Values are classified once at load: bool words first, then a whole-
+ *   string integer, then a whole-string double (both with num_parse from
+ *   common/). Anything else is a string.
+ * - Readers register in one of two counters chosen by the epoch's parity
+ *   and re-check the epoch, so a reload that swapped the pointer and
+ *   bumped the epoch only has to wait for the counter of the old parity
+ *   to drain before freeing the old snapshot. New readers use the other
+ *   counter and are never waited for. This is the two-counter scheme of
+ *   userspace RCU, with sched_yield() as the writer's wait.
+ * - The watcher blocks in poll() on the inotify descriptor and a pipe;
+ *   closing down writes a byte to the pipe instead of cancelling a
+ *   thread that might be in the middle of a reload.
+ */
+
+#define _GNU_SOURCE
+
+#include "config_store.h"
+#include "mapped_file.h"
+#include "num_parse.h"
+#include "simd_scan.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#define CONFIG_MAX_KEYS 65535
+
+// FNV-1a, as in string_intern.c
+static uint32_t hash_key(const char* key, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)key[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static char* trim(char* str) {
+    while (isspace((unsigned char)*str)) str++;
+    char* end = str + strlen(str);
+    while (end > str && isspace((unsigned char)end[-1])) end--;
+    *end = '\0';
+    return str;
+}
+
+int config_split_line(char* line, char** key, char** value) {
+    char* end = line + strlen(line);
+    char* equals = (char*)scan_find(line, end, SCAN_EQUALS);
+    if (equals == end) return 0;
+
+    *equals = '\0';
+    *key = trim(line);
+    *value = trim(equals + 1);
+    return **key != '\0' && **value != '\0';
+}
+
+static void classify_value(ConfigValue* value) {
+    static const char* const true_words[] = {"true", "yes", "on"};
+    static const char* const false_words[] = {"false", "no", "off"};
+    const char* text = value->text;
+
+    value->type = CONFIG_STRING;
+    value->integer = 0;
+    value->number = 0.0;
+    value->boolean = 0;
+
+    for (int i = 0; i < 3; i++) {
+        if (strcasecmp(text, true_words[i]) == 0 || strcasecmp(text, false_words[i]) == 0) {
+            value->type = CONFIG_BOOL;
+            value->boolean = strcasecmp(text, true_words[i]) == 0;
+            value->integer = value->boolean;
+            return;
+        }
+    }
+
+    // Only plain decimal numbers: num_parse rejects "nan", "inf" and hex
+    // floats, which in a config file are almost always strings. An integer
+    // too big for int64_t is still a valid double.
+    size_t length = strlen(text);
+    int64_t integer;
+    double number;
+    if (parse_int64(text, length, &integer) == 0) {
+        value->type = CONFIG_INT;
+        value->integer = integer;
+        value->number = (double)integer;
+    } else if (parse_double(text, length, &number) == 0) {
+        value->type = CONFIG_DOUBLE;
+        value->number = number;
+    }
+}
+
+// Slot of `key`, or of the empty slot where it would go
+static size_t probe(const ConfigSnapshot* snapshot, const char* key, uint32_t hash) {
+    size_t mask = snapshot->slot_count - 1;
+    size_t index = hash & mask;
+    for (;;) {
+        uint32_t slot = snapshot->slots[index];
+        if (slot == 0) return index;
+        if ((slot & 0xFFFF0000u) == (hash & 0xFFFF0000u) &&
+            strcmp(snapshot->values[(slot & 0xFFFFu) - 1].key, key) == 0) {
+            return index;
+        }
+        index = (index + 1) & mask;
+    }
+}
+
+ConfigSnapshot* config_snapshot_parse(const char* text, size_t length) {
+    // Every key needs a line, so the line count bounds the table size
+    size_t line_count = 1;
+    for (const char* p = text; (p = memchr(p, '\n', (size_t)(text + length - p))) != NULL; p++) {
+        line_count++;
+    }
+
+    ConfigSnapshot* snapshot = calloc(1, sizeof(ConfigSnapshot));
+    if (snapshot == NULL) return NULL;
+
+    snapshot->slot_count = 16;
+    while (snapshot->slot_count < line_count * 2) snapshot->slot_count *= 2;
+    snapshot->text = malloc(length + 1);
+    snapshot->values = malloc(line_count * sizeof(ConfigValue));
+    snapshot->slots = calloc(snapshot->slot_count, sizeof(uint32_t));
+    if (snapshot->text == NULL || snapshot->values == NULL || snapshot->slots == NULL) {
+        config_snapshot_free(snapshot);
+        errno = ENOMEM;
+        return NULL;
+    }
+    memcpy(snapshot->text, text, length);
+    snapshot->text[length] = '\0';
+
+    char* line = snapshot->text;
+    char* text_end = snapshot->text + length;
+    while (line < text_end) {
+        char* line_end = (char*)scan_find(line, text_end, SCAN_NEWLINE);
+        *line_end = '\0';
+        char* next = line_end + 1;
+
+        char* trimmed = trim(line);
+        char *key, *value;
+        line = next;
+        if (*trimmed == '#' || !config_split_line(trimmed, &key, &value)) continue;
+
+        uint32_t hash = hash_key(key, strlen(key));
+        size_t index = probe(snapshot, key, hash);
+        ConfigValue* entry;
+        if (snapshot->slots[index] != 0) {
+            // Repeated key: the later line wins, the position stays
+            entry = &snapshot->values[(snapshot->slots[index] & 0xFFFFu) - 1];
+        } else {
+            if (snapshot->count == CONFIG_MAX_KEYS) {
+                config_snapshot_free(snapshot);
+                errno = EINVAL;
+                return NULL;
+            }
+            entry = &snapshot->values[snapshot->count++];
+            snapshot->slots[index] = (hash & 0xFFFF0000u) | (uint32_t)snapshot->count;
+            entry->key = key;
+        }
+        entry->text = value;
+        classify_value(entry);
+    }
+    return snapshot;
+}
+
+ConfigSnapshot* config_snapshot_load(const char* filename) {
+    MappedFile file;
+    if (mapped_file_open(&file, filename, MAPPED_FILE_NO_MMAP) != 0) return NULL;
+    ConfigSnapshot* snapshot = config_snapshot_parse(file.data, file.size);
+    int saved = errno;
+    mapped_file_close(&file);
+    errno = saved;
+    return snapshot;
+}
+
+void config_snapshot_free(ConfigSnapshot* snapshot) {
+    if (snapshot == NULL) return;
+    free(snapshot->text);
+    free(snapshot->values);
+    free(snapshot->slots);
+    free(snapshot);
+}
+
+const ConfigValue* config_lookup(const ConfigSnapshot* snapshot, const char* key) {
+    uint32_t slot = snapshot->slots[probe(snapshot, key, hash_key(key, strlen(key)))];
+    return slot != 0 ? &snapshot->values[(slot & 0xFFFFu) - 1] : NULL;
+}
+
+long long config_get_int(const ConfigSnapshot* snapshot, const char* key, long long fallback) {
+    const ConfigValue* value = config_lookup(snapshot, key);
+    return value != NULL && value->type == CONFIG_INT ? value->integer : fallback;
+}
+
+double config_get_double(const ConfigSnapshot* snapshot, const char* key, double fallback) {
+    const ConfigValue* value = config_lookup(snapshot, key);
+    if (value == NULL || (value->type != CONFIG_DOUBLE && value->type != CONFIG_INT)) {
+        return fallback;
+    }
+    return value->number;
+}
+
+int config_get_bool(const ConfigSnapshot* snapshot, const char* key, int fallback) {
+    const ConfigValue* value = config_lookup(snapshot, key);
+    return value != NULL && value->type == CONFIG_BOOL ? value->boolean : fallback;
+}
+
+const char* config_get_string(const ConfigSnapshot* snapshot, const char* key,
+                              const char* fallback) {
+    const ConfigValue* value = config_lookup(snapshot, key);
+    return value != NULL ? value->text : fallback;
+}
+
+int config_store_open(ConfigStore* store, const char* filename) {
+    memset(store, 0, sizeof(*store));
+    store->notify_fd = -1;
+    store->stop_pipe[0] = store->stop_pipe[1] = -1;
+
+    store->filename = strdup(filename);
+    if (store->filename == NULL) return -1;
+    const char* slash = strrchr(store->filename, '/');
+    store->basename = slash != NULL ? slash + 1 : store->filename;
+
+    store->current = config_snapshot_load(filename);
+    if (store->current == NULL) {
+        int saved = errno;
+        free(store->filename);
+        errno = saved;
+        return -1;
+    }
+    pthread_mutex_init(&store->reload_lock, NULL);
+    return 0;
+}
+
+void config_store_close(ConfigStore* store) {
+    config_store_unwatch(store);
+    config_snapshot_free(store->current);
+    pthread_mutex_destroy(&store->reload_lock);
+    free(store->filename);
+    store->current = NULL;
+    store->filename = NULL;
+}
+
+const ConfigSnapshot* config_read_begin(ConfigStore* store, unsigned long* ticket) {
+    for (;;) {
+        unsigned long epoch = __atomic_load_n(&store->epoch, __ATOMIC_SEQ_CST);
+        __atomic_fetch_add(&store->readers[epoch & 1], 1, __ATOMIC_SEQ_CST);
+
+        // If a reload bumped the epoch in between, it may already have
+        // finished waiting on this counter - register again
+        if (__atomic_load_n(&store->epoch, __ATOMIC_SEQ_CST) == epoch) {
+            *ticket = epoch;
+            return __atomic_load_n(&store->current, __ATOMIC_SEQ_CST);
+        }
+        __atomic_fetch_sub(&store->readers[epoch & 1], 1, __ATOMIC_RELEASE);
+    }
+}
+
+void config_read_end(ConfigStore* store, unsigned long ticket) {
+    __atomic_fetch_sub(&store->readers[ticket & 1], 1, __ATOMIC_RELEASE);
+}
+
+int config_store_reload(ConfigStore* store) {
+    ConfigSnapshot* next = config_snapshot_load(store->filename);
+    if (next == NULL) return -1;
+
+    pthread_mutex_lock(&store->reload_lock);
+    ConfigSnapshot* old = __atomic_exchange_n(&store->current, next, __ATOMIC_SEQ_CST);
+    unsigned long epoch = __atomic_load_n(&store->epoch, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&store->epoch, epoch + 1, __ATOMIC_SEQ_CST);
+
+    // Readers that registered under the old epoch may still hold `old`
+    while (__atomic_load_n(&store->readers[epoch & 1], __ATOMIC_ACQUIRE) != 0) {
+        sched_yield();
+    }
+    __atomic_fetch_add(&store->reload_count, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&store->reload_lock);
+
+    config_snapshot_free(old);
+    return 0;
+}
+
+unsigned long config_store_reloads(ConfigStore* store) {
+    return __atomic_load_n(&store->reload_count, __ATOMIC_RELAXED);
+}
+
+static void* watch_main(void* arg) {
+    ConfigStore* store = (ConfigStore*)arg;
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    struct pollfd fds[2] = {
+        {store->notify_fd, POLLIN, 0},
+        {store->stop_pipe[0], POLLIN, 0}
+    };
+
+    for (;;) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents != 0) break;
+
+        ssize_t got = read(store->notify_fd, buffer, sizeof(buffer));
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) break;
+
+        int changed = 0;
+        const struct inotify_event* event;
+        for (char* p = buffer; p < buffer + got; p += sizeof(*event) + event->len) {
+            event = (const struct inotify_event*)p;
+            if (event->len > 0 && strcmp(event->name, store->basename) == 0) changed = 1;
+        }
+
+        // A failed reload (file briefly missing, unreadable) keeps the
+        // current snapshot; the next event tries again
+        if (changed) config_store_reload(store);
+    }
+    return NULL;
+}
+
+int config_store_watch(ConfigStore* store) {
+    if (store->watching) return 0;
+
+    // The directory part of the filename, or "." if there is none
+    size_t dir_length = (size_t)(store->basename - store->filename);
+    char* directory = dir_length > 0 ? strndup(store->filename, dir_length) : strdup(".");
+    if (directory == NULL) return -1;
+
+    store->notify_fd = inotify_init1(IN_CLOEXEC);
+    int ok = store->notify_fd >= 0 &&
+             inotify_add_watch(store->notify_fd, directory, IN_CLOSE_WRITE | IN_MOVED_TO) >= 0 &&
+             pipe2(store->stop_pipe, O_CLOEXEC) == 0;
+    int saved = errno;
+    free(directory);
+
+    if (ok && pthread_create(&store->watcher, NULL, watch_main, store) == 0) {
+        store->watching = 1;
+        return 0;
+    }
+    if (ok) saved = EAGAIN;
+
+    if (store->notify_fd >= 0) close(store->notify_fd);
+    if (store->stop_pipe[0] >= 0) close(store->stop_pipe[0]);
+    if (store->stop_pipe[1] >= 0) close(store->stop_pipe[1]);
+    store->notify_fd = store->stop_pipe[0] = store->stop_pipe[1] = -1;
+    errno = saved;
+    return -1;
+}
+
+void config_store_unwatch(ConfigStore* store) {
+    if (!store->watching) return;
+
+    char wake = 1;
+    while (write(store->stop_pipe[1], &wake, 1) < 0 && errno == EINTR) {
+    }
+    pthread_join(store->watcher, NULL);
+
+    close(store->notify_fd);
+    close(store->stop_pipe[0]);
+    close(store->stop_pipe[1]);
+    store->notify_fd = store->stop_pipe[0] = store->stop_pipe[1] = -1;
+    store->watching = 0;
+}
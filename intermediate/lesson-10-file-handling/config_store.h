@@ -0,0 +1,116 @@
+/*
+ * config_store.h - Hashed key=value configuration with hot reload
+ *
+ * A config file is loaded into an immutable snapshot: an open-addressing
+ * hash table whose values are parsed once, at load time, into the types
+ * they look like (integer, double, boolean or string). Looking up
+ * "server_port" is one hash and usually one probe, and reading it as an
+ * int is a field access - no strcmp() scan, no atoi() per lookup, and no
+ * limit on the number of entries.
+ *
+ * A ConfigStore holds a pointer to the current snapshot. Reloading builds
+ * a complete new snapshot off to the side and swaps the pointer, so a
+ * reader sees either the old configuration or the new one, never half of
+ * each. Readers never take a lock: they mark themselves active with an
+ * atomic counter, and the old snapshot is freed only once every reader
+ * that could still see it has finished (read-copy-update).
+ *
+ * config_store_watch() adds a thread that reloads the file whenever
+ * inotify reports it was written or replaced.
+ *
+ * For frontend developers: Like keeping app settings in an immutable
+ * object and replacing the whole object on change (Redux-style) instead
+ * of mutating it - anyone holding the old object keeps a consistent view.
+ */
+
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    CONFIG_STRING,      // Anything that isn't one of the types below
+    CONFIG_INT,         // "8080", "-3"
+    CONFIG_DOUBLE,      // "0.75", "1e-3"
+    CONFIG_BOOL         // true/false, yes/no, on/off (any case)
+} ConfigType;
+
+typedef struct {
+    const char* key;
+    const char* text;       // The value as written, trimmed
+    ConfigType type;
+    long long integer;      // Set for CONFIG_INT (and CONFIG_BOOL as 0/1)
+    double number;          // Set for CONFIG_INT and CONFIG_DOUBLE
+    int boolean;            // Set for CONFIG_BOOL
+} ConfigValue;
+
+// One loaded configuration. Never changes after it is built.
+typedef struct {
+    ConfigValue* values;    // In file order; a repeated key keeps its last value
+    size_t count;
+    uint32_t* slots;        // 0 = empty, else (hash tag << 16) | (index + 1)
+    size_t slot_count;      // Always a power of two
+    char* text;             // Copy of the file that keys and values point into
+} ConfigSnapshot;
+
+typedef struct {
+    char* filename;
+    const char* basename;           // Part of `filename` after the last '/'
+    ConfigSnapshot* current;        // Swapped atomically on reload
+    unsigned long epoch;            // Bumped by every swap
+    unsigned long readers[2];       // Active readers per epoch parity
+    unsigned long reload_count;
+    pthread_mutex_t reload_lock;    // Serializes reloads, never taken by readers
+    pthread_t watcher;
+    int watching;
+    int notify_fd;                  // inotify instance watching the directory
+    int stop_pipe[2];               // Written to wake the watcher up for exit
+} ConfigStore;
+
+// Split "key = value" in place. Returns 1 with trimmed `key` and `value`
+// pointing into `line`, or 0 if the line has no '=' or an empty side.
+int config_split_line(char* line, char** key, char** value);
+
+// Snapshots on their own, for callers that don't need reloading.
+// Returns NULL with errno set on failure (EINVAL if more than 65535 keys).
+ConfigSnapshot* config_snapshot_load(const char* filename);
+ConfigSnapshot* config_snapshot_parse(const char* text, size_t length);
+void config_snapshot_free(ConfigSnapshot* snapshot);
+
+// Lookup. `key` must be NUL-terminated; NULL if absent.
+const ConfigValue* config_lookup(const ConfigSnapshot* snapshot, const char* key);
+
+// Typed getters: `fallback` when the key is missing or has another type
+// (an integer is accepted where a double is asked for)
+long long config_get_int(const ConfigSnapshot* snapshot, const char* key, long long fallback);
+double config_get_double(const ConfigSnapshot* snapshot, const char* key, double fallback);
+int config_get_bool(const ConfigSnapshot* snapshot, const char* key, int fallback);
+const char* config_get_string(const ConfigSnapshot* snapshot, const char* key,
+                              const char* fallback);
+
+// Load `filename` into a new store. Returns 0 on success, -1 with errno set.
+int config_store_open(ConfigStore* store, const char* filename);
+void config_store_close(ConfigStore* store);
+
+// Re-read the file and swap the new snapshot in. On failure the current
+// snapshot stays in place and -1 is returned with errno set.
+int config_store_reload(ConfigStore* store);
+
+// Read-side critical section. The snapshot returned by begin stays valid
+// until the matching end; `ticket` is passed from one to the other.
+// Sections are short: a reload waits for the ones that started before it.
+const ConfigSnapshot* config_read_begin(ConfigStore* store, unsigned long* ticket);
+void config_read_end(ConfigStore* store, unsigned long ticket);
+
+// Start/stop the inotify thread that reloads on change. The directory is
+// watched rather than the file, so editors that save by writing a new
+// file and renaming it over the old one are noticed too.
+int config_store_watch(ConfigStore* store);
+void config_store_unwatch(ConfigStore* store);
+
+// Number of successful reloads so far
+unsigned long config_store_reloads(ConfigStore* store);
+
+#endif // CONFIG_STORE_H
@@ -0,0 +1,282 @@
+/*
+ * csv_reader.c - Streaming, zero-copy CSV reader (RFC 4180)
+ *
+ * Implementation notes:
+ * - Fields are returned as slices into the read buffer, so a record costs
+ *   no allocations and no copies, no matter how many rows the file has.
+ * - Quoted fields may contain commas, newlines and "" escapes. Because a
+ *   quoted newline is data, records are found by the parser itself rather
+ *   than by splitting on '\n' first (which is what fgets() would do).
+ * - Delimiters are located with the SIMD structural scanner (simd_scan.c),
+ *   which classifies 64 bytes at a time instead of testing each byte.
+ * - Regular files are memory-mapped (mapped_file.c) and parsed in place,
+ *   so not even the read() copy is made. Anything that can't be mapped
+ *   is streamed through the read buffer instead.
+ * - A record that straddles the end of the buffer is moved to the front
+ *   and completed by the next read, so only partial records are ever copied.
+ */
+
+#include "csv_reader.h"
+#include "mapped_file.h"
+#include "num_parse.h"
+#include "simd_scan.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    CsvRecordCallback callback;
+    void* user_data;
+    size_t record_number;
+    size_t delivered;
+    int stopped;
+    CsvField fields[CSV_MAX_FIELDS];
+} ScanState;
+
+#define CSV_CLASSES (SCAN_COMMA | SCAN_NEWLINE | SCAN_QUOTE)
+
+// Parse one record with a cursor that may already hold the classified
+// block, so consecutive records share the SIMD work
+static const char* parse_record(ScanCursor* cursor, const char* p, const char* end,
+                                int at_eof, CsvField* fields, int max_fields,
+                                int* field_count) {
+    int count = 0;
+
+    for (;;) {
+        CsvField field = {p, 0, 0, 0};
+        const char* delimiter;
+
+        if (p < end && *p == '"') {
+            // Quoted field: runs until a quote that is not followed by another quote
+            const char* start = p + 1;
+            const char* quote = start;
+            field.quoted = 1;
+
+            for (;;) {
+                quote = scan_cursor_next(cursor, quote);
+                while (quote < end && *quote != '"') {
+                    quote = scan_cursor_next(cursor, quote + 1);
+                }
+                if (quote == end) {
+                    if (!at_eof) return NULL;
+                    // Unterminated quote: be lenient and take the rest of the input
+                    break;
+                }
+                if (quote + 1 == end && !at_eof) {
+                    return NULL;  // Can't tell yet whether this is a "" escape
+                }
+                if (quote + 1 < end && quote[1] == '"') {
+                    field.has_escapes = 1;
+                    quote += 2;
+                    continue;
+                }
+                break;
+            }
+            field.data = start;
+            field.length = (size_t)(quote - start);
+            p = quote < end ? quote + 1 : end;
+        }
+
+        // Find the delimiter; stray quotes in unquoted data (or after a
+        // closing quote) are treated as ordinary characters
+        delimiter = scan_cursor_next(cursor, p);
+        while (delimiter < end && *delimiter == '"') {
+            delimiter = scan_cursor_next(cursor, delimiter + 1);
+        }
+        if (!field.quoted) {
+            field.length = (size_t)(delimiter - p);
+        }
+        p = delimiter;
+
+        int at_end = (p == end);
+        if (at_end && !at_eof) return NULL;
+
+        // Record ends here: drop the '\r' of a CRLF line ending
+        if ((at_end || *p == '\n') && !field.quoted &&
+            field.length > 0 && field.data[field.length - 1] == '\r') {
+            field.length--;
+        }
+
+        if (count < max_fields) fields[count] = field;
+        count++;
+
+        if (at_end) {
+            *field_count = count;
+            return end;
+        }
+        if (*p == '\n') {
+            *field_count = count;
+            return p + 1;
+        }
+        p++;  // Skip the comma and parse the next field
+    }
+}
+
+const char* csv_parse_record(const char* p, const char* end, int at_eof,
+                             CsvField* fields, int max_fields, int* field_count) {
+    ScanCursor cursor;
+    scan_cursor_init(&cursor, p, end, CSV_CLASSES);
+    return parse_record(&cursor, p, end, at_eof, fields, max_fields, field_count);
+}
+
+// Deliver every complete record in [p, end). Returns the first byte that
+// was not consumed (the start of an incomplete record).
+static const char* scan_records(ScanState* state, const char* p, const char* end, int at_eof) {
+    ScanCursor cursor;
+    scan_cursor_init(&cursor, p, end, CSV_CLASSES);
+
+    while (p < end && !state->stopped) {
+        // Skip blank lines between records
+        if (*p == '\n') { p++; continue; }
+        if (*p == '\r' && p + 1 < end && p[1] == '\n') { p += 2; continue; }
+
+        int count = 0;
+        const char* next = parse_record(&cursor, p, end, at_eof, state->fields,
+                                        CSV_MAX_FIELDS, &count);
+        if (next == NULL) break;
+
+        CsvRecord record;
+        record.fields = state->fields;
+        record.field_count = count;
+        record.record_number = ++state->record_number;
+
+        state->delivered++;
+        if (!state->callback(&record, state->user_data)) {
+            state->stopped = 1;
+        }
+        p = next;
+    }
+    return p;
+}
+
+size_t csv_scan_buffer(const char* data, size_t length,
+                       CsvRecordCallback callback, void* user_data) {
+    ScanState state = {0};
+    state.callback = callback;
+    state.user_data = user_data;
+
+    scan_records(&state, data, data + length, 1);
+    return state.delivered;
+}
+
+// Parse a whole mapped file in place
+static void read_mapped(const MappedFile* mapped, CsvRecordCallback callback,
+                        void* user_data, CsvStats* stats) {
+    ScanState state = {0};
+    state.callback = callback;
+    state.user_data = user_data;
+
+    const char* end = scan_records(&state, mapped->data, mapped->data + mapped->size, 1);
+    if (stats != NULL) {
+        stats->records = state.delivered;
+        stats->bytes = (size_t)(end - mapped->data);
+    }
+}
+
+int csv_read_file(const char* filename, CsvRecordCallback callback,
+                  void* user_data, CsvStats* stats) {
+    MappedFile mapped;
+    if (mapped_file_open(&mapped, filename, MAPPED_FILE_SEQUENTIAL | MAPPED_FILE_NO_FALLBACK) == 0) {
+        read_mapped(&mapped, callback, user_data, stats);
+        mapped_file_close(&mapped);
+        return 0;
+    }
+
+    // Not mappable (a pipe, for example): stream it instead
+    FILE* file = fopen(filename, "rb");
+    if (file == NULL) return -1;
+
+    size_t capacity = CSV_READ_BUFFER_SIZE;
+    char* buffer = malloc(capacity);
+    if (buffer == NULL) {
+        fclose(file);
+        return -1;
+    }
+
+    ScanState state = {0};
+    state.callback = callback;
+    state.user_data = user_data;
+
+    size_t filled = 0;
+    size_t total_bytes = 0;
+    int at_eof = 0;
+    int result = 0;
+
+    while (!state.stopped) {
+        // fread() only returns short at end of file or on error
+        size_t bytes_read = fread(buffer + filled, 1, capacity - filled, file);
+        filled += bytes_read;
+        total_bytes += bytes_read;
+        if (filled < capacity) {
+            if (ferror(file)) {
+                result = -1;
+                break;
+            }
+            at_eof = 1;
+        }
+
+        const char* consumed = scan_records(&state, buffer, buffer + filled, at_eof);
+        if (at_eof) break;
+
+        size_t leftover = filled - (size_t)(consumed - buffer);
+        if (leftover == capacity) {
+            // A single record is bigger than the whole buffer: grow it
+            char* bigger = realloc(buffer, capacity * 2);
+            if (bigger == NULL) {
+                result = -1;
+                break;
+            }
+            buffer = bigger;
+            capacity *= 2;
+        } else if (leftover > 0) {
+            memmove(buffer, consumed, leftover);
+        }
+        filled = leftover;
+    }
+
+    if (stats != NULL) {
+        stats->records = state.delivered;
+        stats->bytes = total_bytes;
+    }
+
+    free(buffer);
+    fclose(file);
+    return result;
+}
+
+size_t csv_field_copy(const CsvField* field, char* dest, size_t dest_size) {
+    if (dest_size == 0) return 0;
+
+    size_t out = 0;
+    for (size_t i = 0; i < field->length && out < dest_size - 1; i++) {
+        dest[out++] = field->data[i];
+        // "" inside a quoted field stands for a single quote
+        if (field->has_escapes && field->data[i] == '"' &&
+            i + 1 < field->length && field->data[i + 1] == '"') {
+            i++;
+        }
+    }
+    dest[out] = '\0';
+    return out;
+}
+
+int csv_field_int32(const CsvField* field, int32_t* value) {
+    // A number never needs "" escapes; a field with them isn't one
+    if (field->has_escapes) {
+        *value = 0;
+        errno = EINVAL;
+        return -1;
+    }
+    return parse_int32(field->data, field->length, value);
+}
+
+int csv_field_double(const CsvField* field, double* value) {
+    if (field->has_escapes) {
+        *value = 0.0;
+        errno = EINVAL;
+        return -1;
+    }
+    return parse_double(field->data, field->length, value);
+}
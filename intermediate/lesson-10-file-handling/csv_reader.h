@@ -0,0 +1,79 @@
+/*
+ * csv_reader.h - Streaming, zero-copy CSV reader (RFC 4180)
+ *
+ * The reader walks a large buffer (or a whole memory region) and hands
+ * each record to a callback as an array of field slices. A slice is just
+ * a pointer + length into the buffer: nothing is copied or NUL-terminated
+ * until the caller asks for it with csv_field_copy(). Numeric fields are
+ * converted straight from the slice (csv_field_int32/csv_field_double).
+ *
+ * For frontend developers: Think of a streaming parser like the one behind
+ * `response.body.getReader()` - data arrives in big chunks and you process
+ * records as they complete instead of building one giant string first.
+ */
+
+#ifndef CSV_READER_H
+#define CSV_READER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Maximum number of fields stored per record (extra fields are counted
+// but not stored)
+#define CSV_MAX_FIELDS 64
+
+// Size of the streaming read buffer. Records longer than this make the
+// buffer grow, so this is a performance knob, not a limit.
+#define CSV_READ_BUFFER_SIZE (1024 * 1024)
+
+// One field of a record. `data` points into the reader's buffer and is
+// only valid during the callback.
+typedef struct {
+    const char* data;
+    size_t length;
+    int quoted;         // Field was enclosed in double quotes
+    int has_escapes;    // Field contains "" pairs (use csv_field_copy)
+} CsvField;
+
+typedef struct {
+    const CsvField* fields;
+    int field_count;        // Number of fields in the record (may exceed CSV_MAX_FIELDS)
+    size_t record_number;   // 1-based, header included
+} CsvRecord;
+
+typedef struct {
+    size_t records;
+    size_t bytes;
+} CsvStats;
+
+// Return non-zero to keep reading, 0 to stop early
+typedef int (*CsvRecordCallback)(const CsvRecord* record, void* user_data);
+
+// Parse one record starting at `p`. Returns a pointer just past the record
+// terminator, or NULL if the record is incomplete and more data is needed.
+// When `at_eof` is set, an unterminated record at the end is accepted.
+const char* csv_parse_record(const char* p, const char* end, int at_eof,
+                             CsvField* fields, int max_fields, int* field_count);
+
+// Parse every record of an in-memory region (e.g. an mmap'd file).
+// Returns the number of records delivered to the callback.
+size_t csv_scan_buffer(const char* data, size_t length,
+                       CsvRecordCallback callback, void* user_data);
+
+// Parse a file: memory-mapped when possible, otherwise streamed through a
+// large read buffer. Returns 0 on success and -1 on I/O or allocation
+// failure. `stats` may be NULL.
+int csv_read_file(const char* filename, CsvRecordCallback callback,
+                  void* user_data, CsvStats* stats);
+
+// Copy a field into `dest` as a NUL-terminated string, turning "" into ".
+// The copy is truncated to fit. Returns the length of the copied string.
+size_t csv_field_copy(const CsvField* field, char* dest, size_t dest_size);
+
+// Convert a field holding exactly one number (num_parse.h rules, no
+// surrounding spaces). Returns 0, or -1 with errno = EINVAL for anything
+// else - empty, "12abc", "N/A" - and ERANGE if it doesn't fit.
+int csv_field_int32(const CsvField* field, int32_t* value);
+int csv_field_double(const CsvField* field, double* value);
+
+#endif // CSV_READER_H
@@ -18,6 +18,9 @@
 #include <sys/stat.h>
 #include <time.h>
 
+#include "line_index.h"
+#include "mapped_file.h"
+
 // Function prototypes
 void demonstrate_file_creation_and_writing(void);
 void demonstrate_file_reading(void);
@@ -141,41 +144,27 @@ void demonstrate_file_reading(void) {
         }
     }
     
-    // Method 3: Read entire file into buffer
-    rewind(file);
-    
-    // Get file size
-    fseek(file, 0, SEEK_END);
-    long file_size = ftell(file);
-    rewind(file);
-    
-    printf("\nFile size: %ld bytes\n", file_size);
+    fclose(file);
     
-    // Allocate buffer for entire file
-    char* file_content = malloc(file_size + 1);
-    if (file_content == NULL) {
-        fprintf(stderr, "Failed to allocate memory for file content\n");
-        fclose(file);
+    // Method 3: Map the entire file into memory
+    // Instead of fseek/ftell + malloc + fread (a second full copy of the
+    // file), mmap() makes the page cache itself visible as an array.
+    MappedFile mapped;
+    if (mapped_file_open(&mapped, filename, MAPPED_FILE_SEQUENTIAL) != 0) {
+        fprintf(stderr, "Failed to map file '%s': %s\n", filename, strerror(errno));
         return;
     }
     
-    // Read entire file
-    size_t bytes_read = fread(file_content, 1, file_size, file);
-    file_content[bytes_read] = '\0';  // Null terminate
+    printf("\nFile size: %zu bytes (%s)\n", mapped.size,
+           mapped.is_mapped ? "memory-mapped, no copy" : "read into a heap buffer");
     
-    printf("Read %zu bytes from file\n", bytes_read);
+    // The mapping is not NUL-terminated, so print with an explicit length
+    int shown = mapped.size > 100 ? 100 : (int)mapped.size;
     printf("First 100 characters of file content:\n");
-    printf("\"%.100s", file_content);
-    if (strlen(file_content) > 100) {
-        printf("...\"");
-    } else {
-        printf("\"");
-    }
-    printf("\n");
+    printf("\"%.*s%s\"\n", shown, mapped.data, mapped.size > 100 ? "..." : "");
     
-    free(file_content);
-    fclose(file);
-    printf("File closed and memory freed\n\n");
+    mapped_file_close(&mapped);
+    printf("File unmapped\n\n");
 }
 
 void demonstrate_file_positioning(void) {
@@ -252,6 +241,64 @@ void demonstrate_file_positioning(void) {
     printf("First character after rewind: %c\n", ch);
     
     fclose(file);
+    
+    // fseek() jumps to a byte, not a line. To reach line N without
+    // reading the N lines before it, index the line offsets once.
+    const char* log_name = "positioning.log";
+    FILE* log_file = fopen(log_name, "w");
+    if (log_file == NULL) {
+        perror("Failed to create log file");
+        return;
+    }
+    for (int i = 0; i < 100000; i++) {
+        fprintf(log_file, "2024-01-15 09:%02d:%02d INFO  Request %d served in %d ms\n",
+                i / 60 % 60, i % 60, i, i % 97);
+    }
+    fclose(log_file);
+    
+    LineIndex index;
+    if (line_index_open(&index, log_name, LINE_INDEX_DEFAULT_STRIDE) != 0) {
+        perror("Failed to index log file");
+        return;
+    }
+    
+    struct stat index_stat;
+    long index_size = stat("positioning.log.idx", &index_stat) == 0 ? (long)index_stat.st_size : -1;
+    printf("\nIndexed %s: %llu lines, %llu bytes\n", log_name,
+           (unsigned long long)index.line_count, (unsigned long long)index.indexed_size);
+    printf("Sidecar positioning.log.idx: %ld bytes (every %u lines, varint deltas)\n",
+           index_size, index.stride);
+    
+    char line[128];
+    log_file = fopen(log_name, "r");
+    if (log_file != NULL && seek_line(log_file, &index, 76543) == 0 &&
+        fgets(line, sizeof(line), log_file) != NULL) {
+        printf("Line 76543 at byte %ld: %s", ftell(log_file) - (long)strlen(line), line);
+    }
+    if (log_file != NULL) fclose(log_file);
+    
+    // Appending, like a live application.log: only the new bytes are scanned
+    log_file = fopen(log_name, "a");
+    if (log_file != NULL) {
+        for (int i = 100000; i < 100500; i++) {
+            fprintf(log_file, "2024-01-15 10:%02d:%02d WARN  Request %d served in %d ms\n",
+                    i / 60 % 60, i % 60, i, i % 97);
+        }
+        fclose(log_file);
+    }
+    long long added = line_index_update(&index, log_name);
+    line_index_save(&index, "positioning.log.idx");
+    printf("After appending: %lld new lines indexed, %llu total\n", added,
+           (unsigned long long)index.line_count);
+    
+    log_file = fopen(log_name, "r");
+    if (log_file != NULL && seek_line(log_file, &index, index.line_count - 1) == 0 &&
+        fgets(line, sizeof(line), log_file) != NULL) {
+        printf("Last line: %s", line);
+    }
+    if (log_file != NULL) fclose(log_file);
+    
+    line_index_free(&index);
     printf("Position test completed\n\n");
 }
 
@@ -410,6 +457,8 @@ int main(void) {
     
     // Cleanup test files
     remove("position_test.txt");
+    remove("positioning.log");
+    remove("positioning.log.idx");
     printf("\nTest files cleaned up\n");
     
     return 0;
@@ -11,11 +11,25 @@
  * but with manual parsing and explicit memory management.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <errno.h>
 #include <time.h>
+#include <unistd.h>
+
+#include "async_reader.h"
+#include "config_store.h"
+#include "csv_reader.h"
+#include "log_analyzer.h"
+#include "out_sink.h"
+#include "person_table.h"
+#include "simd_scan.h"
+#include "sort.h"
+#include "text_stats.h"
 
 // Structures for different file formats
 typedef struct {
@@ -26,28 +40,31 @@ typedef struct {
     double salary;
 } Person;
 
-typedef struct {
-    char timestamp[20];
-    char level[10];
-    char component[20];
-    char message[200];
-} LogEntry;
-
 typedef struct {
     char key[50];
     char value[100];
 } ConfigEntry;
 
+typedef struct {
+    char letter;
+    int frequency;
+} LetterFrequency;
+
 // Function prototypes
 void demonstrate_csv_processing(void);
 void demonstrate_log_file_analysis(void);
+void print_log_analysis(const char* filename, const LogAnalysis* analysis, int per_thread);
+int run_log_analyzer(int argc, char* argv[]);
+int scan_logs_async(const char* const* filenames, size_t file_count);
 void demonstrate_config_file_parsing(void);
 void demonstrate_text_statistics(void);
 void create_sample_files(void);
 char* trim_whitespace(char* str);
+void strip_newline(char* line);
 int parse_csv_line(char* line, Person* person);
-int parse_log_line(char* line, LogEntry* entry);
+int parse_log_line(LogDictionary* dictionary, char* line, LogEntry* entry);
 int parse_config_line(char* line, ConfigEntry* entry);
+int person_from_csv_record(const CsvRecord* record, Person* person);
 
 void create_sample_files(void) {
     printf("=== Creating Sample Files ===\n");
@@ -61,6 +78,9 @@ void create_sample_files(void) {
         fprintf(csv_file, "1003,\"Carol Davis\",carol@company.com,42,82000.75\n");
         fprintf(csv_file, "1004,\"David Wilson\",david@company.com,29,71500.25\n");
         fprintf(csv_file, "1005,\"Eve Brown\",eve@company.com,33,79000.00\n");
+        fprintf(csv_file, "1006,\"Garcia, Frank\",frank@company.com,45,91000.00\n");
+        fprintf(csv_file, "1007,\"Hannah \"\"Hank\"\" Lee\",hannah@company.com,38,88500.00\n");
+        fprintf(csv_file, "1008,\"Ivan Petrov\",ivan@company.com,41,N/A\n");
         fclose(csv_file);
         printf("Created employees.csv\n");
     }
@@ -73,7 +93,7 @@ void create_sample_files(void) {
         fprintf(log_file, "2024-01-15 09:35:22 WARN  Auth      Failed login attempt for user 'admin'\n");
         fprintf(log_file, "2024-01-15 09:35:45 ERROR Network   Connection timeout to external API\n");
         fprintf(log_file, "2024-01-15 09:36:01 INFO  Auth      User 'alice' logged in successfully\n");
-        fprintf(log_file, "2024-01-15 09:40:12 DEBUG Cache     Cache hit rate: 85.2%\n");
+        fprintf(log_file, "2024-01-15 09:40:12 DEBUG Cache     Cache hit rate: 85.2%%\n");
         fprintf(log_file, "2024-01-15 09:45:33 ERROR Database  Query execution failed: table not found\n");
         fprintf(log_file, "2024-01-15 09:50:44 INFO  Server    Processing 1250 requests/minute\n");
         fclose(log_file);
@@ -114,161 +134,414 @@ void create_sample_files(void) {
     printf("\n");
 }
 
+// Rows collected by the CSV demo. Employees go into a columnar table, so
+// each statistic below scans one compact column instead of every Person.
+typedef struct {
+    PersonTable table;
+    OutSink* out;           // The listing, written with one write(2) per flush
+    int error_count;
+    int printed;
+} EmployeeStats;
+
+#define CSV_PRINT_LIMIT 20
+
+static int collect_employee(const CsvRecord* record, void* user_data) {
+    EmployeeStats* stats = (EmployeeStats*)user_data;
+    OutSink* out = stats->out;
+    
+    // Skip header line
+    if (record->record_number == 1) {
+        out_str(out, "  Header: ");
+        out_int(out, record->field_count);
+        out_str(out, " columns\n");
+        return 1;
+    }
+    
+    Person person;
+    if (!person_from_csv_record(record, &person)) {
+        out_str(out, "  Error parsing record ");
+        out_uint(out, record->record_number);
+        out_str(out, " (");
+        out_int(out, record->field_count);
+        out_str(out, " fields)\n");
+        stats->error_count++;
+        return 1;
+    }
+    
+    // Same text as "  Employee %zu: ID=%d, Name=\"%s\", ... Salary=$%.2f\n",
+    // without parsing a format string per row
+    if (stats->printed < CSV_PRINT_LIMIT) {
+        out_str(out, "  Employee ");
+        out_uint(out, stats->table.count + 1);
+        out_str(out, ": ID=");
+        out_int(out, person.id);
+        out_str(out, ", Name=\"");
+        out_str(out, person.name);
+        out_str(out, "\", Email=");
+        out_str(out, person.email);
+        out_str(out, ", Age=");
+        out_int(out, person.age);
+        out_str(out, ", Salary=$");
+        out_double(out, person.salary, 2);
+        out_char(out, '\n');
+        stats->printed++;
+    } else if (stats->printed == CSV_PRINT_LIMIT) {
+        out_str(out, "  ... (remaining rows not shown)\n");
+        stats->printed++;
+    }
+    
+    if (person_table_append(&stats->table, person.id, person.name, strlen(person.name),
+                            person.email, strlen(person.email), person.age, person.salary) != 0) {
+        fprintf(stderr, "Out of memory at record %zu\n", record->record_number);
+        return 0;
+    }
+    return 1;
+}
+
 void demonstrate_csv_processing(void) {
     printf("=== CSV File Processing ===\n");
     
-    FILE* file = fopen("employees.csv", "r");
-    if (file == NULL) {
-        perror("Failed to open CSV file");
+    EmployeeStats stats = {0};
+    CsvStats io_stats;
+    OutSink out;
+    
+    if (person_table_init(&stats.table, 64) != 0) {
+        fprintf(stderr, "Failed to allocate employee table\n");
         return;
     }
     
-    char line[256];
-    Person employees[10];
-    int employee_count = 0;
-    int line_number = 0;
+    printf("Processing CSV file (zero-copy, fields are slices of the mapped file):\n");
     
-    printf("Processing CSV file:\n");
+    // The sink writes to fd 1 directly: whatever printf() buffered has to
+    // go first, and the sink is flushed before printf() is used again
+    fflush(stdout);
+    if (out_sink_init(&out, STDOUT_FILENO, 0, OUT_SINK_UNLOCKED) != 0) {
+        perror("Failed to allocate output buffer");
+        person_table_free(&stats.table);
+        return;
+    }
+    stats.out = &out;
+    
+    int status = csv_read_file("employees.csv", collect_employee, &stats, &io_stats);
+    int saved_errno = errno;
+    out_sink_close(&out);
+    if (status != 0) {
+        errno = saved_errno;
+        perror("Failed to read CSV file");
+        person_table_free(&stats.table);
+        return;
+    }
     
-    while (fgets(line, sizeof(line), file) != NULL && employee_count < 10) {
-        line_number++;
-        
-        // Remove newline
-        line[strcspn(line, "\n")] = '\0';
-        
-        // Skip header line
-        if (line_number == 1) {
-            printf("  Header: %s\n", line);
-            continue;
-        }
+    printf("  Read %zu bytes, %zu records\n", io_stats.bytes, io_stats.records);
+    
+    // Each statistic is one pass over one contiguous column
+    const PersonTable* table = &stats.table;
+    if (table->count > 0) {
+        size_t top = column_argmax_f64(table->salary, table->count);
         
-        // Parse CSV line
-        if (parse_csv_line(line, &employees[employee_count])) {
-            printf("  Employee %d: ID=%d, Name=\"%s\", Email=%s, Age=%d, Salary=$%.2f\n",
-                   employee_count + 1,
-                   employees[employee_count].id,
-                   employees[employee_count].name,
-                   employees[employee_count].email,
-                   employees[employee_count].age,
-                   employees[employee_count].salary);
-            employee_count++;
-        } else {
-            printf("  Error parsing line %d: %s\n", line_number, line);
-        }
+        printf("\nCSV Statistics (%s column kernels):\n", column_backend_name());
+        printf("  Total employees: %zu\n", table->count);
+        printf("  Average salary: $%.2f\n", column_mean_f64(table->salary, table->count));
+        printf("  Salary range: $%.2f - $%.2f\n", column_min_f64(table->salary, table->count),
+               column_max_f64(table->salary, table->count));
+        printf("  Average age: %.1f years\n", column_mean_i32(table->age, table->count));
+        printf("  Age range: %d - %d\n", column_min_i32(table->age, table->count),
+               column_max_i32(table->age, table->count));
+        printf("  Highest paid: %s ($%.2f)\n", person_table_name(table, top), table->salary[top]);
+    }
+    person_table_free(&stats.table);
+    printf("\n");
+}
+
+void print_log_analysis(const char* filename, const LogAnalysis* analysis, int per_thread) {
+    const LogCounters* total = &analysis->total;
+    
+    printf("Log Analysis Results:\n");
+    printf("  File: %s (%zu bytes, %zu chunks, %d threads)\n", filename,
+           analysis->file_size, analysis->chunk_count, analysis->thread_count);
+    printf("  Total entries: %zu", total->lines);
+    if (total->malformed > 0) printf(" (%zu malformed)", total->malformed);
+    printf("\n");
+    printf("  Errors: %zu\n", log_count(&total->level_counts, LOG_LEVEL_ERROR));
+    printf("  Warnings: %zu\n", log_count(&total->level_counts, LOG_LEVEL_WARN));
+    printf("  Info messages: %zu\n", log_count(&total->level_counts, LOG_LEVEL_INFO));
+    printf("  Debug messages: %zu\n", log_count(&total->level_counts, LOG_LEVEL_DEBUG));
+    
+    // Levels beyond the built-in four were interned as they were seen
+    for (size_t id = LOG_LEVEL_BUILTIN_COUNT; id < intern_count(&total->dictionary.levels); id++) {
+        printf("  %s: %zu\n", intern_name(&total->dictionary.levels, (uint16_t)id),
+               log_count(&total->level_counts, (uint16_t)id));
+    }
+    if (total->unknown_names > 0) {
+        printf("  Names not interned: %zu\n", total->unknown_names);
     }
     
-    fclose(file);
+    if (analysis->seconds > 0) {
+        printf("  Time: %.3f s (%.1f MB/s, %.0f lines/s)\n", analysis->seconds,
+               analysis->file_size / analysis->seconds / (1024.0 * 1024.0),
+               total->lines / analysis->seconds);
+    }
     
-    // Calculate statistics
-    if (employee_count > 0) {
-        double total_salary = 0.0;
-        int total_age = 0;
-        
-        for (int i = 0; i < employee_count; i++) {
-            total_salary += employees[i].salary;
-            total_age += employees[i].age;
-        }
-        
-        printf("\nCSV Statistics:\n");
-        printf("  Total employees: %d\n", employee_count);
-        printf("  Average salary: $%.2f\n", total_salary / employee_count);
-        printf("  Average age: %.1f years\n", (double)total_age / employee_count);
-        
-        // Find highest paid employee
-        int highest_paid_index = 0;
-        for (int i = 1; i < employee_count; i++) {
-            if (employees[i].salary > employees[highest_paid_index].salary) {
-                highest_paid_index = i;
-            }
+    // Component activity analysis
+    printf("\nComponent activity:\n");
+    for (size_t i = 0; i < intern_count(&total->dictionary.components); i++) {
+        uint16_t id = analysis->components_by_count[i];
+        printf("  %s: %zu messages\n", intern_name(&total->dictionary.components, id),
+               log_count(&total->component_counts, id));
+    }
+    
+    if (per_thread) {
+        printf("\nPer-thread throughput:\n");
+        for (int t = 0; t < analysis->thread_count; t++) {
+            const LogCounters* part = &analysis->per_thread[t];
+            double mb = part->bytes / (1024.0 * 1024.0);
+            printf("  Thread %2d: %10zu lines  %9.1f MB  %8.3f s  %8.1f MB/s\n", t,
+                   part->lines, mb, part->seconds, part->seconds > 0 ? mb / part->seconds : 0.0);
         }
-        
-        printf("  Highest paid: %s ($%.2f)\n",
-               employees[highest_paid_index].name,
-               employees[highest_paid_index].salary);
     }
-    printf("\n");
 }
 
 void demonstrate_log_file_analysis(void) {
     printf("=== Log File Analysis ===\n");
     
-    FILE* file = fopen("application.log", "r");
-    if (file == NULL) {
-        perror("Failed to open log file");
+    LogAnalysis analysis;
+    
+    // The file is split into newline-aligned chunks that a pool of
+    // threads counts in parallel; each thread has private counters
+    if (log_analyze_file("application.log", 0, &analysis) != 0) {
+        perror("Failed to analyze log file");
         return;
     }
     
-    char line[512];
-    LogEntry entries[100];
-    int entry_count = 0;
-    int error_count = 0;
-    int warning_count = 0;
-    int info_count = 0;
-    
-    printf("Analyzing log file:\n");
-    
-    while (fgets(line, sizeof(line), file) != NULL && entry_count < 100) {
-        // Remove newline
-        line[strcspn(line, "\n")] = '\0';
-        
-        if (parse_log_line(line, &entries[entry_count])) {
-            printf("  [%s] %s %s: %s\n",
-                   entries[entry_count].timestamp,
-                   entries[entry_count].level,
-                   entries[entry_count].component,
-                   entries[entry_count].message);
-            
-            // Count by level
-            if (strcmp(entries[entry_count].level, "ERROR") == 0) {
-                error_count++;
-            } else if (strcmp(entries[entry_count].level, "WARN") == 0) {
-                warning_count++;
-            } else if (strcmp(entries[entry_count].level, "INFO") == 0) {
-                info_count++;
+    print_log_analysis("application.log", &analysis, 0);
+    
+    // The analyzer only keeps file offsets of the first errors, so seek
+    // straight to each one instead of storing every entry
+    LogDictionary* dictionary = &analysis.total.dictionary;
+    if (analysis.total.error_sample_count > 0) {
+        FILE* file = fopen("application.log", "r");
+        OutSink out;
+        if (file != NULL) {
+            printf("\nError messages:\n");
+            fflush(stdout);
+        }
+        if (file != NULL && out_sink_init(&out, STDOUT_FILENO, 0, OUT_SINK_UNLOCKED) == 0) {
+            for (int i = 0; i < analysis.total.error_sample_count; i++) {
+                char line[512];
+                LogEntry entry;
+                
+                fseek(file, (long)analysis.total.error_offsets[i], SEEK_SET);
+                if (fgets(line, sizeof(line), file) != NULL && parse_log_line(dictionary, line, &entry)) {
+                    out_str(&out, "  ");
+                    out_str(&out, entry.timestamp);
+                    out_str(&out, " [");
+                    out_str(&out, intern_name(&dictionary->components, entry.component));
+                    out_str(&out, "]: ");
+                    out_str(&out, entry.message);
+                    out_char(&out, '\n');
+                }
             }
-            
-            entry_count++;
+            out_sink_close(&out);
         }
+        if (file != NULL) fclose(file);
     }
     
-    fclose(file);
+    // Level and component are 2-byte IDs, not copies of the names
+    printf("\nsizeof(LogEntry): %zu bytes\n", sizeof(LogEntry));
+    
+    // A list of files is read with many reads in flight instead of one
+    // fread() at a time; this is the same as --scan on the command line
+    const char* files[] = {"application.log"};
+    printf("\nStreaming scan:\n");
+    scan_logs_async(files, 1);
+    
+    log_analysis_free(&analysis);
+    printf("\n");
+}
+
+// Per-file totals for scan_logs_async()
+typedef struct {
+    size_t lines;
+    size_t malformed;
+    size_t errors;
+    size_t warnings;
+} ScanCounts;
+
+static void scan_count_line(const char* line, size_t length, ScanCounts* counts) {
+    LogFields fields;
+    if (length > 0 && line[length - 1] == '\r') length--;
+    if (length == 0) return;
+    
+    counts->lines++;
+    if (!log_split_fields(line, length, &fields)) {
+        counts->malformed++;
+    } else if (fields.level.length == 5 && memcmp(fields.level.data, "ERROR", 5) == 0) {
+        counts->errors++;
+    } else if (fields.level.length == 4 && memcmp(fields.level.data, "WARN", 4) == 0) {
+        counts->warnings++;
+    }
+}
+
+// End of a file: count a last line without a newline, print the totals
+// ("  %-24s %10zu lines  %8zu errors  %8zu warnings  %6zu malformed")
+static void scan_finish(OutSink* out, const char* filename, ScanCounts* counts,
+                        size_t* carry_length, const char* carry) {
+    if (*carry_length > 0) scan_count_line(carry, *carry_length, counts);
+    out_str(out, "  ");
+    out_str_width(out, filename, 24);
+    out_char(out, ' ');
+    out_uint_width(out, counts->lines, 10);
+    out_str(out, " lines  ");
+    out_uint_width(out, counts->errors, 8);
+    out_str(out, " errors  ");
+    out_uint_width(out, counts->warnings, 8);
+    out_str(out, " warnings  ");
+    out_uint_width(out, counts->malformed, 6);
+    out_str(out, " malformed\n");
+    memset(counts, 0, sizeof(*counts));
+    *carry_length = 0;
+}
+
+// Count lines and levels of each file without loading whole files. Blocks
+// arrive in file order, so a line cut by a block boundary is kept in
+// `carry` and finished with the start of the next block. One line per
+// file goes to a sink, so thousands of files don't mean thousands of
+// printf() calls; errors still go to stderr right away.
+int scan_logs_async(const char* const* filenames, size_t file_count) {
+    AsyncReader reader;
+    OutSink out;
+    fflush(stdout);
+    if (out_sink_init(&out, STDOUT_FILENO, 0, OUT_SINK_UNLOCKED) != 0) {
+        perror("Failed to allocate output buffer");
+        return -1;
+    }
+    if (async_reader_open(&reader, filenames, file_count, NULL) != 0) {
+        perror("Failed to start reader");
+        out_sink_close(&out);
+        return -1;
+    }
     
-    printf("\nLog Analysis Results:\n");
-    printf("  Total entries: %d\n", entry_count);
-    printf("  Errors: %d\n", error_count);
-    printf("  Warnings: %d\n", warning_count);
-    printf("  Info messages: %d\n", info_count);
-    
-    // Show error messages
-    if (error_count > 0) {
-        printf("\nError messages:\n");
-        for (int i = 0; i < entry_count; i++) {
-            if (strcmp(entries[i].level, "ERROR") == 0) {
-                printf("  %s [%s]: %s\n",
-                       entries[i].timestamp,
-                       entries[i].component,
-                       entries[i].message);
+    ScanCounts counts = {0, 0, 0, 0};
+    size_t current = 0;
+    char* carry = NULL;
+    size_t carry_length = 0, carry_capacity = 0;
+    int result = 0;
+    AsyncBlock block;
+    int status;
+    
+    while ((status = async_reader_next(&reader, &block)) != 0) {
+        if (status < 0 && errno == ENOBUFS) {
+            result = -1;
+            break;
+        }
+        
+        // Files before this one are done (empty files deliver no blocks)
+        while (current < block.file) {
+            scan_finish(&out, filenames[current++], &counts, &carry_length, carry);
+        }
+        if (status < 0) {
+            out_sink_flush(&out);
+            perror(filenames[block.file]);
+            memset(&counts, 0, sizeof(counts));
+            carry_length = 0;
+            current = block.file + 1;
+            result = -1;
+            continue;
+        }
+        
+        const char* p = block.data;
+        const char* end = block.data + block.length;
+        
+        // Make room for a partial line plus all of this block, at most
+        size_t needed = carry_length + block.length;
+        if (needed > carry_capacity) {
+            char* grown = realloc(carry, needed);
+            if (grown == NULL) {
+                async_reader_release(&reader, &block);
+                result = -1;
+                break;
             }
+            carry = grown;
+            carry_capacity = needed;
+        }
+        
+        const char* newline = memchr(p, '\n', block.length);
+        if (carry_length > 0 && newline != NULL) {
+            size_t head = (size_t)(newline - p);
+            memcpy(carry + carry_length, p, head);
+            scan_count_line(carry, carry_length + head, &counts);
+            carry_length = 0;
+            p = newline + 1;
+            newline = memchr(p, '\n', (size_t)(end - p));
+        }
+        
+        while (newline != NULL) {
+            scan_count_line(p, (size_t)(newline - p), &counts);
+            p = newline + 1;
+            newline = memchr(p, '\n', (size_t)(end - p));
         }
+        
+        // The rest has no newline yet: keep it for the next block
+        memcpy(carry + carry_length, p, (size_t)(end - p));
+        carry_length += (size_t)(end - p);
+        
+        async_reader_release(&reader, &block);
     }
     
-    // Component activity analysis
-    printf("\nComponent activity:\n");
-    const char* components[] = {"Server", "Database", "Auth", "Network", "Cache"};
-    int component_count = sizeof(components) / sizeof(components[0]);
-    
-    for (int i = 0; i < component_count; i++) {
-        int count = 0;
-        for (int j = 0; j < entry_count; j++) {
-            if (strcmp(entries[j].component, components[i]) == 0) {
-                count++;
-            }
+    if (status == 0) {
+        while (current < file_count) {
+            scan_finish(&out, filenames[current++], &counts, &carry_length, carry);
         }
-        if (count > 0) {
-            printf("  %s: %d messages\n", components[i], count);
+    }
+    out_str(&out, "  (");
+    out_str(&out, async_reader_backend_name(&reader));
+    out_str(&out, ")\n");
+    if (out_sink_close(&out) != 0) result = -1;
+    
+    free(carry);
+    async_reader_close(&reader);
+    return result;
+}
+
+// Command-line mode: ./file_processing --log FILE [--threads N] [--per-thread]
+//                or: ./file_processing --scan FILE...
+int run_log_analyzer(int argc, char* argv[]) {
+    const char* filename = NULL;
+    int threads = 0;
+    int per_thread = 0;
+    
+    if (argc > 2 && strcmp(argv[1], "--scan") == 0) {
+        return scan_logs_async((const char* const*)argv + 2, (size_t)(argc - 2)) == 0 ? 0 : 1;
+    }
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--log") == 0 && i + 1 < argc) {
+            filename = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--per-thread") == 0) {
+            per_thread = 1;
+        } else {
+            filename = NULL;
+            break;
         }
     }
-    printf("\n");
+    
+    if (filename == NULL) {
+        fprintf(stderr, "Usage: %s [--log FILE [--threads N] [--per-thread] | --scan FILE...]\n",
+                argv[0]);
+        return 1;
+    }
+    
+    LogAnalysis analysis;
+    if (log_analyze_file(filename, threads, &analysis) != 0) {
+        perror(filename);
+        return 1;
+    }
+    
+    print_log_analysis(filename, &analysis, per_thread);
+    log_analysis_free(&analysis);
+    return 0;
 }
 
 void demonstrate_config_file_parsing(void) {
@@ -281,17 +554,16 @@ void demonstrate_config_file_parsing(void) {
     }
     
     char line[256];
-    ConfigEntry config[20];
-    int config_count = 0;
+    ConfigEntry entry;
     int line_number = 0;
     
     printf("Parsing configuration file:\n");
     
-    while (fgets(line, sizeof(line), file) != NULL && config_count < 20) {
+    while (fgets(line, sizeof(line), file) != NULL) {
         line_number++;
         
         // Remove newline
-        line[strcspn(line, "\n")] = '\0';
+        strip_newline(line);
         
         // Skip empty lines and comments
         char* trimmed = trim_whitespace(line);
@@ -301,9 +573,8 @@ void demonstrate_config_file_parsing(void) {
             continue;
         }
         
-        if (parse_config_line(trimmed, &config[config_count])) {
-            printf("  %s = %s\n", config[config_count].key, config[config_count].value);
-            config_count++;
+        if (parse_config_line(trimmed, &entry)) {
+            printf("  %s = %s\n", entry.key, entry.value);
         } else {
             printf("  Error parsing line %d: %s\n", line_number, trimmed);
         }
@@ -311,127 +582,130 @@ void demonstrate_config_file_parsing(void) {
     
     fclose(file);
     
+    // Load the same file into a hash table with typed values. Lookups
+    // below are one hash probe each instead of a strcmp() scan.
+    ConfigStore store;
+    if (config_store_open(&store, "app.conf") != 0) {
+        perror("Failed to load config store");
+        return;
+    }
+    
+    static const char* const type_names[] = {"string", "int", "double", "bool"};
+    unsigned long ticket;
+    const ConfigSnapshot* config = config_read_begin(&store, &ticket);
+    
     printf("\nConfiguration Summary:\n");
-    printf("  Total settings: %d\n", config_count);
-    
-    // Look for specific settings
-    for (int i = 0; i < config_count; i++) {
-        if (strcmp(config[i].key, "server_port") == 0) {
-            printf("  Server will run on port %s\n", config[i].value);
-        } else if (strcmp(config[i].key, "debug_mode") == 0) {
-            printf("  Debug mode: %s\n", config[i].value);
-        } else if (strcmp(config[i].key, "max_connections") == 0) {
-            printf("  Maximum connections: %s\n", config[i].value);
+    printf("  Total settings: %zu (hash table with %zu slots)\n", config->count,
+           config->slot_count);
+    OutSink out;
+    fflush(stdout);
+    if (out_sink_init(&out, STDOUT_FILENO, 0, OUT_SINK_UNLOCKED) == 0) {
+        for (size_t i = 0; i < config->count; i++) {
+            out_str(&out, "    ");
+            out_str_width(&out, config->values[i].key, 16);
+            out_char(&out, ' ');
+            out_str_width(&out, type_names[config->values[i].type], 7);
+            out_char(&out, ' ');
+            out_str(&out, config->values[i].text);
+            out_char(&out, '\n');
         }
+        out_sink_close(&out);
     }
     
+    long long port = config_get_int(config, "server_port", -1);
+    printf("  Server will run on port %lld\n", port);
+    printf("  Debug mode: %s\n", config_get_bool(config, "debug_mode", 0) ? "on" : "off");
+    printf("  Maximum connections: %lld\n", config_get_int(config, "max_connections", 0));
+    
     // Validate configuration
     printf("\nConfiguration validation:\n");
-    int port_found = 0, db_host_found = 0;
-    
-    for (int i = 0; i < config_count; i++) {
-        if (strcmp(config[i].key, "server_port") == 0) {
-            port_found = 1;
-            int port = atoi(config[i].value);
-            if (port < 1024 || port > 65535) {
-                printf("  WARNING: Invalid port number %d\n", port);
-            }
-        } else if (strcmp(config[i].key, "database_host") == 0) {
-            db_host_found = 1;
-        }
-    }
+    int port_found = config_lookup(config, "server_port") != NULL;
+    int db_host_found = config_lookup(config, "database_host") != NULL;
     
+    if (port_found && (port < 1024 || port > 65535)) {
+        printf("  WARNING: Invalid port number %lld\n", port);
+    }
     if (!port_found) printf("  ERROR: server_port not configured\n");
     if (!db_host_found) printf("  ERROR: database_host not configured\n");
     if (port_found && db_host_found) printf("  Configuration appears valid\n");
     
+    // Hot reload: save a changed copy the way editors do (write a new
+    // file, rename it over the old one) and let the inotify thread
+    // pick it up. Readers keep using whichever snapshot they started with.
+    printf("\nHot reload:\n");
+    FILE* changed = config_store_watch(&store) == 0 ? fopen("app.conf.tmp", "w") : NULL;
+    if (changed != NULL) {
+        for (size_t i = 0; i < config->count; i++) {
+            const ConfigValue* value = &config->values[i];
+            fprintf(changed, "%s = %s\n", value->key,
+                    strcmp(value->key, "server_port") == 0 ? "9090" : value->text);
+        }
+        fclose(changed);
+    }
+    config_read_end(&store, ticket);
+    
+    if (changed != NULL && rename("app.conf.tmp", "app.conf") == 0) {
+        // Give the watcher up to a second to notice
+        struct timespec pause = {0, 10 * 1000 * 1000};
+        for (int i = 0; i < 100 && config_store_reloads(&store) == 0; i++) {
+            nanosleep(&pause, NULL);
+        }
+        config = config_read_begin(&store, &ticket);
+        printf("  Reloads seen: %lu, server_port is now %lld\n",
+               config_store_reloads(&store), config_get_int(config, "server_port", -1));
+        config_read_end(&store, ticket);
+    } else {
+        printf("  inotify not available, skipped\n");
+    }
+    
+    config_store_close(&store);
     printf("\n");
 }
 
+// Negated so the most frequent letter sorts first
+static int64_t letter_frequency_key(const void* pair, void* context) {
+    (void)context;
+    return -(int64_t)((const LetterFrequency*)pair)->frequency;
+}
+
 void demonstrate_text_statistics(void) {
     printf("=== Text File Statistics ===\n");
     
-    FILE* file = fopen("sample_text.txt", "r");
-    if (file == NULL) {
+    // Counted in large blocks (32 bytes per instruction with AVX2),
+    // not with one fgetc() + isspace() + isalpha() per character
+    TextStats stats;
+    printf("Analyzing text file in blocks (%s):\n", text_stats_backend_name());
+    if (text_stats_file("sample_text.txt", 0, TEXT_STATS_LETTERS, &stats) != 0) {
         perror("Failed to open text file");
         return;
     }
     
-    int char_count = 0;
-    int word_count = 0;
-    int line_count = 0;
-    int letter_freq[26] = {0};  // Frequency of each letter
-    int in_word = 0;
-    
-    printf("Analyzing text file character by character:\n");
-    
-    int ch;
-    while ((ch = fgetc(file)) != EOF) {
-        char_count++;
-        
-        if (ch == '\n') {
-            line_count++;
-            if (in_word) {
-                word_count++;
-                in_word = 0;
-            }
-        } else if (isspace(ch)) {
-            if (in_word) {
-                word_count++;
-                in_word = 0;
-            }
-        } else {
-            in_word = 1;
-            
-            // Count letter frequency
-            if (isalpha(ch)) {
-                int index = tolower(ch) - 'a';
-                if (index >= 0 && index < 26) {
-                    letter_freq[index]++;
-                }
-            }
-        }
-    }
-    
-    // Count last word if file doesn't end with whitespace
-    if (in_word) {
-        word_count++;
-    }
-    
-    fclose(file);
-    
     printf("\nText Statistics:\n");
-    printf("  Characters: %d\n", char_count);
-    printf("  Words: %d\n", word_count);
-    printf("  Lines: %d\n", line_count);
+    printf("  Characters: %llu\n", (unsigned long long)stats.bytes);
+    printf("  Words: %llu\n", (unsigned long long)stats.words);
+    printf("  Lines: %llu\n", (unsigned long long)stats.lines);
     printf("  Average words per line: %.1f\n", 
-           line_count > 0 ? (double)word_count / line_count : 0.0);
+           stats.lines > 0 ? (double)stats.words / stats.lines : 0.0);
     printf("  Average characters per word: %.1f\n",
-           word_count > 0 ? (double)char_count / word_count : 0.0);
+           stats.words > 0 ? (double)stats.bytes / stats.words : 0.0);
     
     // Show letter frequency
     printf("\nLetter frequency (top 10):\n");
     
     // Create array of letter-frequency pairs for sorting
-    struct {
-        char letter;
-        int frequency;
-    } freq_pairs[26];
+    LetterFrequency freq_pairs[26];
     
     for (int i = 0; i < 26; i++) {
         freq_pairs[i].letter = 'a' + i;
-        freq_pairs[i].frequency = letter_freq[i];
+        freq_pairs[i].frequency = (int)stats.letters[i];
     }
     
-    // Simple bubble sort by frequency (descending)
-    for (int i = 0; i < 25; i++) {
-        for (int j = 0; j < 25 - i; j++) {
-            if (freq_pairs[j].frequency < freq_pairs[j + 1].frequency) {
-                struct { char letter; int frequency; } temp = freq_pairs[j];
-                freq_pairs[j] = freq_pairs[j + 1];
-                freq_pairs[j + 1] = temp;
-            }
-        }
+    // Sort by frequency (descending). The sort is stable and the pairs
+    // start in alphabetical order, so ties stay alphabetical.
+    if (sort_records_by_key(freq_pairs, 26, sizeof(LetterFrequency), letter_frequency_key,
+                            NULL) != 0) {
+        perror("Failed to sort letter frequencies");
+        return;
     }
     
     // Show top 10
@@ -454,85 +728,57 @@ char* trim_whitespace(char* str) {
     return str;
 }
 
-int parse_csv_line(char* line, Person* person) {
-    char* token;
-    int field = 0;
-    
-    // Make a copy since strtok modifies the string
-    char line_copy[256];
-    strncpy(line_copy, line, sizeof(line_copy) - 1);
-    line_copy[sizeof(line_copy) - 1] = '\0';
-    
-    token = strtok(line_copy, ",");
-    while (token != NULL && field < 5) {
-        // Remove quotes if present
-        if (token[0] == '"' && token[strlen(token) - 1] == '"') {
-            token[strlen(token) - 1] = '\0';
-            token++;
-        }
-        
-        switch (field) {
-            case 0: person->id = atoi(token); break;
-            case 1: strncpy(person->name, token, sizeof(person->name) - 1); break;
-            case 2: strncpy(person->email, token, sizeof(person->email) - 1); break;
-            case 3: person->age = atoi(token); break;
-            case 4: person->salary = atof(token); break;
-        }
-        
-        token = strtok(NULL, ",");
-        field++;
+int person_from_csv_record(const CsvRecord* record, Person* person) {
+    if (record->field_count < 5) return 0;
+    
+    // Numbers are converted straight from the field slices; unlike
+    // atoi/atof, "N/A" or "12abc" is an error instead of a silent 0
+    const CsvField* fields = record->fields;
+    int32_t id, age;
+    
+    if (csv_field_int32(&fields[0], &id) != 0 ||
+        csv_field_int32(&fields[3], &age) != 0 ||
+        csv_field_double(&fields[4], &person->salary) != 0) {
+        return 0;
     }
+    person->id = id;
+    person->age = age;
+    csv_field_copy(&fields[1], person->name, sizeof(person->name));
+    csv_field_copy(&fields[2], person->email, sizeof(person->email));
     
-    return field == 5;  // Success if all 5 fields parsed
+    return 1;
 }
 
-int parse_log_line(char* line, LogEntry* entry) {
-    // Expected format: "YYYY-MM-DD HH:MM:SS LEVEL COMPONENT MESSAGE"
-    char* token;
-    int field = 0;
-    
-    char line_copy[512];
-    strncpy(line_copy, line, sizeof(line_copy) - 1);
-    line_copy[sizeof(line_copy) - 1] = '\0';
-    
-    // Parse timestamp (date and time)
-    token = strtok(line_copy, " ");
-    if (token == NULL) return 0;
-    strncpy(entry->timestamp, token, sizeof(entry->timestamp) - 1);
-    
-    token = strtok(NULL, " ");
-    if (token == NULL) return 0;
-    strncat(entry->timestamp, " ", sizeof(entry->timestamp) - strlen(entry->timestamp) - 1);
-    strncat(entry->timestamp, token, sizeof(entry->timestamp) - strlen(entry->timestamp) - 1);
-    
-    // Parse level
-    token = strtok(NULL, " ");
-    if (token == NULL) return 0;
-    strncpy(entry->level, token, sizeof(entry->level) - 1);
-    
-    // Parse component
-    token = strtok(NULL, " ");
-    if (token == NULL) return 0;
-    strncpy(entry->component, token, sizeof(entry->component) - 1);
-    
-    // Parse message (rest of line)
-    token = strtok(NULL, "");
-    if (token == NULL) return 0;
-    strncpy(entry->message, token, sizeof(entry->message) - 1);
+int parse_csv_line(char* line, Person* person) {
+    // Parse the line in place - quoted fields may contain commas, which
+    // strtok(line, ",") would split incorrectly
+    CsvField fields[CSV_MAX_FIELDS];
+    CsvRecord record;
+    int field_count = 0;
     
-    return 1;
+    csv_parse_record(line, line + strlen(line), 1, fields, CSV_MAX_FIELDS, &field_count);
+    
+    record.fields = fields;
+    record.field_count = field_count;
+    record.record_number = 0;
+    
+    return person_from_csv_record(&record, person);
+}
+
+void strip_newline(char* line) {
+    // fgets() keeps the '\n'; cut the line at the first one
+    char* end = line + strlen(line);
+    *(char*)scan_find(line, end, SCAN_NEWLINE) = '\0';
+}
+
+int parse_log_line(LogDictionary* dictionary, char* line, LogEntry* entry) {
+    return parse_log_fields(dictionary, line, strlen(line), entry);
 }
 
 int parse_config_line(char* line, ConfigEntry* entry) {
-    char* equals = strchr(line, '=');
-    if (equals == NULL) return 0;
-    
-    // Split at equals sign
-    *equals = '\0';
-    char* key = trim_whitespace(line);
-    char* value = trim_whitespace(equals + 1);
-    
-    if (strlen(key) == 0 || strlen(value) == 0) return 0;
+    // Same splitting rules as the config store
+    char *key, *value;
+    if (!config_split_line(line, &key, &value)) return 0;
     
     strncpy(entry->key, key, sizeof(entry->key) - 1);
     strncpy(entry->value, value, sizeof(entry->value) - 1);
@@ -542,7 +788,11 @@ int parse_config_line(char* line, ConfigEntry* entry) {
     return 1;
 }
 
-int main(void) {
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        return run_log_analyzer(argc, argv);
+    }
+    
     printf("File Processing - Text Processing, Parsing, and Data Extraction\n");
     printf("==============================================================\n");
     
@@ -554,10 +804,12 @@ int main(void) {
     
     printf("=== Key Implementation Details ===\n");
     printf("1. Manual string parsing gives complete control over format\n");
-    printf("2. strtok() modifies original string - use copies for parsing\n");
+    printf("2. Fields are zero-copy slices of the mapped file - nothing is copied or modified\n");
     printf("3. Always validate parsed data and handle edge cases\n");
-    printf("4. Character-by-character processing enables detailed analysis\n");
+    printf("4. Text statistics are counted a whole block at a time (%s)\n",
+           text_stats_backend_name());
     printf("5. Buffer management is critical for large file processing\n");
+    printf("   (delimiters found 64 bytes at a time with %s)\n", scan_backend_name());
     printf("6. Error handling prevents crashes from malformed data\n");
     
     // Cleanup test files
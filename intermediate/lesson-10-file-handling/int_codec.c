@@ -0,0 +1,545 @@
+/*
+ * int_codec.c - FOR, delta, zigzag varint and RLE integer encodings
+ *
+ * Encoded layouts (integers little-endian):
+ *
+ *   FOR      u64 minimum, u8 width, then count values of `width` bits
+ *   DELTA    u64 first value, u64 smallest difference, u8 width, then
+ *            count - 1 differences minus the smallest, `width` bits each
+ *   VARINT   count zigzag varints, the first relative to 0
+ *   RLE      (zigzag varint change from the previous run's value,
+ *            varint run length) until count values are covered
+ *
+ * Implementation notes:
+ * - Differences wrap around in the value's own width, so every int32 or
+ *   int64 sequence has a delta encoding, and the width of an int32
+ *   column is never more than 32 bits.
+ * - Bits are packed LSB first. Eight values of w bits take exactly w
+ *   bytes, so group g starts at byte g * w and value j of a group at bit
+ *   j * w of it - the same shift pattern for every group. The portable
+ *   unpacker reads each value with one unaligned 64-bit load and a shift
+ *   (why widths stop at 56 bits); the AVX2 one gathers 8 dwords at those
+ *   byte offsets, shifts each lane by its own amount (vpsrlvd) and masks,
+ *   for widths up to 25 bits (shift + width must fit a dword).
+ * - DELTA then needs a running sum. With AVX2 it is done 8 lanes at a
+ *   time: two in-lane shifts and adds, then the low half's total is
+ *   carried into the high half and the previous group's last value is
+ *   added to all 8.
+ * - Both unpackers only take whole groups with enough input left to load
+ *   past them; the last few values go bit by bit.
+ * - VARINT is inherently serial (a value's position depends on every
+ *   length before it); it is there for columns whose differences are
+ *   mostly small with occasional large jumps, where a packed width
+ *   would be set by the jumps.
+ */
+
+#include "int_codec.h"
+
+#include <errno.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define INT_HAVE_X86 1
+#include <immintrin.h>
+#else
+#define INT_HAVE_X86 0
+#endif
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define INT_HOST_BIG_ENDIAN 1
+#else
+#define INT_HOST_BIG_ENDIAN 0
+#endif
+
+#define MAX_PACK_WIDTH 56
+#define AVX2_MAX_WIDTH 25
+#define FOR_HEADER_SIZE 9
+#define DELTA_HEADER_SIZE 17
+#define MAX_VARINT_SIZE 10
+
+// -1 = not detected yet, 0 = portable, 1 = AVX2
+static int simd_level = -1;
+
+int int_codec_set_simd(int enabled) {
+    int level = 0;
+#if INT_HAVE_X86
+    __builtin_cpu_init();
+    level = enabled && __builtin_cpu_supports("avx2");
+#else
+    (void)enabled;
+#endif
+    __atomic_store_n(&simd_level, level, __ATOMIC_RELAXED);
+    return level;
+}
+
+static int use_avx2(void) {
+    int level = __atomic_load_n(&simd_level, __ATOMIC_RELAXED);
+    if (level < 0) level = int_codec_set_simd(1);
+    return level;
+}
+
+const char* int_codec_backend_name(void) {
+    return use_avx2() ? "AVX2" : "portable";
+}
+
+const char* int_encoding_name(IntEncoding encoding) {
+    switch (encoding) {
+        case INT_ENCODING_PLAIN: return "plain";
+        case INT_ENCODING_FOR: return "FOR";
+        case INT_ENCODING_DELTA: return "delta";
+        case INT_ENCODING_VARINT: return "varint";
+        case INT_ENCODING_RLE: return "RLE";
+    }
+    return "?";
+}
+
+static void put_u64(unsigned char* out, uint64_t value) {
+    for (int i = 0; i < 8; i++) out[i] = (unsigned char)(value >> (8 * i));
+}
+
+static uint64_t get_u64(const unsigned char* in) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--) value = value << 8 | in[i];
+    return value;
+}
+
+// Unaligned little-endian 64-bit load
+static uint64_t load64(const unsigned char* in) {
+    uint64_t value;
+    memcpy(&value, in, sizeof(value));
+    return INT_HOST_BIG_ENDIAN ? __builtin_bswap64(value) : value;
+}
+
+static int64_t load_value(const void* values, size_t i, size_t value_size) {
+    if (value_size == 4) {
+        int32_t value;
+        memcpy(&value, (const char*)values + i * 4, 4);
+        return value;
+    }
+    int64_t value;
+    memcpy(&value, (const char*)values + i * 8, 8);
+    return value;
+}
+
+// a - b, wrapped to the value width
+static int64_t difference(int64_t a, int64_t b, size_t value_size) {
+    uint64_t d = (uint64_t)a - (uint64_t)b;
+    return value_size == 4 ? (int64_t)(int32_t)(uint32_t)d : (int64_t)d;
+}
+
+static unsigned bit_width(uint64_t range) {
+    return range ? 64 - (unsigned)__builtin_clzll(range) : 0;
+}
+
+static uint64_t zigzag(int64_t value) {
+    return (uint64_t)value << 1 ^ (uint64_t)(value >> 63);
+}
+
+static int64_t unzigzag(uint64_t value) {
+    return (int64_t)(value >> 1 ^ (0 - (value & 1)));
+}
+
+static size_t varint_size(uint64_t value) {
+    return value ? 1 + (bit_width(value) - 1) / 7 : 1;
+}
+
+static unsigned char* put_varint(unsigned char* out, uint64_t value) {
+    while (value >= 0x80) {
+        *out++ = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (unsigned char)value;
+    return out;
+}
+
+// Returns -1 at the end of the input or for an overlong varint
+static int get_varint(const unsigned char** in, const unsigned char* end, uint64_t* value) {
+    const unsigned char* p = *in;
+    uint64_t result = 0;
+    for (unsigned shift = 0; shift < 7 * MAX_VARINT_SIZE; shift += 7) {
+        if (p >= end) return -1;
+        unsigned byte = *p++;
+        result |= (uint64_t)(byte & 0x7f) << shift;
+        if (byte < 0x80) {
+            *in = p;
+            *value = result;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static size_t packed_size(size_t count, unsigned width) {
+    return (count * width + 7) / 8;
+}
+
+void int_codec_measure(const void* values, size_t count, size_t value_size,
+                       size_t sizes[INT_ENCODING_COUNT]) {
+    sizes[INT_ENCODING_PLAIN] = count * value_size;
+    for (int e = 1; e < INT_ENCODING_COUNT; e++) sizes[e] = SIZE_MAX;
+    if (count == 0) return;
+
+    int64_t first = load_value(values, 0, value_size);
+    int64_t min = first, max = first;
+    int64_t min_delta = INT64_MAX, max_delta = INT64_MIN;
+    size_t varint_bytes = varint_size(zigzag(first));
+    size_t rle_bytes = 0;
+    int64_t previous = first, run_value = first, previous_run = 0;
+    size_t run_length = 1;
+
+    for (size_t i = 1; i < count; i++) {
+        int64_t value = load_value(values, i, value_size);
+        int64_t delta = difference(value, previous, value_size);
+        min = value < min ? value : min;
+        max = value > max ? value : max;
+        min_delta = delta < min_delta ? delta : min_delta;
+        max_delta = delta > max_delta ? delta : max_delta;
+        varint_bytes += varint_size(zigzag(delta));
+        if (value != previous) {
+            rle_bytes += varint_size(zigzag(difference(run_value, previous_run, value_size))) +
+                         varint_size(run_length);
+            previous_run = run_value;
+            run_value = value;
+            run_length = 0;
+        }
+        run_length++;
+        previous = value;
+    }
+    rle_bytes += varint_size(zigzag(difference(run_value, previous_run, value_size))) +
+                 varint_size(run_length);
+
+    unsigned width = bit_width((uint64_t)max - (uint64_t)min);
+    if (width <= MAX_PACK_WIDTH) sizes[INT_ENCODING_FOR] = FOR_HEADER_SIZE + packed_size(count, width);
+    width = count > 1 ? bit_width((uint64_t)max_delta - (uint64_t)min_delta) : 0;
+    if (width <= MAX_PACK_WIDTH) {
+        sizes[INT_ENCODING_DELTA] = DELTA_HEADER_SIZE + packed_size(count - 1, width);
+    }
+    sizes[INT_ENCODING_VARINT] = varint_bytes;
+    sizes[INT_ENCODING_RLE] = rle_bytes;
+}
+
+IntEncoding int_codec_choose(const void* values, size_t count, size_t value_size,
+                             size_t* encoded_size) {
+    size_t sizes[INT_ENCODING_COUNT];
+    int_codec_measure(values, count, value_size, sizes);
+
+    // Ties go to the cheaper decoder: packed before RLE before varint
+    static const IntEncoding order[] = {
+        INT_ENCODING_PLAIN, INT_ENCODING_FOR, INT_ENCODING_DELTA, INT_ENCODING_RLE,
+        INT_ENCODING_VARINT
+    };
+    IntEncoding best = INT_ENCODING_PLAIN;
+    for (size_t k = 1; k < sizeof(order) / sizeof(order[0]); k++) {
+        if (sizes[order[k]] < sizes[best]) best = order[k];
+    }
+    if (encoded_size != NULL) *encoded_size = sizes[best];
+    return best;
+}
+
+// Append values of `width` bits LSB first; `bits` holds what is not yet
+// a whole byte
+typedef struct {
+    unsigned char* out;
+    uint64_t bits;
+    unsigned used;
+} BitWriter;
+
+static void put_bits(BitWriter* writer, uint64_t value, unsigned width) {
+    writer->bits |= value << writer->used;
+    writer->used += width;
+    while (writer->used >= 8) {
+        *writer->out++ = (unsigned char)writer->bits;
+        writer->bits >>= 8;
+        writer->used -= 8;
+    }
+}
+
+static unsigned char* finish_bits(BitWriter* writer) {
+    if (writer->used > 0) *writer->out++ = (unsigned char)writer->bits;
+    return writer->out;
+}
+
+size_t int_codec_encode(IntEncoding encoding, const void* values, size_t count,
+                        size_t value_size, unsigned char* out) {
+    unsigned char* start = out;
+    if (encoding == INT_ENCODING_PLAIN) {
+        for (size_t i = 0; i < count; i++, out += value_size) {
+            uint64_t value = (uint64_t)load_value(values, i, value_size);
+            for (size_t b = 0; b < value_size; b++) out[b] = (unsigned char)(value >> (8 * b));
+        }
+        return (size_t)(out - start);
+    }
+    if (count == 0) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    int64_t first = load_value(values, 0, value_size);
+    if (encoding == INT_ENCODING_FOR || encoding == INT_ENCODING_DELTA) {
+        int delta = encoding == INT_ENCODING_DELTA;
+        int64_t low = INT64_MAX, high = INT64_MIN;
+        for (size_t i = delta; i < count; i++) {
+            int64_t value = load_value(values, i, value_size);
+            if (delta) value = difference(value, load_value(values, i - 1, value_size), value_size);
+            low = value < low ? value : low;
+            high = value > high ? value : high;
+        }
+        unsigned width = count > (size_t)delta ? bit_width((uint64_t)high - (uint64_t)low) : 0;
+        if (count == 1 && delta) low = 0;
+        if (width > MAX_PACK_WIDTH) {
+            errno = EINVAL;
+            return 0;
+        }
+
+        if (delta) {
+            put_u64(out, (uint64_t)first);
+            out += 8;
+        }
+        put_u64(out, (uint64_t)low);
+        out[8] = (unsigned char)width;
+        BitWriter writer = {out + 9, 0, 0};
+        for (size_t i = delta; i < count; i++) {
+            int64_t value = load_value(values, i, value_size);
+            if (delta) value = difference(value, load_value(values, i - 1, value_size), value_size);
+            put_bits(&writer, (uint64_t)value - (uint64_t)low, width);
+        }
+        return (size_t)(finish_bits(&writer) - start);
+    }
+
+    if (encoding == INT_ENCODING_VARINT) {
+        int64_t previous = 0;
+        for (size_t i = 0; i < count; i++) {
+            int64_t value = load_value(values, i, value_size);
+            out = put_varint(out, zigzag(difference(value, previous, value_size)));
+            previous = value;
+        }
+        return (size_t)(out - start);
+    }
+
+    if (encoding == INT_ENCODING_RLE) {
+        int64_t previous_run = 0;
+        size_t i = 0;
+        while (i < count) {
+            int64_t value = load_value(values, i, value_size);
+            size_t end = i + 1;
+            while (end < count && load_value(values, end, value_size) == value) end++;
+            out = put_varint(out, zigzag(difference(value, previous_run, value_size)));
+            out = put_varint(out, end - i);
+            previous_run = value;
+            i = end;
+        }
+        return (size_t)(out - start);
+    }
+
+    errno = EINVAL;
+    return 0;
+}
+
+// Decoding
+
+// `width` bits starting at bit `bit`, reading only bytes inside `size`
+static uint64_t read_bits(const unsigned char* in, size_t size, uint64_t bit, unsigned width) {
+    size_t byte = (size_t)(bit / 8);
+    uint64_t value = 0;
+    for (unsigned k = 0; k < 8 && byte + k < size; k++) value |= (uint64_t)in[byte + k] << (8 * k);
+    return (value >> (bit % 8)) & (((uint64_t)1 << width) - 1);
+}
+
+// Values [from, count) of a packed array, plus `base` (wrapping); `from`
+// is a multiple of 8
+static void unpack32(const unsigned char* in, size_t size, uint32_t* out, size_t from,
+                     size_t count, unsigned width, uint32_t base) {
+    uint64_t mask = ((uint64_t)1 << width) - 1;
+    size_t i = from;
+    if (width == 0) {
+        for (; i < count; i++) out[i] = base;
+        return;
+    }
+    for (; i + 8 <= count && (i / 8) * width + width + 8 <= size; i += 8) {
+        const unsigned char* group = in + (i / 8) * width;
+        for (unsigned j = 0; j < 8; j++) {
+            unsigned bit = j * width;
+            out[i + j] = base + (uint32_t)((load64(group + bit / 8) >> (bit % 8)) & mask);
+        }
+    }
+    for (; i < count; i++) out[i] = base + (uint32_t)read_bits(in, size, (uint64_t)i * width, width);
+}
+
+static void unpack64(const unsigned char* in, size_t size, uint64_t* out, size_t count,
+                     unsigned width, uint64_t base) {
+    uint64_t mask = ((uint64_t)1 << width) - 1;
+    size_t i = 0;
+    if (width == 0) {
+        for (; i < count; i++) out[i] = base;
+        return;
+    }
+    for (; i + 8 <= count && (i / 8) * width + width + 8 <= size; i += 8) {
+        const unsigned char* group = in + (i / 8) * width;
+        for (unsigned j = 0; j < 8; j++) {
+            unsigned bit = j * width;
+            out[i + j] = base + ((load64(group + bit / 8) >> (bit % 8)) & mask);
+        }
+    }
+    for (; i < count; i++) out[i] = base + read_bits(in, size, (uint64_t)i * width, width);
+}
+
+#if INT_HAVE_X86
+// Whole groups of 8 (width 1..25) with room for the gathers; returns how
+// many values were written. With `running_sum`, each output is also added
+// to everything before it, starting from `start`.
+__attribute__((target("avx2")))
+static size_t unpack32_avx2(const unsigned char* in, size_t size, uint32_t* out, size_t count,
+                            unsigned width, uint32_t base, int running_sum, uint32_t start) {
+    const __m256i bits = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                                            _mm256_set1_epi32((int)width));
+    const __m256i offsets = _mm256_srli_epi32(bits, 3);
+    const __m256i shifts = _mm256_and_si256(bits, _mm256_set1_epi32(7));
+    const __m256i mask = _mm256_set1_epi32((int)((1u << width) - 1));
+    const __m256i add = _mm256_set1_epi32((int)base);
+    const __m256i last_lane = _mm256_set1_epi32(7);
+    __m256i running = _mm256_set1_epi32((int)start);
+
+    size_t i = 0;
+    for (; i + 8 <= count && (i / 8) * width + width + 4 <= size; i += 8) {
+        const int* group = (const int*)(const void*)(in + (i / 8) * width);
+        __m256i x = _mm256_i32gather_epi32(group, offsets, 1);
+        x = _mm256_add_epi32(_mm256_and_si256(_mm256_srlv_epi32(x, shifts), mask), add);
+        if (running_sum) {
+            x = _mm256_add_epi32(x, _mm256_slli_si256(x, 4));
+            x = _mm256_add_epi32(x, _mm256_slli_si256(x, 8));
+            // Low half's total into every lane of the high half
+            __m256i carry = _mm256_shuffle_epi32(x, 0xFF);
+            x = _mm256_add_epi32(x, _mm256_permute2x128_si256(carry, carry, 0x08));
+            x = _mm256_add_epi32(x, running);
+            running = _mm256_permutevar8x32_epi32(x, last_lane);
+        }
+        _mm256_storeu_si256((__m256i*)(void*)(out + i), x);
+    }
+    return i;
+}
+#endif
+
+static void store_value(void* values, size_t i, size_t value_size, uint64_t value) {
+    if (value_size == 4) {
+        ((uint32_t*)values)[i] = (uint32_t)value;
+    } else {
+        ((uint64_t*)values)[i] = value;
+    }
+}
+
+static int decode_packed(int delta, const unsigned char* in, size_t size, void* values,
+                         size_t count, size_t value_size) {
+    size_t header = delta ? DELTA_HEADER_SIZE : FOR_HEADER_SIZE;
+    if (size < header) return -1;
+    uint64_t first = delta ? get_u64(in) : 0;
+    uint64_t base = get_u64(in + header - 9);
+    unsigned width = in[header - 1];
+    size_t packed = delta ? count - 1 : count;
+    if (width > (value_size == 4 ? 32 : MAX_PACK_WIDTH) ||
+        size - header != packed_size(packed, width)) return -1;
+    in += header;
+    size -= header;
+
+    if (delta && width == 0) {
+        // Constant steps (sorted IDs): no running sum needed
+        if (value_size == 4) {
+            uint32_t* out = values;
+            for (size_t i = 0; i < count; i++) out[i] = (uint32_t)first + (uint32_t)i * (uint32_t)base;
+        } else {
+            uint64_t* out = values;
+            for (size_t i = 0; i < count; i++) out[i] = first + i * base;
+        }
+        return 0;
+    }
+    if (value_size == 4) {
+        uint32_t* out = values;
+        uint32_t* target = delta ? out + 1 : out;
+        size_t done = 0;
+#if INT_HAVE_X86
+        if (width > 0 && width <= AVX2_MAX_WIDTH && use_avx2()) {
+            done = unpack32_avx2(in, size, target, packed, width, (uint32_t)base, delta,
+                                 (uint32_t)first);
+        }
+#endif
+        unpack32(in, size, target, done, packed, width, (uint32_t)base);
+        if (delta) {
+            out[0] = (uint32_t)first;
+            for (size_t i = done + 1; i < count; i++) out[i] += out[i - 1];
+        }
+    } else {
+        uint64_t* out = values;
+        if (delta) {
+            out[0] = first;
+            unpack64(in, size, out + 1, packed, width, base);
+            for (size_t i = 1; i < count; i++) out[i] += out[i - 1];
+        } else {
+            unpack64(in, size, out, packed, width, base);
+        }
+    }
+    return 0;
+}
+
+static int decode_varint(const unsigned char* in, size_t size, void* values, size_t count,
+                         size_t value_size) {
+    const unsigned char* end = in + size;
+    uint64_t value = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint64_t encoded;
+        if (get_varint(&in, end, &encoded) != 0) return -1;
+        value += (uint64_t)unzigzag(encoded);
+        store_value(values, i, value_size, value);
+    }
+    return in == end ? 0 : -1;
+}
+
+static int decode_rle(const unsigned char* in, size_t size, void* values, size_t count,
+                      size_t value_size) {
+    const unsigned char* end = in + size;
+    uint64_t value = 0;
+    size_t i = 0;
+    while (in < end) {
+        uint64_t change, length;
+        if (get_varint(&in, end, &change) != 0 || get_varint(&in, end, &length) != 0 ||
+            length == 0 || length > count - i) return -1;
+        value += (uint64_t)unzigzag(change);
+        if (value_size == 4) {
+            uint32_t* out = (uint32_t*)values + i;
+            for (size_t k = 0; k < length; k++) out[k] = (uint32_t)value;
+        } else {
+            uint64_t* out = (uint64_t*)values + i;
+            for (size_t k = 0; k < length; k++) out[k] = value;
+        }
+        i += (size_t)length;
+    }
+    return i == count ? 0 : -1;
+}
+
+int int_codec_decode(IntEncoding encoding, const unsigned char* in, size_t size,
+                     void* values, size_t count, size_t value_size) {
+    int result = -1;
+    if (value_size != 4 && value_size != 8) {
+        result = -1;
+    } else if (encoding == INT_ENCODING_PLAIN) {
+        if (size == count * value_size) {
+            memcpy(values, in, size);
+            if (INT_HOST_BIG_ENDIAN) {
+                for (size_t i = 0; i < count; i++) {
+                    uint64_t value = 0;
+                    for (size_t b = value_size; b-- > 0;) value = value << 8 | in[i * value_size + b];
+                    store_value(values, i, value_size, value);
+                }
+            }
+            result = 0;
+        }
+    } else if (count == 0) {
+        result = -1;
+    } else if (encoding == INT_ENCODING_FOR || encoding == INT_ENCODING_DELTA) {
+        result = decode_packed(encoding == INT_ENCODING_DELTA, in, size, values, count, value_size);
+    } else if (encoding == INT_ENCODING_VARINT) {
+        result = decode_varint(in, size, values, count, value_size);
+    } else if (encoding == INT_ENCODING_RLE) {
+        result = decode_rle(in, size, values, count, value_size);
+    }
+    if (result != 0) errno = EINVAL;
+    return result;
+}
@@ -0,0 +1,76 @@
+/*
+ * int_codec.h - Lightweight integer encodings for column chunks
+ *
+ * Version 1 of the custom format spends 4 bytes on every value, whether
+ * it is a sorted ID that grows by 1, an age between 22 and 64 or one of
+ * twelve department numbers. These encodings store only the information
+ * that is actually there:
+ *
+ *   FOR      frame of reference: the minimum, then every value minus the
+ *            minimum in the fewest bits that fit the range (ages: 6 bits)
+ *   DELTA    the first value, then the differences between neighbours,
+ *            bit-packed the same way (sorted IDs: 0 bits per value)
+ *   VARINT   each difference zigzag-encoded (small negatives stay small)
+ *            as a LEB128 varint: 1 byte for -64..63, more for big jumps
+ *   RLE      (value, run length) pairs, for long runs of the same value
+ *
+ * int_codec_choose() computes the size of every encoding in one pass over
+ * the values and picks the smallest, so a writer can decide chunk by
+ * chunk from the data itself.
+ *
+ * Bit-packed values are laid out so that every group of 8 starts on a
+ * byte boundary; the decoder unpacks 8 at a time without branches, with
+ * AVX2 gathers and shifts when the CPU has them.
+ *
+ * For frontend developers: The same tricks Parquet and Arrow use, and
+ * what a protobuf `sint32` field (zigzag varint) does for one number.
+ */
+
+#ifndef INT_CODEC_H
+#define INT_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Stored in MYFT chunk entries: the numbers must not change
+typedef enum {
+    INT_ENCODING_PLAIN = 0,     // Little-endian values as they are
+    INT_ENCODING_FOR = 1,
+    INT_ENCODING_DELTA = 2,
+    INT_ENCODING_VARINT = 3,
+    INT_ENCODING_RLE = 4
+} IntEncoding;
+
+#define INT_ENCODING_COUNT 5
+
+// Values are int32_t (value_size 4) or int64_t (value_size 8) arrays.
+
+// Encoded size of `count` values in every encoding; SIZE_MAX where an
+// encoding can't be used (a range wider than 56 bits).
+void int_codec_measure(const void* values, size_t count, size_t value_size,
+                       size_t sizes[INT_ENCODING_COUNT]);
+
+// The smallest encoding (INT_ENCODING_PLAIN unless another one is
+// smaller), with its size in *encoded_size if that isn't NULL
+IntEncoding int_codec_choose(const void* values, size_t count, size_t value_size,
+                             size_t* encoded_size);
+
+// Encode into `out`, which must hold the size int_codec_measure() gave
+// for `encoding`. Returns the number of bytes written, or 0 with
+// errno = EINVAL if the encoding can't represent these values.
+size_t int_codec_encode(IntEncoding encoding, const void* values, size_t count,
+                        size_t value_size, unsigned char* out);
+
+// Decode exactly `count` values from `size` bytes. Never reads outside
+// `in`. Returns 0, or -1 with errno = EINVAL for damaged input.
+int int_codec_decode(IntEncoding encoding, const unsigned char* in, size_t size,
+                     void* values, size_t count, size_t value_size);
+
+const char* int_encoding_name(IntEncoding encoding);
+
+// Enable or disable the AVX2 unpacking (used when the CPU supports it).
+// Returns 1 if it is now in use.
+int int_codec_set_simd(int enabled);
+const char* int_codec_backend_name(void);
+
+#endif // INT_CODEC_H
@@ -0,0 +1,403 @@
+/*
+ * line_index.c - Line-offset index for random access to lines of text
+ *
+ * Implementation notes:
+ * - The file is read with pread() in 1 MB blocks starting at the first
+ *   unindexed byte, not mapped: a log can be truncated by rotation while
+ *   we read it, which ends a read() early but would fault a mapping.
+ * - Each 64-byte block gets one newline bitmask. popcount() counts its
+ *   lines, and only a block that holds a sampled line (one in K) has its
+ *   bits walked. With K = 64 and ordinary line lengths that is one block
+ *   in a few hundred.
+ * - Only complete lines are indexed. A last line without its newline
+ *   (a log line still being written) is picked up by the next update.
+ * - Sidecar layout, little-endian:
+ *     0  "LIDX"      4  u16 version (1)   6  u16 reserved
+ *     8  u32 stride  12 u32 tail check (CRC32C)
+ *     16 u64 line count   24 u64 indexed size   32 u64 sample count
+ *     40 varint deltas between consecutive samples (sample 0 is 0)
+ *   It is written to a temporary file and renamed over the old one, so
+ *   a reader never sees half an index.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "line_index.h"
+#include "checksum.h"
+#include "simd_scan.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#define INDEX_VERSION 1
+#define HEADER_SIZE 40
+#define READ_BLOCK_SIZE (1024 * 1024)
+#define TAIL_CHECK_SIZE 4096
+
+static const unsigned char INDEX_MAGIC[4] = {'L', 'I', 'D', 'X'};
+
+static void put_u32(unsigned char* out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out[i] = (unsigned char)(value >> (8 * i));
+}
+
+static void put_u64(unsigned char* out, uint64_t value) {
+    for (int i = 0; i < 8; i++) out[i] = (unsigned char)(value >> (8 * i));
+}
+
+static uint32_t get_u32(const unsigned char* in) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) value |= (uint32_t)in[i] << (8 * i);
+    return value;
+}
+
+static uint64_t get_u64(const unsigned char* in) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) value |= (uint64_t)in[i] << (8 * i);
+    return value;
+}
+
+// LEB128: 7 bits per byte, high bit set on all but the last byte
+static size_t put_varint(unsigned char* out, uint64_t value) {
+    size_t length = 0;
+    while (value >= 0x80) {
+        out[length++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    out[length++] = (unsigned char)value;
+    return length;
+}
+
+// Returns bytes used, or 0 if the varint is truncated or too long
+static size_t get_varint(const unsigned char* in, size_t available, uint64_t* value) {
+    uint64_t result = 0;
+    for (size_t i = 0; i < available && i < 10; i++) {
+        result |= (uint64_t)(in[i] & 0x7F) << (7 * i);
+        if ((in[i] & 0x80) == 0) {
+            *value = result;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+static int add_sample(LineIndex* index, uint64_t offset) {
+    if (index->sample_count == index->sample_capacity) {
+        size_t capacity = index->sample_capacity ? index->sample_capacity * 2 : 256;
+        uint64_t* samples = realloc(index->samples, capacity * sizeof(uint64_t));
+        if (samples == NULL) {
+            errno = ENOMEM;
+            return -1;
+        }
+        index->samples = samples;
+        index->sample_capacity = capacity;
+    }
+    index->samples[index->sample_count++] = offset;
+    return 0;
+}
+
+static int reset(LineIndex* index, uint32_t stride) {
+    index->stride = stride ? stride : LINE_INDEX_DEFAULT_STRIDE;
+    index->line_count = 0;
+    index->indexed_size = 0;
+    index->tail_check = 0;
+    index->sample_count = 0;
+    return add_sample(index, 0);
+}
+
+static int read_fully(int fd, char* buffer, size_t size, uint64_t offset, size_t* got) {
+    *got = 0;
+    while (*got < size) {
+        ssize_t n = pread(fd, buffer + *got, size - *got, (off_t)(offset + *got));
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return -1;
+        if (n == 0) break;
+        *got += (size_t)n;
+    }
+    return 0;
+}
+
+// CRC32C of the TAIL_CHECK_SIZE bytes (or fewer) before `end`. Returns
+// 0 on success, 1 if the file is now shorter than `end`, -1 on error.
+static int tail_check(int fd, uint64_t end, char* buffer, uint32_t* check) {
+    size_t size = end < TAIL_CHECK_SIZE ? (size_t)end : TAIL_CHECK_SIZE;
+    size_t got;
+    if (read_fully(fd, buffer, size, end - size, &got) != 0) return -1;
+    if (got != size) return 1;
+    *check = crc32c(0, buffer, size);
+    return 0;
+}
+
+// Count newlines in `data` (file offset `base`), sampling every stride-th
+// line start. `data` must have room for 64 bytes past `length`.
+static int scan_block(LineIndex* index, char* data, size_t length, uint64_t base) {
+    memset(data + length, 0, SCAN_BLOCK_SIZE);
+    uint64_t until_sample = index->stride - index->line_count % index->stride;
+
+    for (size_t pos = 0; pos < length; pos += SCAN_BLOCK_SIZE) {
+        ScanMasks masks;
+        scan_block64(data + pos, &masks);
+        uint64_t bits = masks.newline;
+        if (bits == 0) continue;
+
+        unsigned count = (unsigned)__builtin_popcountll(bits);
+        index->line_count += count;
+        index->indexed_size = base + pos + 64 - (uint64_t)__builtin_clzll(bits);
+
+        while (count >= until_sample) {
+            // The sampled line starts after the until_sample-th newline here
+            for (uint64_t i = 1; i < until_sample; i++) bits &= bits - 1;
+            if (add_sample(index, base + pos + (uint64_t)__builtin_ctzll(bits) + 1) != 0) {
+                return -1;
+            }
+            bits &= bits - 1;
+            count -= (unsigned)until_sample;
+            until_sample = index->stride;
+        }
+        until_sample -= count;
+    }
+    return 0;
+}
+
+long long line_index_update(LineIndex* index, const char* filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return -1;
+
+    char* buffer = malloc(READ_BLOCK_SIZE + SCAN_BLOCK_SIZE);
+    if (buffer == NULL) {
+        close(fd);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    uint64_t old_lines = index->line_count;
+    uint32_t check = 0;
+    int status = 0;
+    if (index->indexed_size > 0) {
+        // An index of a file that was replaced rather than appended to
+        // is thrown away
+        status = tail_check(fd, index->indexed_size, buffer, &check);
+        if (status > 0 || (status == 0 && check != index->tail_check)) {
+            status = reset(index, index->stride);
+            old_lines = 0;
+        }
+    }
+
+    uint64_t offset = index->indexed_size;
+    size_t got = 0;
+    while (status == 0) {
+        status = read_fully(fd, buffer, READ_BLOCK_SIZE, offset, &got);
+        if (status != 0 || got == 0) break;
+        status = scan_block(index, buffer, got, offset);
+        offset += got;
+        if (got < READ_BLOCK_SIZE) break;
+    }
+
+    // A truncation racing with the scan is noticed by the next update
+    if (status == 0 && index->line_count != old_lines &&
+        tail_check(fd, index->indexed_size, buffer, &index->tail_check) < 0) {
+        status = -1;
+    }
+
+    int saved = errno;
+    free(buffer);
+    close(fd);
+    errno = saved;
+    return status == 0 ? (long long)(index->line_count - old_lines) : -1;
+}
+
+int line_index_build(LineIndex* index, const char* filename, uint32_t stride) {
+    memset(index, 0, sizeof(*index));
+    if (reset(index, stride) != 0 || line_index_update(index, filename) < 0) {
+        int saved = errno;
+        line_index_free(index);
+        errno = saved;
+        return -1;
+    }
+    return 0;
+}
+
+int line_index_save(const LineIndex* index, const char* index_filename) {
+    size_t capacity = HEADER_SIZE + index->sample_count * 10;
+    unsigned char* out = malloc(capacity);
+    if (out == NULL) return -1;
+
+    memcpy(out, INDEX_MAGIC, 4);
+    out[4] = INDEX_VERSION;
+    out[5] = out[6] = out[7] = 0;
+    put_u32(out + 8, index->stride);
+    put_u32(out + 12, index->tail_check);
+    put_u64(out + 16, index->line_count);
+    put_u64(out + 24, index->indexed_size);
+    put_u64(out + 32, index->sample_count);
+    size_t length = HEADER_SIZE;
+    for (size_t i = 1; i < index->sample_count; i++) {
+        length += put_varint(out + length, index->samples[i] - index->samples[i - 1]);
+    }
+
+    // Write next to the target, then rename over it
+    size_t name_length = strlen(index_filename);
+    char* temp_name = malloc(name_length + 5);
+    if (temp_name == NULL) {
+        free(out);
+        return -1;
+    }
+    memcpy(temp_name, index_filename, name_length);
+    memcpy(temp_name + name_length, ".tmp", 5);
+
+    FILE* file = fopen(temp_name, "wb");
+    int ok = file != NULL && fwrite(out, 1, length, file) == length;
+    if (file != NULL && fclose(file) != 0) ok = 0;
+    if (ok && rename(temp_name, index_filename) != 0) ok = 0;
+
+    int saved = errno;
+    if (!ok) remove(temp_name);
+    free(temp_name);
+    free(out);
+    errno = saved;
+    return ok ? 0 : -1;
+}
+
+int line_index_load(LineIndex* index, const char* index_filename) {
+    memset(index, 0, sizeof(*index));
+    FILE* file = fopen(index_filename, "rb");
+    if (file == NULL) return -1;
+
+    unsigned char header[HEADER_SIZE];
+    unsigned char* body = NULL;
+    long size = -1;
+    int valid = fread(header, 1, HEADER_SIZE, file) == HEADER_SIZE &&
+                memcmp(header, INDEX_MAGIC, 4) == 0 && header[4] == INDEX_VERSION && header[5] == 0 &&
+                fseek(file, 0, SEEK_END) == 0 && (size = ftell(file)) >= HEADER_SIZE;
+
+    if (valid) {
+        index->stride = get_u32(header + 8);
+        index->tail_check = get_u32(header + 12);
+        index->line_count = get_u64(header + 16);
+        index->indexed_size = get_u64(header + 24);
+        uint64_t sample_count = get_u64(header + 32);
+        valid = index->stride > 0 && sample_count > 0 &&
+                sample_count == index->line_count / index->stride + 1 &&
+                sample_count <= (uint64_t)size;     // Every sample past the first takes a byte
+        if (valid) {
+            index->sample_capacity = (size_t)sample_count;
+            index->samples = malloc(index->sample_capacity * sizeof(uint64_t));
+            body = malloc((size_t)size - HEADER_SIZE + 1);
+            valid = index->samples != NULL && body != NULL &&
+                    fseek(file, HEADER_SIZE, SEEK_SET) == 0 &&
+                    fread(body, 1, (size_t)size - HEADER_SIZE, file) == (size_t)size - HEADER_SIZE;
+        }
+        if (valid) {
+            size_t position = 0, body_size = (size_t)size - HEADER_SIZE;
+            index->samples[0] = 0;
+            index->sample_count = 1;
+            while (valid && index->sample_count < sample_count) {
+                uint64_t delta;
+                size_t used = get_varint(body + position, body_size - position, &delta);
+                uint64_t previous = index->samples[index->sample_count - 1];
+                valid = used > 0 && delta > 0 && delta <= index->indexed_size - previous;
+                index->samples[index->sample_count++] = previous + delta;
+                position += used;
+            }
+            valid = valid && position == body_size;
+        }
+    }
+
+    fclose(file);
+    free(body);
+    if (!valid) {
+        line_index_free(index);
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+int line_index_open(LineIndex* index, const char* filename, uint32_t stride) {
+    size_t name_length = strlen(filename);
+    char* index_filename = malloc(name_length + 5);
+    if (index_filename == NULL) return -1;
+    memcpy(index_filename, filename, name_length);
+    memcpy(index_filename + name_length, ".idx", 5);
+
+    int changed = 0;
+    if (line_index_load(index, index_filename) != 0 ||
+        (stride != 0 && index->stride != stride)) {
+        line_index_free(index);
+        if (line_index_build(index, filename, stride) != 0) {
+            int saved = errno;
+            free(index_filename);
+            errno = saved;
+            return -1;
+        }
+        changed = 1;
+    } else {
+        uint64_t old_size = index->indexed_size;
+        long long added = line_index_update(index, filename);
+        if (added < 0) {
+            int saved = errno;
+            line_index_free(index);
+            free(index_filename);
+            errno = saved;
+            return -1;
+        }
+        changed = added > 0 || index->indexed_size != old_size;
+    }
+
+    // The sidecar is a cache: an index that can't be saved (read-only
+    // directory) is still returned
+    if (changed) line_index_save(index, index_filename);
+    free(index_filename);
+    return 0;
+}
+
+void line_index_free(LineIndex* index) {
+    free(index->samples);
+    index->samples = NULL;
+    index->sample_count = 0;
+    index->sample_capacity = 0;
+}
+
+long long line_index_offset(const LineIndex* index, FILE* file, uint64_t line) {
+    if (line > index->line_count) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    uint64_t offset = index->samples[line / index->stride];
+    uint64_t skip = line % index->stride;
+    if (skip == 0) return (long long)offset;
+    if (fseeko(file, (off_t)offset, SEEK_SET) != 0) return -1;
+
+    char buffer[16 * 1024];
+    for (;;) {
+        size_t got = fread(buffer, 1, sizeof(buffer), file);
+        if (got == 0) {
+            // The file lost lines the index knows about
+            if (!ferror(file)) errno = EINVAL;
+            return -1;
+        }
+
+        ScanCursor cursor;
+        const char* end = buffer + got;
+        const char* p = buffer;
+        scan_cursor_init(&cursor, buffer, end, SCAN_NEWLINE);
+        while (skip > 0) {
+            const char* newline = scan_cursor_next(&cursor, p);
+            if (newline == end) break;
+            p = newline + 1;
+            skip--;
+        }
+        if (skip == 0) return (long long)(offset + (uint64_t)(p - buffer));
+        offset += got;
+    }
+}
+
+int seek_line(FILE* file, const LineIndex* index, uint64_t line) {
+    long long offset = line_index_offset(index, file, line);
+    if (offset < 0) return -1;
+    return fseeko(file, (off_t)offset, SEEK_SET);
+}
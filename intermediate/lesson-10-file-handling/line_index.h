@@ -0,0 +1,75 @@
+/*
+ * line_index.h - Line-offset index for random access to lines of text
+ *
+ * fseek() can jump to any byte, but "go to line 5,000,000" still means
+ * reading every line before it to count newlines. A line index does that
+ * counting once: it records the byte offset of every K-th line, so line
+ * N is reached by seeking to the offset of line N - N % K and reading
+ * forward over fewer than K lines.
+ *
+ * The index is saved next to the text file as a sidecar (`app.log.idx`).
+ * Offsets are stored as varint-encoded differences between samples -
+ * typically two or three bytes per sample instead of eight. When the
+ * text file grows (a log being appended to), only the new bytes are
+ * scanned; the sidecar remembers how far it got and a checksum of the
+ * bytes just before that point, so a file that was rewritten instead of
+ * appended is detected and indexed from scratch.
+ *
+ * Newlines are found 64 bytes at a time with the SIMD scanner
+ * (simd_scan.h) and counted with popcount.
+ *
+ * For frontend developers: This is what a virtualized list needs to jump
+ * to row N of a huge log view without rendering rows 0..N-1, and what
+ * source maps do for "line:column" positions.
+ */
+
+#ifndef LINE_INDEX_H
+#define LINE_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define LINE_INDEX_DEFAULT_STRIDE 64
+
+typedef struct {
+    uint32_t stride;            // K: lines between samples
+    uint64_t line_count;        // Complete (newline-terminated) lines indexed
+    uint64_t indexed_size;      // Bytes covered: up to just after the last newline
+    uint32_t tail_check;        // CRC32C of up to 4 KB before indexed_size
+    uint64_t* samples;          // samples[i] = byte offset of line i * stride
+    size_t sample_count;        // Always line_count / stride + 1
+    size_t sample_capacity;
+} LineIndex;
+
+// Index `filename` from scratch (stride 0 = LINE_INDEX_DEFAULT_STRIDE).
+// Returns 0 on success, -1 with errno set.
+int line_index_build(LineIndex* index, const char* filename, uint32_t stride);
+
+// Scan whatever was appended to `filename` since the index was built.
+// Re-indexes from scratch if the file shrank or the indexed part changed.
+// Returns the number of lines added, or -1 with errno set.
+long long line_index_update(LineIndex* index, const char* filename);
+
+// Read/write the sidecar. Load returns -1 with errno EINVAL for a file
+// that isn't a valid index.
+int line_index_save(const LineIndex* index, const char* index_filename);
+int line_index_load(LineIndex* index, const char* index_filename);
+
+// Everything together: load `filename`.idx if it exists, bring it up to
+// date with line_index_update(), and save it back if anything changed.
+// Builds and saves a new sidecar when there is none (or it is invalid).
+int line_index_open(LineIndex* index, const char* filename, uint32_t stride);
+
+void line_index_free(LineIndex* index);
+
+// Byte offset where line `line` (0-based) starts. Reads fewer than
+// `stride` lines from `file`. Line `line_count` is allowed and is where
+// the next appended line will start. Returns -1 with errno EINVAL for a
+// line past that, or on a read error.
+long long line_index_offset(const LineIndex* index, FILE* file, uint64_t line);
+
+// fseek() to the start of line `line`. Returns 0 on success, -1 on error.
+int seek_line(FILE* file, const LineIndex* index, uint64_t line);
+
+#endif // LINE_INDEX_H
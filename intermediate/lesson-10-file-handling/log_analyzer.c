@@ -0,0 +1,423 @@
+/*
+ * log_analyzer.c - Log line parsing and a parallel, chunked log analyzer
+ *
+ * Implementation notes:
+ * - The file is mapped once (mapped_file.c) and shared read-only by every
+ *   thread. Inputs that can't be mapped, like pipes, are read into memory.
+ * - Chunk boundaries are plain byte offsets. A line belongs to the chunk
+ *   that holds its first byte: a worker skips the partial line at the
+ *   start of its chunk and finishes the line that crosses its end. No
+ *   line is lost or counted twice, and no pre-pass is needed.
+ * - There are more chunks than threads; threads grab the next chunk with
+ *   an atomic fetch-and-add, so a slow thread doesn't hold up the rest.
+ * - Each thread interns names into its own dictionary, so IDs differ
+ *   between threads. The merge translates them by name into the total's
+ *   dictionary - once per distinct name, not once per line.
+ */
+
+#define _GNU_SOURCE
+
+#include "log_analyzer.h"
+#include "mapped_file.h"
+#include "simd_scan.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Chunks per thread: enough to balance uneven lines, few enough that the
+// per-chunk overhead stays invisible
+#define CHUNKS_PER_THREAD 16
+#define MIN_CHUNK_SIZE (1024 * 1024)
+
+typedef struct {
+    const char* data;
+    size_t size;
+    size_t chunk_size;
+    size_t chunk_count;
+    size_t next_chunk;      // Updated with atomic fetch-and-add
+} SharedWork;
+
+typedef struct {
+    SharedWork* work;
+    LogCounters* counters;
+    pthread_t thread;
+} Worker;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static const char* skip_spaces(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    return p;
+}
+
+// Split one line whose end (newline or end of data) is `end`. The cursor
+// reports spaces and newlines and may be shared by consecutive lines.
+static int split_with_cursor(ScanCursor* cursor, const char* line, const char* end,
+                             LogFields* fields) {
+    LogSlice* slots[4] = {&fields->date, &fields->time, &fields->level, &fields->component};
+    const char* p = skip_spaces(line, end);
+
+    for (int i = 0; i < 4; i++) {
+        if (p == end) return 0;
+        const char* field_end = scan_cursor_next(cursor, p);
+        if (field_end > end) field_end = end;
+        slots[i]->data = p;
+        slots[i]->length = (size_t)(field_end - p);
+        p = skip_spaces(field_end, end);
+    }
+
+    // Message is the rest of the line, without a CRLF's '\r'
+    if (p == end) return 0;
+    const char* message_end = end;
+    if (message_end[-1] == '\r') message_end--;
+    fields->message.data = p;
+    fields->message.length = (size_t)(message_end - p);
+    return 1;
+}
+
+int log_split_fields(const char* line, size_t length, LogFields* fields) {
+    const char* end = scan_find(line, line + length, SCAN_NEWLINE);
+    ScanCursor cursor;
+
+    scan_cursor_init(&cursor, line, end, SCAN_SPACE);
+    return split_with_cursor(&cursor, line, end, fields);
+}
+
+// Copy a slice into a fixed-size field, always terminated
+static void copy_slice(char* dest, size_t dest_size, LogSlice slice) {
+    size_t length = slice.length < dest_size ? slice.length : dest_size - 1;
+    memcpy(dest, slice.data, length);
+    dest[length] = '\0';
+}
+
+int log_dictionary_init(LogDictionary* dictionary) {
+    static const char* builtin_levels[LOG_LEVEL_BUILTIN_COUNT] = {"ERROR", "WARN", "INFO", "DEBUG"};
+
+    if (intern_init(&dictionary->levels, 16) != 0) return -1;
+    if (intern_init(&dictionary->components, 64) != 0) {
+        intern_free(&dictionary->levels);
+        return -1;
+    }
+
+    // Seeded in LogLevel order, so e.g. "ERROR" is always ID 0
+    for (int i = 0; i < LOG_LEVEL_BUILTIN_COUNT; i++) {
+        intern_id(&dictionary->levels, builtin_levels[i], strlen(builtin_levels[i]));
+    }
+    return 0;
+}
+
+void log_dictionary_free(LogDictionary* dictionary) {
+    intern_free(&dictionary->levels);
+    intern_free(&dictionary->components);
+}
+
+static uint16_t intern_slice(InternTable* table, LogSlice slice) {
+    int id = intern_id(table, slice.data, slice.length);
+    return id < 0 ? LOG_UNKNOWN_ID : (uint16_t)id;
+}
+
+int parse_log_fields(LogDictionary* dictionary, const char* line, size_t length,
+                     LogEntry* entry) {
+    LogFields fields;
+    if (!log_split_fields(line, length, &fields)) return 0;
+
+    snprintf(entry->timestamp, sizeof(entry->timestamp), "%.*s %.*s",
+             (int)fields.date.length, fields.date.data,
+             (int)fields.time.length, fields.time.data);
+    entry->level = intern_slice(&dictionary->levels, fields.level);
+    entry->component = intern_slice(&dictionary->components, fields.component);
+    copy_slice(entry->message, sizeof(entry->message), fields.message);
+    return 1;
+}
+
+size_t log_count(const LogCountArray* array, uint16_t id) {
+    return id < array->capacity ? array->counts[id] : 0;
+}
+
+static int count_add(LogCountArray* array, uint16_t id, size_t count) {
+    if (id >= array->capacity) {
+        size_t new_capacity = array->capacity ? array->capacity : 16;
+        while (new_capacity <= id) new_capacity *= 2;
+
+        size_t* counts = realloc(array->counts, new_capacity * sizeof(size_t));
+        if (counts == NULL) return -1;
+        memset(counts + array->capacity, 0, (new_capacity - array->capacity) * sizeof(size_t));
+        array->counts = counts;
+        array->capacity = new_capacity;
+    }
+    array->counts[id] += count;
+    return 0;
+}
+
+static int counters_init(LogCounters* counters) {
+    memset(counters, 0, sizeof(*counters));
+    return log_dictionary_init(&counters->dictionary);
+}
+
+static void counters_free(LogCounters* counters) {
+    log_dictionary_free(&counters->dictionary);
+    free(counters->level_counts.counts);
+    free(counters->component_counts.counts);
+    memset(counters, 0, sizeof(*counters));
+}
+
+int log_default_thread_count(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (int)cpus : 1;
+}
+
+static void process_chunk(const SharedWork* work, size_t start, size_t end,
+                          LogCounters* counters) {
+    const char* data = work->data;
+    const char* data_end = data + work->size;
+    const char* chunk_end = data + end;
+    const char* p = data + start;
+
+    // The partial line at the start belongs to the previous chunk
+    if (start > 0 && data[start - 1] != '\n') {
+        p = scan_find(p, data_end, SCAN_NEWLINE);
+        p = (p < data_end) ? p + 1 : data_end;
+    }
+
+    ScanCursor lines, fields;
+    scan_cursor_init(&lines, p, data_end, SCAN_NEWLINE);
+    scan_cursor_init(&fields, p, data_end, SCAN_SPACE | SCAN_NEWLINE);
+
+    while (p < chunk_end) {
+        const char* line_end = scan_cursor_next(&lines, p);
+        LogFields parsed;
+
+        if (line_end > p) {
+            counters->lines++;
+            if (split_with_cursor(&fields, p, line_end, &parsed)) {
+                uint16_t level = intern_slice(&counters->dictionary.levels, parsed.level);
+                uint16_t component = intern_slice(&counters->dictionary.components, parsed.component);
+
+                // Counting is an array increment - no strcmp() per line
+                if (level == LOG_UNKNOWN_ID || count_add(&counters->level_counts, level, 1) != 0) {
+                    counters->unknown_names++;
+                }
+                if (component == LOG_UNKNOWN_ID ||
+                    count_add(&counters->component_counts, component, 1) != 0) {
+                    counters->unknown_names++;
+                }
+
+                if (level == LOG_LEVEL_ERROR && counters->error_sample_count < LOG_ERROR_SAMPLES) {
+                    counters->error_offsets[counters->error_sample_count++] = (size_t)(p - data);
+                }
+            } else {
+                counters->malformed++;
+            }
+        }
+
+        p = (line_end < data_end) ? line_end + 1 : data_end;
+    }
+}
+
+static void* worker_main(void* arg) {
+    Worker* worker = (Worker*)arg;
+    SharedWork* work = worker->work;
+    double start = now_seconds();
+
+    for (;;) {
+        size_t chunk = __atomic_fetch_add(&work->next_chunk, 1, __ATOMIC_RELAXED);
+        if (chunk >= work->chunk_count) break;
+
+        size_t begin = chunk * work->chunk_size;
+        size_t end = begin + work->chunk_size;
+        if (end > work->size) end = work->size;
+
+        process_chunk(work, begin, end, worker->counters);
+        worker->counters->bytes += end - begin;
+    }
+
+    worker->counters->seconds = now_seconds() - start;
+    return NULL;
+}
+
+static int compare_offsets(const void* a, const void* b) {
+    size_t x = *(const size_t*)a, y = *(const size_t*)b;
+    return (x > y) - (x < y);
+}
+
+typedef struct {
+    uint16_t id;
+    size_t count;
+    const char* name;
+} RankedComponent;
+
+static int compare_components(const void* a, const void* b) {
+    const RankedComponent* x = (const RankedComponent*)a;
+    const RankedComponent* y = (const RankedComponent*)b;
+    if (x->count != y->count) return (x->count < y->count) ? 1 : -1;
+    return strcmp(x->name, y->name);
+}
+
+// Add every count of `part` to `total`, translating IDs through the names
+static void merge_names(InternTable* total_names, LogCountArray* total_counts,
+                        const InternTable* part_names, const LogCountArray* part_counts,
+                        size_t* unknown_names) {
+    for (size_t id = 0; id < intern_count(part_names); id++) {
+        size_t count = log_count(part_counts, (uint16_t)id);
+        if (count == 0) continue;
+
+        const char* name = intern_name(part_names, (uint16_t)id);
+        int total_id = intern_id(total_names, name, strlen(name));
+        if (total_id < 0 || count_add(total_counts, (uint16_t)total_id, count) != 0) {
+            *unknown_names += count;
+        }
+    }
+}
+
+static int merge_counters(LogAnalysis* analysis) {
+    LogCounters* total = &analysis->total;
+    size_t offsets[LOG_MAX_THREADS * LOG_ERROR_SAMPLES];
+    size_t offset_count = 0;
+
+    for (int t = 0; t < analysis->thread_count; t++) {
+        const LogCounters* part = &analysis->per_thread[t];
+
+        total->lines += part->lines;
+        total->malformed += part->malformed;
+        total->bytes += part->bytes;
+        total->unknown_names += part->unknown_names;
+        merge_names(&total->dictionary.levels, &total->level_counts,
+                    &part->dictionary.levels, &part->level_counts, &total->unknown_names);
+        merge_names(&total->dictionary.components, &total->component_counts,
+                    &part->dictionary.components, &part->component_counts,
+                    &total->unknown_names);
+        for (int i = 0; i < part->error_sample_count; i++) {
+            offsets[offset_count++] = part->error_offsets[i];
+        }
+    }
+
+    // Each thread kept its own first errors; the global first ones are among them
+    qsort(offsets, offset_count, sizeof(size_t), compare_offsets);
+    total->error_sample_count = offset_count < LOG_ERROR_SAMPLES ? (int)offset_count : LOG_ERROR_SAMPLES;
+    memcpy(total->error_offsets, offsets, total->error_sample_count * sizeof(size_t));
+
+    // Rank components by activity for reporting
+    size_t component_count = intern_count(&total->dictionary.components);
+    RankedComponent* ranked = malloc((component_count + 1) * sizeof(RankedComponent));
+    analysis->components_by_count = malloc((component_count + 1) * sizeof(uint16_t));
+    if (ranked == NULL || analysis->components_by_count == NULL) {
+        free(ranked);
+        return -1;
+    }
+
+    for (size_t id = 0; id < component_count; id++) {
+        ranked[id].id = (uint16_t)id;
+        ranked[id].count = log_count(&total->component_counts, (uint16_t)id);
+        ranked[id].name = intern_name(&total->dictionary.components, (uint16_t)id);
+    }
+    qsort(ranked, component_count, sizeof(RankedComponent), compare_components);
+    for (size_t i = 0; i < component_count; i++) {
+        analysis->components_by_count[i] = ranked[i].id;
+    }
+
+    free(ranked);
+    return 0;
+}
+
+void log_analysis_free(LogAnalysis* analysis) {
+    if (analysis->per_thread != NULL) {
+        for (int t = 0; t < analysis->thread_count; t++) {
+            counters_free(&analysis->per_thread[t]);
+        }
+        free(analysis->per_thread);
+    }
+    counters_free(&analysis->total);
+    free(analysis->components_by_count);
+    memset(analysis, 0, sizeof(*analysis));
+}
+
+// Allocate the total and per-thread counters for `thread_count` threads
+static int analysis_init(LogAnalysis* analysis, int thread_count) {
+    memset(analysis, 0, sizeof(*analysis));
+
+    analysis->per_thread = calloc((size_t)thread_count, sizeof(LogCounters));
+    if (analysis->per_thread == NULL) return -1;
+    analysis->thread_count = thread_count;
+
+    int result = counters_init(&analysis->total);
+    for (int t = 0; t < thread_count; t++) {
+        if (counters_init(&analysis->per_thread[t]) != 0) result = -1;
+    }
+    if (result != 0) log_analysis_free(analysis);
+    return result;
+}
+
+int log_analyze_file(const char* filename, int thread_count, LogAnalysis* analysis) {
+    if (thread_count <= 0) thread_count = log_default_thread_count();
+    if (thread_count > LOG_MAX_THREADS) thread_count = LOG_MAX_THREADS;
+
+    if (analysis_init(analysis, thread_count) != 0) return -1;
+
+    MappedFile file;
+    if (mapped_file_open(&file, filename, MAPPED_FILE_SEQUENTIAL) != 0) {
+        log_analysis_free(analysis);
+        return -1;
+    }
+
+    analysis->file_size = file.size;
+    if (file.size == 0) {
+        mapped_file_close(&file);
+        return merge_counters(analysis);
+    }
+
+    SharedWork work;
+    work.data = file.data;
+    work.size = file.size;
+    work.chunk_size = work.size / ((size_t)thread_count * CHUNKS_PER_THREAD);
+    if (work.chunk_size < MIN_CHUNK_SIZE) work.chunk_size = MIN_CHUNK_SIZE;
+    work.chunk_count = (work.size + work.chunk_size - 1) / work.chunk_size;
+    work.next_chunk = 0;
+    analysis->chunk_count = work.chunk_count;
+
+    Worker* workers = calloc((size_t)thread_count, sizeof(Worker));
+    if (workers == NULL) {
+        mapped_file_close(&file);
+        log_analysis_free(analysis);
+        return -1;
+    }
+
+    double start = now_seconds();
+
+    int started = 0;
+    for (int t = 0; t < thread_count; t++) {
+        workers[t].work = &work;
+        workers[t].counters = &analysis->per_thread[t];
+        if (pthread_create(&workers[t].thread, NULL, worker_main, &workers[t]) != 0) break;
+        started++;
+    }
+
+    if (started == 0) {
+        // No threads available: do all the work on this one
+        worker_main(&workers[0]);
+        started = 1;
+    } else {
+        for (int t = 0; t < started; t++) {
+            pthread_join(workers[t].thread, NULL);
+        }
+    }
+
+    analysis->seconds = now_seconds() - start;
+
+    // Fewer threads may have started than asked for: report only those
+    for (int t = started; t < thread_count; t++) counters_free(&analysis->per_thread[t]);
+    analysis->thread_count = started;
+    int result = merge_counters(analysis);
+
+    free(workers);
+    mapped_file_close(&file);
+    if (result != 0) log_analysis_free(analysis);
+    return result;
+}
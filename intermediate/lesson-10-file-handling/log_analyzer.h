@@ -0,0 +1,122 @@
+/*
+ * log_analyzer.h - Log line parsing and a parallel, chunked log analyzer
+ *
+ * The analyzer maps the log file into memory, cuts it into chunks that
+ * start and end on line boundaries, and lets a pool of pthreads pull
+ * chunks from a shared counter. Each thread counts levels and components
+ * into its own private counters - no locks, no shared cache lines - and
+ * the counters are merged once at the end.
+ *
+ * Levels and components are interned (string_intern.h): each distinct
+ * name gets a small integer ID, a LogEntry carries two uint16_t codes
+ * instead of two char arrays, and counting is an array increment.
+ *
+ * For frontend developers: Like splitting work across Web Workers and
+ * combining their postMessage() results, except the threads share the
+ * mapped file directly instead of copying it to each worker.
+ */
+
+#ifndef LOG_ANALYZER_H
+#define LOG_ANALYZER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "string_intern.h"
+
+typedef struct {
+    char timestamp[20];
+    uint16_t level;         // ID in LogDictionary.levels
+    uint16_t component;     // ID in LogDictionary.components
+    char message[200];
+} LogEntry;
+
+// Name <-> ID tables for levels and components
+typedef struct {
+    InternTable levels;
+    InternTable components;
+} LogDictionary;
+
+// A field of a log line: pointer + length into the line, not terminated
+typedef struct {
+    const char* data;
+    size_t length;
+} LogSlice;
+
+typedef struct {
+    LogSlice date;
+    LogSlice time;
+    LogSlice level;
+    LogSlice component;
+    LogSlice message;
+} LogFields;
+
+// Every dictionary starts with these levels, so their IDs are fixed.
+// Any other level name gets the next free ID.
+typedef enum {
+    LOG_LEVEL_ERROR,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_DEBUG,
+    LOG_LEVEL_BUILTIN_COUNT
+} LogLevel;
+
+// ID used when a name could not be interned (table full or out of memory)
+#define LOG_UNKNOWN_ID 0xFFFF
+
+#define LOG_MAX_THREADS 256
+#define LOG_ERROR_SAMPLES 8
+
+// Counters indexed by interned ID; grows as new IDs appear
+typedef struct {
+    size_t* counts;
+    size_t capacity;
+} LogCountArray;
+
+typedef struct {
+    LogDictionary dictionary;       // Private to the thread that fills it
+    LogCountArray level_counts;
+    LogCountArray component_counts;
+    size_t lines;
+    size_t malformed;
+    size_t unknown_names;           // Names that could not be interned
+    size_t error_offsets[LOG_ERROR_SAMPLES];  // File offsets of the first ERROR lines
+    int error_sample_count;
+    size_t bytes;                   // Bytes of input this thread processed
+    double seconds;                 // Wall time this thread spent working
+} LogCounters;
+
+typedef struct {
+    int thread_count;
+    size_t chunk_count;
+    size_t file_size;
+    double seconds;
+    LogCounters total;
+    LogCounters* per_thread;
+    uint16_t* components_by_count;  // Component IDs of `total`, busiest first
+} LogAnalysis;
+
+int log_dictionary_init(LogDictionary* dictionary);
+void log_dictionary_free(LogDictionary* dictionary);
+
+// Count for an ID (0 if the ID has never been counted)
+size_t log_count(const LogCountArray* array, uint16_t id);
+
+// Split "YYYY-MM-DD HH:MM:SS LEVEL COMPONENT MESSAGE" into slices.
+// Returns 1 on success, 0 if the line is missing fields.
+int log_split_fields(const char* line, size_t length, LogFields* fields);
+
+// Parse one line into a LogEntry. Level and component are interned in
+// `dictionary`; timestamp and message are copied and truncated to fit.
+int parse_log_fields(LogDictionary* dictionary, const char* line, size_t length,
+                     LogEntry* entry);
+
+// Number of online CPUs (at least 1)
+int log_default_thread_count(void);
+
+// Analyze a log file with `thread_count` threads (0 = one per CPU).
+// Returns 0 on success; release the result with log_analysis_free().
+int log_analyze_file(const char* filename, int thread_count, LogAnalysis* analysis);
+void log_analysis_free(LogAnalysis* analysis);
+
+#endif // LOG_ANALYZER_H
@@ -0,0 +1,254 @@
+/*
+ * lz_codec.c - LZ4 block format compressor and decompressor
+ *
+ * Implementation notes:
+ * - Positions are offsets from the block start, which fit in 16 bits
+ *   because a block is at most 64 KB, so the hash table is 8192 uint16_t
+ *   (16 KB, stays in L1). It is cleared per block; a stale entry can
+ *   only cause a failed 4-byte comparison, never a wrong match.
+ * - The format's end rules are kept so the output is valid LZ4: the last
+ *   5 bytes are always literals and no match starts in the last 12
+ *   bytes. That also gives the decompressor slack to copy in 8/16-byte
+ *   pieces.
+ * - Search: after 32 positions without a match, the step grows by one
+ *   every 32 more, so random data is skipped over quickly instead of
+ *   hashed byte by byte.
+ * - Match length is found 8 bytes at a time: XOR two words and count the
+ *   trailing zero bits (leading on big-endian hosts) of the difference.
+ * - The decompressor checks every length against both buffers before
+ *   copying. Literals and matches with an offset of 8 or more are copied
+ *   in 8-byte (literals: 16-byte) pieces when there is room behind the
+ *   output to spill into; overlapping matches (offset < 8, i.e. runs)
+ *   and the end of the buffer go byte by byte.
+ */
+
+#include "lz_codec.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#define MIN_MATCH 4
+#define LAST_LITERALS 5
+#define MATCH_FIND_LIMIT 12
+#define HASH_LOG 13
+#define SKIP_TRIGGER 5
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define LZ_BIG_ENDIAN 1
+#else
+#define LZ_BIG_ENDIAN 0
+#endif
+
+static uint32_t read32(const unsigned char* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static uint64_t read64(const unsigned char* p) {
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static unsigned hash4(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - HASH_LOG);
+}
+
+// Equal bytes from a and b onwards, stopping at `limit` (b is behind a)
+static size_t common_length(const unsigned char* a, const unsigned char* b,
+                            const unsigned char* limit) {
+    const unsigned char* start = a;
+    while (a + 8 <= limit) {
+        uint64_t difference = read64(a) ^ read64(b);
+        if (difference != 0) {
+            unsigned bits = LZ_BIG_ENDIAN ? (unsigned)__builtin_clzll(difference)
+                                          : (unsigned)__builtin_ctzll(difference);
+            return (size_t)(a - start) + bits / 8;
+        }
+        a += 8;
+        b += 8;
+    }
+    while (a < limit && *a == *b) {
+        a++;
+        b++;
+    }
+    return (size_t)(a - start);
+}
+
+size_t lz_compress_bound(size_t size) {
+    return size + size / 255 + 16;
+}
+
+// Extra length bytes after a 15 in the token
+static unsigned char* put_length(unsigned char* out, size_t length) {
+    while (length >= 255) {
+        *out++ = 255;
+        length -= 255;
+    }
+    *out++ = (unsigned char)length;
+    return out;
+}
+
+// Worst-case bytes for a sequence with these lengths
+static size_t sequence_size(size_t literals, size_t match_extra) {
+    return 1 + literals / 255 + 1 + literals + 2 + match_extra / 255 + 1;
+}
+
+size_t lz_compress(const void* source, size_t size, void* destination, size_t capacity) {
+    const unsigned char* const base = source;
+    const unsigned char* const end = base + size;
+    const unsigned char* ip = base;
+    const unsigned char* anchor = base;    // First byte not yet written out
+    unsigned char* op = destination;
+    unsigned char* const op_end = op + capacity;
+
+    if (size > LZ_MAX_BLOCK) return 0;
+
+    if (size > MATCH_FIND_LIMIT) {
+        const unsigned char* const match_limit = end - LAST_LITERALS;
+        const unsigned char* const search_limit = end - MATCH_FIND_LIMIT;
+        uint16_t table[1 << HASH_LOG];
+        memset(table, 0, sizeof(table));
+        ip++;
+
+        while (ip <= search_limit) {
+            // Find a 4-byte match
+            const unsigned char* match;
+            unsigned attempts = 1u << SKIP_TRIGGER;
+            for (;;) {
+                uint32_t sequence = read32(ip);
+                unsigned h = hash4(sequence);
+                match = base + table[h];
+                table[h] = (uint16_t)(ip - base);
+                if (read32(match) == sequence && match < ip) break;
+                ip += attempts++ >> SKIP_TRIGGER;
+                if (ip > search_limit) goto last_literals;
+            }
+
+            // Take in equal bytes before it, then extend it forwards
+            while (ip > anchor && match > base && ip[-1] == match[-1]) {
+                ip--;
+                match--;
+            }
+            size_t literals = (size_t)(ip - anchor);
+            size_t extra = common_length(ip + MIN_MATCH, match + MIN_MATCH, match_limit);
+            if (sequence_size(literals, extra) > (size_t)(op_end - op)) return 0;
+
+            unsigned char* token = op++;
+            if (literals >= 15) {
+                *token = 15 << 4;
+                op = put_length(op, literals - 15);
+            } else {
+                *token = (unsigned char)(literals << 4);
+            }
+            memcpy(op, anchor, literals);
+            op += literals;
+
+            size_t offset = (size_t)(ip - match);
+            op[0] = (unsigned char)offset;
+            op[1] = (unsigned char)(offset >> 8);
+            op += 2;
+            if (extra >= 15) {
+                *token |= 15;
+                op = put_length(op, extra - 15);
+            } else {
+                *token |= (unsigned char)extra;
+            }
+
+            ip += MIN_MATCH + extra;
+            anchor = ip;
+            // Remember a position inside the match: the next one often
+            // continues from there
+            if (ip <= search_limit) table[hash4(read32(ip - 2))] = (uint16_t)(ip - 2 - base);
+        }
+    }
+
+last_literals:;
+    size_t literals = (size_t)(end - anchor);
+    if (1 + literals / 255 + 1 + literals > (size_t)(op_end - op)) return 0;
+    if (literals >= 15) {
+        *op++ = 15 << 4;
+        op = put_length(op, literals - 15);
+    } else {
+        *op++ = (unsigned char)(literals << 4);
+    }
+    memcpy(op, anchor, literals);
+    op += literals;
+    return (size_t)(op - (unsigned char*)destination);
+}
+
+// Add the extra length bytes to `length`. Returns -1 if the input ends
+// or the length can't fit in `limit`.
+static int read_length(const unsigned char** in, const unsigned char* in_end, size_t* length,
+                       size_t limit) {
+    const unsigned char* p = *in;
+    unsigned byte;
+    do {
+        if (p >= in_end) return -1;
+        byte = *p++;
+        *length += byte;
+        if (*length > limit) return -1;
+    } while (byte == 255);
+    *in = p;
+    return 0;
+}
+
+int lz_decompress(const void* source, size_t size, void* destination, size_t raw_size) {
+    const unsigned char* ip = source;
+    const unsigned char* const ip_end = ip + size;
+    unsigned char* const base = destination;
+    unsigned char* op = base;
+    unsigned char* const op_end = base + raw_size;
+
+    for (;;) {
+        if (ip >= ip_end) goto corrupt;
+        unsigned token = *ip++;
+
+        size_t literals = token >> 4;
+        if (literals == 15 && read_length(&ip, ip_end, &literals, raw_size) != 0) goto corrupt;
+        if (literals > (size_t)(ip_end - ip) || literals > (size_t)(op_end - op)) goto corrupt;
+        if (literals <= 16 && ip_end - ip >= 16 && op_end - op >= 16) {
+            memcpy(op, ip, 16);
+        } else {
+            memcpy(op, ip, literals);
+        }
+        op += literals;
+        ip += literals;
+
+        // The last sequence has literals only
+        if (ip == ip_end) break;
+
+        if (ip_end - ip < 2) goto corrupt;
+        size_t offset = (size_t)ip[0] | (size_t)ip[1] << 8;
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - base)) goto corrupt;
+
+        size_t length = token & 15;
+        if (length == 15 && read_length(&ip, ip_end, &length, raw_size) != 0) goto corrupt;
+        length += MIN_MATCH;
+        if (length > (size_t)(op_end - op)) goto corrupt;
+
+        const unsigned char* match = op - offset;
+        unsigned char* copy_end = op + length;
+        if (offset >= 8 && (size_t)(op_end - op) >= length + 8) {
+            // May write up to 7 bytes past copy_end, which the next
+            // sequence overwrites
+            do {
+                memcpy(op, match, 8);
+                op += 8;
+                match += 8;
+            } while (op < copy_end);
+        } else {
+            while (op < copy_end) *op++ = *match++;
+        }
+        op = copy_end;
+    }
+
+    if (op == op_end) return 0;
+
+corrupt:
+    errno = EINVAL;
+    return -1;
+}
@@ -0,0 +1,47 @@
+/*
+ * lz_codec.h - LZ4-style block compression, no external library
+ *
+ * LZ77 compression replaces a run of bytes that already appeared
+ * earlier with a (distance back, length) pair. Record files repeat a lot
+ * - zero padding in names, the same department IDs, similar salaries -
+ * so most of their bytes turn into a few pairs.
+ *
+ * The output is the LZ4 block format: a sequence is one token byte
+ * (4 bits literal count, 4 bits match length - 4), longer counts in
+ * extra bytes of 255, the literals themselves, and a 2-byte
+ * little-endian match offset. The compressor is LZ4's greedy one: a hash
+ * table of the last position each 4-byte string was seen, checked once
+ * per position, with bigger steps through data that doesn't match.
+ * Decompression is just copies, which is why it runs at GB/s.
+ *
+ * Blocks are independent (no dictionary carried over) and at most
+ * LZ_MAX_BLOCK bytes, so block_file.h can compress and decompress them
+ * in any order and on any thread.
+ *
+ * For frontend developers: The same family as the gzip/brotli a web
+ * server applies to responses, tuned for speed instead of size - like
+ * CompressionStream, but one block at a time.
+ */
+
+#ifndef LZ_CODEC_H
+#define LZ_CODEC_H
+
+#include <stddef.h>
+
+#define LZ_MAX_BLOCK 65536
+
+// Largest possible output for `size` input bytes (incompressible data
+// grows by a little)
+size_t lz_compress_bound(size_t size);
+
+// Compress `size` bytes (at most LZ_MAX_BLOCK) into `destination`.
+// Returns the compressed size, or 0 if it would exceed `capacity` - pass
+// capacity < size to get 0 for data that doesn't shrink.
+size_t lz_compress(const void* source, size_t size, void* destination, size_t capacity);
+
+// Decompress a block that must expand to exactly `raw_size` bytes.
+// Never reads or writes outside the two buffers, whatever the input.
+// Returns 0, or -1 with errno = EINVAL for corrupt input.
+int lz_decompress(const void* source, size_t size, void* destination, size_t raw_size);
+
+#endif // LZ_CODEC_H
@@ -0,0 +1,153 @@
+/*
+ * mapped_file.c - Read-only whole-file access via mmap, with a fallback
+ *
+ * Implementation notes:
+ * - The file descriptor is closed right after mmap(); the mapping keeps
+ *   the file alive until munmap().
+ * - A zero-length file can't be mapped (mmap rejects length 0), so it is
+ *   represented by a static empty buffer instead.
+ * - The fallback reads with plain read() into a buffer that grows as
+ *   needed, so it also works for pipes whose size fstat() can't report.
+ * - madvise() offsets must be page aligned; mapped_file_advise() rounds
+ *   the start down so callers can pass any offset.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include "mapped_file.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define FALLBACK_INITIAL_SIZE (64 * 1024)
+
+static const char empty_file[1] = "";
+
+static int advice_to_madvise(MappedAdvice advice) {
+    switch (advice) {
+        case MAPPED_ADVICE_SEQUENTIAL: return MADV_SEQUENTIAL;
+        case MAPPED_ADVICE_RANDOM:     return MADV_RANDOM;
+        case MAPPED_ADVICE_WILLNEED:   return MADV_WILLNEED;
+        case MAPPED_ADVICE_DONTNEED:   return MADV_DONTNEED;
+        default:                       return MADV_NORMAL;
+    }
+}
+
+// Read everything from `fd` into a heap buffer. `size_hint` is the
+// expected size (0 if unknown).
+static int read_whole(int fd, size_t size_hint, MappedFile* file) {
+    size_t capacity = size_hint > 0 ? size_hint : FALLBACK_INITIAL_SIZE;
+    size_t filled = 0;
+    char* buffer = malloc(capacity);
+    if (buffer == NULL) return -1;
+
+    for (;;) {
+        if (filled == capacity) {
+            char* bigger = realloc(buffer, capacity * 2);
+            if (bigger == NULL) {
+                free(buffer);
+                errno = ENOMEM;
+                return -1;
+            }
+            buffer = bigger;
+            capacity *= 2;
+        }
+
+        ssize_t got = read(fd, buffer + filled, capacity - filled);
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            int saved = errno;
+            free(buffer);
+            errno = saved;
+            return -1;
+        }
+        if (got == 0) break;
+        filled += (size_t)got;
+
+        // A regular file is done once its known size has been read
+        if (size_hint > 0 && filled == size_hint) break;
+    }
+
+    file->data = buffer;
+    file->size = filled;
+    file->is_mapped = 0;
+    return 0;
+}
+
+int mapped_file_open(MappedFile* file, const char* filename, unsigned flags) {
+    file->data = empty_file;
+    file->size = 0;
+    file->is_mapped = 0;
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return -1;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+
+    int regular = S_ISREG(info.st_mode);
+    size_t size = regular ? (size_t)info.st_size : 0;
+    if (regular && size == 0) {
+        close(fd);
+        return 0;
+    }
+
+    if (regular && !(flags & MAPPED_FILE_NO_MMAP)) {
+        void* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            close(fd);
+            file->data = (const char*)mapping;
+            file->size = size;
+            file->is_mapped = 1;
+
+            if (flags & MAPPED_FILE_SEQUENTIAL) madvise(mapping, size, MADV_SEQUENTIAL);
+            if (flags & MAPPED_FILE_WILLNEED) madvise(mapping, size, MADV_WILLNEED);
+            return 0;
+        }
+    }
+
+    if (flags & MAPPED_FILE_NO_FALLBACK) {
+        int saved = regular && !(flags & MAPPED_FILE_NO_MMAP) ? errno : ENODEV;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+
+    int result = read_whole(fd, size, file);
+    int saved = errno;
+    close(fd);
+    errno = saved;
+    return result;
+}
+
+int mapped_file_advise(const MappedFile* file, size_t offset, size_t length,
+                       MappedAdvice advice) {
+    if (!file->is_mapped || offset >= file->size) return 0;
+
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start = offset - offset % page_size;
+    if (length > file->size - offset) length = file->size - offset;
+
+    return madvise((void*)(file->data + start), length + (offset - start),
+                   advice_to_madvise(advice));
+}
+
+void mapped_file_close(MappedFile* file) {
+    if (file->is_mapped) {
+        munmap((void*)file->data, file->size);
+    } else if (file->data != empty_file) {
+        free((void*)file->data);
+    }
+    file->data = empty_file;
+    file->size = 0;
+    file->is_mapped = 0;
+}
@@ -0,0 +1,55 @@
+/*
+ * mapped_file.h - Read-only whole-file access via mmap, with a fallback
+ *
+ * Reading a file "the classic way" (fseek/ftell, malloc, fread) copies
+ * every byte from the kernel's page cache into a second buffer you own.
+ * For a multi-GB file that is twice the memory and a full extra copy.
+ * mmap() instead maps the page cache pages straight into the process:
+ * the file *is* the buffer, pages are loaded on first touch, and the
+ * kernel can drop them again under memory pressure.
+ *
+ * Not every file can be mapped (pipes, some special files), so when
+ * mmap() is not possible the file is read into a heap buffer instead and
+ * the caller sees the same MappedFile either way.
+ *
+ * For frontend developers: Compare `await file.arrayBuffer()` (a full
+ * copy) with `file.slice()` / streams, which read lazily on demand.
+ */
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <stddef.h>
+
+// Flags for mapped_file_open() (combine with |)
+#define MAPPED_FILE_SEQUENTIAL  0x01u   // Will be read front to back: read ahead aggressively
+#define MAPPED_FILE_WILLNEED    0x02u   // Start loading the whole file now
+#define MAPPED_FILE_NO_FALLBACK 0x04u   // Fail instead of copying when mmap isn't possible
+#define MAPPED_FILE_NO_MMAP     0x08u   // Always use the buffered-read fallback
+
+typedef enum {
+    MAPPED_ADVICE_NORMAL,
+    MAPPED_ADVICE_SEQUENTIAL,
+    MAPPED_ADVICE_RANDOM,
+    MAPPED_ADVICE_WILLNEED,
+    MAPPED_ADVICE_DONTNEED
+} MappedAdvice;
+
+typedef struct {
+    const char* data;   // File contents (not NUL-terminated)
+    size_t size;
+    int is_mapped;      // 1 = mmap'd, 0 = heap copy from the fallback
+} MappedFile;
+
+// Open and map `filename`. Returns 0 on success, -1 on failure with
+// errno set.
+int mapped_file_open(MappedFile* file, const char* filename, unsigned flags);
+
+// Hint how a range will be used next (no-op for the heap fallback).
+// Returns 0 on success, -1 on failure.
+int mapped_file_advise(const MappedFile* file, size_t offset, size_t length,
+                       MappedAdvice advice);
+
+void mapped_file_close(MappedFile* file);
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,394 @@
+/*
+ * person_table.c - Columnar Person table and column kernels
+ *
+ * Implementation notes:
+ * - Columns grow together by doubling, like a JavaScript array's backing
+ *   store; the text arena grows on its own.
+ * - The portable kernels keep 8 independent accumulators. That breaks the
+ *   chain of dependent additions, and the compiler can map the lanes onto
+ *   SSE registers.
+ * - The AVX2 kernels are compiled with __attribute__((target("avx2"))) and
+ *   picked at runtime, so the binary still runs on CPUs without AVX2.
+ * - argmax finds the largest block maximum first and only then searches
+ *   that one block for the index - a single pass over the column.
+ */
+
+#include "person_table.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define COLUMN_HAVE_X86 1
+#include <immintrin.h>
+#else
+#define COLUMN_HAVE_X86 0
+#endif
+
+#define LANES 8
+#define ARGMAX_BLOCK 4096
+
+// -1 = not detected yet, 0 = portable, 1 = AVX2
+static int simd_level = -1;
+
+int person_table_init(PersonTable* table, size_t capacity) {
+    memset(table, 0, sizeof(*table));
+    if (capacity < 16) capacity = 16;
+
+    table->capacity = capacity;
+    table->id = malloc(capacity * sizeof(int32_t));
+    table->age = malloc(capacity * sizeof(int32_t));
+    table->salary = malloc(capacity * sizeof(double));
+    table->text_offset = malloc(capacity * sizeof(size_t));
+    table->text_capacity = capacity * 16;
+    table->text = malloc(table->text_capacity);
+
+    if (table->id == NULL || table->age == NULL || table->salary == NULL ||
+        table->text_offset == NULL || table->text == NULL) {
+        person_table_free(table);
+        return -1;
+    }
+    return 0;
+}
+
+void person_table_free(PersonTable* table) {
+    free(table->id);
+    free(table->age);
+    free(table->salary);
+    free(table->text_offset);
+    free(table->text);
+    memset(table, 0, sizeof(*table));
+}
+
+// realloc() that leaves the old block alone on failure
+static int grow_column(void** column, size_t new_capacity, size_t element_size) {
+    void* grown = realloc(*column, new_capacity * element_size);
+    if (grown == NULL) return -1;
+    *column = grown;
+    return 0;
+}
+
+static int grow_rows(PersonTable* table) {
+    size_t new_capacity = table->capacity * 2;
+
+    if (grow_column((void**)&table->id, new_capacity, sizeof(int32_t)) != 0 ||
+        grow_column((void**)&table->age, new_capacity, sizeof(int32_t)) != 0 ||
+        grow_column((void**)&table->salary, new_capacity, sizeof(double)) != 0 ||
+        grow_column((void**)&table->text_offset, new_capacity, sizeof(size_t)) != 0) {
+        return -1;
+    }
+    table->capacity = new_capacity;
+    return 0;
+}
+
+int person_table_append(PersonTable* table, int32_t id,
+                        const char* name, size_t name_length,
+                        const char* email, size_t email_length,
+                        int32_t age, double salary) {
+    if (table->count == table->capacity && grow_rows(table) != 0) return -1;
+
+    size_t text_needed = name_length + 1 + email_length + 1;
+    if (table->text_used + text_needed > table->text_capacity) {
+        size_t new_capacity = table->text_capacity * 2;
+        while (table->text_used + text_needed > new_capacity) new_capacity *= 2;
+        char* text = realloc(table->text, new_capacity);
+        if (text == NULL) return -1;
+        table->text = text;
+        table->text_capacity = new_capacity;
+    }
+
+    size_t row = table->count;
+    char* p = table->text + table->text_used;
+    memcpy(p, name, name_length);
+    p[name_length] = '\0';
+    memcpy(p + name_length + 1, email, email_length);
+    p[name_length + 1 + email_length] = '\0';
+
+    table->id[row] = id;
+    table->age[row] = age;
+    table->salary[row] = salary;
+    table->text_offset[row] = table->text_used;
+    table->text_used += text_needed;
+    table->count++;
+    return 0;
+}
+
+const char* person_table_name(const PersonTable* table, size_t row) {
+    return table->text + table->text_offset[row];
+}
+
+const char* person_table_email(const PersonTable* table, size_t row) {
+    const char* name = person_table_name(table, row);
+    return name + strlen(name) + 1;
+}
+
+// ---- Portable kernels ----
+
+static int64_t sum_i32_portable(const int32_t* values, size_t count) {
+    int64_t lanes[LANES] = {0};
+    size_t i = 0;
+
+    for (; i + LANES <= count; i += LANES) {
+        for (int j = 0; j < LANES; j++) lanes[j] += values[i + j];
+    }
+    int64_t sum = 0;
+    for (int j = 0; j < LANES; j++) sum += lanes[j];
+    for (; i < count; i++) sum += values[i];
+    return sum;
+}
+
+static int32_t min_i32_portable(const int32_t* values, size_t count) {
+    int32_t result = values[0];
+    for (size_t i = 1; i < count; i++) {
+        if (values[i] < result) result = values[i];
+    }
+    return result;
+}
+
+static int32_t max_i32_portable(const int32_t* values, size_t count) {
+    int32_t result = values[0];
+    for (size_t i = 1; i < count; i++) {
+        if (values[i] > result) result = values[i];
+    }
+    return result;
+}
+
+static double sum_f64_portable(const double* values, size_t count) {
+    double lanes[LANES] = {0};
+    size_t i = 0;
+
+    for (; i + LANES <= count; i += LANES) {
+        for (int j = 0; j < LANES; j++) lanes[j] += values[i + j];
+    }
+    double sum = 0.0;
+    for (int j = 0; j < LANES; j++) sum += lanes[j];
+    for (; i < count; i++) sum += values[i];
+    return sum;
+}
+
+static double min_f64_portable(const double* values, size_t count) {
+    double lanes[LANES];
+    size_t i = 0;
+
+    for (int j = 0; j < LANES; j++) lanes[j] = values[0];
+    for (; i + LANES <= count; i += LANES) {
+        for (int j = 0; j < LANES; j++) {
+            lanes[j] = values[i + j] < lanes[j] ? values[i + j] : lanes[j];
+        }
+    }
+    double result = lanes[0];
+    for (int j = 1; j < LANES; j++) result = lanes[j] < result ? lanes[j] : result;
+    for (; i < count; i++) result = values[i] < result ? values[i] : result;
+    return result;
+}
+
+static double max_f64_portable(const double* values, size_t count) {
+    double lanes[LANES];
+    size_t i = 0;
+
+    for (int j = 0; j < LANES; j++) lanes[j] = values[0];
+    for (; i + LANES <= count; i += LANES) {
+        for (int j = 0; j < LANES; j++) {
+            lanes[j] = values[i + j] > lanes[j] ? values[i + j] : lanes[j];
+        }
+    }
+    double result = lanes[0];
+    for (int j = 1; j < LANES; j++) result = lanes[j] > result ? lanes[j] : result;
+    for (; i < count; i++) result = values[i] > result ? values[i] : result;
+    return result;
+}
+
+// ---- AVX2 kernels ----
+
+#if COLUMN_HAVE_X86
+
+__attribute__((target("avx2")))
+static int64_t sum_i32_avx2(const int32_t* values, size_t count) {
+    __m256i sum_lo = _mm256_setzero_si256();
+    __m256i sum_hi = _mm256_setzero_si256();
+    size_t i = 0;
+
+    // Widen 8 x int32 to 2 x (4 x int64) so large columns can't overflow
+    for (; i + 8 <= count; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(values + i));
+        sum_lo = _mm256_add_epi64(sum_lo, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+        sum_hi = _mm256_add_epi64(sum_hi, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+    }
+
+    int64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, _mm256_add_epi64(sum_lo, sum_hi));
+    int64_t sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (; i < count; i++) sum += values[i];
+    return sum;
+}
+
+__attribute__((target("avx2")))
+static int32_t min_i32_avx2(const int32_t* values, size_t count) {
+    __m256i result = _mm256_set1_epi32(values[0]);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        result = _mm256_min_epi32(result, _mm256_loadu_si256((const __m256i*)(values + i)));
+    }
+
+    int32_t lanes[8];
+    _mm256_storeu_si256((__m256i*)lanes, result);
+    int32_t min = lanes[0];
+    for (int j = 1; j < 8; j++) if (lanes[j] < min) min = lanes[j];
+    for (; i < count; i++) if (values[i] < min) min = values[i];
+    return min;
+}
+
+__attribute__((target("avx2")))
+static int32_t max_i32_avx2(const int32_t* values, size_t count) {
+    __m256i result = _mm256_set1_epi32(values[0]);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        result = _mm256_max_epi32(result, _mm256_loadu_si256((const __m256i*)(values + i)));
+    }
+
+    int32_t lanes[8];
+    _mm256_storeu_si256((__m256i*)lanes, result);
+    int32_t max = lanes[0];
+    for (int j = 1; j < 8; j++) if (lanes[j] > max) max = lanes[j];
+    for (; i < count; i++) if (values[i] > max) max = values[i];
+    return max;
+}
+
+__attribute__((target("avx2")))
+static double sum_f64_avx2(const double* values, size_t count) {
+    // Two accumulators hide the latency of vaddpd
+    __m256d sum0 = _mm256_setzero_pd();
+    __m256d sum1 = _mm256_setzero_pd();
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        sum0 = _mm256_add_pd(sum0, _mm256_loadu_pd(values + i));
+        sum1 = _mm256_add_pd(sum1, _mm256_loadu_pd(values + i + 4));
+    }
+
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(sum0, sum1));
+    double sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for (; i < count; i++) sum += values[i];
+    return sum;
+}
+
+__attribute__((target("avx2")))
+static double min_f64_avx2(const double* values, size_t count) {
+    __m256d result = _mm256_set1_pd(values[0]);
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        result = _mm256_min_pd(_mm256_loadu_pd(values + i), result);
+    }
+
+    double lanes[4];
+    _mm256_storeu_pd(lanes, result);
+    double min = lanes[0];
+    for (int j = 1; j < 4; j++) min = lanes[j] < min ? lanes[j] : min;
+    for (; i < count; i++) min = values[i] < min ? values[i] : min;
+    return min;
+}
+
+__attribute__((target("avx2")))
+static double max_f64_avx2(const double* values, size_t count) {
+    __m256d result = _mm256_set1_pd(values[0]);
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        result = _mm256_max_pd(_mm256_loadu_pd(values + i), result);
+    }
+
+    double lanes[4];
+    _mm256_storeu_pd(lanes, result);
+    double max = lanes[0];
+    for (int j = 1; j < 4; j++) max = lanes[j] > max ? lanes[j] : max;
+    for (; i < count; i++) max = values[i] > max ? values[i] : max;
+    return max;
+}
+
+#endif // COLUMN_HAVE_X86
+
+static int use_avx2(void) {
+    int level = __atomic_load_n(&simd_level, __ATOMIC_RELAXED);
+    if (level < 0) level = column_set_simd(1);
+    return level;
+}
+
+int column_set_simd(int enabled) {
+    int level = 0;
+#if COLUMN_HAVE_X86
+    __builtin_cpu_init();
+    level = enabled && __builtin_cpu_supports("avx2");
+#else
+    (void)enabled;
+#endif
+    __atomic_store_n(&simd_level, level, __ATOMIC_RELAXED);
+    return level;
+}
+
+const char* column_backend_name(void) {
+    return use_avx2() ? "AVX2" : "portable";
+}
+
+#if COLUMN_HAVE_X86
+#define DISPATCH(name, ...) (use_avx2() ? name##_avx2(__VA_ARGS__) : name##_portable(__VA_ARGS__))
+#else
+#define DISPATCH(name, ...) name##_portable(__VA_ARGS__)
+#endif
+
+int64_t column_sum_i32(const int32_t* values, size_t count) {
+    return DISPATCH(sum_i32, values, count);
+}
+
+int32_t column_min_i32(const int32_t* values, size_t count) {
+    return DISPATCH(min_i32, values, count);
+}
+
+int32_t column_max_i32(const int32_t* values, size_t count) {
+    return DISPATCH(max_i32, values, count);
+}
+
+double column_mean_i32(const int32_t* values, size_t count) {
+    return count > 0 ? (double)column_sum_i32(values, count) / count : 0.0;
+}
+
+double column_sum_f64(const double* values, size_t count) {
+    return DISPATCH(sum_f64, values, count);
+}
+
+double column_min_f64(const double* values, size_t count) {
+    return DISPATCH(min_f64, values, count);
+}
+
+double column_max_f64(const double* values, size_t count) {
+    return DISPATCH(max_f64, values, count);
+}
+
+double column_mean_f64(const double* values, size_t count) {
+    return count > 0 ? column_sum_f64(values, count) / count : 0.0;
+}
+
+size_t column_argmax_f64(const double* values, size_t count) {
+    if (count == 0) return COLUMN_NO_ROW;
+
+    // Strict '>' keeps the earliest block when maxima tie
+    size_t best_block = 0;
+    double best = values[0];
+    for (size_t start = 0; start < count; start += ARGMAX_BLOCK) {
+        size_t length = count - start < ARGMAX_BLOCK ? count - start : ARGMAX_BLOCK;
+        double block_max = column_max_f64(values + start, length);
+        if (block_max > best) {
+            best = block_max;
+            best_block = start;
+        }
+    }
+
+    size_t end = best_block + ARGMAX_BLOCK < count ? best_block + ARGMAX_BLOCK : count;
+    for (size_t i = best_block; i < end; i++) {
+        if (values[i] == best) return i;
+    }
+    return best_block;
+}
@@ -0,0 +1,462 @@
+/*
+ * record_codec.c - Employee/Department wire format, batched
+ *
+ * Implementation notes:
+ * - On the usual ABIs an Employee is 72 bytes: id, name and salary are
+ *   followed by 2 bytes of padding before the double, and 5 after
+ *   `active`. On the wire the fields are back to back, so a record is
+ *   copied in two runs: bytes 0..53 (id + name) and 56..66 (salary,
+ *   department_id, active). A Department has no padding at all, so a
+ *   batch of them is one memcpy().
+ * - When bytes must be swapped, SSSE3 pshufb does the swap and the
+ *   packing in one step: the 16 bytes from `salary` onwards are shuffled
+ *   so the 8 salary bytes and the 2 department bytes come out reversed
+ *   and the padding drops out.
+ * - The 16-byte stores of one Employee spill up to 5 bytes into the next
+ *   record's slot, which that record then overwrites; decoding likewise
+ *   reads a few bytes of the next record. So the vector loops stop one
+ *   record early and the last record takes the portable path.
+ * - The fast paths rely on the usual struct layout; if the compiler laid
+ *   the structs out differently, everything goes field by field.
+ * - A block reader refills with whole 64 KB blocks only (four, or three
+ *   while a partial record is still buffered), so every block is
+ *   decompressed once, straight into the buffer.
+ */
+
+#include "record_codec.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define RECORD_HAVE_X86 1
+#include <immintrin.h>
+#else
+#define RECORD_HAVE_X86 0
+#endif
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define HOST_ORDER RECORD_BIG_ENDIAN
+#else
+#define HOST_ORDER RECORD_LITTLE_ENDIAN
+#endif
+
+// Wire offsets
+#define EMPLOYEE_WIRE_SALARY 54
+#define EMPLOYEE_WIRE_DEPARTMENT 62
+#define EMPLOYEE_WIRE_ACTIVE 64
+#define EMPLOYEE_TAIL_SIZE 11          // salary + department_id + active
+
+// -1 = not detected yet, 0 = portable, 1 = SSSE3
+static int simd_level = -1;
+
+static int employee_layout_is_standard(void) {
+    return offsetof(Employee, name) == 4 && offsetof(Employee, salary) == 56 &&
+           offsetof(Employee, department_id) == 64 && offsetof(Employee, active) == 66 &&
+           sizeof(Employee) == 72;
+}
+
+static int department_layout_is_standard(void) {
+    return offsetof(Department, department_name) == 2 &&
+           offsetof(Department, budget) == 32 && sizeof(Department) == DEPARTMENT_WIRE_SIZE;
+}
+
+int record_codec_set_simd(int enabled) {
+    int level = 0;
+#if RECORD_HAVE_X86
+    __builtin_cpu_init();
+    level = enabled && __builtin_cpu_supports("ssse3");
+#else
+    (void)enabled;
+#endif
+    __atomic_store_n(&simd_level, level, __ATOMIC_RELAXED);
+    return level;
+}
+
+static int use_ssse3(void) {
+    int level = __atomic_load_n(&simd_level, __ATOMIC_RELAXED);
+    if (level < 0) level = record_codec_set_simd(1);
+    return level;
+}
+
+const char* record_codec_backend_name(void) {
+    return use_ssse3() ? "SSSE3" : "portable";
+}
+
+// Field-by-field helpers: copy a value, reversing its bytes if asked
+
+static void put_u16(unsigned char* out, uint16_t value, int swap) {
+    if (swap) value = __builtin_bswap16(value);
+    memcpy(out, &value, sizeof(value));
+}
+
+static void put_u32(unsigned char* out, uint32_t value, int swap) {
+    if (swap) value = __builtin_bswap32(value);
+    memcpy(out, &value, sizeof(value));
+}
+
+static void put_f64(unsigned char* out, double value, int swap) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    if (swap) bits = __builtin_bswap64(bits);
+    memcpy(out, &bits, sizeof(bits));
+}
+
+static uint16_t get_u16(const unsigned char* in, int swap) {
+    uint16_t value;
+    memcpy(&value, in, sizeof(value));
+    return swap ? __builtin_bswap16(value) : value;
+}
+
+static uint32_t get_u32(const unsigned char* in, int swap) {
+    uint32_t value;
+    memcpy(&value, in, sizeof(value));
+    return swap ? __builtin_bswap32(value) : value;
+}
+
+static double get_f64(const unsigned char* in, int swap) {
+    uint64_t bits;
+    memcpy(&bits, in, sizeof(bits));
+    if (swap) bits = __builtin_bswap64(bits);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static void encode_employee(unsigned char* out, const Employee* in, int swap) {
+    put_u32(out, in->id, swap);
+    memcpy(out + 4, in->name, sizeof(in->name));
+    put_f64(out + EMPLOYEE_WIRE_SALARY, in->salary, swap);
+    put_u16(out + EMPLOYEE_WIRE_DEPARTMENT, in->department_id, swap);
+    out[EMPLOYEE_WIRE_ACTIVE] = in->active;
+}
+
+static void decode_employee(Employee* out, const unsigned char* in, int swap) {
+    out->id = get_u32(in, swap);
+    memcpy(out->name, in + 4, sizeof(out->name));
+    out->salary = get_f64(in + EMPLOYEE_WIRE_SALARY, swap);
+    out->department_id = get_u16(in + EMPLOYEE_WIRE_DEPARTMENT, swap);
+    out->active = in[EMPLOYEE_WIRE_ACTIVE];
+}
+
+static void encode_department(unsigned char* out, const Department* in, int swap) {
+    put_u16(out, in->department_id, swap);
+    memcpy(out + 2, in->department_name, sizeof(in->department_name));
+    put_u32(out + 32, in->budget, swap);
+}
+
+static void decode_department(Department* out, const unsigned char* in, int swap) {
+    out->department_id = get_u16(in, swap);
+    memcpy(out->department_name, in + 2, sizeof(out->department_name));
+    out->budget = get_u32(in + 32, swap);
+}
+
+#if RECORD_HAVE_X86
+
+// Shuffle masks (byte k of the result = byte mask[k] of the input, -1 = zero)
+
+// Employee bytes 0..15: reverse the id
+#define EMPLOYEE_HEAD_MASK 3, 2, 1, 0, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15
+// Struct bytes 56..71 <-> wire bytes 54..69: reverse salary and
+// department_id, keep active, zero the rest
+#define EMPLOYEE_TAIL_MASK 7, 6, 5, 4, 3, 2, 1, 0, 9, 8, 10, -1, -1, -1, -1, -1
+
+// Department bytes 0..15: reverse department_id
+#define DEPARTMENT_HEAD_MASK 1, 0, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15
+// Department bytes 20..35: reverse budget (the last 4)
+#define DEPARTMENT_TAIL_MASK 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 15, 14, 13, 12
+
+#define LOAD(p) _mm_loadu_si128((const __m128i*)(const void*)(p))
+#define STORE(p, v) _mm_storeu_si128((__m128i*)(void*)(p), (v))
+
+// Encode all but the last record (see implementation notes)
+__attribute__((target("ssse3")))
+static void encode_employees_ssse3(unsigned char* out, const Employee* in, size_t count) {
+    const __m128i head = _mm_setr_epi8(EMPLOYEE_HEAD_MASK);
+    const __m128i tail = _mm_setr_epi8(EMPLOYEE_TAIL_MASK);
+    for (size_t i = 0; i + 1 < count; i++) {
+        const unsigned char* record = (const unsigned char*)&in[i];
+        unsigned char* wire = out + i * EMPLOYEE_WIRE_SIZE;
+        STORE(wire, _mm_shuffle_epi8(LOAD(record), head));
+        STORE(wire + 16, LOAD(record + 16));
+        STORE(wire + 32, LOAD(record + 32));
+        STORE(wire + 38, LOAD(record + 38));
+        STORE(wire + EMPLOYEE_WIRE_SALARY, _mm_shuffle_epi8(LOAD(record + 56), tail));
+    }
+}
+
+__attribute__((target("ssse3")))
+static void decode_employees_ssse3(Employee* out, const unsigned char* in, size_t count) {
+    const __m128i head = _mm_setr_epi8(EMPLOYEE_HEAD_MASK);
+    const __m128i tail = _mm_setr_epi8(EMPLOYEE_TAIL_MASK);
+    for (size_t i = 0; i + 1 < count; i++) {
+        const unsigned char* wire = in + i * EMPLOYEE_WIRE_SIZE;
+        unsigned char* record = (unsigned char*)&out[i];
+        STORE(record, _mm_shuffle_epi8(LOAD(wire), head));
+        STORE(record + 16, LOAD(wire + 16));
+        STORE(record + 32, LOAD(wire + 32));
+        STORE(record + 38, LOAD(wire + 38));
+        STORE(record + 56, _mm_shuffle_epi8(LOAD(wire + EMPLOYEE_WIRE_SALARY), tail));
+    }
+}
+
+// The same shuffles turn a Department either way
+__attribute__((target("ssse3")))
+static void swap_departments_ssse3(unsigned char* out, const unsigned char* in, size_t count) {
+    const __m128i head = _mm_setr_epi8(DEPARTMENT_HEAD_MASK);
+    const __m128i tail = _mm_setr_epi8(DEPARTMENT_TAIL_MASK);
+    for (size_t i = 0; i < count; i++) {
+        const unsigned char* src = in + i * DEPARTMENT_WIRE_SIZE;
+        unsigned char* dst = out + i * DEPARTMENT_WIRE_SIZE;
+        STORE(dst, _mm_shuffle_epi8(LOAD(src), head));
+        STORE(dst + 16, LOAD(src + 16));
+        STORE(dst + 20, _mm_shuffle_epi8(LOAD(src + 20), tail));
+    }
+}
+
+#undef LOAD
+#undef STORE
+
+#endif // RECORD_HAVE_X86
+
+void record_encode_employees(unsigned char* out, const Employee* in, size_t count,
+                             RecordByteOrder order) {
+    int swap = order != HOST_ORDER;
+    size_t done = 0;
+
+    if (employee_layout_is_standard() && !swap) {
+        // Same byte order: just close the gaps
+        for (size_t i = 0; i < count; i++) {
+            const unsigned char* record = (const unsigned char*)&in[i];
+            unsigned char* wire = out + i * EMPLOYEE_WIRE_SIZE;
+            memcpy(wire, record, EMPLOYEE_WIRE_SALARY);
+            memcpy(wire + EMPLOYEE_WIRE_SALARY, record + offsetof(Employee, salary),
+                   EMPLOYEE_TAIL_SIZE);
+        }
+        return;
+    }
+#if RECORD_HAVE_X86
+    if (employee_layout_is_standard() && count > 1 && use_ssse3()) {
+        encode_employees_ssse3(out, in, count);
+        done = count - 1;
+    }
+#endif
+    for (size_t i = done; i < count; i++) {
+        encode_employee(out + i * EMPLOYEE_WIRE_SIZE, &in[i], swap);
+    }
+}
+
+void record_decode_employees(Employee* out, const unsigned char* in, size_t count,
+                             RecordByteOrder order) {
+    int swap = order != HOST_ORDER;
+    size_t done = 0;
+
+    if (employee_layout_is_standard() && !swap) {
+        for (size_t i = 0; i < count; i++) {
+            const unsigned char* wire = in + i * EMPLOYEE_WIRE_SIZE;
+            unsigned char* record = (unsigned char*)&out[i];
+            memcpy(record, wire, EMPLOYEE_WIRE_SALARY);
+            memcpy(record + offsetof(Employee, salary), wire + EMPLOYEE_WIRE_SALARY,
+                   EMPLOYEE_TAIL_SIZE);
+        }
+        return;
+    }
+#if RECORD_HAVE_X86
+    if (employee_layout_is_standard() && count > 1 && use_ssse3()) {
+        decode_employees_ssse3(out, in, count);
+        done = count - 1;
+    }
+#endif
+    for (size_t i = done; i < count; i++) {
+        decode_employee(&out[i], in + i * EMPLOYEE_WIRE_SIZE, swap);
+    }
+}
+
+void record_encode_departments(unsigned char* out, const Department* in, size_t count,
+                               RecordByteOrder order) {
+    int swap = order != HOST_ORDER;
+    if (department_layout_is_standard()) {
+        if (!swap) {
+            memcpy(out, in, count * DEPARTMENT_WIRE_SIZE);
+            return;
+        }
+#if RECORD_HAVE_X86
+        if (use_ssse3()) {
+            swap_departments_ssse3(out, (const unsigned char*)in, count);
+            return;
+        }
+#endif
+    }
+    for (size_t i = 0; i < count; i++) {
+        encode_department(out + i * DEPARTMENT_WIRE_SIZE, &in[i], swap);
+    }
+}
+
+void record_decode_departments(Department* out, const unsigned char* in, size_t count,
+                               RecordByteOrder order) {
+    int swap = order != HOST_ORDER;
+    if (department_layout_is_standard()) {
+        if (!swap) {
+            memcpy(out, in, count * DEPARTMENT_WIRE_SIZE);
+            return;
+        }
+#if RECORD_HAVE_X86
+        if (use_ssse3()) {
+            swap_departments_ssse3((unsigned char*)out, in, count);
+            return;
+        }
+#endif
+    }
+    for (size_t i = 0; i < count; i++) {
+        decode_department(&out[i], in + i * DEPARTMENT_WIRE_SIZE, swap);
+    }
+}
+
+// Streams
+
+int record_stream_init(RecordStream* stream, FILE* file, RecordByteOrder order) {
+    stream->file = file;
+    stream->order = order;
+    stream->used = 0;
+    stream->position = 0;
+    stream->block_writer = NULL;
+    stream->block_file = NULL;
+    stream->block_offset = 0;
+    stream->buffer = malloc(RECORD_BUFFER_SIZE);
+    return stream->buffer != NULL ? 0 : -1;
+}
+
+int record_stream_init_block_writer(RecordStream* stream, BlockWriter* writer,
+                                    RecordByteOrder order) {
+    if (record_stream_init(stream, NULL, order) != 0) return -1;
+    stream->block_writer = writer;
+    return 0;
+}
+
+int record_stream_init_block_reader(RecordStream* stream, const BlockFile* file,
+                                    RecordByteOrder order) {
+    if (record_stream_init(stream, NULL, order) != 0) return -1;
+    stream->block_file = file;
+    return 0;
+}
+
+void record_stream_free(RecordStream* stream) {
+    free(stream->buffer);
+    stream->buffer = NULL;
+    stream->used = 0;
+    stream->position = 0;
+}
+
+int record_stream_flush(RecordStream* stream) {
+    if (stream->used > 0 && stream->block_writer != NULL) {
+        if (block_writer_write(stream->block_writer, stream->buffer, stream->used) != 0) return -1;
+    } else if (stream->used > 0 &&
+               fwrite(stream->buffer, 1, stream->used, stream->file) != stream->used) {
+        return -1;
+    }
+    stream->used = 0;
+    return 0;
+}
+
+// Room for at least `count` records of `wire_size` bytes, flushing if
+// needed; returns how many fit
+static size_t reserve(RecordStream* stream, size_t wire_size, size_t count) {
+    size_t fit = (RECORD_BUFFER_SIZE - stream->used) / wire_size;
+    if (fit == 0) {
+        if (record_stream_flush(stream) != 0) return 0;
+        fit = RECORD_BUFFER_SIZE / wire_size;
+    }
+    return count < fit ? count : fit;
+}
+
+int record_write_u32(RecordStream* stream, uint32_t value) {
+    if (reserve(stream, sizeof(value), 1) == 0) return -1;
+    put_u32(stream->buffer + stream->used, value, stream->order != HOST_ORDER);
+    stream->used += sizeof(value);
+    return 0;
+}
+
+int record_write_employees(RecordStream* stream, const Employee* records, size_t count) {
+    while (count > 0) {
+        size_t n = reserve(stream, EMPLOYEE_WIRE_SIZE, count);
+        if (n == 0) return -1;
+        record_encode_employees(stream->buffer + stream->used, records, n, stream->order);
+        stream->used += n * EMPLOYEE_WIRE_SIZE;
+        records += n;
+        count -= n;
+    }
+    return 0;
+}
+
+int record_write_departments(RecordStream* stream, const Department* records, size_t count) {
+    while (count > 0) {
+        size_t n = reserve(stream, DEPARTMENT_WIRE_SIZE, count);
+        if (n == 0) return -1;
+        record_encode_departments(stream->buffer + stream->used, records, n, stream->order);
+        stream->used += n * DEPARTMENT_WIRE_SIZE;
+        records += n;
+        count -= n;
+    }
+    return 0;
+}
+
+// At least one record of `wire_size` bytes buffered (refilling if
+// needed); returns how many of `count` are available
+static size_t fill(RecordStream* stream, size_t wire_size, size_t count) {
+    size_t available = stream->used - stream->position;
+    if (available < wire_size) {
+        memmove(stream->buffer, stream->buffer + stream->position, available);
+        stream->used = available;
+        stream->position = 0;
+        if (stream->block_file != NULL) {
+            // Whole blocks only, so block_offset stays on a block boundary
+            size_t space = RECORD_BUFFER_SIZE - available;
+            long long n = block_file_read(stream->block_file, stream->block_offset,
+                                          stream->buffer + available,
+                                          space - space % BLOCK_FILE_BLOCK_SIZE);
+            if (n > 0) {
+                stream->used += (size_t)n;
+                stream->block_offset += (uint64_t)n;
+            }
+        } else {
+            stream->used += fread(stream->buffer + available, 1,
+                                  RECORD_BUFFER_SIZE - available, stream->file);
+        }
+        available = stream->used;
+    }
+    size_t ready = available / wire_size;
+    return count < ready ? count : ready;
+}
+
+size_t record_read_u32(RecordStream* stream, uint32_t* value) {
+    if (fill(stream, sizeof(*value), 1) == 0) return 0;
+    *value = get_u32(stream->buffer + stream->position, stream->order != HOST_ORDER);
+    stream->position += sizeof(*value);
+    return 1;
+}
+
+size_t record_read_employees(RecordStream* stream, Employee* records, size_t count) {
+    size_t total = 0;
+    while (total < count) {
+        size_t n = fill(stream, EMPLOYEE_WIRE_SIZE, count - total);
+        if (n == 0) break;
+        record_decode_employees(records + total, stream->buffer + stream->position, n,
+                                stream->order);
+        stream->position += n * EMPLOYEE_WIRE_SIZE;
+        total += n;
+    }
+    return total;
+}
+
+size_t record_read_departments(RecordStream* stream, Department* records, size_t count) {
+    size_t total = 0;
+    while (total < count) {
+        size_t n = fill(stream, DEPARTMENT_WIRE_SIZE, count - total);
+        if (n == 0) break;
+        record_decode_departments(records + total, stream->buffer + stream->position, n,
+                                  stream->order);
+        stream->position += n * DEPARTMENT_WIRE_SIZE;
+        total += n;
+    }
+    return total;
+}
@@ -0,0 +1,121 @@
+/*
+ * record_codec.h - Portable, batched binary serializer for Employee and
+ * Department records
+ *
+ * fwrite()-ing a struct writes whatever the compiler laid out in memory:
+ * padding bytes between fields, host byte order, and sizes that can
+ * change with the ABI. A file written that way is only readable by the
+ * same program on the same kind of machine.
+ *
+ * The codec writes a fixed wire layout instead - fields back to back, no
+ * padding, in a chosen byte order:
+ *
+ *   Employee   (65 bytes): u32 id, char name[50], f64 salary,
+ *                          u16 department_id, u8 active
+ *   Department (36 bytes): u16 department_id, char department_name[30],
+ *                          u32 budget
+ *
+ * Records are converted a whole batch at a time into a buffer that is
+ * written with one fwrite(). When the wire order matches the host the
+ * conversion is just copying the fields together; otherwise the byte
+ * swaps are done with SSSE3 shuffles (16 bytes per instruction) where
+ * the CPU has them.
+ *
+ * A stream can also go through a block_file.h container instead of a
+ * FILE*: the encoded bytes are then compressed in 64 KB blocks on the way
+ * out and decompressed a few blocks at a time on the way in.
+ *
+ * For frontend developers: This is what a DataView with explicit
+ * `littleEndian` arguments does, or protobuf's fixed32/fixed64 fields -
+ * a layout defined by the format, not by the machine.
+ */
+
+#ifndef RECORD_CODEC_H
+#define RECORD_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "block_file.h"
+
+typedef struct {
+    uint32_t id;
+    char name[50];
+    double salary;
+    uint16_t department_id;
+    uint8_t active;
+} Employee;
+
+typedef struct {
+    uint16_t department_id;
+    char department_name[30];
+    uint32_t budget;
+} Department;
+
+#define EMPLOYEE_WIRE_SIZE 65
+#define DEPARTMENT_WIRE_SIZE 36
+
+typedef enum {
+    RECORD_LITTLE_ENDIAN,   // Native on x86 and ARM: no byte swapping there
+    RECORD_BIG_ENDIAN       // Network order, like htonl()
+} RecordByteOrder;
+
+// Convert `count` records to and from wire format. `out` must hold
+// count * *_WIRE_SIZE bytes (encode) or count records (decode). Name
+// arrays are copied whole, so zero them before filling in a name.
+void record_encode_employees(unsigned char* out, const Employee* in, size_t count,
+                             RecordByteOrder order);
+void record_decode_employees(Employee* out, const unsigned char* in, size_t count,
+                             RecordByteOrder order);
+void record_encode_departments(unsigned char* out, const Department* in, size_t count,
+                               RecordByteOrder order);
+void record_decode_departments(Department* out, const unsigned char* in, size_t count,
+                               RecordByteOrder order);
+
+// Streaming over a FILE* (or a block file) the caller opened and closes:
+// records are encoded into a buffer that is written / refilled in large
+// batches
+
+#define RECORD_BUFFER_SIZE (256 * 1024)
+
+typedef struct {
+    FILE* file;
+    RecordByteOrder order;
+    unsigned char* buffer;
+    size_t used;                // Writer: bytes waiting; reader: bytes buffered
+    size_t position;            // Reader: next unread byte
+    BlockWriter* block_writer;  // Set: write through this instead of `file`
+    const BlockFile* block_file;    // Set: read from this instead of `file`
+    uint64_t block_offset;      // Reader: next raw byte of block_file
+} RecordStream;
+
+// Returns 0 on success, -1 if the buffer can't be allocated
+int record_stream_init(RecordStream* stream, FILE* file, RecordByteOrder order);
+
+// The same over a compressed container: flushes go to
+// block_writer_write(), refills decompress whole blocks from `file`
+int record_stream_init_block_writer(RecordStream* stream, BlockWriter* writer,
+                                    RecordByteOrder order);
+int record_stream_init_block_reader(RecordStream* stream, const BlockFile* file,
+                                    RecordByteOrder order);
+void record_stream_free(RecordStream* stream);
+
+// Writing. Each returns 0 on success, -1 on a write error.
+int record_write_u32(RecordStream* stream, uint32_t value);
+int record_write_employees(RecordStream* stream, const Employee* records, size_t count);
+int record_write_departments(RecordStream* stream, const Department* records, size_t count);
+int record_stream_flush(RecordStream* stream);
+
+// Reading. Each returns the number of values/records read, which is
+// smaller than asked for at end of file or on error.
+size_t record_read_u32(RecordStream* stream, uint32_t* value);
+size_t record_read_employees(RecordStream* stream, Employee* records, size_t count);
+size_t record_read_departments(RecordStream* stream, Department* records, size_t count);
+
+// Enable or disable the SSSE3 byte swapping (used when the CPU supports
+// it). Returns 1 if it is now in use.
+int record_codec_set_simd(int enabled);
+const char* record_codec_backend_name(void);
+
+#endif // RECORD_CODEC_H
@@ -0,0 +1,251 @@
+/*
+ * simd_scan.c - Structural character scanner (scalar, SSE2, AVX2)
+ *
+ * Implementation notes:
+ * - SSE2 compares 16 bytes per instruction and is always available on
+ *   x86-64. AVX2 compares 32 and is only used when cpuid says both the
+ *   CPU and the OS support it.
+ * - The AVX2 function is compiled with __attribute__((target("avx2")))
+ *   so the rest of the program keeps the default instruction set.
+ * - The portable fallback uses SWAR tricks on 64-bit words, comparing
+ *   8 bytes per operation without any vector instructions.
+ * - Blocks at the end of a buffer are copied into a zero-padded 64-byte
+ *   array, so the vector code never reads past the caller's data.
+ */
+
+#include "simd_scan.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SCAN_HAVE_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#else
+#define SCAN_HAVE_X86 0
+#endif
+
+typedef void (*BlockFunction)(const char* block, ScanMasks* masks);
+
+static BlockFunction block_function = NULL;
+static ScanBackend active_backend = SCAN_BACKEND_SCALAR;
+
+// SWAR ("SIMD within a register"): treat a uint64_t as 8 byte lanes.
+// Returns 0x80 in every lane of `word` that equals `c`, 0 elsewhere.
+static uint64_t swar_match(uint64_t word, unsigned char c) {
+    const uint64_t low7 = 0x7F7F7F7F7F7F7F7FULL;
+    uint64_t x = word ^ (0x0101010101010101ULL * c);
+    // A lane is zero exactly when adding 0x7F to its low bits doesn't carry
+    // into the top bit and its own top bit is clear
+    return ~(((x & low7) + low7) | x | low7);
+}
+
+// Gather the top bit of each lane into an 8-bit mask (lane 0 -> bit 0)
+static uint64_t swar_movemask(uint64_t lanes) {
+    return ((lanes >> 7) * 0x0102040810204080ULL) >> 56;
+}
+
+static void scan_block_scalar(const char* block, ScanMasks* masks) {
+    ScanMasks result = {0, 0, 0, 0, 0};
+
+    for (int i = 0; i < SCAN_BLOCK_SIZE / 8; i++) {
+        uint64_t word;
+        int shift = 8 * i;
+
+        // memcpy is how C spells an unaligned load; compilers emit one mov
+        memcpy(&word, block + shift, sizeof(word));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        word = __builtin_bswap64(word);
+#endif
+        result.newline |= swar_movemask(swar_match(word, '\n')) << shift;
+        result.comma |= swar_movemask(swar_match(word, ',')) << shift;
+        result.quote |= swar_movemask(swar_match(word, '"')) << shift;
+        result.space |= swar_movemask(swar_match(word, ' ') | swar_match(word, '\t')) << shift;
+        result.equals |= swar_movemask(swar_match(word, '=')) << shift;
+    }
+
+    *masks = result;
+}
+
+#if SCAN_HAVE_X86
+
+static void scan_block_sse2(const char* block, ScanMasks* masks) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i equals = _mm_set1_epi8('=');
+
+    ScanMasks result = {0, 0, 0, 0, 0};
+
+    for (int i = 0; i < 4; i++) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(block + 16 * i));
+        int shift = 16 * i;
+
+        // movemask packs the top bit of each compared byte into an int
+        result.newline |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline)) << shift;
+        result.comma |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, comma)) << shift;
+        result.quote |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, quote)) << shift;
+        result.space |= (uint64_t)(unsigned)_mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(bytes, space), _mm_cmpeq_epi8(bytes, tab))) << shift;
+        result.equals |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, equals)) << shift;
+    }
+
+    *masks = result;
+}
+
+__attribute__((target("avx2")))
+static void scan_block_avx2(const char* block, ScanMasks* masks) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i equals = _mm256_set1_epi8('=');
+
+    __m256i lo = _mm256_loadu_si256((const __m256i*)block);
+    __m256i hi = _mm256_loadu_si256((const __m256i*)(block + 32));
+
+#define SCAN_MASK64(cmp_lo, cmp_hi) \
+    ((uint64_t)(uint32_t)_mm256_movemask_epi8(cmp_lo) | \
+     ((uint64_t)(uint32_t)_mm256_movemask_epi8(cmp_hi) << 32))
+
+    masks->newline = SCAN_MASK64(_mm256_cmpeq_epi8(lo, newline), _mm256_cmpeq_epi8(hi, newline));
+    masks->comma = SCAN_MASK64(_mm256_cmpeq_epi8(lo, comma), _mm256_cmpeq_epi8(hi, comma));
+    masks->quote = SCAN_MASK64(_mm256_cmpeq_epi8(lo, quote), _mm256_cmpeq_epi8(hi, quote));
+    masks->space = SCAN_MASK64(
+        _mm256_or_si256(_mm256_cmpeq_epi8(lo, space), _mm256_cmpeq_epi8(lo, tab)),
+        _mm256_or_si256(_mm256_cmpeq_epi8(hi, space), _mm256_cmpeq_epi8(hi, tab)));
+    masks->equals = SCAN_MASK64(_mm256_cmpeq_epi8(lo, equals), _mm256_cmpeq_epi8(hi, equals));
+
+#undef SCAN_MASK64
+}
+
+static int cpu_supports_avx2(void) {
+    unsigned eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return 0;
+    if (!(ecx & bit_OSXSAVE) || !(ecx & bit_AVX)) return 0;
+
+    // XCR0 bits 1 and 2: the OS saves SSE and AVX registers on context switch
+    unsigned xcr0_lo, xcr0_hi;
+    __asm__ volatile ("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+    (void)xcr0_hi;
+    if ((xcr0_lo & 0x6) != 0x6) return 0;
+
+    if (__get_cpuid_max(0, NULL) < 7) return 0;
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return (ebx & bit_AVX2) != 0;
+}
+
+#endif // SCAN_HAVE_X86
+
+ScanBackend scan_set_backend(ScanBackend backend) {
+#if SCAN_HAVE_X86
+    if (backend == SCAN_BACKEND_AUTO) {
+        backend = cpu_supports_avx2() ? SCAN_BACKEND_AVX2 : SCAN_BACKEND_SSE2;
+    } else if (backend == SCAN_BACKEND_AVX2 && !cpu_supports_avx2()) {
+        backend = SCAN_BACKEND_SCALAR;
+    }
+#else
+    backend = SCAN_BACKEND_SCALAR;
+#endif
+
+    BlockFunction function = scan_block_scalar;
+#if SCAN_HAVE_X86
+    if (backend == SCAN_BACKEND_SSE2) function = scan_block_sse2;
+    if (backend == SCAN_BACKEND_AVX2) function = scan_block_avx2;
+#endif
+
+    active_backend = backend;
+    // Threads racing through first-use detection all store the same value
+    __atomic_store_n(&block_function, function, __ATOMIC_RELEASE);
+    return backend;
+}
+
+const char* scan_backend_name(void) {
+    if (__atomic_load_n(&block_function, __ATOMIC_ACQUIRE) == NULL) {
+        scan_set_backend(SCAN_BACKEND_AUTO);
+    }
+    switch (active_backend) {
+        case SCAN_BACKEND_AVX2: return "AVX2";
+        case SCAN_BACKEND_SSE2: return "SSE2";
+        default: return "scalar";
+    }
+}
+
+void scan_block64(const char* block, ScanMasks* masks) {
+    BlockFunction function = __atomic_load_n(&block_function, __ATOMIC_ACQUIRE);
+    if (function == NULL) {
+        scan_set_backend(SCAN_BACKEND_AUTO);
+        function = __atomic_load_n(&block_function, __ATOMIC_ACQUIRE);
+    }
+    function(block, masks);
+}
+
+static uint64_t select_classes(const ScanMasks* masks, unsigned classes) {
+    uint64_t bits = 0;
+    if (classes & SCAN_NEWLINE) bits |= masks->newline;
+    if (classes & SCAN_COMMA) bits |= masks->comma;
+    if (classes & SCAN_QUOTE) bits |= masks->quote;
+    if (classes & SCAN_SPACE) bits |= masks->space;
+    if (classes & SCAN_EQUALS) bits |= masks->equals;
+    return bits;
+}
+
+// Classify the block starting at `start` and make it the cursor's current block
+static void cursor_load(ScanCursor* cursor, const char* start) {
+    ScanMasks masks;
+
+    if (cursor->end - start >= SCAN_BLOCK_SIZE) {
+        scan_block64(start, &masks);
+    } else {
+        // Zero padding never matches any class
+        char padded[SCAN_BLOCK_SIZE];
+        size_t remaining = (size_t)(cursor->end - start);
+        memcpy(padded, start, remaining);
+        memset(padded + remaining, 0, SCAN_BLOCK_SIZE - remaining);
+        scan_block64(padded, &masks);
+    }
+
+    cursor->base = start;
+    cursor->bits = select_classes(&masks, cursor->classes);
+}
+
+void scan_cursor_init(ScanCursor* cursor, const char* start, const char* end,
+                      unsigned classes) {
+    cursor->end = end;
+    cursor->classes = classes;
+    if (start < end) {
+        cursor_load(cursor, start);
+    } else {
+        cursor->base = end;
+        cursor->bits = 0;
+    }
+}
+
+const char* scan_cursor_advance(ScanCursor* cursor, const char* from) {
+    if (from >= cursor->end) return cursor->end;
+
+    if (from < cursor->base || from - cursor->base >= SCAN_BLOCK_SIZE) {
+        cursor_load(cursor, from);
+    } else {
+        cursor->bits &= ~(uint64_t)0 << (from - cursor->base);
+    }
+
+    for (;;) {
+        if (cursor->bits != 0) {
+            return cursor->base + __builtin_ctzll(cursor->bits);
+        }
+        const char* next = cursor->base + SCAN_BLOCK_SIZE;
+        if (next >= cursor->end) return cursor->end;
+        cursor_load(cursor, next);
+    }
+}
+
+const char* scan_find(const char* p, const char* end, unsigned classes) {
+    ScanCursor cursor;
+    scan_cursor_init(&cursor, p, end, classes);
+    return scan_cursor_next(&cursor, p);
+}
@@ -0,0 +1,89 @@
+/*
+ * simd_scan.h - Structural character scanner for the text parsers
+ *
+ * Instead of asking "is this byte a comma?" one byte at a time, the
+ * scanner compares 64 bytes at once with SSE2 or AVX2 and packs the
+ * answers into 64-bit masks: bit i is set when byte i is a newline,
+ * comma, quote, space or '='. Parsers then jump from one interesting
+ * byte to the next with a count-trailing-zeros instruction.
+ *
+ * The implementation is picked once at runtime with cpuid, so the same
+ * binary runs on machines with and without AVX2. A portable scalar
+ * version is used everywhere else.
+ *
+ * For frontend developers: This is the trick behind fast JSON parsers
+ * like simdjson - and the reason `JSON.parse` in V8 is not a simple
+ * character-by-character loop.
+ */
+
+#ifndef SIMD_SCAN_H
+#define SIMD_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Character classes (combine with |)
+#define SCAN_NEWLINE 0x01u  // '\n'
+#define SCAN_COMMA   0x02u  // ','
+#define SCAN_QUOTE   0x04u  // '"'
+#define SCAN_SPACE   0x08u  // ' ' and '\t'
+#define SCAN_EQUALS  0x10u  // '='
+
+#define SCAN_BLOCK_SIZE 64
+
+typedef struct {
+    uint64_t newline;
+    uint64_t comma;
+    uint64_t quote;
+    uint64_t space;
+    uint64_t equals;
+} ScanMasks;
+
+typedef enum {
+    SCAN_BACKEND_AUTO,
+    SCAN_BACKEND_SCALAR,
+    SCAN_BACKEND_SSE2,
+    SCAN_BACKEND_AVX2
+} ScanBackend;
+
+// Walks a buffer one structural character at a time. Each 64-byte block
+// is classified once, no matter how many positions are taken from it.
+typedef struct {
+    const char* base;   // Start of the block held in `bits`
+    const char* end;
+    uint64_t bits;      // Positions in the block still to be returned
+    unsigned classes;
+} ScanCursor;
+
+// Classify 64 bytes starting at `block` (all 64 must be readable)
+void scan_block64(const char* block, ScanMasks* masks);
+
+// Force a backend (SCAN_BACKEND_AUTO re-runs cpuid detection). Returns
+// the backend now in use; unsupported requests fall back to scalar.
+ScanBackend scan_set_backend(ScanBackend backend);
+const char* scan_backend_name(void);
+
+void scan_cursor_init(ScanCursor* cursor, const char* start, const char* end,
+                      unsigned classes);
+
+// Slow path of scan_cursor_next(): moves to later blocks
+const char* scan_cursor_advance(ScanCursor* cursor, const char* from);
+
+// First character of the cursor's classes at or after `from`, or `end`
+// if there is none. Calls must use non-decreasing `from` values.
+// Inline because parsers call it once per field.
+static inline const char* scan_cursor_next(ScanCursor* cursor, const char* from) {
+    if (from >= cursor->base && from - cursor->base < SCAN_BLOCK_SIZE) {
+        // Drop positions before `from` and take the next one in this block
+        cursor->bits &= ~(uint64_t)0 << (from - cursor->base);
+        if (cursor->bits != 0) {
+            return cursor->base + __builtin_ctzll(cursor->bits);
+        }
+    }
+    return scan_cursor_advance(cursor, from);
+}
+
+// One-shot search: first character of `classes` in [p, end), or `end`
+const char* scan_find(const char* p, const char* end, unsigned classes);
+
+#endif // SIMD_SCAN_H
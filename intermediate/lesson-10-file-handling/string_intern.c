@@ -0,0 +1,161 @@
+/*
+ * string_intern.c - String interning table (open-addressing hash map)
+ *
+ * Implementation notes:
+ * - Slots hold a 16-bit hash tag next to the ID, so most probes that hit
+ *   a different string are rejected without touching the string itself.
+ * - Linear probing keeps a lookup inside one or two cache lines; the
+ *   table doubles before it gets half full, which keeps probe runs short.
+ * - Names live in one growing arena and are referenced by offset, so
+ *   growing the arena never invalidates an entry.
+ */
+
+#include "string_intern.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// FNV-1a: tiny, and good enough for short identifiers
+static uint32_t hash_name(const char* name, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t make_slot(uint32_t hash, size_t id) {
+    return (hash & 0xFFFF0000u) | (uint32_t)(id + 1);
+}
+
+static size_t slot_id(uint32_t slot) {
+    return (slot & 0xFFFFu) - 1;
+}
+
+int intern_init(InternTable* table, size_t expected_count) {
+    memset(table, 0, sizeof(*table));
+
+    table->slot_count = 16;
+    while (table->slot_count < expected_count * 2) table->slot_count *= 2;
+    table->entry_capacity = table->slot_count / 2;
+    table->arena_capacity = table->entry_capacity * 16;
+
+    table->slots = calloc(table->slot_count, sizeof(uint32_t));
+    table->entries = malloc(table->entry_capacity * sizeof(InternEntry));
+    table->arena = malloc(table->arena_capacity);
+    if (table->slots == NULL || table->entries == NULL || table->arena == NULL) {
+        intern_free(table);
+        return -1;
+    }
+    return 0;
+}
+
+void intern_free(InternTable* table) {
+    free(table->slots);
+    free(table->entries);
+    free(table->arena);
+    memset(table, 0, sizeof(*table));
+}
+
+static int grow_slots(InternTable* table) {
+    size_t new_count = table->slot_count * 2;
+    uint32_t* new_slots = calloc(new_count, sizeof(uint32_t));
+    if (new_slots == NULL) return -1;
+
+    // Stored hashes mean rehashing never re-reads the names
+    for (size_t id = 0; id < table->count; id++) {
+        uint32_t hash = table->entries[id].hash;
+        size_t index = hash & (new_count - 1);
+        while (new_slots[index] != 0) index = (index + 1) & (new_count - 1);
+        new_slots[index] = make_slot(hash, id);
+    }
+
+    free(table->slots);
+    table->slots = new_slots;
+    table->slot_count = new_count;
+    return 0;
+}
+
+// Probe for `name`. Returns its ID, or INTERN_NOT_FOUND with *empty_slot
+// set to where it would be inserted.
+static int probe(const InternTable* table, const char* name, size_t length,
+                 uint32_t hash, size_t* empty_slot) {
+    size_t mask = table->slot_count - 1;
+    size_t index = hash & mask;
+
+    for (;;) {
+        uint32_t slot = table->slots[index];
+        if (slot == 0) {
+            if (empty_slot != NULL) *empty_slot = index;
+            return INTERN_NOT_FOUND;
+        }
+        if ((slot & 0xFFFF0000u) == (hash & 0xFFFF0000u)) {
+            const InternEntry* entry = &table->entries[slot_id(slot)];
+            if (entry->hash == hash && entry->length == length &&
+                memcmp(table->arena + entry->offset, name, length) == 0) {
+                return (int)slot_id(slot);
+            }
+        }
+        index = (index + 1) & mask;
+    }
+}
+
+int intern_find(const InternTable* table, const char* name, size_t length) {
+    if (table->slots == NULL) return INTERN_NOT_FOUND;
+    return probe(table, name, length, hash_name(name, length), NULL);
+}
+
+int intern_id(InternTable* table, const char* name, size_t length) {
+    if (table->slots == NULL) return -1;
+
+    uint32_t hash = hash_name(name, length);
+    size_t empty_slot;
+    int id = probe(table, name, length, hash, &empty_slot);
+    if (id != INTERN_NOT_FOUND) return id;
+
+    if (table->count == INTERN_MAX_IDS) return -1;
+
+    // Keep the load factor at or below 1/2
+    if ((table->count + 1) * 2 > table->slot_count) {
+        if (grow_slots(table) != 0) return -1;
+        probe(table, name, length, hash, &empty_slot);
+    }
+
+    if (table->count == table->entry_capacity) {
+        size_t new_capacity = table->entry_capacity * 2;
+        InternEntry* entries = realloc(table->entries, new_capacity * sizeof(InternEntry));
+        if (entries == NULL) return -1;
+        table->entries = entries;
+        table->entry_capacity = new_capacity;
+    }
+
+    if (table->arena_used + length + 1 > table->arena_capacity) {
+        size_t new_capacity = table->arena_capacity * 2;
+        while (table->arena_used + length + 1 > new_capacity) new_capacity *= 2;
+        char* arena = realloc(table->arena, new_capacity);
+        if (arena == NULL) return -1;
+        table->arena = arena;
+        table->arena_capacity = new_capacity;
+    }
+
+    InternEntry* entry = &table->entries[table->count];
+    entry->hash = hash;
+    entry->offset = (uint32_t)table->arena_used;
+    entry->length = (uint32_t)length;
+    memcpy(table->arena + table->arena_used, name, length);
+    table->arena[table->arena_used + length] = '\0';
+    table->arena_used += length + 1;
+
+    table->slots[empty_slot] = make_slot(hash, table->count);
+    return (int)table->count++;
+}
+
+const char* intern_name(const InternTable* table, uint16_t id) {
+    if (id >= table->count) return NULL;
+    return table->arena + table->entries[id].offset;
+}
+
+size_t intern_count(const InternTable* table) {
+    return table->count;
+}
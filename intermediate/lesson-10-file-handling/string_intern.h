@@ -0,0 +1,55 @@
+/*
+ * string_intern.h - String interning table (open-addressing hash map)
+ *
+ * Interning gives every distinct string a small integer ID. After that,
+ * "is this the same component?" is an integer compare instead of a
+ * strcmp(), and per-name counters become plain array slots indexed by ID.
+ *
+ * For frontend developers: This is what JavaScript engines do with
+ * property names and what `Symbol.for("name")` does - one canonical copy
+ * of each string, referred to by identity.
+ */
+
+#ifndef STRING_INTERN_H
+#define STRING_INTERN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// IDs must fit in a uint16_t
+#define INTERN_MAX_IDS 65535
+#define INTERN_NOT_FOUND (-1)
+
+typedef struct {
+    uint32_t hash;
+    uint32_t offset;    // Position of the name in the arena
+    uint32_t length;
+} InternEntry;
+
+typedef struct {
+    uint32_t* slots;        // 0 = empty, else (hash tag << 16) | (id + 1)
+    size_t slot_count;      // Always a power of two
+    InternEntry* entries;   // Indexed by ID
+    size_t count;
+    size_t entry_capacity;
+    char* arena;            // All names, NUL-terminated, back to back
+    size_t arena_used;
+    size_t arena_capacity;
+} InternTable;
+
+// Returns 0 on success, -1 if memory could not be allocated
+int intern_init(InternTable* table, size_t expected_count);
+void intern_free(InternTable* table);
+
+// ID for `name`, adding it if needed. Returns -1 when the table is full
+// (INTERN_MAX_IDS names) or memory runs out.
+int intern_id(InternTable* table, const char* name, size_t length);
+
+// ID for `name` if present, INTERN_NOT_FOUND otherwise
+int intern_find(const InternTable* table, const char* name, size_t length);
+
+// NUL-terminated name for an ID (valid until the next intern_id call)
+const char* intern_name(const InternTable* table, uint16_t id);
+size_t intern_count(const InternTable* table);
+
+#endif // STRING_INTERN_H
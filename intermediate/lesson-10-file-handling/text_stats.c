@@ -0,0 +1,353 @@
+/*
+ * text_stats.c - Block-based line, word and letter counting
+ *
+ * Implementation notes:
+ * - Whitespace is found with a nibble lookup table (pshufb): the low and
+ *   high 4 bits of each byte each select a bit pattern, and a byte is
+ *   whitespace when the two patterns share a bit. Two shuffles classify
+ *   32 bytes at once, with no per-byte branches.
+ * - Word starts are "not space" bits whose previous bit is a space:
+ *   nonspace & ~(nonspace << 1), with the last bit carried into the next
+ *   64-byte block. popcount() then counts them.
+ * - Letter counters are 8-bit lanes in vector registers (one register per
+ *   letter), flushed into 64-bit totals with psadbw before they can
+ *   overflow. 7 letters are counted per pass so the counters stay in
+ *   registers; each ~8 KB piece is read four times, from L1 cache.
+ * - The portable path looks whitespace up in a table (no branches to
+ *   mispredict) and keeps four interleaved byte histograms, so
+ *   consecutive bytes rarely update the same counter.
+ * - Threads get equal byte ranges. A range starting mid-word knows it
+ *   from the byte before it, so no word is counted twice.
+ */
+
+#define _GNU_SOURCE
+
+#include "text_stats.h"
+#include "mapped_file.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define TEXT_HAVE_X86 1
+#include <immintrin.h>
+#else
+#define TEXT_HAVE_X86 0
+#endif
+
+#define TEXT_MAX_THREADS 256
+#define MIN_BYTES_PER_THREAD (4 * 1024 * 1024)
+#define STREAM_BUFFER_SIZE (1024 * 1024)
+
+// 127 blocks of 64 bytes = 254 vectors: 8-bit letter counters can't overflow
+#define PIECE_SIZE (127 * 64)
+
+// -1 = not detected yet, 0 = portable, 1 = AVX2
+static int simd_level = -1;
+
+// isspace() in the C locale, as a table: a lookup instead of branches
+static const unsigned char space_table[256] = {
+    ['\t'] = 1, ['\n'] = 1, ['\v'] = 1, ['\f'] = 1, ['\r'] = 1, [' '] = 1
+};
+
+void text_counter_init(TextCounter* counter, unsigned flags) {
+    memset(counter, 0, sizeof(*counter));
+    counter->flags = flags;
+}
+
+static void count_portable(TextCounter* counter, const unsigned char* p, size_t length) {
+    uint64_t histogram[4][256];
+    memset(histogram, 0, sizeof(histogram));
+
+    uint64_t words = 0;
+    int in_word = counter->in_word;
+    size_t i = 0;
+
+    for (; i + 4 <= length; i += 4) {
+        for (int j = 0; j < 4; j++) {
+            int word_byte = space_table[p[i + j]] ^ 1;
+            words += (uint64_t)(word_byte & ~in_word);
+            in_word = word_byte;
+            histogram[j][p[i + j]]++;
+        }
+    }
+    for (; i < length; i++) {
+        int word_byte = space_table[p[i]] ^ 1;
+        words += (uint64_t)(word_byte & ~in_word);
+        in_word = word_byte;
+        histogram[0][p[i]]++;
+    }
+
+    TextStats* stats = &counter->stats;
+    for (int j = 0; j < 4; j++) {
+        stats->lines += histogram[j]['\n'];
+        if (!(counter->flags & TEXT_STATS_LETTERS)) continue;
+        for (int letter = 0; letter < 26; letter++) {
+            stats->letters[letter] += histogram[j]['a' + letter] + histogram[j]['A' + letter];
+        }
+    }
+    stats->words += words;
+    counter->in_word = in_word;
+}
+
+#if TEXT_HAVE_X86
+
+// Sum of the 32 byte lanes of `counts`
+__attribute__((target("avx2")))
+static uint64_t sum_bytes(__m256i counts) {
+    __m256i sums = _mm256_sad_epu8(counts, _mm256_setzero_si256());
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, sums);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+// Count 7 letters starting at `first` in `length` bytes (a multiple of
+// 32, at most 255 vectors). Inlined with a constant `first`, and written
+// out per counter, so every counter stays in a register.
+__attribute__((target("avx2"), always_inline))
+static inline void count_letter_group(const unsigned char* p, size_t length, int first,
+                                      uint64_t* letters) {
+    const __m256i lower = _mm256_set1_epi8(0x20);
+    const __m256i a = _mm256_set1_epi8('a');
+    __m256i c0 = _mm256_setzero_si256(), c1 = c0, c2 = c0, c3 = c0, c4 = c0, c5 = c0, c6 = c0;
+
+    for (size_t i = 0; i < length; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(p + i));
+        // 'A'/'a' -> 0 ... 'Z'/'z' -> 25; every other byte lands outside 0..25
+        __m256i index = _mm256_sub_epi8(_mm256_or_si256(v, lower), a);
+
+        // cmpeq yields -1 per match, so subtracting it adds 1
+#define COUNT_LETTER(n) \
+        c##n = _mm256_sub_epi8(c##n, _mm256_cmpeq_epi8(index, _mm256_set1_epi8((char)(first + n))))
+        COUNT_LETTER(0); COUNT_LETTER(1); COUNT_LETTER(2); COUNT_LETTER(3);
+        COUNT_LETTER(4); COUNT_LETTER(5); COUNT_LETTER(6);
+#undef COUNT_LETTER
+    }
+
+    __m256i counts[7] = {c0, c1, c2, c3, c4, c5, c6};
+    for (int k = 0; k < 7 && first + k < 26; k++) {
+        letters[first + k] += sum_bytes(counts[k]);
+    }
+}
+
+// Letter frequencies of `length` bytes (a multiple of 32, at most 255
+// vectors): four passes of 7 letters, each from L1 cache
+__attribute__((target("avx2")))
+static void count_letters_avx2(const unsigned char* p, size_t length, uint64_t* letters) {
+    count_letter_group(p, length, 0, letters);
+    count_letter_group(p, length, 7, letters);
+    count_letter_group(p, length, 14, letters);
+    count_letter_group(p, length, 21, letters);
+}
+
+// Bitmask of the non-whitespace bytes among 32
+__attribute__((target("avx2")))
+static uint32_t nonspace_mask(__m256i v) {
+    // Bit 0: high nibble 0 and low nibble 9..D ('\t'..'\r')
+    // Bit 1: high nibble 2 and low nibble 0 (' ')
+    const __m256i low_table = _mm256_setr_epi8(
+        2, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 0, 0,
+        2, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 0, 0);
+    const __m256i high_table = _mm256_setr_epi8(
+        1, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        1, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+
+    __m256i low = _mm256_shuffle_epi8(low_table, _mm256_and_si256(v, nibble));
+    __m256i high = _mm256_shuffle_epi8(high_table,
+                                       _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+    __m256i space = _mm256_and_si256(low, high);
+    return (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(space, _mm256_setzero_si256()));
+}
+
+// Lines and words in `length` bytes (a multiple of 64). popcnt comes with
+// every AVX2 CPU; without the target, popcount would be a library call.
+__attribute__((target("avx2,popcnt")))
+static void count_lines_words_avx2(TextCounter* counter, const unsigned char* p, size_t length) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    uint64_t previous = (uint64_t)counter->in_word;
+    uint64_t lines = 0, words = 0;
+
+    for (size_t i = 0; i < length; i += 64) {
+        __m256i lo = _mm256_loadu_si256((const __m256i*)(p + i));
+        __m256i hi = _mm256_loadu_si256((const __m256i*)(p + i + 32));
+
+        uint64_t newlines = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, newline)) |
+                            (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, newline)) << 32;
+        uint64_t nonspace = nonspace_mask(lo) | (uint64_t)nonspace_mask(hi) << 32;
+
+        // A word starts at a non-space byte that follows a space
+        uint64_t starts = nonspace & ~((nonspace << 1) | previous);
+        previous = nonspace >> 63;
+
+        lines += (uint64_t)__builtin_popcountll(newlines);
+        words += (uint64_t)__builtin_popcountll(starts);
+    }
+
+    counter->stats.lines += lines;
+    counter->stats.words += words;
+    counter->in_word = (int)previous;
+}
+
+static void count_avx2(TextCounter* counter, const unsigned char* p, size_t length) {
+    while (length >= 64) {
+        size_t piece = length < PIECE_SIZE ? length - length % 64 : PIECE_SIZE;
+
+        count_lines_words_avx2(counter, p, piece);
+        if (counter->flags & TEXT_STATS_LETTERS) {
+            count_letters_avx2(p, piece, counter->stats.letters);
+        }
+        p += piece;
+        length -= piece;
+    }
+    count_portable(counter, p, length);
+}
+
+#endif // TEXT_HAVE_X86
+
+int text_stats_set_simd(int enabled) {
+    int level = 0;
+#if TEXT_HAVE_X86
+    __builtin_cpu_init();
+    level = enabled && __builtin_cpu_supports("avx2");
+#else
+    (void)enabled;
+#endif
+    __atomic_store_n(&simd_level, level, __ATOMIC_RELAXED);
+    return level;
+}
+
+static int use_avx2(void) {
+    int level = __atomic_load_n(&simd_level, __ATOMIC_RELAXED);
+    if (level < 0) level = text_stats_set_simd(1);
+    return level;
+}
+
+const char* text_stats_backend_name(void) {
+    return use_avx2() ? "AVX2" : "portable";
+}
+
+void text_counter_update(TextCounter* counter, const char* data, size_t length) {
+    const unsigned char* p = (const unsigned char*)data;
+    counter->stats.bytes += length;
+
+#if TEXT_HAVE_X86
+    if (use_avx2()) {
+        count_avx2(counter, p, length);
+        return;
+    }
+#endif
+    count_portable(counter, p, length);
+}
+
+typedef struct {
+    const char* data;
+    size_t start;
+    size_t end;
+    TextCounter counter;
+    pthread_t thread;
+    int started;
+} TextWorker;
+
+static void* text_worker_main(void* arg) {
+    TextWorker* worker = (TextWorker*)arg;
+    text_counter_update(&worker->counter, worker->data + worker->start,
+                        worker->end - worker->start);
+    return NULL;
+}
+
+static void add_stats(TextStats* total, const TextStats* part) {
+    total->bytes += part->bytes;
+    total->lines += part->lines;
+    total->words += part->words;
+    for (int i = 0; i < 26; i++) total->letters[i] += part->letters[i];
+}
+
+static int count_mapped(const MappedFile* file, int thread_count, unsigned flags,
+                        TextStats* stats) {
+    size_t max_threads = file->size / MIN_BYTES_PER_THREAD;
+    if ((size_t)thread_count > max_threads) thread_count = max_threads > 0 ? (int)max_threads : 1;
+
+    TextWorker* workers = calloc((size_t)thread_count, sizeof(TextWorker));
+    if (workers == NULL) return -1;
+
+    size_t share = file->size / (size_t)thread_count;
+    for (int t = 0; t < thread_count; t++) {
+        TextWorker* worker = &workers[t];
+        worker->data = file->data;
+        worker->start = (size_t)t * share;
+        worker->end = t == thread_count - 1 ? file->size : worker->start + share;
+        text_counter_init(&worker->counter, flags);
+        // Continue a word that began in the previous range
+        worker->counter.in_word = worker->start > 0 &&
+                                  !space_table[(unsigned char)file->data[worker->start - 1]];
+    }
+
+    // Range 0 is counted on this thread, as is any range whose thread
+    // couldn't be started
+    for (int t = 1; t < thread_count; t++) {
+        workers[t].started =
+            pthread_create(&workers[t].thread, NULL, text_worker_main, &workers[t]) == 0;
+    }
+    text_worker_main(&workers[0]);
+
+    memset(stats, 0, sizeof(*stats));
+    for (int t = 0; t < thread_count; t++) {
+        if (workers[t].started) {
+            pthread_join(workers[t].thread, NULL);
+        } else if (t > 0) {
+            text_worker_main(&workers[t]);
+        }
+        add_stats(stats, &workers[t].counter.stats);
+    }
+
+    free(workers);
+    return 0;
+}
+
+static int count_stream(const char* filename, unsigned flags, TextStats* stats) {
+    FILE* file = fopen(filename, "rb");
+    if (file == NULL) return -1;
+
+    char* buffer = malloc(STREAM_BUFFER_SIZE);
+    if (buffer == NULL) {
+        fclose(file);
+        return -1;
+    }
+
+    TextCounter counter;
+    text_counter_init(&counter, flags);
+
+    size_t bytes_read;
+    while ((bytes_read = fread(buffer, 1, STREAM_BUFFER_SIZE, file)) > 0) {
+        text_counter_update(&counter, buffer, bytes_read);
+    }
+    int result = ferror(file) ? -1 : 0;
+
+    *stats = counter.stats;
+    free(buffer);
+    fclose(file);
+    return result;
+}
+
+int text_stats_file(const char* filename, int thread_count, unsigned flags,
+                    TextStats* stats) {
+    if (thread_count <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_count = cpus > 0 ? (int)cpus : 1;
+    }
+    if (thread_count > TEXT_MAX_THREADS) thread_count = TEXT_MAX_THREADS;
+
+    MappedFile file;
+    if (mapped_file_open(&file, filename, MAPPED_FILE_SEQUENTIAL | MAPPED_FILE_NO_FALLBACK) != 0) {
+        // Not mappable (a pipe, for example): stream it on this thread
+        return count_stream(filename, flags, stats);
+    }
+
+    int result = count_mapped(&file, thread_count, flags, stats);
+    mapped_file_close(&file);
+    return result;
+}
@@ -0,0 +1,56 @@
+/*
+ * text_stats.h - Block-based line, word and letter counting
+ *
+ * Counting characters with fgetc() costs a library call, an isspace()
+ * and an isalpha() per byte. This engine works on large blocks instead:
+ * with AVX2 it classifies 32 bytes per instruction, turns "is newline" /
+ * "is whitespace" into bitmasks and counts them with popcount, and keeps
+ * per-letter counters in vector registers. Large files are split across
+ * threads.
+ *
+ * Words are runs of non-whitespace bytes and letters are ASCII a-z in
+ * either case - the same rules as isspace()/isalpha() in the C locale.
+ *
+ * For frontend developers: This is how `wc` manages gigabytes per second,
+ * and why `text.split(/\s+/).length` on a huge string is so much slower.
+ */
+
+#ifndef TEXT_STATS_H
+#define TEXT_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Flags: letter frequencies cost more than lines and words, so they are
+// only counted on request
+#define TEXT_STATS_LETTERS 0x01u
+
+typedef struct {
+    uint64_t bytes;
+    uint64_t lines;         // Newline characters
+    uint64_t words;
+    uint64_t letters[26];   // 'a'..'z', upper and lower case combined (TEXT_STATS_LETTERS)
+} TextStats;
+
+// Incremental counter: feed blocks of any size in order
+typedef struct {
+    TextStats stats;
+    int in_word;            // Last byte seen was part of a word
+    unsigned flags;
+} TextCounter;
+
+void text_counter_init(TextCounter* counter, unsigned flags);
+void text_counter_update(TextCounter* counter, const char* data, size_t length);
+
+// Count a whole file with `thread_count` threads (0 = one per CPU). Files
+// that can't be memory-mapped are streamed on one thread. Returns 0 on
+// success, -1 on failure with errno set.
+int text_stats_file(const char* filename, int thread_count, unsigned flags,
+                    TextStats* stats);
+
+// Enable or disable the AVX2 kernel (used when the CPU supports it).
+// Returns 1 if AVX2 is now in use.
+int text_stats_set_simd(int enabled);
+const char* text_stats_backend_name(void);
+
+#endif // TEXT_STATS_H
@@ -9,11 +9,33 @@
  * 
  * These are fundamental algorithms that every C programmer
  * should understand and implement.
+ * 
+ * The O(n^2) sorts are compared with pdqsort and merge sort from
+ * ../../common/sort.h - what a program should actually call once the
+ * array holds more than a few dozen elements - with the LSD radix sort
+ * from ../../common/radix_sort.h, which never compares two elements, and
+ * with the C library's qsort(). On large arrays, the parallel merge sort
+ * from ../../common/parallel_sort.h sorts on every CPU at once.
+ *
+ * Timings come from ../../common/bench_harness.h: each sort runs on the
+ * same seeded input after a warmup run, repeatedly, and the median
+ * wall-clock time is reported with its spread (MAD) and p99. clock()
+ * would add up the CPU time of all threads of the parallel sort.
+ * "./array_algorithms --bench" skips the demos and prints every sort on
+ * every input pattern as a table, CSV or JSON (--format).
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
-#include <time.h>
 #include <stdlib.h>
+#include <string.h>
+
+#include "bench_harness.h"
+#include "parallel_sort.h"
+#include "radix_sort.h"
+#include "rng.h"
+#include "sort.h"
 
 // Function prototypes
 void printArray(int arr[], int size);
@@ -22,11 +44,56 @@ int binarySearch(int arr[], int size, int target);
 void bubbleSort(int arr[], int size);
 void selectionSort(int arr[], int size);
 void insertionSort(int arr[], int size);
+void pdqSort(int arr[], int size);
+void mergeSort(int arr[], int size);
+void librarySort(int arr[], int size);
+void radixSort(int arr[], int size);
+void parallelSort(int arr[], int size);
+void stopParallelSort(void);
+int compareLargeSorts(Bench* bench, int size);
+int runBenchmarks(Bench* bench, const int sizes[], int sizeCount);
 void copyArray(int source[], int dest[], int size);
 void generateRandomArray(int arr[], int size, int maxValue);
-double measureSortTime(void (*sortFunc)(int[], int), int arr[], int size);
+BenchResult benchmarkSort(Bench* bench, const char* name, const char* inputName,
+                          void (*sortFunc)(int[], int), const int input[], int work[], int size);
+BenchResult benchmarkSearch(Bench* bench, const char* name, int (*searchFunc)(int[], int, int),
+                            int arr[], int size, int target);
+void printSortTime(const char* label, const BenchResult* result);
 
-int main() {
+int main(int argc, char* argv[]) {
+    Bench bench;
+    bench_init(&bench);
+    bench.min_samples = 3;      // Sorting 10 million elements takes seconds
+    
+    // Sizes for the O(n log n) comparison: "./array_algorithms 1000000
+    // 10000000 100000000" (100 million ints need about 1 GB). Without
+    // any, the demo skips it and --bench uses 1,000,000.
+    int largeSizes[8];
+    int largeSizeCount = 0;
+    int benchMode = 0;
+    int badArguments = bench_parse_args(&bench, &argc, argv) != 0;
+    for (int i = 1; i < argc && !badArguments; i++) {
+        if (strcmp(argv[i], "--bench") == 0) {
+            benchMode = 1;
+            continue;
+        }
+        long size = strtol(argv[i], NULL, 10);
+        if (size <= 0 || size > 500000000 || largeSizeCount == 8) {
+            badArguments = 1;
+        } else {
+            largeSizes[largeSizeCount++] = (int)size;
+        }
+    }
+    if (badArguments) {
+        fprintf(stderr, "Usage: %s [--bench] [array size]... %s\n", argv[0],
+                BENCH_OPTIONS_USAGE);
+        return 1;
+    }
+    if (benchMode) {
+        if (largeSizeCount == 0) largeSizes[largeSizeCount++] = 1000000;
+        return runBenchmarks(&bench, largeSizes, largeSizeCount);
+    }
+    
     printf("=== Array Algorithms ===\n\n");
     
     // 1. Linear Search
@@ -108,8 +175,19 @@ int main() {
     printArray(insertionArray, arraySize);
     printf("\n");
     
+    // Pattern-defeating quicksort (sort.h)
+    int pdqArray[12];
+    copyArray(originalArray, pdqArray, arraySize);
+    printf("Pattern-Defeating Quicksort:\n");
+    printf("Before: ");
+    printArray(pdqArray, arraySize);
+    pdqSort(pdqArray, arraySize);
+    printf("After:  ");
+    printArray(pdqArray, arraySize);
+    printf("\n");
+    
     // 4. Performance Comparison
-    printf("4. Performance Comparison (1000 random elements):\n");
+    printf("4. Performance Comparison (1000 random elements, median of repeated runs):\n");
     const int LARGE_SIZE = 1000;
     int largeArray[LARGE_SIZE];
     int testArray[LARGE_SIZE];
@@ -117,22 +195,38 @@ int main() {
     // Generate random data
     generateRandomArray(largeArray, LARGE_SIZE, 1000);
     
-    // Test Bubble Sort
-    copyArray(largeArray, testArray, LARGE_SIZE);
-    double bubbleTime = measureSortTime(bubbleSort, testArray, LARGE_SIZE);
-    printf("Bubble Sort:    %.6f seconds\n", bubbleTime);
-    
-    // Test Selection Sort
-    copyArray(largeArray, testArray, LARGE_SIZE);
-    double selectionTime = measureSortTime(selectionSort, testArray, LARGE_SIZE);
-    printf("Selection Sort: %.6f seconds\n", selectionTime);
+    BenchResult result;
+    result = benchmarkSort(&bench, "bubble sort", "random", bubbleSort, largeArray, testArray,
+                           LARGE_SIZE);
+    printSortTime("Bubble Sort:", &result);
+    result = benchmarkSort(&bench, "selection sort", "random", selectionSort, largeArray,
+                           testArray, LARGE_SIZE);
+    printSortTime("Selection Sort:", &result);
+    result = benchmarkSort(&bench, "insertion sort", "random", insertionSort, largeArray,
+                           testArray, LARGE_SIZE);
+    printSortTime("Insertion Sort:", &result);
     
-    // Test Insertion Sort
-    copyArray(largeArray, testArray, LARGE_SIZE);
-    double insertionTime = measureSortTime(insertionSort, testArray, LARGE_SIZE);
-    printf("Insertion Sort: %.6f seconds\n", insertionTime);
+    // O(n log n) sorts
+    result = benchmarkSort(&bench, "merge sort", "random", mergeSort, largeArray, testArray,
+                           LARGE_SIZE);
+    printSortTime("Merge Sort:", &result);
+    result = benchmarkSort(&bench, "pdqsort", "random", pdqSort, largeArray, testArray,
+                           LARGE_SIZE);
+    printSortTime("pdqsort:", &result);
+    result = benchmarkSort(&bench, "radix sort", "random", radixSort, largeArray, testArray,
+                           LARGE_SIZE);
+    printSortTime("Radix Sort:", &result);
     printf("\n");
     
+    // The O(n^2) sorts would take minutes here: 1000x the elements is
+    // 1,000,000x the comparisons
+    for (int i = 0; i < largeSizeCount; i++) {
+        if (compareLargeSorts(&bench, largeSizes[i]) != 0) {
+            return 1;
+        }
+    }
+    stopParallelSort();
+    
     // 5. Search Performance Comparison
     printf("5. Search Performance Comparison:\n");
     
@@ -144,17 +238,16 @@ int main() {
     
     target = 1500;  // Search for this value
     
-    // Linear Search
-    clock_t start = clock();
+    // One search takes nanoseconds: the harness times batches of them
     position = linearSearch(searchTestArray, LARGE_SIZE, target);
-    clock_t end = clock();
-    double linearTime = ((double)(end - start)) / CLOCKS_PER_SEC;
+    result = benchmarkSearch(&bench, "linear search", linearSearch, searchTestArray, LARGE_SIZE,
+                             target);
+    double linearTime = result.median_ns / 1e9;
     
-    // Binary Search
-    start = clock();
     int binaryPos = binarySearch(searchTestArray, LARGE_SIZE, target);
-    end = clock();
-    double binaryTime = ((double)(end - start)) / CLOCKS_PER_SEC;
+    result = benchmarkSearch(&bench, "binary search", binarySearch, searchTestArray, LARGE_SIZE,
+                             target);
+    double binaryTime = result.median_ns / 1e9;
     
     printf("Searching for %d in array of %d elements:\n", target, LARGE_SIZE);
     printf("Linear Search: %.8f seconds (found at index %d)\n", linearTime, position);
@@ -258,22 +351,243 @@ void insertionSort(int arr[], int size) {
     }
 }
 
+void pdqSort(int arr[], int size) {
+    sort_int32(arr, (size_t)size);
+}
+
+void mergeSort(int arr[], int size) {
+    // Needs size / 2 ints of scratch space; keep the array as it was if
+    // there is none
+    if (sort_int32_stable(arr, (size_t)size) != 0) {
+        perror("mergeSort");
+    }
+}
+
+static int compareInts(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+void librarySort(int arr[], int size) {
+    qsort(arr, (size_t)size, sizeof(int), compareInts);
+}
+
+void radixSort(int arr[], int size) {
+    // Needs a second array of the same size
+    if (radix_sort_int32(arr, (size_t)size) != 0) {
+        perror("radixSort");
+    }
+}
+
+// Started on first use with one thread per CPU, and reused
+static TaskPool sortPool;
+static int sortPoolStarted = 0;
+
+void parallelSort(int arr[], int size) {
+    if (!sortPoolStarted) {
+        if (task_pool_init(&sortPool, 0) != 0) {
+            perror("parallelSort");
+            pdqSort(arr, size);
+            return;
+        }
+        sortPoolStarted = 1;
+    }
+    // Needs a second array of the same size
+    if (parallel_sort_int32(&sortPool, arr, (size_t)size) != 0) {
+        perror("parallelSort");
+    }
+}
+
+void stopParallelSort(void) {
+    if (sortPoolStarted) {
+        task_pool_destroy(&sortPool);
+        sortPoolStarted = 0;
+    }
+}
+
+// Time qsort(), the O(n log n) sorts and the parallel sort on `size`
+// random elements. Returns 0, or 1 if the arrays can't be allocated.
+int compareLargeSorts(Bench* bench, int size) {
+    printf("Large array (%d random elements, O(n log n), radix and parallel sorts):\n", size);
+    int* hugeArray = malloc((size_t)size * sizeof(int));
+    int* hugeTestArray = malloc((size_t)size * sizeof(int));
+    if (hugeArray == NULL || hugeTestArray == NULL) {
+        printf("Out of memory\n");
+        free(hugeArray);
+        free(hugeTestArray);
+        return 1;
+    }
+    generateRandomArray(hugeArray, size, size);
+    
+    BenchResult library = benchmarkSort(bench, "qsort", "random", librarySort, hugeArray,
+                                        hugeTestArray, size);
+    printSortTime("qsort():", &library);
+    
+    BenchResult result = benchmarkSort(bench, "merge sort", "random", mergeSort, hugeArray,
+                                       hugeTestArray, size);
+    printSortTime("Merge Sort:", &result);
+    
+    result = benchmarkSort(bench, "pdqsort", "random", pdqSort, hugeArray, hugeTestArray, size);
+    printSortTime("pdqsort:", &result);
+    printf("                (%.1fx faster than qsort)\n", library.median_ns / result.median_ns);
+    
+    result = benchmarkSort(bench, "radix sort", "random", radixSort, hugeArray, hugeTestArray,
+                           size);
+    printSortTime("Radix Sort:", &result);
+    printf("                (%.1fx faster than qsort)\n", library.median_ns / result.median_ns);
+    
+    result = benchmarkSort(bench, "parallel sort", "random", parallelSort, hugeArray,
+                           hugeTestArray, size);
+    printSortTime("Parallel Sort:", &result);
+    printf("                (%.1fx faster than qsort, %d thread%s)\n\n",
+           library.median_ns / result.median_ns, sortPool.thread_count,
+           sortPool.thread_count == 1 ? "" : "s");
+    
+    free(hugeArray);
+    free(hugeTestArray);
+    return 0;
+}
+
+typedef struct {
+    const char* name;
+    void (*sortFunc)(int[], int);
+} NamedSort;
+
+// --bench: every sort on every input pattern of ../../common/bench_harness.h,
+// then both searches, as one table (or CSV/JSON). The O(n^2) sorts only
+// get 1000 elements. Returns 0, or 1 if the arrays can't be allocated.
+int runBenchmarks(Bench* bench, const int sizes[], int sizeCount) {
+    const int SLOW_SIZE = 1000;
+    static const NamedSort slowSorts[] = {
+        {"bubble sort", bubbleSort}, {"selection sort", selectionSort},
+        {"insertion sort", insertionSort}
+    };
+    static const NamedSort fastSorts[] = {
+        {"qsort", librarySort}, {"merge sort", mergeSort}, {"pdqsort", pdqSort},
+        {"radix sort", radixSort}, {"parallel sort", parallelSort}
+    };
+    
+    int maxSize = SLOW_SIZE;
+    for (int i = 0; i < sizeCount; i++) {
+        if (sizes[i] > maxSize) maxSize = sizes[i];
+    }
+    int* input = malloc((size_t)maxSize * sizeof(int));
+    int* work = malloc((size_t)maxSize * sizeof(int));
+    if (input == NULL || work == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        free(input);
+        free(work);
+        return 1;
+    }
+    
+    bench_begin(bench);
+    BenchResult result;
+    for (int kind = 0; kind < BENCH_INPUT_COUNT; kind++) {
+        const char* inputName = bench_input_name((BenchInput)kind);
+        bench_fill_int32(input, (size_t)SLOW_SIZE, (BenchInput)kind, bench->seed);
+        for (size_t s = 0; s < sizeof(slowSorts) / sizeof(slowSorts[0]); s++) {
+            result = benchmarkSort(bench, slowSorts[s].name, inputName, slowSorts[s].sortFunc,
+                                   input, work, SLOW_SIZE);
+            bench_report(bench, &result);
+        }
+        for (int i = 0; i < sizeCount; i++) {
+            bench_fill_int32(input, (size_t)sizes[i], (BenchInput)kind, bench->seed);
+            for (size_t s = 0; s < sizeof(fastSorts) / sizeof(fastSorts[0]); s++) {
+                result = benchmarkSort(bench, fastSorts[s].name, inputName,
+                                       fastSorts[s].sortFunc, input, work, sizes[i]);
+                bench_report(bench, &result);
+            }
+        }
+    }
+    
+    // Searches for a value near the middle of 0, 2, 4, ...
+    for (int i = -1; i < sizeCount; i++) {
+        int size = i < 0 ? SLOW_SIZE : sizes[i];
+        for (int j = 0; j < size; j++) {
+            input[j] = j * 2;
+        }
+        int target = (size / 2) | 1;    // Odd: not found, the longest search
+        result = benchmarkSearch(bench, "linear search", linearSearch, input, size, target);
+        bench_report(bench, &result);
+        result = benchmarkSearch(bench, "binary search", binarySearch, input, size, target);
+        bench_report(bench, &result);
+    }
+    bench_end(bench);
+    
+    stopParallelSort();
+    free(input);
+    free(work);
+    return 0;
+}
+
 void copyArray(int source[], int dest[], int size) {
     for (int i = 0; i < size; i++) {
         dest[i] = source[i];
     }
 }
 
+// A fixed seed: every run sorts the same numbers, so timings can be
+// compared between runs and machines. Every call takes the next seed.
+static uint64_t randomSeed = 42;
+
+// Unbiased values in [0, maxValue) (no % maxValue), on the sort pool's
+// threads once it is running; the values are the same either way
 void generateRandomArray(int arr[], int size, int maxValue) {
-    srand(time(NULL));
-    for (int i = 0; i < size; i++) {
-        arr[i] = rand() % maxValue;
-    }
+    rng_fill_int32(sortPoolStarted ? &sortPool : NULL, arr, (size_t)size, 0, maxValue - 1,
+                   randomSeed++);
+}
+
+typedef struct {
+    void (*sortFunc)(int[], int);
+    const int* input;
+    int* work;
+    int size;
+} SortRun;
+
+// Untimed: every run sorts the same unsorted copy
+static void copySortInput(void* context) {
+    SortRun* run = context;
+    memcpy(run->work, run->input, (size_t)run->size * sizeof(int));
 }
 
-double measureSortTime(void (*sortFunc)(int[], int), int arr[], int size) {
-    clock_t start = clock();
-    sortFunc(arr, size);
-    clock_t end = clock();
-    return ((double)(end - start)) / CLOCKS_PER_SEC;
-}
\ No newline at end of file
+static void runSort(void* context) {
+    SortRun* run = context;
+    run->sortFunc(run->work, run->size);
+}
+
+// Median and spread of sorting `input` (copied to `work` first, untimed)
+BenchResult benchmarkSort(Bench* bench, const char* name, const char* inputName,
+                          void (*sortFunc)(int[], int), const int input[], int work[], int size) {
+    SortRun run = {sortFunc, input, work, size};
+    BenchResult result;
+    bench_run(bench, &result, name, inputName, (size_t)size, runSort, copySortInput, &run);
+    return result;
+}
+
+typedef struct {
+    int (*searchFunc)(int[], int, int);
+    int* arr;
+    int size;
+    int target;
+    int found;      // Kept, so the search can't be optimized away
+} SearchRun;
+
+static void runSearch(void* context) {
+    SearchRun* run = context;
+    run->found = run->searchFunc(run->arr, run->size, run->target);
+}
+
+BenchResult benchmarkSearch(Bench* bench, const char* name, int (*searchFunc)(int[], int, int),
+                            int arr[], int size, int target) {
+    SearchRun run = {searchFunc, arr, size, target, 0};
+    BenchResult result;
+    bench_run(bench, &result, name, "sorted", (size_t)size, runSearch, NULL, &run);
+    return result;
+}
+
+void printSortTime(const char* label, const BenchResult* result) {
+    printf("%-16s%.6f seconds (median of %d runs, MAD %.6f, p99 %.6f)\n", label,
+           result->median_ns / 1e9, result->samples, result->mad_ns / 1e9,
+           result->p99_ns / 1e9);
+}
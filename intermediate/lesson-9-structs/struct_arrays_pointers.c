@@ -7,13 +7,26 @@
  * - Dynamic structure allocation
  * - Structure pointer arithmetic
  * 
+ * Book listings go through an OutSink (../../common/out_sink.h): each
+ * listing is formatted into one buffer and written with a single
+ * write(2), instead of a printf() call - format parsing, stream locking -
+ * for every book. Books are sorted with sort_records_by_key() from
+ * ../../common/sort.h: each year is read once, and each 200-byte struct
+ * is moved once, not swapped step by step like in a bubble sort.
+ * 
  * For frontend developers: Like arrays of JavaScript objects,
  * but with explicit memory management and pointer manipulation.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+
+#include "out_sink.h"
+#include "sort.h"
 
 // Define structures for a library management system
 struct Book {
@@ -35,8 +48,16 @@ struct Library {
     char location[100];
 };
 
+// What print_book_list() puts in front of each book
+typedef enum {
+    LABEL_NONE,
+    LABEL_NUMBER,   // "1. ", "2. ", ...
+    LABEL_YEAR      // "1994: "
+} BookLabel;
+
 // Function prototypes
-void print_book(const struct Book* book);
+void print_book(OutSink* out, const struct Book* book);
+void print_book_list(const struct Book* books, int count, const char* indent, BookLabel label);
 void print_library_stats(const struct Library* lib);
 struct Book* find_book_by_id(struct Book* books, int count, int id);
 struct Book* find_books_by_author(struct Book* books, int count, const char* author, int* found_count);
@@ -57,10 +78,7 @@ void demonstrate_structure_arrays(void) {
     int book_count = sizeof(library_books) / sizeof(library_books[0]);
     
     printf("Library Collection (%d books):\n", book_count);
-    for (int i = 0; i < book_count; i++) {
-        printf("  %d. ", i + 1);
-        print_book(&library_books[i]);
-    }
+    print_book_list(library_books, book_count, "  ", LABEL_NUMBER);
     
     // Calculate collection statistics
     double total_value = 0.0;
@@ -180,10 +198,7 @@ void demonstrate_dynamic_structures(void) {
     }
     
     printf("\nAdded %d books to library:\n", lib->book_count);
-    for (int i = 0; i < lib->book_count; i++) {
-        printf("  ");
-        print_book(&lib->books[i]);
-    }
+    print_book_list(lib->books, lib->book_count, "  ", LABEL_NONE);
     
     print_library_stats(lib);
     
@@ -210,8 +225,7 @@ void demonstrate_structure_search(void) {
     printf("Searching for book with ID 203:\n");
     struct Book* found_book = find_book_by_id(catalog, catalog_size, 203);
     if (found_book != NULL) {
-        printf("  Found: ");
-        print_book(found_book);
+        print_book_list(found_book, 1, "  Found: ", LABEL_NONE);
     } else {
         printf("  Book not found\n");
     }
@@ -223,10 +237,7 @@ void demonstrate_structure_search(void) {
     
     if (author_books != NULL && found_count > 0) {
         printf("  Found %d book(s):\n", found_count);
-        for (int i = 0; i < found_count; i++) {
-            printf("    ");
-            print_book(&author_books[i]);
-        }
+        print_book_list(author_books, found_count, "    ", LABEL_NONE);
         free(author_books);  // Clean up allocated memory
     } else {
         printf("  No books found by this author\n");
@@ -235,17 +246,52 @@ void demonstrate_structure_search(void) {
     // Sort books by year
     printf("\nSorting books by publication year:\n");
     sort_books_by_year(catalog, catalog_size);
-    for (int i = 0; i < catalog_size; i++) {
-        printf("  %d: ", catalog[i].year);
-        print_book(&catalog[i]);
-    }
+    print_book_list(catalog, catalog_size, "  ", LABEL_YEAR);
 }
 
 // Helper function implementations
-void print_book(const struct Book* book) {
-    printf("\"%s\" by %s (%d) - $%.2f [%s]\n",
-           book->title, book->author, book->year, book->price,
-           book->available ? "Available" : "Checked out");
+
+// Same text as printf("\"%s\" by %s (%d) - $%.2f [%s]\n", ...), appended
+// to the sink's buffer
+void print_book(OutSink* out, const struct Book* book) {
+    out_char(out, '"');
+    out_str(out, book->title);
+    out_str(out, "\" by ");
+    out_str(out, book->author);
+    out_str(out, " (");
+    out_int(out, book->year);
+    out_str(out, ") - $");
+    out_double(out, book->price, 2);
+    out_str(out, book->available ? " [Available]\n" : " [Checked out]\n");
+}
+
+void print_book_list(const struct Book* books, int count, const char* indent, BookLabel label) {
+    OutSink out;
+    
+    // The sink writes to file descriptor 1 itself, so printf()'s buffer
+    // has to be emptied first to keep the lines in order
+    fflush(stdout);
+    if (out_sink_init(&out, STDOUT_FILENO, 0, OUT_SINK_UNLOCKED) != 0) {
+        perror("Failed to allocate output buffer");
+        return;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        out_str(&out, indent);
+        if (label == LABEL_NUMBER) {
+            out_int(&out, i + 1);
+            out_str(&out, ". ");
+        } else if (label == LABEL_YEAR) {
+            out_int(&out, books[i].year);
+            out_str(&out, ": ");
+        }
+        print_book(&out, &books[i]);
+    }
+    
+    // One write(2) for the whole listing
+    if (out_sink_close(&out) != 0) {
+        perror("Failed to write book list");
+    }
 }
 
 void print_library_stats(const struct Library* lib) {
@@ -310,17 +356,16 @@ struct Book* find_books_by_author(struct Book* books, int count, const char* aut
     return results;
 }
 
+static int64_t book_year(const void* book, void* context) {
+    (void)context;
+    return ((const struct Book*)book)->year;
+}
+
 void sort_books_by_year(struct Book* books, int count) {
-    // Simple bubble sort by year
-    for (int i = 0; i < count - 1; i++) {
-        for (int j = 0; j < count - i - 1; j++) {
-            if (books[j].year > books[j + 1].year) {
-                // Swap entire structures
-                struct Book temp = books[j];
-                books[j] = books[j + 1];
-                books[j + 1] = temp;
-            }
-        }
+    // Stable, like the bubble sort it replaces: books from the same year
+    // keep their catalog order
+    if (sort_records_by_key(books, (size_t)count, sizeof(struct Book), book_year, NULL) != 0) {
+        perror("sort_books_by_year");
     }
 }
 